@@ -3,21 +3,34 @@
 #include "Transaction.h"  // Теперь включаем здесь
 #include <stdexcept>
 #include <iostream>
+#include <utility>
 
 namespace Banking {
 
 
-    Account::Account(const std::string& accNumber, const int& client_id, const std::string& type, double initialBalance)
-        : accountNumber(accNumber), client_id(client_id), type(type), balance(initialBalance) {
+    Account::Account(std::string accNumber, const int& client_id, std::string type, double initialBalance, std::string currency_value, std::shared_ptr<BalanceStore> store)
+        : accountNumber(std::move(accNumber)), client_id(client_id), type(std::move(type)), currency(std::move(currency_value)), hot(std::move(store)) {
         std::cout << "\n-----Account constructor called. " << std::endl;
         if (initialBalance < 0) {
             throw std::invalid_argument("Initial balance cannot be negative");
         }
+        if (!isCurrencyCode(currency)) {
+            throw std::invalid_argument("Invalid currency code: " + currency);
+        }
+        hot->balance = initialBalance;
         std::cout << "You created a new account: " << accountNumber << " for client: " << client_id << std::endl;
     }
 
     Account::~Account() {
         std::cout << "\n-----Account destructor called. "  << std::endl;
+        BalanceVersion* version = hot->versions.exchange(nullptr);
+        while (version != nullptr) {
+            BalanceVersion* prev = version->prev.load();
+            delete version;
+            version = prev;
+        }
+        delete hot->spare_version;
+        hot->spare_version = nullptr;
     }
 
     //увеличивает баланс счета на указанную сумму
@@ -25,9 +38,9 @@ namespace Banking {
         if (amount <= 0) {
             throw std::invalid_argument("Deposit amount must be positive");
         }
-        balance += amount; 
+        hot->balance += amount; 
         std::cout << "\nBalance for account " << accountNumber << " increased by " << amount << std::endl;
-        std::cout << "Current balance = " << balance << std::endl;
+        std::cout << "Current balance = " << hot->balance << std::endl;
     }
 
     // уменьшает баланс счета на указанную сумму
@@ -35,42 +48,97 @@ namespace Banking {
         if (amount <= 0) {
             throw std::invalid_argument("Withdrawal amount must be positive");
         }
-        if (amount > balance) {
+        if (amount > hot->balance) {
             std::cout << "\nYou are trying to withdraw more than available. " << std::endl;
             return false;
         }
-        balance -= amount;
+        hot->balance -= amount;
         std::cout << "\nBalance for account " << accountNumber << " decreased by " << amount << std::endl;
-        std::cout << "Current balance = " << balance << std::endl;
+        std::cout << "Current balance = " << hot->balance << std::endl;
         return true;
     }
 
 
     double Account::getBalance() const {
-        return balance;
+        return hot->balance;
+    }
+
+    void Account::saveState(AccountState& state) const {
+        state.balance = hot->balance;
     }
 
-    std::string Account::getAccountNumber() const {
-        return accountNumber;
+    void Account::restoreState(const AccountState& state) {
+        hot->balance = state.balance;
     }
 
     void Account::displayinfo() const {
         std::cout << "\nInformation about an account: " << std::endl; 
-        std::cout << "number: " << accountNumber << ", \nclient_id: " << client_id << ", \nbalance: " << balance << ", \ntype: " << type << std::endl;
+        std::cout << "number: " << accountNumber << ", \nclient_id: " << client_id << ", \nbalance: " << hot->balance << " " << currency << ", \ntype: " << type << std::endl;
 
     }
- 
+
+    // только проверка: историю счета пополняет банк
     void Account::addTransaction_in_account(std::shared_ptr<Transaction> transaction) {
-        all_account_transactions.push_back(transaction);
-        std::cout << "Transaction " << transaction->getType() << ", summa: " << transaction->getSumma() << " added to account. Total transactions in account: " << all_account_transactions.size() << std::endl;
+        if (!transaction) {
+            throw std::invalid_argument("Transaction cannot be null");
+        }
+        if (transaction->getAcc1() != accountNumber && transaction->getAcc2() != accountNumber) {
+            throw std::invalid_argument("Transaction " + transaction->getFormattedId() + " does not involve account " + accountNumber);
+        }
+        std::cout << "Transaction " << transaction->getFormattedId() << " is recorded in the bank history of account " << accountNumber << std::endl;
     }
 
     void Account::displayinfo_about_transactions_in_account() {
-        std::cout << "\nInformation about transactions for account: " << accountNumber << std::endl;
-        std::cout << "Amount of transactions: " << all_account_transactions.size() << std::endl;
-        for (auto& transaction : all_account_transactions) {
-            transaction->displayinfo();
+        std::cout << "\nHistory of account " << accountNumber << " is kept by the bank: use Bank::display_account_transactions(\"" << accountNumber << "\")" << std::endl;
+    }
+ 
+    void Account::publishBalance(uint64_t epoch, uint64_t oldest_needed) {
+        BalanceRecord& record = *hot;
+        BalanceVersion* head = record.versions.load(std::memory_order_relaxed);
+        BalanceVersion* version = record.spare_version;
+        if (version != nullptr) {
+            record.spare_version = nullptr;
+            version->epoch = epoch;
+            version->balance = record.balance;
+            version->prev.store(head, std::memory_order_relaxed);
+        }
+        else {
+            version = new BalanceVersion{ epoch, record.balance, { head } };
         }
+        record.versions.store(version, std::memory_order_release);
+
+        // ищем версию, которую видит самый старый читатель - все что старше нее больше не нужно
+        // (до старших версий не дойдет ни один читатель, поэтому одну можно переиспользовать)
+        BalanceVersion* keep = head;
+        while (keep != nullptr && keep->epoch > oldest_needed) {
+            keep = keep->prev.load(std::memory_order_relaxed);
+        }
+        if (keep == nullptr) {
+            return;
+        }
+        BalanceVersion* garbage = keep->prev.exchange(nullptr, std::memory_order_relaxed);
+        while (garbage != nullptr) {
+            BalanceVersion* prev = garbage->prev.load(std::memory_order_relaxed);
+            if (record.spare_version == nullptr) {
+                record.spare_version = garbage;
+            }
+            else {
+                delete garbage;
+            }
+            garbage = prev;
+        }
+    }
+
+    bool Account::getBalanceAt(uint64_t epoch, double& value) const {
+        const BalanceVersion* version = hot->versions.load(std::memory_order_acquire);
+        while (version != nullptr && version->epoch > epoch) {
+            version = version->prev.load(std::memory_order_acquire);
+        }
+        if (version == nullptr) {
+            return false;
+        }
+        value = version->balance;
+        return true;
     }
 
 } // namespace Banking
\ No newline at end of file
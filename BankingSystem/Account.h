@@ -2,6 +2,11 @@
 #include <string>
 #include <vector>
 #include <memory> 
+#include <atomic>
+#include <cstdint>
+#include "Structs.h"
+#include "FxRates.h"
+#include "BalanceStore.h"
 
 // Предварительное объявление вместо включения
 namespace Banking {
@@ -16,14 +21,21 @@ namespace Banking {
         std::string accountNumber;
         int client_id;
         std::string type;
-        std::vector<std::shared_ptr<Transaction>> all_account_transactions; // все транзакции аккаунта через умный указатель
+        std::string currency; // код ISO 4217, все суммы счета - в этой валюте
 
     protected:
-        // для доступа в наследниках
-    double balance; 
-    
+        // горячие поля (остаток, овердрафт, комиссия, версии MVCC) - в массиве записей банка по кэш-линии, для доступа в наследниках
+        BalanceSlot hot;
+
+    public:
+        Account(const Account&) = delete;
+        Account& operator=(const Account&) = delete;
+
     public:
-        Account(const std::string& accountNumber, const int& client_id, const std::string& type, double initialBalance = 0);
+        // строки - sink-параметры: временные значения перемещаются в счет без копирования
+        // store - хранилище горячих полей банка; nullptr - общее хранилище для счетов вне банка
+        Account(std::string accountNumber, const int& client_id, std::string type, double initialBalance = 0, std::string currency = DEFAULT_CURRENCY,
+            std::shared_ptr<BalanceStore> store = nullptr);
         virtual ~Account();
 
         // Виртуальные функции для полиморфизма
@@ -33,16 +45,31 @@ namespace Banking {
 
         // Можно ли закрыть счет
         virtual bool canClose() const = 0;             
+        virtual double getCommission() const { return 0; } // комиссия последнего списания
+
+        // сохранить/восстановить состояние: откат без повторного выполнения бизнес-операций
+        virtual void saveState(AccountState& state) const;
+        virtual void restoreState(const AccountState& state);
         
-        // Геттеры
-        std::string getAccountNumber() const;
+        // Геттеры (строки - по ссылке: номер счета читается на каждом переводе, копия выделяла бы память)
+        const std::string& getAccountNumber() const { return accountNumber; }
         double getBalance() const;
-        std::string getType() const { return type; }
+        const std::string& getType() const { return type; }
+        const std::string& getCurrency() const { return currency; }
         int getClientId() const { return client_id; }
 
-        // Не виртуальные функции
-        void addTransaction_in_account(std::shared_ptr<Transaction> transaction); // делаем не статичную в отличие от банковской функции (так как нужно индивидуально под каждый объект = под каждый счет)
+        // историю счета хранит банк: Bank::get_account_transactions, Bank::display_account_transactions
+        // старый API оставлен для совместимости: запись попадает в историю счета при проведении операции банком
+        [[deprecated("history is kept by Bank, use Bank::get_account_transactions")]]
+        void addTransaction_in_account(std::shared_ptr<Transaction> transaction);
+        [[deprecated("use Bank::display_account_transactions")]]
         void displayinfo_about_transactions_in_account();
+
+        // MVCC: publishBalance вызывает только пишущий поток банка (под его блокировкой),
+        // версии старше oldest_needed (кроме одной видимой для oldest_needed) удаляются
+        void publishBalance(uint64_t epoch, uint64_t oldest_needed);
+        // баланс на момент эпохи, без блокировок; false - счета в этой эпохе еще не было
+        bool getBalanceAt(uint64_t epoch, double& value) const;
     };
 
 } // namespace Banking
\ No newline at end of file
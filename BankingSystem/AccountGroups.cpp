@@ -0,0 +1,145 @@
+﻿#include "AccountGroups.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace Banking {
+
+    const AccountGroups::Group& AccountGroups::checked(uint32_t group) const {
+        if (!isValid(group)) {
+            throw std::invalid_argument("Account group " + std::to_string(group) + " not found");
+        }
+        return groups[group];
+    }
+
+    uint32_t AccountGroups::create(int client_id, std::string name, uint32_t parent, std::string currency) {
+        if (name.empty()) {
+            throw std::invalid_argument("Group name cannot be empty");
+        }
+        if (parent != NO_GROUP) {
+            const Group& parent_group = checked(parent);
+            if (parent_group.client_id != client_id) {
+                throw std::invalid_argument("Parent group belongs to another client");
+            }
+            currency = parent_group.currency; // дерево групп - в одной валюте
+        }
+        uint32_t id = static_cast<uint32_t>(groups.size());
+        groups.push_back(Group{ client_id, std::move(name), std::move(currency), parent, true, {}, {} });
+        if (parent != NO_GROUP) {
+            groups[parent].children.push_back(id);
+        }
+        else {
+            client_roots[client_id].push_back(id);
+        }
+        dirty = true;
+        return id;
+    }
+
+    void AccountGroups::removeClient(int client_id) {
+        auto it = client_roots.find(client_id);
+        if (it == client_roots.end()) {
+            return;
+        }
+        for (auto& group : groups) {
+            if (group.client_id == client_id && group.active) {
+                group.active = false;
+                for (uint32_t slot : group.accounts) {
+                    group_of_slot[slot] = NO_GROUP;
+                }
+                group.accounts.clear();
+            }
+        }
+        client_roots.erase(it);
+        dirty = true;
+    }
+
+    void AccountGroups::assign(uint32_t slot, uint32_t group) {
+        checked(group);
+        remove(slot);
+        if (slot >= group_of_slot.size()) {
+            group_of_slot.resize(slot + 1, NO_GROUP);
+        }
+        group_of_slot[slot] = group;
+        groups[group].accounts.push_back(slot);
+        dirty = true;
+    }
+
+    void AccountGroups::remove(uint32_t slot) {
+        uint32_t group = groupOf(slot);
+        if (group == NO_GROUP) {
+            return;
+        }
+        auto& accounts = groups[group].accounts;
+        accounts.erase(std::find(accounts.begin(), accounts.end(), slot));
+        group_of_slot[slot] = NO_GROUP;
+        dirty = true;
+    }
+
+    // обход в глубину: счета группы, затем подгруппы - отрезок группы покрывает все поддерево
+    void AccountGroups::place(uint32_t group) {
+        Group& node = groups[group];
+        node.begin = static_cast<uint32_t>(layout.size());
+        layout.insert(layout.end(), node.accounts.begin(), node.accounts.end());
+        for (uint32_t child : node.children) {
+            place(child);
+        }
+        groups[group].end = static_cast<uint32_t>(layout.size());
+    }
+
+    void AccountGroups::refresh(const std::function<int64_t(uint32_t)>& balance_of) {
+        if (!dirty) {
+            return;
+        }
+        layout.clear();
+        client_span.clear();
+        for (const auto& client : client_roots) {
+            uint32_t begin = static_cast<uint32_t>(layout.size());
+            for (uint32_t root : client.second) {
+                place(root);
+            }
+            client_span[client.first] = { begin, static_cast<uint32_t>(layout.size()) };
+        }
+        position_of_slot.assign(group_of_slot.size(), NO_POSITION);
+        balances.resize(layout.size());
+        for (size_t i = 0; i < layout.size(); ++i) {
+            position_of_slot[layout[i]] = static_cast<uint32_t>(i);
+            balances[i] = balance_of(layout[i]);
+        }
+        totals.assign(balances);
+        dirty = false;
+    }
+
+    int64_t AccountGroups::groupTotal(uint32_t group) const {
+        const Group& node = checked(group);
+        return totals.range(node.begin, node.end);
+    }
+
+    int64_t AccountGroups::groupRange(uint32_t group, size_t from, size_t to) const {
+        const Group& node = checked(group);
+        size_t size = node.end - node.begin;
+        return totals.range(node.begin + std::min(from, size), node.begin + std::min(to, size));
+    }
+
+    int64_t AccountGroups::clientRange(int client_id, size_t from, size_t to) const {
+        auto it = client_span.find(client_id);
+        if (it == client_span.end()) {
+            return 0;
+        }
+        size_t size = it->second.second - it->second.first;
+        return totals.range(it->second.first + std::min(from, size), it->second.first + std::min(to, size));
+    }
+
+    std::vector<uint32_t> AccountGroups::groupSlots(uint32_t group) const {
+        const Group& node = checked(group);
+        return std::vector<uint32_t>(layout.begin() + node.begin, layout.begin() + node.end);
+    }
+
+    std::vector<uint32_t> AccountGroups::clientSlots(int client_id) const {
+        auto it = client_span.find(client_id);
+        if (it == client_span.end()) {
+            return {};
+        }
+        return std::vector<uint32_t>(layout.begin() + it->second.first, layout.begin() + it->second.second);
+    }
+
+}
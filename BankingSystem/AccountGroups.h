@@ -0,0 +1,95 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
+#include "FenwickTree.h"
+
+namespace Banking {
+
+    // Группы счетов клиента (дерево: холдинг -> подразделения -> ...) со сводными остатками.
+    // Счета всех групп выложены в один массив так, что каждая группа вместе с подгруппами - непрерывный
+    // отрезок (обход дерева в глубину), а все группы клиента - тоже один отрезок. Остатки в копейках лежат
+    // в дереве Фенвика: после проводки обновляется только позиция счета (O(log n)), итог группы
+    // и сумма на отрезке счетов клиента - тоже O(log n), без обхода счетов.
+    // Раскладка перестраивается (O(n)) лениво - при первом запросе после изменения состава групп.
+    // Счета задаются номерами слотов таблицы счетов банка. Не потокобезопасен (вызывается под write_mutex банка).
+    class AccountGroups {
+    public:
+        static constexpr uint32_t NO_GROUP = UINT32_MAX;
+
+    private:
+        static constexpr uint32_t NO_POSITION = UINT32_MAX;
+
+        struct Group {
+            int client_id;
+            std::string name;
+            std::string currency;          // валюта всех счетов группы (задается корнем дерева)
+            uint32_t parent;
+            bool active;                   // false - клиент удален
+            std::vector<uint32_t> children;
+            std::vector<uint32_t> accounts; // слоты счетов, назначенных прямо в эту группу
+            uint32_t begin = 0;             // отрезок раскладки: счета группы и всех подгрупп
+            uint32_t end = 0;
+        };
+
+        std::vector<Group> groups;
+        std::unordered_map<int, std::vector<uint32_t>> client_roots; // корневые группы клиента по порядку создания
+        std::vector<uint32_t> group_of_slot;
+
+        // раскладка: позиция -> слот счета и обратно, остатки по позициям
+        bool dirty = false;
+        std::vector<uint32_t> layout;
+        std::vector<uint32_t> position_of_slot;
+        std::vector<int64_t> balances;
+        FenwickTree totals;
+        std::unordered_map<int, std::pair<uint32_t, uint32_t>> client_span;
+
+        const Group& checked(uint32_t group) const; // std::invalid_argument для несуществующей группы
+        void place(uint32_t group);
+
+    public:
+        uint32_t create(int client_id, std::string name, uint32_t parent, std::string currency);
+        void removeClient(int client_id); // группы клиента становятся недействительными
+
+        bool empty() const { return groups.empty(); }
+        bool isValid(uint32_t group) const { return group < groups.size() && groups[group].active; }
+        int getClientId(uint32_t group) const { return checked(group).client_id; }
+        const std::string& getName(uint32_t group) const { return checked(group).name; }
+        const std::string& getCurrency(uint32_t group) const { return checked(group).currency; }
+        uint32_t getParent(uint32_t group) const { return checked(group).parent; }
+        const std::vector<uint32_t>& getChildren(uint32_t group) const { return checked(group).children; }
+        std::vector<uint32_t> clientRoots(int client_id) const {
+            auto it = client_roots.find(client_id);
+            return it == client_roots.end() ? std::vector<uint32_t>() : it->second;
+        }
+
+        // назначить счет в группу (из другой группы счет переносится) / убрать из групп
+        void assign(uint32_t slot, uint32_t group);
+        void remove(uint32_t slot);
+        uint32_t groupOf(uint32_t slot) const { return slot < group_of_slot.size() ? group_of_slot[slot] : NO_GROUP; }
+
+        // новый остаток счета (копейки); при устаревшей раскладке ничего не делает - она перестроится с актуальными остатками
+        void balanceChanged(uint32_t slot, int64_t cents) {
+            if (dirty || slot >= position_of_slot.size() || position_of_slot[slot] == NO_POSITION) {
+                return;
+            }
+            uint32_t position = position_of_slot[slot];
+            totals.add(position, cents - balances[position]);
+            balances[position] = cents;
+        }
+
+        // перестроить раскладку, если состав групп менялся; balance_of - текущий остаток счета по слоту (копейки)
+        void refresh(const std::function<int64_t(uint32_t)>& balance_of);
+
+        // запросы - только после refresh
+        int64_t groupTotal(uint32_t group) const;
+        // сумма счетов [from, to) в порядке groupSlots / clientSlots
+        int64_t groupRange(uint32_t group, size_t from, size_t to) const;
+        int64_t clientRange(int client_id, size_t from, size_t to) const;
+        std::vector<uint32_t> groupSlots(uint32_t group) const;
+        std::vector<uint32_t> clientSlots(int client_id) const;
+    };
+
+}
@@ -0,0 +1,90 @@
+﻿#pragma once
+#include <vector>
+#include <cstdint>
+
+namespace Banking {
+
+    // Связи "один ко многим" на номерах вместо shared_ptr: у каждого владельца (клиент, счет)
+    // двусвязный список элементов (счета клиента, транзакции счета) в плотных массивах.
+    // Добавление и удаление связи - O(1), обход - O(число элементов владельца).
+    class Adjacency {
+    public:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+    private:
+        // по владельцам
+        std::vector<uint32_t> head;
+        std::vector<uint32_t> tail;
+        std::vector<uint32_t> count;
+        // по элементам
+        std::vector<uint32_t> next;
+        std::vector<uint32_t> prev;
+        std::vector<uint32_t> owner;
+
+    public:
+        // элемент добавляется в конец списка владельца (порядок добавления сохраняется)
+        void link(uint32_t owner_value, uint32_t item) {
+            if (owner_value >= head.size()) {
+                head.resize(owner_value + 1, NONE);
+                tail.resize(owner_value + 1, NONE);
+                count.resize(owner_value + 1, 0);
+            }
+            if (item >= owner.size()) {
+                next.resize(item + 1, NONE);
+                prev.resize(item + 1, NONE);
+                owner.resize(item + 1, NONE);
+            }
+            owner[item] = owner_value;
+            next[item] = NONE;
+            prev[item] = tail[owner_value];
+            if (tail[owner_value] != NONE) {
+                next[tail[owner_value]] = item;
+            }
+            else {
+                head[owner_value] = item;
+            }
+            tail[owner_value] = item;
+            ++count[owner_value];
+        }
+
+        void unlink(uint32_t item) {
+            if (item >= owner.size() || owner[item] == NONE) {
+                return;
+            }
+            uint32_t owner_value = owner[item];
+            if (prev[item] != NONE) {
+                next[prev[item]] = next[item];
+            }
+            else {
+                head[owner_value] = next[item];
+            }
+            if (next[item] != NONE) {
+                prev[next[item]] = prev[item];
+            }
+            else {
+                tail[owner_value] = prev[item];
+            }
+            owner[item] = NONE;
+            --count[owner_value];
+        }
+
+        // отвязать все элементы владельца (владелец удален, его номер будет переиспользован)
+        void unlinkAll(uint32_t owner_value) {
+            if (owner_value >= head.size()) {
+                return;
+            }
+            for (uint32_t item = head[owner_value]; item != NONE; item = next[item]) {
+                owner[item] = NONE;
+            }
+            head[owner_value] = NONE;
+            tail[owner_value] = NONE;
+            count[owner_value] = 0;
+        }
+
+        uint32_t first(uint32_t owner_value) const { return owner_value < head.size() ? head[owner_value] : NONE; }
+        uint32_t following(uint32_t item) const { return next[item]; }
+        uint32_t countOf(uint32_t owner_value) const { return owner_value < count.size() ? count[owner_value] : 0; }
+        uint32_t ownerOf(uint32_t item) const { return item < owner.size() ? owner[item] : NONE; }
+    };
+
+}
@@ -0,0 +1,83 @@
+﻿#include "Async.h"
+
+#include <stdexcept>
+
+namespace Banking {
+
+    Executor::Executor(size_t thread_count) {
+        if (thread_count == 0) {
+            throw std::invalid_argument("Executor thread count must be positive");
+        }
+        for (size_t i = 0; i < thread_count; ++i) {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        for (auto& worker : workers) {
+            worker->thread = std::thread(&Executor::workerLoop, this, std::ref(*worker));
+        }
+    }
+
+    Executor::~Executor() {
+        stopping.store(true, std::memory_order_release);
+        for (auto& worker : workers) {
+            worker->wakeups.notify();
+        }
+        for (auto& worker : workers) {
+            worker->thread.join();
+        }
+    }
+
+    void Executor::post(std::coroutine_handle<> handle) {
+        Worker& worker = *workers[next.fetch_add(1, std::memory_order_relaxed) % workers.size()];
+        worker.queue.push(handle);
+        worker.wakeups.notify();
+    }
+
+    void Executor::workerLoop(Worker& worker) {
+        std::coroutine_handle<> handle;
+        while (worker.queue.pop(handle) || worker.wakeups.waitFor([&]() { return worker.queue.pop(handle); }, stopping)) {
+            handle.resume();
+        }
+    }
+
+    // false - мьютекс захвачен сразу, сопрограмма не приостанавливается
+    bool AsyncMutex::Waiter::await_suspend(std::coroutine_handle<> handle_value) {
+        std::lock_guard<std::mutex> lock(mutex.state_mutex);
+        if (!mutex.locked) {
+            mutex.locked = true;
+            return false;
+        }
+        handle = handle_value;
+        if (mutex.last) {
+            mutex.last->next = this;
+        }
+        else {
+            mutex.first = this;
+        }
+        mutex.last = this;
+        return true;
+    }
+
+    AsyncMutex::Lock AsyncMutex::Waiter::await_resume() const noexcept {
+        return Lock(&mutex);
+    }
+
+    // владение передается первому в очереди, мьютекс остается захваченным;
+    // продолжение - через пул, а не в этом потоке, чтобы длинная очередь не росла в глубину стека
+    void AsyncMutex::unlock() {
+        Waiter* waiter = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            waiter = first;
+            if (!waiter) {
+                locked = false;
+                return;
+            }
+            first = waiter->next;
+            if (!first) {
+                last = nullptr;
+            }
+        }
+        executor.post(waiter->handle);
+    }
+
+}
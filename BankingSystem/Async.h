@@ -0,0 +1,271 @@
+﻿#pragma once
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <cstdint>
+#include "MpscQueue.h"
+#include "Wakeup.h"
+
+namespace Banking {
+
+    // Пул потоков для сопрограмм: готовые к продолжению сопрограммы кладутся в очереди потоков по кругу.
+    // Ожидающая сопрограмма не занимает поток - она лежит в очереди мьютекса или в сообщении шарда.
+    class Executor {
+    private:
+        struct Worker {
+            MpscQueue<std::coroutine_handle<>> queue;
+            WakeupCounter wakeups;
+            std::thread thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic<size_t> next{ 0 };
+        std::atomic<bool> stopping{ false };
+
+        void workerLoop(Worker& worker);
+
+    public:
+        explicit Executor(size_t thread_count);
+        ~Executor();
+
+        Executor(const Executor&) = delete;
+        Executor& operator=(const Executor&) = delete;
+
+        size_t getThreadCount() const { return workers.size(); }
+
+        // продолжить сопрограмму в одном из потоков пула (можно вызывать из любого потока)
+        void post(std::coroutine_handle<> handle);
+
+        // co_await executor.schedule() - перейти в поток пула
+        auto schedule() {
+            struct Awaiter {
+                Executor& executor;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle) { executor.post(handle); }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter{ *this };
+        }
+    };
+
+    template <typename T>
+    class Task;
+
+    namespace detail {
+
+        // общая часть обещания Task: продолжение вызывающей сопрограммы и исключение
+        struct TaskPromiseBase {
+            std::coroutine_handle<> continuation;
+            std::exception_ptr error;
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+
+            // по завершении сразу передаем управление ожидающему (без роста стека)
+            struct FinalAwaiter {
+                bool await_ready() const noexcept { return false; }
+                template <typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+                    std::coroutine_handle<> continuation = handle.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+                void await_resume() const noexcept {}
+            };
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+
+            void unhandled_exception() { error = std::current_exception(); }
+        };
+
+        template <typename T>
+        struct TaskPromise : TaskPromiseBase {
+            std::optional<T> value;
+
+            Task<T> get_return_object();
+            void return_value(T result) { value.emplace(std::move(result)); }
+            T take() {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                return std::move(*value);
+            }
+        };
+
+        template <>
+        struct TaskPromise<void> : TaskPromiseBase {
+            Task<void> get_return_object();
+            void return_void() const noexcept {}
+            void take() {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+
+    }
+
+    // Ленивая сопрограмма с результатом T: начинает выполняться при co_await, исключение передается ожидающему.
+    // Параметры сопрограмм-операций передаются по значению - ссылки могут не дожить до продолжения.
+    template <typename T = void>
+    class Task {
+    public:
+        using promise_type = detail::TaskPromise<T>;
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+
+    public:
+        explicit Task(std::coroutine_handle<promise_type> handle_value) : handle(handle_value) {}
+        Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                if (handle) {
+                    handle.destroy();
+                }
+                handle = std::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+        ~Task() {
+            if (handle) {
+                handle.destroy();
+            }
+        }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        auto operator co_await() && noexcept {
+            struct Awaiter {
+                std::coroutine_handle<promise_type> handle;
+                bool await_ready() const noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+                    handle.promise().continuation = caller;
+                    return handle;
+                }
+                T await_resume() { return handle.promise().take(); }
+            };
+            return Awaiter{ handle };
+        }
+    };
+
+    namespace detail {
+
+        template <typename T>
+        Task<T> TaskPromise<T>::get_return_object() {
+            return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object() {
+            return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+
+        // сопрограмма без владельца: кадр удаляется сам по завершении
+        struct Detached {
+            struct promise_type {
+                Detached get_return_object() const noexcept { return {}; }
+                std::suspend_never initial_suspend() const noexcept { return {}; }
+                std::suspend_never final_suspend() const noexcept { return {}; }
+                void return_void() const noexcept {}
+                void unhandled_exception() const noexcept { std::terminate(); }
+            };
+        };
+
+        inline Detached runDetached(Executor& executor, Task<void> task) {
+            co_await executor.schedule();
+            co_await std::move(task);
+        }
+
+    }
+
+    // запустить задачу в пуле без ожидания результата (исключение задачи завершает программу -
+    // обработка ошибок должна быть внутри нее)
+    inline void spawn(Executor& executor, Task<void> task) {
+        detail::runDetached(executor, std::move(task));
+    }
+
+    // выполнить задачу в пуле и заблокировать вызывающий поток до результата (для main, тестов и меню)
+    template <typename T>
+    T syncWait(Executor& executor, Task<T> task) {
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool done = false;
+        std::exception_ptr error;
+        std::optional<T> result;
+        auto wrapper = [&]() -> Task<void> {
+            try {
+                result.emplace(co_await std::move(task));
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+            finished.notify_one();
+        };
+        spawn(executor, wrapper());
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&]() { return done; });
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*result);
+    }
+
+    // Мьютекс для сопрограмм: co_await mutex.lock() не блокирует поток - при занятом мьютексе сопрограмма
+    // встает в очередь (узел очереди - сам ожидающий объект в кадре сопрограммы, без выделений памяти),
+    // при освобождении следующая продолжается в пуле по порядку очереди.
+    class AsyncMutex {
+    public:
+        class Lock;
+
+    private:
+        struct Waiter {
+            AsyncMutex& mutex;
+            std::coroutine_handle<> handle;
+            Waiter* next = nullptr;
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> handle_value);
+            Lock await_resume() const noexcept;
+        };
+
+        Executor& executor;
+        std::mutex state_mutex;
+        bool locked = false;
+        Waiter* first = nullptr;
+        Waiter* last = nullptr;
+
+    public:
+        // владение мьютексом на время жизни объекта
+        class Lock {
+        private:
+            AsyncMutex* mutex;
+
+        public:
+            explicit Lock(AsyncMutex* mutex_value) : mutex(mutex_value) {}
+            Lock(Lock&& other) noexcept : mutex(std::exchange(other.mutex, nullptr)) {}
+            Lock(const Lock&) = delete;
+            Lock& operator=(const Lock&) = delete;
+            Lock& operator=(Lock&&) = delete;
+            ~Lock() {
+                if (mutex) {
+                    mutex->unlock();
+                }
+            }
+        };
+
+        explicit AsyncMutex(Executor& executor_value) : executor(executor_value) {}
+        AsyncMutex(const AsyncMutex&) = delete;
+        AsyncMutex& operator=(const AsyncMutex&) = delete;
+
+        Waiter lock() { return Waiter{ *this, {} }; }
+        void unlock();
+    };
+
+}
@@ -0,0 +1,92 @@
+﻿#include "AsyncBank.h"
+#include "Account.h"
+
+#include <stdexcept>
+
+namespace Banking {
+
+    namespace {
+
+        // ожидание уведомления шарда: send отправляет сообщение уже после приостановки сопрограммы,
+        // поэтому уведомление может прийти из потока шарда в любой момент после отправки
+        template <typename Send>
+        struct ShardAwaiter {
+            Executor& executor;
+            Send send;
+            std::coroutine_handle<> handle;
+            bool ok = false;
+
+            static void complete(void* context, bool ok_value) {
+                auto* self = static_cast<ShardAwaiter*>(context);
+                self->ok = ok_value;
+                self->executor.post(self->handle);
+            }
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle_value) {
+                handle = handle_value;
+                send(ShardedBank::Completion{ &ShardAwaiter::complete, this }); // после отправки this не трогаем
+            }
+            bool await_resume() const noexcept { return ok; }
+        };
+
+        template <typename Send>
+        ShardAwaiter<Send> shardOperation(Executor& executor, Send send) {
+            return ShardAwaiter<Send>{ executor, std::move(send), {} };
+        }
+
+    }
+
+    AsyncBank::AsyncBank(Bank& bank_value, Executor& executor)
+        : bank(bank_value), mutex(executor) {
+    }
+
+    Task<BankStatus> AsyncBank::transfer(std::string accountNumber_from, std::string accountNumber_to, double amount) {
+        auto lock = co_await mutex.lock();
+        co_return bank.tryTransfer(accountNumber_from, accountNumber_to, amount);
+    }
+
+    Task<BankStatus> AsyncBank::deposit(std::string accountNumber, double amount) {
+        auto lock = co_await mutex.lock();
+        auto account = bank.find_acc_by_number(accountNumber);
+        co_return account ? bank.tryDeposit(account, amount) : BankStatus::AccountNotFound;
+    }
+
+    Task<BankStatus> AsyncBank::withdraw(std::string accountNumber, double amount) {
+        auto lock = co_await mutex.lock();
+        auto account = bank.find_acc_by_number(accountNumber);
+        co_return account ? bank.tryWithdraw(account, amount) : BankStatus::AccountNotFound;
+    }
+
+    Task<double> AsyncBank::getBalance(std::string accountNumber) {
+        auto lock = co_await mutex.lock();
+        auto account = bank.find_acc_by_number(accountNumber);
+        if (!account) {
+            throw std::invalid_argument("Account not found: " + accountNumber);
+        }
+        co_return account->getBalance();
+    }
+
+    AsyncShardedBank::AsyncShardedBank(ShardedBank& bank_value, Executor& executor_value)
+        : bank(bank_value), executor(executor_value) {
+    }
+
+    Task<bool> AsyncShardedBank::transfer(std::string accountNumber_from, std::string accountNumber_to, double amount) {
+        co_return co_await shardOperation(executor, [&](ShardedBank::Completion done) {
+            bank.transfer(accountNumber_from, accountNumber_to, amount, done);
+        });
+    }
+
+    Task<bool> AsyncShardedBank::deposit(std::string accountNumber, double amount) {
+        co_return co_await shardOperation(executor, [&](ShardedBank::Completion done) {
+            bank.deposit(accountNumber, amount, done);
+        });
+    }
+
+    Task<bool> AsyncShardedBank::withdraw(std::string accountNumber, double amount) {
+        co_return co_await shardOperation(executor, [&](ShardedBank::Completion done) {
+            bank.withdraw(accountNumber, amount, done);
+        });
+    }
+
+}
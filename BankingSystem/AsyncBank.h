@@ -0,0 +1,42 @@
+﻿#pragma once
+#include <string>
+#include "Async.h"
+#include "Bank.h"
+#include "ShardedBank.h"
+
+namespace Banking {
+
+    // Сопрограммный фасад над Bank: co_await bank.transfer(...) для сервисного слоя.
+    // Операции с записью идут по одной через AsyncMutex - тысячи запросов ждут своей очереди
+    // в кадрах сопрограмм, а не на write_mutex банка в отдельных потоках.
+    class AsyncBank {
+    private:
+        Bank& bank;
+        AsyncMutex mutex;
+
+    public:
+        AsyncBank(Bank& bank_value, Executor& executor);
+
+        Task<BankStatus> transfer(std::string accountNumber_from, std::string accountNumber_to, double amount);
+        Task<BankStatus> deposit(std::string accountNumber, double amount);
+        Task<BankStatus> withdraw(std::string accountNumber, double amount);
+        Task<double> getBalance(std::string accountNumber); // std::invalid_argument, если счета нет
+    };
+
+    // Сопрограммный фасад над ShardedBank: сопрограмма приостанавливается на время всех переходов
+    // операции между шардами и продолжается в пуле по уведомлению шарда, где операция завершилась.
+    // Результат - true, если операция выполнена (false - отказ, для перевода деньги возвращены отправителю).
+    class AsyncShardedBank {
+    private:
+        ShardedBank& bank;
+        Executor& executor;
+
+    public:
+        AsyncShardedBank(ShardedBank& bank_value, Executor& executor_value);
+
+        Task<bool> transfer(std::string accountNumber_from, std::string accountNumber_to, double amount);
+        Task<bool> deposit(std::string accountNumber, double amount);
+        Task<bool> withdraw(std::string accountNumber, double amount);
+    };
+
+}
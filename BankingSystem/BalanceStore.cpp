@@ -0,0 +1,69 @@
+﻿#include "BalanceStore.h"
+#include <new>
+
+namespace Banking {
+
+    const std::shared_ptr<BalanceStore>& BalanceStore::shared() {
+        // не разрушается: счета могут пережить статические объекты
+        static const std::shared_ptr<BalanceStore>* instance = new std::shared_ptr<BalanceStore>(std::make_shared<BalanceStore>());
+        return *instance;
+    }
+
+    BalanceRecord* BalanceStore::allocate() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!free_records.empty()) {
+            BalanceRecord* record = free_records.back();
+            free_records.pop_back();
+            new (record) BalanceRecord(); // атомарная голова версий не присваивается
+            return record;
+        }
+        if (used_in_last == CHUNK) {
+            chunks.emplace_back(new BalanceRecord[CHUNK]);
+            used_in_last = 0;
+        }
+        return &chunks.back()[used_in_last++];
+    }
+
+    void BalanceStore::release(BalanceRecord* record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        free_records.push_back(record);
+    }
+
+    // остаток последнего блока уходит в список свободных, чтобы новые блоки шли подряд
+    void BalanceStore::reserve(size_t records) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t available = free_records.size() + (CHUNK - used_in_last);
+        if (available >= records) {
+            return;
+        }
+        size_t new_chunks = (records - available + CHUNK - 1) / CHUNK;
+        free_records.reserve(free_records.size() + (CHUNK - used_in_last) + new_chunks * CHUNK);
+        size_t first_new = chunks.size();
+        for (size_t c = 0; c < new_chunks; ++c) {
+            chunks.emplace_back(new BalanceRecord[CHUNK]);
+        }
+        // список свободных - стек: кладем с конца, чтобы записи выдавались в порядке адресов
+        for (size_t c = chunks.size(); c-- > first_new;) {
+            for (size_t i = CHUNK; i-- > 0;) {
+                free_records.push_back(&chunks[c][i]);
+            }
+        }
+        if (first_new > 0) {
+            for (size_t i = CHUNK; i-- > used_in_last;) {
+                free_records.push_back(&chunks[first_new - 1][i]);
+            }
+        }
+        used_in_last = CHUNK;
+    }
+
+    size_t BalanceStore::getCapacity() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return chunks.size() * CHUNK;
+    }
+
+    size_t BalanceStore::getFreeCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return free_records.size() + (CHUNK - used_in_last);
+    }
+
+}
@@ -0,0 +1,81 @@
+﻿#pragma once
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+namespace Banking {
+
+    // версия баланса для согласованных отчетов (MVCC): новая версия в голове списка
+    struct BalanceVersion {
+        uint64_t epoch;
+        double balance;
+        std::atomic<BalanceVersion*> prev;
+    };
+
+    // Горячие поля счета, которые меняет каждая операция. Одна запись - одна кэш-линия:
+    // обновление остатка трогает одну линию, а потоки, работающие с разными счетами, не делят линии.
+    // Поля овердрафта и комиссии использует только расчетный счет.
+    // Голова списка версий публикуется вместе с каждым новым остатком, поэтому она тоже здесь:
+    // читатели снимков читают эту линию, а объект Account после создания не перезаписывается.
+    struct alignas(64) BalanceRecord {
+        double balance = 0;
+        double commission = 0;           // комиссия последнего списания
+        double available_overdraft = 0;
+        double overdraft_limit = 0;
+        std::atomic<BalanceVersion*> versions{ nullptr };
+        BalanceVersion* spare_version = nullptr; // освобожденная версия для следующей публикации (только пишущий поток)
+    };
+
+    // Плотный массив записей счетов: блоками по CHUNK записей, записи не перемещаются,
+    // освобожденные переиспользуются. Свое хранилище у каждого банка (и у каждого шарда ShardedBank),
+    // поэтому потоки шардов не делят мьютекс при создании и удалении счетов.
+    // Холодные данные счета (номер, тип, валюта, клиент) остаются в объекте Account.
+    class BalanceStore {
+    public:
+        static const size_t CHUNK = 4096; // 256 КБ
+
+    private:
+        std::mutex mutex; // счет может быть удален в другом потоке, чем создан
+        std::vector<std::unique_ptr<BalanceRecord[]>> chunks;
+        size_t used_in_last = CHUNK;
+        std::vector<BalanceRecord*> free_records;
+
+    public:
+        // хранилище для счетов, созданных вне банка
+        static const std::shared_ptr<BalanceStore>& shared();
+
+        BalanceRecord* allocate(); // запись обнулена
+        void release(BalanceRecord* record);
+        void reserve(size_t records); // заранее выделить блоки под массовое создание счетов
+
+        size_t getCapacity();
+        size_t getFreeCount();
+    };
+
+    // запись счета во владении объекта: выделяется при создании, возвращается в хранилище при удалении
+    class BalanceSlot {
+    private:
+        std::shared_ptr<BalanceStore> store; // счет может пережить банк - хранилище живет, пока есть его записи
+        BalanceRecord* record;
+
+    public:
+        explicit BalanceSlot(std::shared_ptr<BalanceStore> owner = nullptr)
+            : store(owner ? std::move(owner) : BalanceStore::shared()), record(store->allocate()) {}
+        ~BalanceSlot() {
+            if (record) {
+                store->release(record);
+            }
+        }
+        BalanceSlot(BalanceSlot&& other) noexcept : store(std::move(other.store)), record(other.record) { other.record = nullptr; }
+        BalanceSlot& operator=(BalanceSlot&&) = delete;
+        BalanceSlot(const BalanceSlot&) = delete;
+        BalanceSlot& operator=(const BalanceSlot&) = delete;
+
+        BalanceRecord* operator->() const { return record; }
+        BalanceRecord& operator*() const { return *record; }
+    };
+
+}
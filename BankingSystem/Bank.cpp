@@ -8,192 +8,975 @@
 #include "CheckingAccount.h"  //   
 
 #include "Transaction.h"  //   
+#include "Metrics.h"
 
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <optional>
+#include <cmath>
 
 namespace Banking {
 
+    //      : fn(, )      
+    template <typename Fn>
+    static void forEachDebitTotal(const Posting& posting, Fn fn) {
+        const auto& legs = posting.getLegs();
+        for (size_t i = 0; i < legs.size(); ++i) {
+            if (!legs[i].debit) {
+                continue;
+            }
+            bool seen = false;
+            for (size_t k = 0; k < i && !seen; ++k) {
+                seen = legs[k].debit && legs[k].account == legs[i].account;
+            }
+            if (seen) {
+                continue;
+            }
+            double total = 0;
+            for (size_t k = i; k < legs.size(); ++k) {
+                if (legs[k].debit && legs[k].account == legs[i].account) {
+                    total += legs[k].amount;
+                }
+            }
+            if (!fn(*legs[i].account, total)) {
+                return;
+            }
+        }
+    }
+
+    Bank::Bank() {
+        for (auto& slot : snapshot_epochs) {
+            slot.store(NO_SNAPSHOT);
+        }
+    }
+
     //     ( )
     std::shared_ptr<Client> Bank::find_client_by_id(const int& id) {
-        for (auto& client : all_clients) {
-            if (client->getId() == id) {
-                return client;
-            }
+        if (!client_filter.mayContain(LookupFilter::hashOf(static_cast<uint64_t>(id)))) {
+            BANK_METRIC_COUNT(LOOKUP_FILTER_REJECTED);
+            return nullptr;
         }
+        WriteLock lock(*this);
+        auto it = clients_by_id.find(id);
+        if (it != clients_by_id.end()) {
+            return client_table[it->second];
+        }
+        client_filter.recordFalsePositive();
+        BANK_METRIC_COUNT(LOOKUP_FILTER_FALSE_POSITIVE);
         return nullptr;
     }
     
     //     ( )
-    std::shared_ptr<Account> Bank::find_acc_by_number(const std::string& accountNumber) {
-        for (auto& account : all_accounts) {
-            if (account->getAccountNumber() == accountNumber) {
-                return account;
-            }
+    std::shared_ptr<Account> Bank::find_acc_by_number(std::string_view accountNumber) {
+        if (!account_filter.mayContain(LookupFilter::hashOf(accountNumber))) {
+            BANK_METRIC_COUNT(LOOKUP_FILTER_REJECTED);
+            return nullptr;
+        }
+        WriteLock lock(*this);
+        auto it = accounts_by_number.find(accountNumber);
+        if (it != accounts_by_number.end()) {
+            return account_table[it->second];
         }
+        account_filter.recordFalsePositive();
+        BANK_METRIC_COUNT(LOOKUP_FILTER_FALSE_POSITIVE);
         return nullptr;
     }
 
+    LookupFilter::Counts Bank::getLookupFilterCounts() const {
+        LookupFilter::Counts accounts = account_filter.getCounts();
+        LookupFilter::Counts clients = client_filter.getCounts();
+        accounts.rejected += clients.rejected;
+        accounts.false_positives += clients.false_positives;
+        return accounts;
+    }
+
+    void Bank::rebuildLookupFilters() {
+        WriteLock lock(*this);
+        std::vector<uint64_t> hashes;
+        hashes.reserve(accounts_by_number.size());
+        for (const auto& entry : accounts_by_number) {
+            hashes.push_back(LookupFilter::hashOf(entry.first));
+        }
+        account_filter.rebuild(hashes);
+        hashes.clear();
+        for (const auto& entry : clients_by_id) {
+            hashes.push_back(LookupFilter::hashOf(static_cast<uint64_t>(entry.first)));
+        }
+        client_filter.rebuild(hashes);
+    }
+
+    void Bank::maintainLookupFilters() {
+        if (account_filter.needsRebuild() || client_filter.needsRebuild()) {
+            rebuildLookupFilters();
+        }
+    }
+
     //  
-    std::shared_ptr<Client> Bank::createClient(int id_value, const std::string& name_value, const std::string& surname_value, const Address& address_value, const Date& date_value) {
-        auto client = std::make_shared<Client>(id_value, name_value, surname_value, address_value, date_value);
+    std::shared_ptr<Client> Bank::createClient(int id_value, std::string name_value, std::string surname_value, const Address& address_value, const Date& date_value) {
+        WriteLock lock(*this);
+        auto client = std::make_shared<Client>(id_value, std::move(name_value), std::move(surname_value), address_value, date_value);
         addClient_in_bank(client);
         return client;
     }
     
     //   
-    std::shared_ptr<PremiumClient> Bank::createPremiumClient(int id_value, const std::string& name_value, const std::string& surname_value, const Address& address_value, const Date& date_value, const std::string& level, double discount) {
-        auto client = std::make_shared<PremiumClient>(id_value, name_value, surname_value, address_value, date_value, level, discount);
+    std::shared_ptr<PremiumClient> Bank::createPremiumClient(int id_value, std::string name_value, std::string surname_value, const Address& address_value, const Date& date_value, std::string level, double discount) {
+        WriteLock lock(*this);
+        auto client = std::make_shared<PremiumClient>(id_value, std::move(name_value), std::move(surname_value), address_value, date_value, std::move(level), discount);
         addClient_in_bank(client);
         return client;
     }
 
+    //   :   ,   ,    
+    BankResult<std::shared_ptr<Client>> Bank::tryCreateClient(int id_value, std::string name_value, std::string surname_value, const Address& address_value, const Date& date_value) {
+        WriteLock lock(*this);
+        if (id_value <= 0 || name_value.empty() || surname_value.empty() || !date_value.isValid()) {
+            return BankStatus::InvalidClientData;
+        }
+        if (clients_by_id.count(id_value) != 0) {
+            return BankStatus::DuplicateClient;
+        }
+        return createClient(id_value, std::move(name_value), std::move(surname_value), address_value, date_value);
+    }
+
+    BankResult<std::shared_ptr<PremiumClient>> Bank::tryCreatePremiumClient(int id_value, std::string name_value, std::string surname_value, const Address& address_value, const Date& date_value, std::string level, double discount) {
+        WriteLock lock(*this);
+        if (id_value <= 0 || name_value.empty() || surname_value.empty() || !date_value.isValid()
+            || (level != "Silver" && level != "Gold" && level != "Platinum")) {
+            return BankStatus::InvalidClientData;
+        }
+        if (clients_by_id.count(id_value) != 0) {
+            return BankStatus::DuplicateClient;
+        }
+        return createPremiumClient(id_value, std::move(name_value), std::move(surname_value), address_value, date_value, std::move(level), discount);
+    }
+
     //    
-    void Bank::addClient_in_bank(std::shared_ptr<Client> client) {
+    void Bank::addClient_in_bank(const std::shared_ptr<Client>& client) {
+        WriteLock lock(*this);
         if (find_client_by_id(client->getId()) != nullptr) {
             throw std::invalid_argument("You already have this client in bank");
         }
-        all_clients.push_back(client);
+        client_index.add(client->getId(), client->getSurname(), client->getAddress(), client->getRegistrationDate());
+        uint32_t slot;
+        if (!free_client_slots.empty()) {
+            slot = free_client_slots.back();
+            free_client_slots.pop_back();
+            client_table[slot] = client;
+        }
+        else {
+            slot = static_cast<uint32_t>(client_table.size());
+            client_table.push_back(client);
+        }
+        clients_by_id.emplace(client->getId(), slot);
+        client_filter.add(LookupFilter::hashOf(static_cast<uint64_t>(client->getId())));
+        maintainLookupFilters();
         std::cout << "Client " << client->getSurname() << " added to bank. Total clients in bank: " << getClientsCount() << std::endl;
     }
 
     //     
-    void Bank::addClient_in_bank(std::shared_ptr<PremiumClient> client) {
+    void Bank::addClient_in_bank(const std::shared_ptr<PremiumClient>& client) {
         //        
         addClient_in_bank(std::static_pointer_cast<Client>(client));
     }
     
     //    ()
-    std::shared_ptr<CheckingAccount> Bank::createCheckAccount(const std::string& accountNumber, const int& client_id, double initialBalance, double overdraft_value) {  //       
+    std::shared_ptr<CheckingAccount> Bank::createCheckAccount(const std::string& accountNumber, const int& client_id, double initialBalance, double overdraft_value, const std::string& currency) {  //       
+        WriteLock lock(*this);
         auto client = Bank::find_client_by_id(client_id);
         if (!client) {
             throw std::invalid_argument("Client with id " + std::to_string(client_id) + " not found");
         }
-        auto account = std::make_shared<CheckingAccount>(accountNumber, client_id, initialBalance);
-        addAccount_in_bank(account);
-        client->addAccount_to_client(account);
+        auto account = std::make_shared<CheckingAccount>(accountNumber, client_id, initialBalance, currency, balance_store);
+        addAccount_in_bank(account); //     
         return account;
     }
 
     //    ()
-    std::shared_ptr<SavingsAccount> Bank::createSavAccount(const std::string& accountNumber, const int& client_id, double initialBalance, int months) {  //       
+    std::shared_ptr<SavingsAccount> Bank::createSavAccount(const std::string& accountNumber, const int& client_id, double initialBalance, int months, const std::string& currency) {  //       
+        WriteLock lock(*this);
         auto client = Bank::find_client_by_id(client_id);
         if (!client) {
             throw std::invalid_argument("Client with id " + std::to_string(client_id) + " not found");
         }
-        auto account = std::make_shared<SavingsAccount>(accountNumber, client_id, initialBalance, months);
-        addAccount_in_bank(account);
-        client->addAccount_to_client(account);
+        auto account = std::make_shared<SavingsAccount>(accountNumber, client_id, initialBalance, months, currency, balance_store);
+        addAccount_in_bank(account); //     
         return account;
     }
 
+    BankResult<std::shared_ptr<CheckingAccount>> Bank::tryCreateCheckAccount(const std::string& accountNumber, const int& client_id, double initialBalance, double overdraft_value, const std::string& currency) {
+        WriteLock lock(*this);
+        if (initialBalance < 0 || !isCurrencyCode(currency)) {
+            return BankStatus::InvalidAccountData;
+        }
+        if (clients_by_id.count(client_id) == 0) {
+            return BankStatus::ClientNotFound;
+        }
+        if (accounts_by_number.count(accountNumber) != 0) {
+            return BankStatus::DuplicateAccount;
+        }
+        return createCheckAccount(accountNumber, client_id, initialBalance, overdraft_value, currency);
+    }
+
+    BankResult<std::shared_ptr<SavingsAccount>> Bank::tryCreateSavAccount(const std::string& accountNumber, const int& client_id, double initialBalance, int months, const std::string& currency) {
+        WriteLock lock(*this);
+        if (initialBalance < 5000 || months < 1 || !isCurrencyCode(currency)) {
+            return BankStatus::InvalidAccountData;
+        }
+        if (clients_by_id.count(client_id) == 0) {
+            return BankStatus::ClientNotFound;
+        }
+        if (accounts_by_number.count(accountNumber) != 0) {
+            return BankStatus::DuplicateAccount;
+        }
+        return createSavAccount(accountNumber, client_id, initialBalance, months, currency);
+    }
+
     //   ()  
-    void Bank::addAccount_in_bank(std::shared_ptr<Account> account) {
+    void Bank::addAccount_in_bank(const std::shared_ptr<Account>& account) {
+        WriteLock lock(*this);
         if (find_acc_by_number(account->getAccountNumber()) != nullptr) {
             throw std::invalid_argument("You already have an account with this number");
         }
-        all_accounts.push_back(account);
+        uint32_t ledger_account = ledger.accountIndex(account->getAccountNumber());
+        if (account->getBalance() > 0) {
+            int64_t opening = Ledger::toCents(account->getBalance());
+            ledger.post(Ledger::OPEN, { { Ledger::CASH, -opening, Ledger::PRINCIPAL }, { ledger_account, opening, Ledger::PRINCIPAL } });
+        }
+        uint32_t slot;
+        if (!free_account_slots.empty()) {
+            slot = free_account_slots.back();
+            free_account_slots.pop_back();
+            account_table[slot] = account;
+        }
+        else {
+            slot = static_cast<uint32_t>(account_table.size());
+            account_table.push_back(account);
+        }
+        accounts_by_number.emplace(account->getAccountNumber(), slot);
+        account_filter.add(LookupFilter::hashOf(account->getAccountNumber()));
+        maintainLookupFilters();
+        auto client = clients_by_id.find(account->getClientId());
+        if (client != clients_by_id.end()) {
+            client_accounts.link(client->second, slot);
+        }
+        commitVersions({ account.get() });
+        emitChange(ChangeEvent::ACCOUNT_OPENED, *account, std::string(), account->getBalance());
         std::cout << "Account " << account->getAccountNumber() << " added to bank. Total accounts in bank: " << getAccountCount() << std::endl;
     }
 
+    void Bank::importEntities(const std::vector<std::shared_ptr<Client>>& clients, const std::vector<std::shared_ptr<Account>>& accounts,
+        std::vector<size_t>& rejected_clients, std::vector<size_t>& rejected_accounts) {
+        WriteLock lock(*this);
+        clients_by_id.reserve(clients_by_id.size() + clients.size());
+        client_table.reserve(client_table.size() + clients.size());
+        client_index.reserve(client_index.size() + clients.size());
+        for (size_t i = 0; i < clients.size(); ++i) {
+            const auto& client = clients[i];
+            uint32_t slot = static_cast<uint32_t>(client_table.size());
+            if (!clients_by_id.emplace(client->getId(), slot).second) {
+                rejected_clients.push_back(i);
+                continue;
+            }
+            client_table.push_back(client);
+            client_filter.add(LookupFilter::hashOf(static_cast<uint64_t>(client->getId())));
+            client_index.add(client->getId(), client->getSurname(), client->getAddress(), client->getRegistrationDate());
+        }
+
+        //      -    
+        accounts_by_number.reserve(accounts_by_number.size() + accounts.size());
+        account_table.reserve(account_table.size() + accounts.size());
+        ledger.reserveAccounts(accounts.size());
+        std::vector<Ledger::Leg> opening;
+        std::vector<Account*> opened;
+        opened.reserve(accounts.size());
+        int64_t total = 0;
+        for (size_t i = 0; i < accounts.size(); ++i) {
+            const auto& account = accounts[i];
+            auto client = clients_by_id.find(account->getClientId());
+            if (client == clients_by_id.end()) {
+                rejected_accounts.push_back(i);
+                continue;
+            }
+            uint32_t slot = static_cast<uint32_t>(account_table.size());
+            auto inserted = accounts_by_number.emplace(account->getAccountNumber(), slot);
+            if (!inserted.second) {
+                rejected_accounts.push_back(i);
+                continue;
+            }
+            account_table.push_back(account);
+            account_filter.add(LookupFilter::hashOf(inserted.first->first));
+            client_accounts.link(client->second, slot);
+            uint32_t ledger_account = ledger.accountIndex(inserted.first->first);
+            int64_t cents = Ledger::toCents(account->getBalance());
+            if (cents > 0) {
+                opening.push_back(Ledger::Leg{ ledger_account, cents, Ledger::PRINCIPAL });
+                total += cents;
+            }
+            opened.push_back(account.get());
+        }
+        if (!opening.empty()) {
+            opening.push_back(Ledger::Leg{ Ledger::CASH, -total, Ledger::PRINCIPAL });
+            ledger.post(Ledger::OPEN, opening.data(), opening.size());
+        }
+        maintainLookupFilters(); //      ,     
+        commitVersions(opened.data(), opened.size());
+        if (change_feed) {
+            for (Account* account : opened) {
+                emitChange(ChangeEvent::ACCOUNT_OPENED, *account, std::string(), account->getBalance());
+            }
+        }
+        std::cout << "Imported clients: " << clients.size() - rejected_clients.size() << ", accounts: " << opened.size()
+            << ". Total clients in bank: " << clients_by_id.size() << ", accounts: " << accounts_by_number.size() << std::endl;
+    }
+
     //     
     void Bank::transfer(const std::string& accountNumber_from, const std::string& accountNumber_to, double amount) {
-        if (amount <= 0) {
+        //    : tryTransfer     
+        switch (tryTransfer(accountNumber_from, accountNumber_to, amount)) {
+        case BankStatus::Ok:
+            return;
+        case BankStatus::InvalidAmount:
             throw std::invalid_argument("Transfer amount must be positive");
+        case BankStatus::SameAccount:
+            throw std::invalid_argument("Cannot transfer to the same account");
+        case BankStatus::SourceNotFound:
+            throw std::invalid_argument("Source account not found: " + accountNumber_from);
+        case BankStatus::DestinationNotFound:
+            throw std::invalid_argument("Destination account not found: " + accountNumber_to);
+        case BankStatus::InsufficientFunds:
+            throw std::runtime_error("Insufficient funds in account: " + accountNumber_from);
+        case BankStatus::VelocityLimitExceeded:
+            throw std::runtime_error("Velocity limit exceeded for account: " + accountNumber_from);
+        case BankStatus::CurrencyNotSupported:
+            throw std::runtime_error("No exchange rate for transfer from " + accountNumber_from + " to " + accountNumber_to);
+        default:
+            throw std::runtime_error("Transfer failed. No changes were applied to the accounts.");
+        }
+    }
+
+    BankStatus Bank::tryTransfer(const std::string& accountNumber_from, const std::string& accountNumber_to, double amount) {
+        BANK_METRIC_SCOPE(TRANSFER);
+        BANK_METRIC_START(phase);
+        if (amount <= 0) {
+            return BankStatus::InvalidAmount;
         }
         if (accountNumber_from == accountNumber_to) {
-            throw std::invalid_argument("Cannot transfer to the same account");
+            return BankStatus::SameAccount;
         }
+        //    ,    
+        if (!account_filter.mayContain(LookupFilter::hashOf(accountNumber_from))) {
+            BANK_METRIC_COUNT(LOOKUP_FILTER_REJECTED);
+            return BankStatus::SourceNotFound;
+        }
+        if (!account_filter.mayContain(LookupFilter::hashOf(accountNumber_to))) {
+            BANK_METRIC_COUNT(LOOKUP_FILTER_REJECTED);
+            return BankStatus::DestinationNotFound;
+        }
+        WriteLock lock(*this);
+        BANK_METRIC_LAP(phase, LOCK_WAIT);
 
         std::shared_ptr<Account> client1 = find_acc_by_number(accountNumber_from);
         std::shared_ptr<Account> client2 = find_acc_by_number(accountNumber_to);
+        BANK_METRIC_LAP(phase, TRANSFER_LOOKUP);
 
         if (!client1) {
-            throw std::invalid_argument("Source account not found: " + accountNumber_from);
+            return BankStatus::SourceNotFound;
         }
         if (!client2) {
-            throw std::invalid_argument("Destination account not found: " + accountNumber_to);
+            return BankStatus::DestinationNotFound;
+        }
+        bool allowed = velocityAllows(*client1, amount);
+        BANK_METRIC_LAP(phase, VELOCITY_CHECK);
+        if (!allowed) {
+            BANK_METRIC_COUNT(VELOCITY_BLOCKED);
+            std::cout << "Transfer blocked: velocity limit exceeded for account " << accountNumber_from << std::endl;
+            return BankStatus::VelocityLimitExceeded;
         }
 
-        if (client1->withdraw(amount)) { //    (true)
-            //    -  
-            try {
-                client2->deposit(amount);
-                auto transaction1 = Transaction::createTransaction("TRANSFER_OUT", amount, accountNumber_from, accountNumber_to); //    
-                addTransaction_in_bank(transaction1); //   
-                client1->addTransaction_in_account(transaction1); //   
-                auto transaction2 = Transaction::createTransaction("TRANSFER_IN", amount, accountNumber_from, accountNumber_to); //    
-                addTransaction_in_bank(transaction2); //   
-                client2->addTransaction_in_account(transaction2); //   
-                std::cout << "Transfer completed successfully!" << std::endl;
+        //    :       ( )
+        double credited = amount;
+        uint64_t fx_version = 0;
+        std::optional<FxRateTable::Reader> rates; //      
+        if (client1->getCurrency() != client2->getCurrency()) {
+            rates.emplace(fx_rates);
+            double rate = 0;
+            if (!(*rates)->crossRate(client1->getCurrency(), client2->getCurrency(), rate)) {
+                return BankStatus::CurrencyNotSupported;
             }
-            catch (const std::exception& e) {
-                //     -   
-                client1->deposit(amount); //   
-                throw std::runtime_error("Transfer failed during deposit: " + std::string(e.what()) + ". Funds returned to source account.");
+            credited = Ledger::fromCents(Ledger::toCents(amount * rate));
+            fx_version = (*rates)->getVersion();
+            if (!(credited > 0)) {
+                return BankStatus::InvalidAmount; //    
             }
         }
+
+        //    -  :          
+        transfer_posting.debit(client1, amount, "TRANSFER_OUT", accountNumber_to);
+        transfer_posting.credit(client2, credited, "TRANSFER_IN", accountNumber_from);
+        transfer_posting.setConversion(fx_version);
+        BankStatus status = applyPosting(transfer_posting, rates ? &**rates : nullptr);
+        transfer_posting.clear();
+        if (status == BankStatus::Ok) {
+            recordVelocity(*client1, amount);
+            std::cout << "Transfer completed successfully!" << std::endl;
+        }
         else {
-            throw std::runtime_error("Insufficient funds in account: " + accountNumber_from);;
+            BANK_METRIC_COUNT(TRANSFER_DECLINED);
+        }
+        return status;
+    }
+
+    BankStatus Bank::tryTransferWithFee(const std::string& accountNumber_from, const std::string& accountNumber_to, double amount, double fee, const std::string& feeAccountNumber) {
+        WriteLock lock(*this);
+        if (amount <= 0 || fee < 0) {
+            return BankStatus::InvalidAmount;
+        }
+        if (accountNumber_from == accountNumber_to || accountNumber_from == feeAccountNumber) {
+            return BankStatus::SameAccount;
+        }
+        std::shared_ptr<Account> client1 = find_acc_by_number(accountNumber_from);
+        std::shared_ptr<Account> client2 = find_acc_by_number(accountNumber_to);
+        std::shared_ptr<Account> fee_account = find_acc_by_number(feeAccountNumber);
+        if (!client1) {
+            return BankStatus::SourceNotFound;
+        }
+        if (!client2) {
+            return BankStatus::DestinationNotFound;
+        }
+        if (!fee_account) {
+            return BankStatus::AccountNotFound;
+        }
+        if (client1->getCurrency() != client2->getCurrency() || client1->getCurrency() != fee_account->getCurrency()) {
+            return BankStatus::CurrencyMismatch; //     
         }
+
+        Posting posting;
+        posting.debit(client1, amount, "TRANSFER_OUT", accountNumber_to);
+        posting.credit(client2, amount, "TRANSFER_IN", accountNumber_from);
+        if (fee > 0) {
+            // -    ,     
+            double charged = fee;
+            auto premium = std::dynamic_pointer_cast<PremiumClient>(find_client_by_id(client1->getClientId()));
+            if (premium) {
+                premium->applyDiscount(charged);
+                charged = Ledger::fromCents(Ledger::toCents(charged));
+                posting.addDiscount(fee - charged);
+            }
+            posting.debit(client1, charged, "FEE", feeAccountNumber);
+            posting.credit(fee_account, fee, "FEE", accountNumber_from);
+        }
+        if (!velocityAllows(posting)) {
+            BANK_METRIC_COUNT(VELOCITY_BLOCKED);
+            std::cout << "Transfer blocked: velocity limit exceeded for account " << accountNumber_from << std::endl;
+            return BankStatus::VelocityLimitExceeded;
+        }
+        BankStatus status = applyPosting(posting);
+        if (status == BankStatus::Ok) {
+            recordVelocity(posting);
+        }
+        return status;
     }
 
-    void Bank::registerDeposit(std::shared_ptr<Account> account, double amount) {
+    // : 1) undo record    , 2)   (   ),
+    // 3)     ,   ,   
+    BankStatus Bank::post(const Posting& posting) {
+        WriteLock lock(*this);
+        const auto& legs = posting.getLegs();
+        if (legs.empty()) {
+            return BankStatus::InvalidAmount;
+        }
+        for (const auto& leg : legs) {
+            if (!(leg.amount > 0)) {
+                return BankStatus::InvalidAmount;
+            }
+            if (!leg.account) {
+                return BankStatus::AccountNotFound;
+            }
+            if (!ownsAccount(*leg.account)) {
+                return BankStatus::AccountNotFound; //     
+            }
+            //   -       
+            if (posting.isConversion() || leg.account->getCurrency() != legs[0].account->getCurrency()) {
+                return BankStatus::CurrencyMismatch;
+            }
+        }
+        if (!velocityAllows(posting)) {
+            BANK_METRIC_COUNT(VELOCITY_BLOCKED);
+            return BankStatus::VelocityLimitExceeded;
+        }
+        BankStatus status = applyPosting(posting);
+        if (status == BankStatus::Ok) {
+            recordVelocity(posting);
+        }
+        return status;
+    }
+
+    //    :        
+    //        
+    bool Bank::conversionBalanced(const Posting& posting, const FxRates& rates) {
+        if (rates.getVersion() != posting.getFxVersion()) {
+            return false;
+        }
+        double value = 0;
+        double volume = 0;
+        double tolerance = 0;
+        for (const auto& leg : posting.getLegs()) {
+            double rate = 0;
+            if (!rates.rateOf(leg.account->getCurrency(), rate)) {
+                return false;
+            }
+            value += (leg.debit ? leg.amount : -leg.amount) * rate;
+            volume += leg.amount * rate;
+            tolerance += 0.005 * rate;
+        }
+        return std::abs(value) <= tolerance + volume * 1e-12;
+    }
+
+    //   :  ,   
+    BankStatus Bank::applyPosting(const Posting& posting, const FxRates* rates) {
+        BANK_METRIC_START(phase);
+        const auto& legs = posting.getLegs();
+        if (posting.isConversion() && (rates == nullptr || !conversionBalanced(posting, *rates))) {
+            return BankStatus::CurrencyMismatch;
+        }
+        undo_log.clear();
+        posted_accounts.clear();
+        for (const auto& leg : legs) {
+            if (std::find(posted_accounts.begin(), posted_accounts.end(), leg.account.get()) == posted_accounts.end()) {
+                posted_accounts.push_back(leg.account.get());
+                undo_log.push_back(UndoRecord{ leg.account.get(), AccountState() });
+                leg.account->saveState(undo_log.back().state);
+            }
+        }
+
+        BankStatus status = BankStatus::Ok;
+        size_t history_mark = all_banking_transactions.size();
+        ledger_legs.clear();
+        fx_legs.clear();
+        try {
+            for (const auto& leg : legs) {
+                Ledger::LegKind kind = std::strcmp(leg.type, "FEE") == 0 ? Ledger::COMMISSION : Ledger::PRINCIPAL;
+                if (!leg.debit) {
+                    leg.account->deposit(leg.amount);
+                    addCreditLegs(*leg.account, leg.amount, kind);
+                }
+                else if (!leg.account->withdraw(leg.amount)) {
+                    status = BankStatus::InsufficientFunds;
+                    break;
+                }
+                else {
+                    addDebitLegs(*leg.account, leg.amount, kind); //      
+                }
+                if (posting.isConversion()) {
+                    //        :     
+                    int64_t cents = Ledger::toCents(leg.amount);
+                    uint32_t position = fxPositionIndex(leg.account->getCurrency());
+                    auto same = std::find_if(fx_legs.begin(), fx_legs.end(), [&](const Ledger::Leg& fx) { return fx.account == position && fx.kind == kind; });
+                    if (same == fx_legs.end()) {
+                        fx_legs.push_back(Ledger::Leg{ position, 0, kind });
+                        same = fx_legs.end() - 1;
+                    }
+                    same->amount += leg.debit ? cents : -cents;
+                }
+            }
+            for (const auto& fx : fx_legs) {
+                if (fx.amount != 0) {
+                    ledger_legs.push_back(fx);
+                }
+            }
+            BANK_METRIC_LAP(phase, POSTING_APPLY);
+            //     ,  - :     
+            if (status == BankStatus::Ok) {
+                for (const auto& leg : legs) {
+                    const std::string& number = leg.account->getAccountNumber();
+                    if (leg.counterpart == " ") {
+                        all_banking_transactions.emplace_back(leg.type, leg.amount, number);
+                    }
+                    else if (leg.debit) {
+                        all_banking_transactions.emplace_back(leg.type, leg.amount, number, leg.counterpart);
+                    }
+                    else {
+                        all_banking_transactions.emplace_back(leg.type, leg.amount, leg.counterpart, number);
+                    }
+                    all_banking_transactions.back().setFxVersion(posting.getFxVersion());
+                }
+            }
+            BANK_METRIC_LAP(phase, POSTING_HISTORY);
+            //    -  ,    (,  )
+            if (status == BankStatus::Ok) {
+                if (posting.getDiscount() > 0) {
+                    ledger_legs.push_back(Ledger::Leg{ Ledger::DISCOUNT_EXPENSE, -Ledger::toCents(posting.getDiscount()), Ledger::DISCOUNT });
+                }
+                ledger.post(Ledger::TRANSFER, ledger_legs.data(), ledger_legs.size());
+                BANK_METRIC_LAP(phase, POSTING_LEDGER);
+            }
+        }
+        catch (const std::exception&) {
+            status = BankStatus::OperationFailed;
+        }
+        if (status != BankStatus::Ok) {
+            BANK_METRIC_COUNT(POSTING_ROLLBACK);
+            while (all_banking_transactions.size() > history_mark) {
+                all_banking_transactions.pop_back();
+            }
+            for (auto it = undo_log.rbegin(); it != undo_log.rend(); ++it) {
+                it->account->restoreState(it->state);
+            }
+            return status;
+        }
+
+        for (size_t i = 0; i < legs.size(); ++i) {
+            linkTransaction(*legs[i].account, history_mark + i);
+        }
+        commitVersions(posted_accounts.data(), posted_accounts.size()); //      
+
+        if (change_feed) {
+            static const std::string none;
+            for (const auto& leg : legs) {
+                ChangeEvent::Kind kind = leg.debit ? ChangeEvent::WITHDRAW : ChangeEvent::DEPOSIT;
+                if (std::strcmp(leg.type, "TRANSFER_OUT") == 0) {
+                    kind = ChangeEvent::TRANSFER_OUT;
+                }
+                else if (std::strcmp(leg.type, "TRANSFER_IN") == 0) {
+                    kind = ChangeEvent::TRANSFER_IN;
+                }
+                emitChange(kind, *leg.account, leg.counterpart == " " ? none : leg.counterpart, leg.amount);
+            }
+        }
+        BANK_METRIC_LAP(phase, POSTING_PUBLISH);
+        return BankStatus::Ok;
+    }
+
+    void Bank::registerDeposit(const std::shared_ptr<Account>& account, double amount) {
+        BANK_METRIC_SCOPE(DEPOSIT);
+        WriteLock lock(*this);
+        requireOwnedAccount(account);
         account->deposit(amount); // deposit  Account
-        auto transaction = Transaction::createTransaction("DEPOSIT", amount, account->getAccountNumber()); //    
-        addTransaction_in_bank(transaction);
-        account->addTransaction_in_account(transaction);
+        ledger_legs.clear();
+        ledger_legs.push_back(Ledger::Leg{ Ledger::CASH, -Ledger::toCents(amount), Ledger::PRINCIPAL });
+        addCreditLegs(*account, amount, Ledger::PRINCIPAL);
+        ledger.post(Ledger::DEPOSIT, ledger_legs.data(), ledger_legs.size());
+        all_banking_transactions.emplace_back("DEPOSIT", amount, account->getAccountNumber());
+        linkTransaction(*account, all_banking_transactions.size() - 1);
+        commitVersions({ account.get() });
+        emitChange(ChangeEvent::DEPOSIT, *account, std::string(), amount);
+    }
+
+    bool Bank::registerWithdraw(const std::shared_ptr<Account>& account, double amount) {
+        return applyWithdraw(account, amount) == BankStatus::Ok;
     }
 
-    void Bank::registerWithdraw(std::shared_ptr<Account> account, double amount) {
+    BankStatus Bank::applyWithdraw(const std::shared_ptr<Account>& account, double amount) {
+        BANK_METRIC_SCOPE(WITHDRAW);
+        WriteLock lock(*this);
+        requireOwnedAccount(account);
+        if (!velocityAllows(*account, amount)) {
+            BANK_METRIC_COUNT(VELOCITY_BLOCKED);
+            std::cout << "Withdrawal blocked: velocity limit exceeded for account " << account->getAccountNumber() << std::endl;
+            return BankStatus::VelocityLimitExceeded;
+        }
         if (account->withdraw(amount)) { // withdraw  Account
+            ledger_legs.clear();
+            addDebitLegs(*account, amount, Ledger::PRINCIPAL);
+            ledger_legs.push_back(Ledger::Leg{ Ledger::CASH, Ledger::toCents(amount), Ledger::PRINCIPAL });
+            ledger.post(Ledger::WITHDRAW, ledger_legs.data(), ledger_legs.size());
             std::cout << "Withdrawal successful! Amount: " << amount << ", New balance: " << account->getBalance() << std::endl;
-            auto transaction = Transaction::createTransaction("WITHDRAW", amount, account->getAccountNumber()); //    
-            addTransaction_in_bank(transaction);
-            account->addTransaction_in_account(transaction);
+            all_banking_transactions.emplace_back("WITHDRAW", amount, account->getAccountNumber());
+            linkTransaction(*account, all_banking_transactions.size() - 1);
+            commitVersions({ account.get() });
+            emitChange(ChangeEvent::WITHDRAW, *account, std::string(), amount);
+            recordVelocity(*account, amount);
+            return BankStatus::Ok;
+        }
+        BANK_METRIC_COUNT(WITHDRAW_DECLINED);
+        return BankStatus::InsufficientFunds;
+    }
+
+    BankStatus Bank::tryDeposit(const std::shared_ptr<Account>& account, double amount) {
+        if (!account) {
+            return BankStatus::AccountNotFound;
+        }
+        if (amount <= 0) {
+            return BankStatus::InvalidAmount;
+        }
+        WriteLock lock(*this);
+        if (!ownsAccount(*account)) {
+            return BankStatus::AccountNotFound; //      
         }
+        registerDeposit(account, amount);
+        return BankStatus::Ok;
+    }
+
+    BankStatus Bank::tryWithdraw(const std::shared_ptr<Account>& account, double amount) {
+        if (!account) {
+            return BankStatus::AccountNotFound;
+        }
+        if (amount <= 0) {
+            return BankStatus::InvalidAmount;
+        }
+        WriteLock lock(*this);
+        if (!ownsAccount(*account)) {
+            return BankStatus::AccountNotFound; //      
+        }
+        return applyWithdraw(account, amount);
+    }
+
+    //   :       ()
+    bool Bank::registerTransferOut(const std::shared_ptr<Account>& account, const std::string& accountNumber_to, double amount) {
+        WriteLock lock(*this);
+        requireOwnedAccount(account);
+        if (!velocityAllows(*account, amount) || !account->withdraw(amount)) {
+            return false;
+        }
+        recordVelocity(*account, amount);
+        ledger_legs.clear();
+        addDebitLegs(*account, amount, Ledger::PRINCIPAL);
+        ledger_legs.push_back(Ledger::Leg{ Ledger::TRANSIT, Ledger::toCents(amount), Ledger::PRINCIPAL });
+        ledger.post(Ledger::TRANSFER_OUT, ledger_legs.data(), ledger_legs.size());
+        all_banking_transactions.emplace_back("TRANSFER_OUT", amount, account->getAccountNumber(), accountNumber_to);
+        linkTransaction(*account, all_banking_transactions.size() - 1);
+        commitVersions({ account.get() });
+        emitChange(ChangeEvent::TRANSFER_OUT, *account, accountNumber_to, amount);
+        return true;
+    }
+
+    //   :       ()
+    void Bank::registerTransferIn(const std::shared_ptr<Account>& account, const std::string& accountNumber_from, double amount) {
+        WriteLock lock(*this);
+        requireOwnedAccount(account);
+        account->deposit(amount);
+        ledger_legs.clear();
+        ledger_legs.push_back(Ledger::Leg{ Ledger::TRANSIT, -Ledger::toCents(amount), Ledger::PRINCIPAL });
+        addCreditLegs(*account, amount, Ledger::PRINCIPAL);
+        ledger.post(Ledger::TRANSFER_IN, ledger_legs.data(), ledger_legs.size());
+        all_banking_transactions.emplace_back("TRANSFER_IN", amount, accountNumber_from, account->getAccountNumber());
+        linkTransaction(*account, all_banking_transactions.size() - 1);
+        commitVersions({ account.get() });
+        emitChange(ChangeEvent::TRANSFER_IN, *account, accountNumber_from, amount);
+    }
+
+    //      :      
+    bool Bank::runIdempotent(const std::string& idempotency_key, const IdempotencyCache::Request& request, const std::function<bool()>& operation) {
+        if (idempotency_key.empty()) {
+            return operation();
+        }
+        IdempotencyCache::Result result;
+        switch (idempotency_cache.lookupOrReserve(idempotency_key, request, result)) {
+        case IdempotencyCache::Lookup::Completed:
+            if (result.error) {
+                std::rethrow_exception(result.error);
+            }
+            return result.success;
+        case IdempotencyCache::Lookup::InProgress:
+            throw std::runtime_error("Request " + idempotency_key + " is already in progress");
+        case IdempotencyCache::Lookup::Mismatch:
+            throw std::invalid_argument("Idempotency key " + idempotency_key + " was already used for a different request");
+        case IdempotencyCache::Lookup::Reserved:
+            break;
+        }
+        try {
+            result.success = operation();
+        }
+        catch (...) {
+            result.success = false;
+            result.error = std::current_exception();
+            idempotency_cache.complete(idempotency_key, result);
+            throw;
+        }
+        idempotency_cache.complete(idempotency_key, result);
+        return result.success;
+    }
+
+    void Bank::transfer(const std::string& accountNumber_from, const std::string& accountNumber_to, double amount, const std::string& idempotency_key) {
+        IdempotencyCache::Request request{ IdempotencyCache::Request::Operation::Transfer, accountNumber_from, accountNumber_to, Ledger::toCents(amount) };
+        runIdempotent(idempotency_key, request, [&]() {
+            transfer(accountNumber_from, accountNumber_to, amount);
+            return true;
+        });
+    }
+
+    void Bank::registerDeposit(const std::shared_ptr<Account>& account, double amount, const std::string& idempotency_key) {
+        IdempotencyCache::Request request{ IdempotencyCache::Request::Operation::Deposit, std::string(), account ? account->getAccountNumber() : std::string(), Ledger::toCents(amount) };
+        runIdempotent(idempotency_key, request, [&]() {
+            registerDeposit(account, amount);
+            return true;
+        });
+    }
+
+    bool Bank::registerWithdraw(const std::shared_ptr<Account>& account, double amount, const std::string& idempotency_key) {
+        IdempotencyCache::Request request{ IdempotencyCache::Request::Operation::Withdraw, account ? account->getAccountNumber() : std::string(), std::string(), Ledger::toCents(amount) };
+        return runIdempotent(idempotency_key, request, [&]() {
+            return registerWithdraw(account, amount);
+        });
+    }
+
+    //  :       
+    size_t Bank::transfer_batch(const std::vector<TransferOrder>& orders, std::vector<size_t>& failed) {
+        BANK_METRIC_SCOPE(TRANSFER_BATCH);
+        size_t completed = 0;
+        std::string from;
+        std::string to;
+        for (size_t i = 0; i < orders.size(); ++i) {
+            from.assign(orders[i].from);
+            to.assign(orders[i].to);
+            if (tryTransfer(from, to, orders[i].amount) == BankStatus::Ok) {
+                ++completed;
+            }
+            else {
+                failed.push_back(i);
+            }
+        }
+        return completed;
     }
 
     //  
-    void Bank::addTransaction_in_bank(std::shared_ptr<Transaction> transaction) {
-        all_banking_transactions.push_back(transaction);
+    void Bank::addTransaction_in_bank(const std::shared_ptr<Transaction>& transaction) {
+        WriteLock lock(*this);
+        all_banking_transactions.push_back(*transaction);
         std::cout << "Transaction " << transaction->getType() << ", summa: " << transaction->getSumma() << " added to bank. Total transactions in bank: " << all_banking_transactions.size() << std::endl;
     }
 
+    size_t Bank::getTransactionCount() {
+        WriteLock lock(*this);
+        return all_banking_transactions.size();
+    }
+
+    uint32_t Bank::account_slot(const Account& account) {
+        return accounts_by_number.at(account.getAccountNumber());
+    }
+
+    bool Bank::ownsAccount(const Account& account) {
+        auto it = accounts_by_number.find(account.getAccountNumber());
+        return it != accounts_by_number.end() && account_table[it->second].get() == &account;
+    }
+
+    //             
+    void Bank::requireOwnedAccount(const std::shared_ptr<Account>& account) {
+        if (!account) {
+            throw std::invalid_argument("Account cannot be null");
+        }
+        if (!ownsAccount(*account)) {
+            throw std::invalid_argument("Account " + account->getAccountNumber() + " does not belong to this bank");
+        }
+    }
+
+    //    (    )   ,       
+    void Bank::linkTransaction(const Account& account, size_t transaction) {
+        auto it = accounts_by_number.find(account.getAccountNumber());
+        if (it != accounts_by_number.end() && account_table[it->second].get() == &account) {
+            account_transactions.link(it->second, static_cast<uint32_t>(transaction));
+        }
+        const Transaction& record = all_banking_transactions[transaction];
+        std::cout << "Transaction " << record.getType() << ", summa: " << record.getSumma() << " added to account " << account.getAccountNumber()
+            << ". Total transactions in bank: " << all_banking_transactions.size() << std::endl;
+    }
+
+    std::vector<std::shared_ptr<Account>> Bank::get_client_accounts(int client_id) {
+        WriteLock lock(*this);
+        std::vector<std::shared_ptr<Account>> result;
+        auto it = clients_by_id.find(client_id);
+        if (it == clients_by_id.end()) {
+            return result;
+        }
+        result.reserve(client_accounts.countOf(it->second));
+        for (uint32_t slot = client_accounts.first(it->second); slot != Adjacency::NONE; slot = client_accounts.following(slot)) {
+            result.push_back(account_table[slot]);
+        }
+        return result;
+    }
+
+    std::vector<const Transaction*> Bank::get_account_transactions(const std::string& accountNumber) {
+        WriteLock lock(*this);
+        std::vector<const Transaction*> result;
+        auto it = accounts_by_number.find(accountNumber);
+        if (it == accounts_by_number.end()) {
+            return result;
+        }
+        result.reserve(account_transactions.countOf(it->second));
+        for (uint32_t index = account_transactions.first(it->second); index != Adjacency::NONE; index = account_transactions.following(index)) {
+            result.push_back(&all_banking_transactions[index]);
+        }
+        return result;
+    }
+
+    void Bank::display_client_accounts(int client_id) {
+        WriteLock lock(*this);
+        auto client = find_client_by_id(client_id);
+        if (!client) {
+            std::cout << "Client not found with ID: " << client_id << std::endl;
+            return;
+        }
+        auto accounts = get_client_accounts(client_id);
+        std::cout << "\nInformation about accounts for client: " << client->getSurname() << std::endl;
+        std::cout << "Amount of accounts: " << accounts.size() << std::endl;
+        for (auto& account : accounts) {
+            account->displayinfo();
+        }
+    }
+
+    void Bank::display_account_transactions(const std::string& accountNumber) {
+        WriteLock lock(*this);
+        auto it = accounts_by_number.find(accountNumber);
+        if (it == accounts_by_number.end()) {
+            std::cout << "Account not found: " << accountNumber << std::endl;
+            return;
+        }
+        std::cout << "\nInformation about transactions for account: " << accountNumber << std::endl;
+        std::cout << "Amount of transactions: " << account_transactions.countOf(it->second) << std::endl;
+        for (uint32_t index = account_transactions.first(it->second); index != Adjacency::NONE; index = account_transactions.following(index)) {
+            all_banking_transactions[index].displayinfo();
+        }
+    }
+
     size_t Bank::getClientsCount() {
-        return all_clients.size();
+        WriteLock lock(*this);
+        return clients_by_id.size();
     }
 
     size_t Bank::getAccountCount() {
-        return all_accounts.size();
+        WriteLock lock(*this);
+        return accounts_by_number.size();
     }
 
     void Bank::display_all_clients_in_bank() {
+        WriteLock lock(*this);
         std::cout << "\nInformation about ALL clients IN BANK: " << std::endl;
         std::cout << "Amount of clients: " << getClientsCount() << std::endl;
-        for (auto& client : all_clients) {
-            client->displayinfo();
+        for (uint32_t slot = 0; slot < client_table.size(); ++slot) {
+            if (client_table[slot]) {
+                client_table[slot]->displayinfo();
+                std::cout << "Amount of accounts: " << client_accounts.countOf(slot) << std::endl;
+            }
         }
     }
 
     void Bank::display_all_accounts_in_bank() {
+        WriteLock lock(*this);
         std::cout << "\nInformation about ALL accounts IN BANK: " << std::endl;
         std::cout << "Amount of account: " << getAccountCount() << std::endl;
-        for (auto& account : all_accounts) {
-            account->displayinfo();
+        for (auto& account : account_table) {
+            if (account) {
+                account->displayinfo();
+            }
         }
     }
 
     void Bank::displayinfo_about_transactions_in_bank() {
+        WriteLock lock(*this);
         std::cout << "\nInformation about ALL transactions IN BANK: " << std::endl;
         std::cout << "Amount of transactions: " << all_banking_transactions.size() << std::endl;
         for (auto& transaction : all_banking_transactions) {
-            transaction->displayinfo();
+            transaction.displayinfo();
         }
     }
 
     //  
     bool Bank::deleteAccount(const std::string& accountNumber) {
+        WriteLock lock(*this);
         auto account = find_acc_by_number(accountNumber);
         if (!account) {
             std::cout << "Account not found: " << accountNumber << std::endl;
@@ -209,44 +992,540 @@ namespace Banking {
             std::cout << "Cannot delete account " << accountNumber << ". Balance must be zero." << std::endl;
             return false;
         }
-        //    
-        for (auto it = all_accounts.begin(); it != all_accounts.end(); ++it) {
-            if ((*it)->getAccountNumber() == accountNumber) {
-                all_accounts.erase(it);
-                std::cout << "Account " << accountNumber << " successfully deleted." << std::endl;
-                return true;
-            }
+        //    :    ,      
+        uint32_t slot = account_slot(*account);
+        client_accounts.unlink(slot);
+        account_transactions.unlinkAll(slot);
+        account_groups.remove(slot);
+        account_table[slot] = nullptr;
+        free_account_slots.push_back(slot);
+        accounts_by_number.erase(accountNumber);
+        account_filter.remove();
+        maintainLookupFilters();
+        emitChange(ChangeEvent::ACCOUNT_CLOSED, *account, std::string(), 0);
+        std::cout << "Account " << accountNumber << " successfully deleted." << std::endl;
+        return true;
+    }
+
+    std::vector<std::shared_ptr<Client>> Bank::clients_by_ids(const std::vector<int>& ids) {
+        std::vector<std::shared_ptr<Client>> result;
+        result.reserve(ids.size());
+        for (int id : ids) {
+            result.push_back(client_table[clients_by_id.at(id)]);
         }
-        return false;
+        return result;
+    }
+
+    std::vector<std::shared_ptr<Client>> Bank::find_clients_by_surname_prefix(const std::string& prefix, size_t limit) {
+        WriteLock lock(*this);
+        return clients_by_ids(client_index.findBySurnamePrefix(prefix, limit));
+    }
+
+    std::vector<std::shared_ptr<Client>> Bank::find_clients_by_city(const std::string& city, size_t limit) {
+        WriteLock lock(*this);
+        return clients_by_ids(client_index.findByCity(city, limit));
+    }
+
+    std::vector<std::shared_ptr<Client>> Bank::find_clients_by_country(const std::string& country, size_t limit) {
+        WriteLock lock(*this);
+        return clients_by_ids(client_index.findByCountry(country, limit));
+    }
+
+    std::vector<std::shared_ptr<Client>> Bank::find_clients_registered_between(const Date& from, const Date& to, size_t limit) {
+        WriteLock lock(*this);
+        return clients_by_ids(client_index.findRegisteredBetween(from, to, limit));
     }
 
     //  
     bool Bank::deleteClient(int client_id) {
+        WriteLock lock(*this);
         auto client = find_client_by_id(client_id);
         if (!client) {
             std::cout << "Client not found with ID: " << client_id << std::endl;
             return false;
         }
         // ,     
-        int accountCount = 0;
-        for (const auto& account : all_accounts) {
-            if (account->getClientId() == client_id) {
-                accountCount++;
-            }
-        }
+        uint32_t slot = clients_by_id.at(client_id);
+        uint32_t accountCount = client_accounts.countOf(slot);
         if (accountCount > 0) {
             std::cout << "Cannot delete client " << client_id << ". Client has " << accountCount << " active accounts." << std::endl;
             return false;
         }
         //  
-        for (auto it = all_clients.begin(); it != all_clients.end(); ++it) {
-            if ((*it)->getId () == client_id) {
-                all_clients.erase(it);
-                std::cout << "Client " << client_id << " successfully deleted." << std::endl;
-                return true;
+        client_table[slot] = nullptr;
+        free_client_slots.push_back(slot);
+        clients_by_id.erase(client_id);
+        client_filter.remove();
+        maintainLookupFilters();
+        client_index.remove(client_id);
+        account_groups.removeClient(client_id);
+        std::cout << "Client " << client_id << " successfully deleted." << std::endl;
+        return true;
+    }
+
+    //    :   ,    ,     
+    void Bank::addDebitLegs(Account& account, double amount, Ledger::LegKind kind) {
+        uint32_t index = ledger.accountIndex(account.getAccountNumber());
+        ledger_legs.push_back(Ledger::Leg{ index, -Ledger::toCents(amount), kind });
+        int64_t commission = Ledger::toCents(account.getCommission());
+        if (commission > 0) {
+            ledger_legs.push_back(Ledger::Leg{ index, -commission, Ledger::COMMISSION });
+            ledger_legs.push_back(Ledger::Leg{ Ledger::COMMISSION_INCOME, commission, Ledger::COMMISSION });
+        }
+    }
+
+    void Bank::addCreditLegs(Account& account, double amount, Ledger::LegKind kind) {
+        ledger_legs.push_back(Ledger::Leg{ ledger.accountIndex(account.getAccountNumber()), Ledger::toCents(amount), kind });
+    }
+
+    uint32_t Bank::fxPositionIndex(const std::string& currency) {
+        return ledger.accountIndex("@FX-" + currency); //   (SSO) -   
+    }
+
+    std::vector<AccountBalance> Bank::trial_balance() {
+        WriteLock lock(*this);
+        std::vector<int64_t> totals = ledger.trialBalance();
+        std::vector<AccountBalance> result;
+        result.reserve(totals.size());
+        for (size_t i = 0; i < totals.size(); ++i) {
+            result.emplace_back(ledger.getAccountName(static_cast<uint32_t>(i)), Ledger::fromCents(totals[i]));
+        }
+        return result;
+    }
+
+    void Bank::display_trial_balance() {
+        WriteLock lock(*this);
+        std::cout << "\nTrial balance (double-entry ledger): " << std::endl;
+        for (const auto& item : trial_balance()) {
+            std::cout << item.accountNumber << ": " << item.balance << std::endl;
+        }
+        int64_t total = ledger.totalOfAllEntries();
+        std::cout << "Postings: " << ledger.getPostingCount() << ", legs: " << ledger.getEntryCount()
+            << ", total: " << Ledger::fromCents(total) << (total == 0 ? " (balanced)" : " (NOT BALANCED)") << std::endl;
+    }
+
+    StatementSummary Bank::write_statement(const std::string& accountNumber, std::time_t from, std::time_t to, std::ostream& out) {
+        WriteLock lock(*this);
+        uint32_t account = 0;
+        if (!ledger.findAccount(accountNumber, account)) {
+            throw std::invalid_argument("Account not found: " + accountNumber);
+        }
+        StatementSink sink(out);
+        return StatementEngine(ledger).write(account, from, to, sink);
+    }
+
+    void Bank::display_statement(const std::string& accountNumber, int year, int month) {
+        write_statement(accountNumber, StatementEngine::monthStart(year, month), StatementEngine::monthStart(year, month + 1), std::cout);
+    }
+
+    size_t Bank::write_month_end_statements(int year, int month, const std::string& path_prefix, unsigned threads) {
+        //     :       ,
+        //         
+        Ledger::Snapshot bound;
+        {
+            WriteLock lock(*this);
+            bound = ledger.snapshot();
+        }
+        return StatementEngine(ledger, bound).writeAll(StatementEngine::monthStart(year, month), StatementEngine::monthStart(year, month + 1), path_prefix, threads);
+    }
+
+    //    (      )   ,    ,    
+    const std::string& Bank::historyOwner(size_t transaction) {
+        uint32_t slot = account_transactions.ownerOf(static_cast<uint32_t>(transaction));
+        if (slot != Adjacency::NONE && account_table[slot]) {
+            return account_table[slot]->getAccountNumber();
+        }
+        const Transaction& record = all_banking_transactions[transaction];
+        return record.getType() == "TRANSFER_IN" ? record.getAcc2() : record.getAcc1();
+    }
+
+    //    ,    ;     ,
+    //        .       
+    size_t Bank::archive_transactions(std::time_t older_than, const std::string& path) {
+        WriteLock lock(*this);
+        size_t count = 0;
+        while (count < all_banking_transactions.size() && all_banking_transactions[count].getTimestamp() < older_than) {
+            ++count;
+        }
+        if (count == 0) {
+            return 0;
+        }
+        for (const auto& segment : archive) {
+            if (segment.getPath() == path) {
+                throw std::invalid_argument("Archive segment is already in use: " + path);
+            }
+        }
+        ArchiveWriter writer;
+        for (size_t i = 0; i < count; ++i) {
+            writer.add(all_banking_transactions[i], historyOwner(i));
+        }
+        archive.push_back(writer.finish(path));
+
+        Adjacency rebased;
+        for (uint32_t slot = 0; slot < account_table.size(); ++slot) {
+            for (uint32_t index = account_transactions.first(slot); index != Adjacency::NONE; index = account_transactions.following(index)) {
+                if (index >= count) {
+                    rebased.link(slot, static_cast<uint32_t>(index - count));
+                }
+            }
+        }
+        account_transactions = std::move(rebased);
+        all_banking_transactions.erase(all_banking_transactions.begin(), all_banking_transactions.begin() + count);
+        archived_transactions += count;
+        std::cout << "Archived " << count << " transactions to " << path << " (" << archive.back().getFileBytes() << " bytes)" << std::endl;
+        return count;
+    }
+
+    size_t Bank::getArchivedTransactionCount() {
+        WriteLock lock(*this);
+        return archived_transactions;
+    }
+
+    namespace {
+        TransactionView viewOf(const Transaction& record, const std::string& owner) {
+            TransactionView view;
+            view.id = record.getId();
+            view.timestamp = record.getTimestamp();
+            view.summa = record.getSumma();
+            view.fx_version = record.getFxVersion();
+            view.type = record.getType();
+            view.acc1 = record.getAcc1();
+            view.acc2 = record.getAcc2();
+            view.owner = owner;
+            return view;
+        }
+    }
+
+    size_t Bank::audit_account_history(const std::string& accountNumber, std::time_t from, std::time_t to, const TransactionVisitor& visit) {
+        WriteLock lock(*this);
+        size_t visited = 0;
+        for (const auto& segment : archive) {
+            visited += segment.scan(accountNumber, from, to, visit);
+        }
+        auto it = accounts_by_number.find(accountNumber);
+        if (it == accounts_by_number.end()) {
+            return visited;
+        }
+        for (uint32_t index = account_transactions.first(it->second); index != Adjacency::NONE; index = account_transactions.following(index)) {
+            const Transaction& record = all_banking_transactions[index];
+            if (record.getTimestamp() >= from && record.getTimestamp() < to) {
+                visit(viewOf(record, accountNumber));
+                ++visited;
+            }
+        }
+        return visited;
+    }
+
+    size_t Bank::audit_transactions(std::time_t from, std::time_t to, const TransactionVisitor& visit) {
+        WriteLock lock(*this);
+        size_t visited = 0;
+        for (const auto& segment : archive) {
+            visited += segment.scan(std::string_view(), from, to, visit);
+        }
+        for (size_t i = 0; i < all_banking_transactions.size(); ++i) {
+            const Transaction& record = all_banking_transactions[i];
+            if (record.getTimestamp() >= from && record.getTimestamp() < to) {
+                visit(viewOf(record, historyOwner(i)));
+                ++visited;
+            }
+        }
+        return visited;
+    }
+
+    void Bank::setVelocityLimits(const VelocityLimits& limits) {
+        WriteLock lock(*this);
+        velocity.setLimits(limits);
+    }
+
+    //      (  addAccount_in_bank),  accountIndex -  
+    bool Bank::velocityAllows(const Account& account, double amount) {
+        if (!velocity.isEnabled()) {
+            return true;
+        }
+        return velocity.allow(ledger.accountIndex(account.getAccountNumber()), Ledger::toCents(amount), VelocityTracker::Clock::now());
+    }
+
+    void Bank::recordVelocity(const Account& account, double amount) {
+        velocity.record(ledger.accountIndex(account.getAccountNumber()), Ledger::toCents(amount), VelocityTracker::Clock::now());
+    }
+
+    bool Bank::velocityAllows(const Posting& posting) {
+        if (!velocity.isEnabled()) {
+            return true;
+        }
+        bool allowed = true;
+        forEachDebitTotal(posting, [&](const Account& account, double total) {
+            allowed = velocityAllows(account, total);
+            return allowed;
+        });
+        return allowed;
+    }
+
+    //    :      
+    void Bank::recordVelocity(const Posting& posting) {
+        forEachDebitTotal(posting, [&](const Account& account, double total) {
+            recordVelocity(account, total);
+            return true;
+        });
+    }
+
+    void Bank::setChangeFeed(std::shared_ptr<ChangeFeed> feed) {
+        WriteLock lock(*this);
+        change_feed = std::move(feed);
+    }
+
+    //        
+    void Bank::emitChange(ChangeEvent::Kind kind, const Account& account, const std::string& counterpart, double amount) {
+        if (change_feed) {
+            pending_changes.push_back(ChangeEvent::make(kind, account.getAccountNumber(), counterpart, amount, account.getBalance(), account.getClientId()));
+            pending_count.store(pending_changes.size());
+        }
+    }
+
+    Bank::WriteLock::WriteLock(Bank& bank_value) : bank(bank_value) {
+        bank.write_mutex.lock();
+        ++bank.write_depth;
+    }
+
+    Bank::WriteLock::~WriteLock() {
+        bool outermost = --bank.write_depth == 0;
+        bank.write_mutex.unlock();
+        if (outermost && bank.pending_count.load() != 0) {
+            bank.publishChanges();
+        }
+    }
+
+    //  ,    publish_mutex, -   ,    .
+    //   ,      :     
+    // (    ).     -  .
+    void Bank::publishChanges() {
+        while (pending_count.load() != 0) {
+            std::unique_lock<std::mutex> publishing(publish_mutex, std::defer_lock);
+            if (!publishing.try_lock()) {
+                size_t limit = 0;
+                {
+                    std::lock_guard<std::recursive_mutex> lock(write_mutex); //  WriteLock:  
+                    limit = change_feed ? change_feed->getCapacity() : 0;
+                }
+                if (pending_count.load() < limit) {
+                    return;
+                }
+                publishing.lock();
+            }
+            while (true) {
+                std::shared_ptr<ChangeFeed> feed;
+                {
+                    std::lock_guard<std::recursive_mutex> lock(write_mutex); //  WriteLock:  
+                    if (pending_changes.empty()) {
+                        pending_count.store(0);
+                        break;
+                    }
+                    publishing_changes.swap(pending_changes);
+                    pending_count.store(0);
+                    feed = change_feed;
+                }
+                if (feed) {
+                    for (const ChangeEvent& event : publishing_changes) {
+                        feed->publish(event);
+                    }
+                }
+                publishing_changes.clear();
+            }
+        }
+    }
+
+    // MVCC:        
+    void Bank::commitVersions(std::initializer_list<Account*> changed) {
+        commitVersions(changed.begin(), changed.size());
+    }
+
+    void Bank::commitVersions(Account* const* changed, size_t count) {
+        uint64_t epoch = committed_epoch.load() + 1;
+
+        // ,   ,  
+        uint64_t oldest_needed = epoch - 1;
+        for (const auto& slot : snapshot_epochs) {
+            uint64_t snapshot = slot.load();
+            if (snapshot < oldest_needed) {
+                oldest_needed = snapshot;
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            changed[i]->publishBalance(epoch, oldest_needed);
+        }
+        if (!account_groups.empty()) {
+            for (size_t i = 0; i < count; ++i) {
+                auto it = accounts_by_number.find(changed[i]->getAccountNumber());
+                if (it != accounts_by_number.end() && account_table[it->second].get() == changed[i]) {
+                    account_groups.balanceChanged(it->second, Ledger::toCents(changed[i]->getBalance()));
+                }
+            }
+        }
+        committed_epoch.store(epoch); //       
+    }
+
+    //   write_mutex,        
+    size_t Bank::openSnapshot(uint64_t& epoch) {
+        epoch = committed_epoch.load();
+        for (size_t i = 0; i < MAX_SNAPSHOTS; ++i) {
+            uint64_t expected = NO_SNAPSHOT;
+            if (snapshot_epochs[i].compare_exchange_strong(expected, epoch)) {
+                return i;
+            }
+        }
+        throw std::runtime_error("Too many reports are open at the same time");
+    }
+
+    void Bank::closeSnapshot(size_t slot) {
+        snapshot_epochs[slot].store(NO_SNAPSHOT);
+    }
+
+    std::vector<AccountBalance> Bank::snapshot_balances() {
+        std::vector<std::shared_ptr<Account>> accounts;
+        uint64_t epoch = 0;
+        size_t slot = 0;
+        {
+            //      ,     
+            WriteLock lock(*this);
+            accounts.reserve(accounts_by_number.size());
+            for (const auto& account : account_table) {
+                if (account) {
+                    accounts.push_back(account);
+                }
+            }
+            slot = openSnapshot(epoch);
+        }
+
+        std::vector<AccountBalance> result;
+        result.reserve(accounts.size());
+        for (const auto& account : accounts) {
+            double balance = 0;
+            if (account->getBalanceAt(epoch, balance)) {
+                result.emplace_back(account->getAccountNumber(), balance);
+            }
+        }
+        closeSnapshot(slot);
+        return result;
+    }
+
+    void Bank::display_balance_report() {
+        std::vector<AccountBalance> balances = snapshot_balances();
+        double total = 0;
+        std::cout << "\nBalance report (consistent snapshot): " << std::endl;
+        for (const auto& item : balances) {
+            std::cout << item.accountNumber << ": " << item.balance << std::endl;
+            total += item.balance;
+        }
+        std::cout << "Accounts: " << balances.size() << ", total balance: " << total << std::endl;
+    }
+
+    uint32_t Bank::createAccountGroup(int client_id, const std::string& name, uint32_t parent, const std::string& currency) {
+        WriteLock lock(*this);
+        if (clients_by_id.count(client_id) == 0) {
+            throw std::invalid_argument("Client with id " + std::to_string(client_id) + " not found");
+        }
+        if (!isCurrencyCode(currency)) {
+            throw std::invalid_argument("Invalid currency code: " + currency);
+        }
+        return account_groups.create(client_id, name, parent, currency);
+    }
+
+    void Bank::assignAccountToGroup(const std::string& accountNumber, uint32_t group) {
+        WriteLock lock(*this);
+        auto it = accounts_by_number.find(accountNumber);
+        if (it == accounts_by_number.end()) {
+            throw std::invalid_argument("Account not found: " + accountNumber);
+        }
+        const Account& account = *account_table[it->second];
+        if (account.getClientId() != account_groups.getClientId(group)) {
+            throw std::invalid_argument("Account " + accountNumber + " belongs to another client");
+        }
+        if (account.getCurrency() != account_groups.getCurrency(group)) {
+            throw std::invalid_argument("Account " + accountNumber + " is not in the group currency " + account_groups.getCurrency(group));
+        }
+        account_groups.assign(it->second, group);
+    }
+
+    void Bank::removeAccountFromGroup(const std::string& accountNumber) {
+        WriteLock lock(*this);
+        auto it = accounts_by_number.find(accountNumber);
+        if (it != accounts_by_number.end()) {
+            account_groups.remove(it->second);
+        }
+    }
+
+    //       ,   
+    void Bank::refreshGroups() {
+        account_groups.refresh([this](uint32_t slot) { return Ledger::toCents(account_table[slot]->getBalance()); });
+    }
+
+    std::vector<std::shared_ptr<Account>> Bank::accounts_of_slots(const std::vector<uint32_t>& slots) {
+        std::vector<std::shared_ptr<Account>> result;
+        result.reserve(slots.size());
+        for (uint32_t slot : slots) {
+            result.push_back(account_table[slot]);
+        }
+        return result;
+    }
+
+    double Bank::getGroupTotal(uint32_t group) {
+        WriteLock lock(*this);
+        refreshGroups();
+        return Ledger::fromCents(account_groups.groupTotal(group));
+    }
+
+    double Bank::getGroupRangeTotal(uint32_t group, size_t from, size_t to) {
+        WriteLock lock(*this);
+        refreshGroups();
+        return Ledger::fromCents(account_groups.groupRange(group, from, to));
+    }
+
+    double Bank::getClientRangeTotal(int client_id, size_t from, size_t to) {
+        WriteLock lock(*this);
+        refreshGroups();
+        return Ledger::fromCents(account_groups.clientRange(client_id, from, to));
+    }
+
+    std::vector<std::shared_ptr<Account>> Bank::get_group_accounts(uint32_t group) {
+        WriteLock lock(*this);
+        refreshGroups();
+        return accounts_of_slots(account_groups.groupSlots(group));
+    }
+
+    std::vector<std::shared_ptr<Account>> Bank::get_consolidated_accounts(int client_id) {
+        WriteLock lock(*this);
+        refreshGroups();
+        return accounts_of_slots(account_groups.clientSlots(client_id));
+    }
+
+    void Bank::display_account_groups(int client_id) {
+        WriteLock lock(*this);
+        refreshGroups();
+        std::cout << "\nAccount groups of client " << client_id << ": " << std::endl;
+        //   :  (, ),     
+        std::vector<std::pair<uint32_t, int>> stack;
+        auto roots = account_groups.clientRoots(client_id);
+        for (auto it = roots.rbegin(); it != roots.rend(); ++it) {
+            stack.emplace_back(*it, 0);
+        }
+        if (stack.empty()) {
+            std::cout << "No account groups" << std::endl;
+            return;
+        }
+        while (!stack.empty()) {
+            uint32_t group = stack.back().first;
+            int depth = stack.back().second;
+            stack.pop_back();
+            std::cout << std::string(depth * 2, ' ') << account_groups.getName(group) << " [" << group << "]: "
+                << Ledger::fromCents(account_groups.groupTotal(group)) << " " << account_groups.getCurrency(group)
+                << " (" << account_groups.groupSlots(group).size() << " accounts)" << std::endl;
+            const auto& children = account_groups.getChildren(group);
+            for (auto it = children.rbegin(); it != children.rend(); ++it) {
+                stack.emplace_back(*it, depth + 1);
             }
         }
-        return false;
+        std::cout << "Consolidated total: " << Ledger::fromCents(account_groups.clientRange(client_id, 0, SIZE_MAX)) << std::endl;
     }
 
 }
\ No newline at end of file
@@ -1,8 +1,32 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <functional>
+#include <deque>
 #include "Structs.h"
+#include "Transaction.h"
+#include "Adjacency.h"
+#include "IdempotencyCache.h"
+#include "ChangeFeed.h"
+#include "BankStatus.h"
+#include "Posting.h"
+#include "Ledger.h"
+#include "Statement.h"
+#include "VelocityTracker.h"
+#include "ClientIndex.h"
+#include "FxRates.h"
+#include "AccountGroups.h"
+#include "TransactionArchive.h"
+#include "LookupFilter.h"
+#include "BalanceStore.h"
 
 //  
 namespace Banking {
@@ -19,45 +43,257 @@ namespace Banking {
 	class Bank {
 	
 	private:
-		std::vector<std::shared_ptr<Client>> all_clients; //      
-		std::vector<std::shared_ptr<Account>> all_accounts; //      
-		std::vector<std::shared_ptr<Transaction>> all_banking_transactions; //      
+		//    :    -       (),
+		//   ; shared_ptr        API
+		std::vector<std::shared_ptr<Client>> client_table;
+		std::vector<std::shared_ptr<Account>> account_table;
+		std::vector<uint32_t> free_client_slots;
+		std::vector<uint32_t> free_account_slots;
+		std::deque<Transaction> all_banking_transactions; //   (  )
+		std::vector<ArchiveSegment> archive; //   ,     
+		size_t archived_transactions = 0;
+		const std::string& historyOwner(size_t transaction); // ,     
+
+		//   :  ->  ,  ->  
+		Adjacency client_accounts;
+		Adjacency account_transactions;
+
+		//    :     
+		std::unordered_map<int, uint32_t> clients_by_id;
+		//   string_view   std::string
+		struct NumberHash {
+			using is_transparent = void;
+			size_t operator()(std::string_view number) const { return std::hash<std::string_view>{}(number); }
+		};
+		std::unordered_map<std::string, uint32_t, NumberHash, std::equal_to<>> accounts_by_number;
+		uint32_t account_slot(const Account& account); //    
+		bool ownsAccount(const Account& account); //        ;   write_mutex
+		void requireOwnedAccount(const std::shared_ptr<Account>& account); // invalid_argument     ;   write_mutex
+		//    :         
+		LookupFilter account_filter;
+		LookupFilter client_filter;
+		//     :    ()     
+		std::shared_ptr<BalanceStore> balance_store = std::make_shared<BalanceStore>();
+		void maintainLookupFilters(); //   ,   write_mutex
+		void linkTransaction(const Account& account, size_t transaction); //     
+		ClientIndex client_index; //    , ,    
+		std::vector<std::shared_ptr<Client>> clients_by_ids(const std::vector<int>& ids);
+
+		//        (, ..    )
+		std::recursive_mutex write_mutex;
+		//    lock_guard:        
+		class WriteLock {
+		private:
+			Bank& bank;
+
+		public:
+			explicit WriteLock(Bank& bank_value);
+			~WriteLock();
+			WriteLock(const WriteLock&) = delete;
+			WriteLock& operator=(const WriteLock&) = delete;
+		};
+		int write_depth = 0; //  write_mutex (   )
+
+		// MVCC:           
+		static const size_t MAX_SNAPSHOTS = 64;
+		static const uint64_t NO_SNAPSHOT = UINT64_MAX;
+		std::atomic<uint64_t> committed_epoch{ 0 };
+		std::array<std::atomic<uint64_t>, MAX_SNAPSHOTS> snapshot_epochs; //   
+
+		//           
+		IdempotencyCache idempotency_cache;
+		bool runIdempotent(const std::string& idempotency_key, const IdempotencyCache::Request& request, const std::function<bool()>& operation);
+
+		//      ( )
+		std::shared_ptr<ChangeFeed> change_feed;
+		void emitChange(ChangeEvent::Kind kind, const Account& account, const std::string& counterpart, double amount); //   write_mutex
+		//    write_mutex    :    backpressure-,
+		//    (      )
+		std::vector<ChangeEvent> pending_changes;   //  write_mutex
+		std::vector<ChangeEvent> publishing_changes; //  publish_mutex
+		std::atomic<size_t> pending_count{ 0 };     // pending_changes.size()    write_mutex
+		std::mutex publish_mutex; //     ,  -   
+		void publishChanges();
+
+		//    ( write_mutex): ,       
+		struct UndoRecord {
+			Account* account;
+			AccountState state;
+		};
+		std::vector<UndoRecord> undo_log;
+		std::vector<Account*> posted_accounts;
+		Posting transfer_posting;
+
+		//   ,   write_mutex;    -     
+		BankStatus applyPosting(const Posting& posting, const FxRates* rates = nullptr);
+
+		//   :     -  
+		Ledger ledger;
+		std::vector<Ledger::Leg> ledger_legs; //   
+		void addDebitLegs(Account& account, double amount, Ledger::LegKind kind);
+		void addCreditLegs(Account& account, double amount, Ledger::LegKind kind);
+
+		//       (  commitVersions)
+		AccountGroups account_groups;
+		void refreshGroups(); //   write_mutex
+		std::vector<std::shared_ptr<Account>> accounts_of_slots(const std::vector<uint32_t>& slots);
+
+		//          (  @FX-<>)
+		FxRateTable fx_rates;
+		uint32_t fxPositionIndex(const std::string& currency);
+		std::vector<Ledger::Leg> fx_legs; //  :        
+		bool conversionBalanced(const Posting& posting, const FxRates& rates);
+
+		//      (  -    )
+		VelocityTracker velocity;
+		bool velocityAllows(const Account& account, double amount);
+		void recordVelocity(const Account& account, double amount);
+		//  -   :           (  )
+		bool velocityAllows(const Posting& posting);
+		void recordVelocity(const Posting& posting);
+		BankStatus applyWithdraw(const std::shared_ptr<Account>& account, double amount);
+
+		void commitVersions(Account* const* changed, size_t count);
+		void commitVersions(std::initializer_list<Account*> changed); //   write_mutex
+		size_t openSnapshot(uint64_t& epoch);
+		void closeSnapshot(size_t slot);
 
 	public:
-		Bank() = default;
+		Bank();
 		~Bank() = default;
 
 		//           
 		std::shared_ptr<Client> find_client_by_id(const int& id);
-		std::shared_ptr<Account> find_acc_by_number(const std::string& accountNumber);
+		std::shared_ptr<Account> find_acc_by_number(std::string_view accountNumber);
+		//          ;   -  
+		void rebuildLookupFilters();
+		//       (     )
+		LookupFilter::Counts getLookupFilterCounts() const;
+		const std::shared_ptr<BalanceStore>& getBalanceStore() const { return balance_store; } //  ,       
 
 		//      
-		std::shared_ptr<Client> createClient(int id_value, const std::string& name_value, const std::string& surname_value, const Address& address_value, const Date& date_value); //       
-		std::shared_ptr<PremiumClient> createPremiumClient(int id_value, const std::string& name_value, const std::string& surname_value, const Address& address_value, const Date& date_value, const std::string& level = "Silver", double discount = 5.0);
-		void addClient_in_bank(std::shared_ptr<Client> client); //   
-		void addClient_in_bank(std::shared_ptr<PremiumClient> client); //  -
+		std::shared_ptr<Client> createClient(int id_value, std::string name_value, std::string surname_value, const Address& address_value, const Date& date_value); //       
+		std::shared_ptr<PremiumClient> createPremiumClient(int id_value, std::string name_value, std::string surname_value, const Address& address_value, const Date& date_value, std::string level = "Silver", double discount = 5.0);
+		void addClient_in_bank(const std::shared_ptr<Client>& client); //   
+		void addClient_in_bank(const std::shared_ptr<PremiumClient>& client); //  -
 		size_t getClientsCount();
 		bool deleteClient(int client_id);
+
+		//      (  limit ,    )
+		std::vector<std::shared_ptr<Client>> find_clients_by_surname_prefix(const std::string& prefix, size_t limit = 100);
+		std::vector<std::shared_ptr<Client>> find_clients_by_city(const std::string& city, size_t limit = 100);
+		std::vector<std::shared_ptr<Client>> find_clients_by_country(const std::string& country, size_t limit = 100);
+		std::vector<std::shared_ptr<Client>> find_clients_registered_between(const Date& from, const Date& to, size_t limit = 100);
 		
 		//       ()
-		std::shared_ptr<CheckingAccount> createCheckAccount(const std::string& accountNumber, const int& client_id, double initialBalance = 0, double overdraft_value = 0); //       
-		std::shared_ptr<SavingsAccount> createSavAccount(const std::string& accountNumber, const int& client_id, double initialBalance = 5000, int months = 1); //       
-		void addAccount_in_bank(std::shared_ptr<Account> account);
+		std::shared_ptr<CheckingAccount> createCheckAccount(const std::string& accountNumber, const int& client_id, double initialBalance = 0, double overdraft_value = 0, const std::string& currency = DEFAULT_CURRENCY); //       
+		std::shared_ptr<SavingsAccount> createSavAccount(const std::string& accountNumber, const int& client_id, double initialBalance = 5000, int months = 1, const std::string& currency = DEFAULT_CURRENCY); //       
+		void addAccount_in_bank(const std::shared_ptr<Account>& account);
+		//   ():        ,     ;
+		//          ,        rejected_*
+		void importEntities(const std::vector<std::shared_ptr<Client>>& clients, const std::vector<std::shared_ptr<Account>>& accounts,
+			std::vector<size_t>& rejected_clients, std::vector<size_t>& rejected_accounts);
 		size_t getAccountCount();
 		bool deleteAccount(const std::string& accountNumber);
 
-		//     ()
+		//     ();      - invalid_argument,   
 		void transfer(const std::string& accountNumber_from, const std::string& accountNumber_to, double amount);
-		void registerDeposit(std::shared_ptr<Account> account, double amount);
-		void registerWithdraw(std::shared_ptr<Account> account, double amount);
+		void registerDeposit(const std::shared_ptr<Account>& account, double amount);
+		bool registerWithdraw(const std::shared_ptr<Account>& account, double amount); // false,   
+
+		//      :    
+		// (   )    
+		void transfer(const std::string& accountNumber_from, const std::string& accountNumber_to, double amount, const std::string& idempotency_key);
+		void registerDeposit(const std::shared_ptr<Account>& account, double amount, const std::string& idempotency_key);
+		bool registerWithdraw(const std::shared_ptr<Account>& account, double amount, const std::string& idempotency_key);
+		IdempotencyCache& getIdempotencyCache() { return idempotency_cache; }
+
+		//     :        undo records
+		BankStatus post(const Posting& posting);
+		//      (   feeAccountNumber)
+		BankStatus tryTransferWithFee(const std::string& accountNumber_from, const std::string& accountNumber_to, double amount, double fee, const std::string& feeAccountNumber);
+
+		//     :       
+		BankStatus tryTransfer(const std::string& accountNumber_from, const std::string& accountNumber_to, double amount);
+		BankStatus tryDeposit(const std::shared_ptr<Account>& account, double amount);
+		BankStatus tryWithdraw(const std::shared_ptr<Account>& account, double amount);
+		BankResult<std::shared_ptr<Client>> tryCreateClient(int id_value, std::string name_value, std::string surname_value, const Address& address_value, const Date& date_value);
+		BankResult<std::shared_ptr<PremiumClient>> tryCreatePremiumClient(int id_value, std::string name_value, std::string surname_value, const Address& address_value, const Date& date_value, std::string level = "Silver", double discount = 5.0);
+		BankResult<std::shared_ptr<CheckingAccount>> tryCreateCheckAccount(const std::string& accountNumber, const int& client_id, double initialBalance = 0, double overdraft_value = 0, const std::string& currency = DEFAULT_CURRENCY);
+		BankResult<std::shared_ptr<SavingsAccount>> tryCreateSavAccount(const std::string& accountNumber, const int& client_id, double initialBalance = 5000, int months = 1, const std::string& currency = DEFAULT_CURRENCY);
+
+		//   ( ):   ,     
+		//     O(log n),        
+		uint32_t createAccountGroup(int client_id, const std::string& name, uint32_t parent = AccountGroups::NO_GROUP, const std::string& currency = DEFAULT_CURRENCY);
+		void assignAccountToGroup(const std::string& accountNumber, uint32_t group); //        
+		void removeAccountFromGroup(const std::string& accountNumber);
+		double getGroupTotal(uint32_t group);
+		//   [from, to)   get_group_accounts / get_consolidated_accounts
+		double getGroupRangeTotal(uint32_t group, size_t from, size_t to);
+		double getClientRangeTotal(int client_id, size_t from, size_t to);
+		std::vector<std::shared_ptr<Account>> get_group_accounts(uint32_t group); //    (  )
+		std::vector<std::shared_ptr<Account>> get_consolidated_accounts(int client_id); //   
+		void display_account_groups(int client_id);
+
+		//  :           ,
+		//       ;         
+		FxRateTable& getFxRates() { return fx_rates; }
+
+		//    (    )   ; 0 -  
+		void setVelocityLimits(const VelocityLimits& limits);
+		VelocityTracker& getVelocityTracker() { return velocity; }
+
+		//    (nullptr - );    write_mutex,   
+		void setChangeFeed(std::shared_ptr<ChangeFeed> feed);
+		std::shared_ptr<ChangeFeed> getChangeFeed() { return change_feed; }
+
+		//   (   ,      )
+		bool registerTransferOut(const std::shared_ptr<Account>& account, const std::string& accountNumber_to, double amount);
+		void registerTransferIn(const std::shared_ptr<Account>& account, const std::string& accountNumber_from, double amount);
+
+		//  :   ,      failed
+		size_t transfer_batch(const std::vector<TransferOrder>& orders, std::vector<size_t>& failed);
 
 		//      
-		void addTransaction_in_bank(std::shared_ptr<Transaction> transaction);
+		void addTransaction_in_bank(const std::shared_ptr<Transaction>& transaction); //      
+		size_t getTransactionCount();
+
+		//  ,    (    ,      )
+		std::vector<std::shared_ptr<Account>> get_client_accounts(int client_id);
+		std::vector<const Transaction*> get_account_transactions(const std::string& accountNumber);
+		void display_client_accounts(int client_id);
+		void display_account_transactions(const std::string& accountNumber);
 
 		//   
 		void display_all_clients_in_bank();
 		void display_all_accounts_in_bank();
 		void displayinfo_about_transactions_in_bank();
 
+		//       :   ,
+		//            
+		std::vector<AccountBalance> snapshot_balances();
+		void display_balance_report();
+
+		//       (  @CASH, @COMMISSION, @DISCOUNT, @TRANSIT)
+		Ledger& getLedger() { return ledger; }
+		std::vector<AccountBalance> trial_balance();
+		void display_trial_balance();
+
+		//      [from, to)   : /      
+		StatementSummary write_statement(const std::string& accountNumber, std::time_t from, std::time_t to, std::ostream& out);
+		void display_statement(const std::string& accountNumber, int year, int month); //   
+		//          <path_prefix>_<>.txt;
+		//       ,      ;    - runtime_error
+		size_t write_month_end_statements(int year, int month, const std::string& path_prefix, unsigned threads = 0);
+
+		//  :   older_than (     )     path
+		//   ;    .     - std::invalid_argument,
+		//      - std::runtime_error (    )
+		size_t archive_transactions(std::time_t older_than, const std::string& path);
+		size_t getArchivedTransactionCount();
+		//   [from, to):  ,    ;   
+		size_t audit_account_history(const std::string& accountNumber, std::time_t from, std::time_t to, const TransactionVisitor& visit);
+		size_t audit_transactions(std::time_t from, std::time_t to, const TransactionVisitor& visit);
+
 	};
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+﻿#pragma once
+#include <cstdint>
+#include <utility>
+
+namespace Banking {
+
+    // Исход операции банка без исключений: отказ клиенту - обычный результат, а не ошибка
+    enum class BankStatus : uint8_t {
+        Ok = 0,
+        InvalidAmount,
+        SameAccount,
+        SourceNotFound,
+        DestinationNotFound,
+        AccountNotFound,
+        InsufficientFunds,
+        ClientNotFound,
+        DuplicateClient,
+        DuplicateAccount,
+        InvalidClientData,
+        InvalidAccountData,
+        VelocityLimitExceeded, // слишком много списаний со счета за окно времени
+        CurrencyNotSupported, // нет курса для валюты одного из счетов
+        CurrencyMismatch, // операция без пересчета между счетами в разных валютах
+        OperationFailed // модель выбросила исключение посреди операции
+    };
+
+    // сообщения - строковые литералы, поэтому отказ не выделяет память
+    inline const char* statusMessage(BankStatus status) noexcept {
+        switch (status) {
+        case BankStatus::Ok: return "OK";
+        case BankStatus::InvalidAmount: return "Amount must be positive";
+        case BankStatus::SameAccount: return "Cannot transfer to the same account";
+        case BankStatus::SourceNotFound: return "Source account not found";
+        case BankStatus::DestinationNotFound: return "Destination account not found";
+        case BankStatus::AccountNotFound: return "Account not found";
+        case BankStatus::InsufficientFunds: return "Insufficient funds";
+        case BankStatus::ClientNotFound: return "Client not found";
+        case BankStatus::DuplicateClient: return "Client with this id already exists";
+        case BankStatus::DuplicateAccount: return "Account with this number already exists";
+        case BankStatus::InvalidClientData: return "Invalid client data";
+        case BankStatus::InvalidAccountData: return "Invalid account data";
+        case BankStatus::VelocityLimitExceeded: return "Velocity limit exceeded";
+        case BankStatus::CurrencyNotSupported: return "No exchange rate for account currency";
+        case BankStatus::CurrencyMismatch: return "Accounts are in different currencies";
+        case BankStatus::OperationFailed: return "Operation failed";
+        }
+        return "Unknown status";
+    }
+
+    // значение или код отказа (в духе std::expected)
+    template <typename T>
+    class BankResult {
+    private:
+        T value;
+        BankStatus status;
+
+    public:
+        BankResult(T value_value) : value(std::move(value_value)), status(BankStatus::Ok) {}
+        BankResult(BankStatus status_value) : value(), status(status_value) {}
+
+        bool isOk() const noexcept { return status == BankStatus::Ok; }
+        explicit operator bool() const noexcept { return isOk(); }
+        BankStatus getStatus() const noexcept { return status; }
+        const char* getMessage() const noexcept { return statusMessage(status); }
+
+        T& getValue() { return value; }
+        const T& getValue() const { return value; }
+    };
+
+}
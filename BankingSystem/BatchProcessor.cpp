@@ -0,0 +1,211 @@
+﻿#include "BatchProcessor.h"
+#include "Client.h"
+#include "PremiumClient.h"
+#include "Account.h"
+
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace Banking;
+
+namespace {
+
+    std::string_view trim(std::string_view field) {
+        while (!field.empty() && (field.front() == ' ' || field.front() == '\t')) {
+            field.remove_prefix(1);
+        }
+        while (!field.empty() && (field.back() == ' ' || field.back() == '\t' || field.back() == '\r')) {
+            field.remove_suffix(1);
+        }
+        return field;
+    }
+}
+
+BatchProcessor::BatchProcessor(Bank& bank_value, std::ostream& errors_value)
+    : bank(bank_value), errors(errors_value) {
+}
+
+size_t BatchProcessor::splitFields(std::string_view line, std::string_view* fields) {
+    size_t count = 0;
+    while (true) {
+        size_t comma = line.find(',');
+        if (count == MAX_FIELDS) {
+            return MAX_FIELDS + 1; // лишние поля не отбрасываем молча
+        }
+        fields[count++] = trim(line.substr(0, comma));
+        if (comma == std::string_view::npos) {
+            return count;
+        }
+        line.remove_prefix(comma + 1);
+    }
+}
+
+bool BatchProcessor::parseInt(std::string_view field, int& value) {
+    auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == std::errc() && result.ptr == field.data() + field.size();
+}
+
+bool BatchProcessor::parseDouble(std::string_view field, double& value) {
+    auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+    return result.ec == std::errc() && result.ptr == field.data() + field.size();
+}
+
+void BatchProcessor::reportError(size_t line_number, const char* message) {
+    ++failed;
+    errors << "line " << line_number << ": " << message << '\n';
+}
+
+void BatchProcessor::flushTransfers() {
+    if (pending_transfers.empty()) {
+        return;
+    }
+    failed_orders.clear();
+    processed += bank.transfer_batch(pending_transfers, failed_orders);
+    for (size_t index : failed_orders) {
+        reportError(pending_lines[index], "transfer declined");
+    }
+    pending_transfers.clear();
+    pending_lines.clear();
+}
+
+void BatchProcessor::processLine(std::string_view line, size_t line_number) {
+    line = trim(line);
+    if (line.empty() || line.front() == '#') {
+        return;
+    }
+
+    std::string_view fields[MAX_FIELDS];
+    size_t count = splitFields(line, fields);
+    if (count > MAX_FIELDS) {
+        reportError(line_number, "too many fields");
+        return;
+    }
+    std::string_view command = fields[0];
+
+    // переводы не выполняем сразу, а копим в пакет
+    if (command == "TRANSFER") {
+        double amount = 0;
+        if (count != 4 || !parseDouble(fields[3], amount)) {
+            reportError(line_number, "expected TRANSFER,from,to,amount");
+            return;
+        }
+        pending_transfers.emplace_back(fields[1], fields[2], amount);
+        pending_lines.push_back(line_number);
+        return;
+    }
+
+    // любая другая команда может зависеть от результатов переводов - сначала отправляем пакет
+    flushTransfers();
+
+    try {
+        if (command == "CLIENT" || command == "PREMIUM") {
+            bool premium = command == "PREMIUM";
+            int id = 0, post_id = 0, day = 0, month = 0, year = 0;
+            if (count != (premium ? 12u : 11u) || !parseInt(fields[1], id) || !parseInt(fields[7], post_id)
+                || !parseInt(fields[8], day) || !parseInt(fields[9], month) || !parseInt(fields[10], year)) {
+                reportError(line_number, premium ? "expected PREMIUM,id,name,surname,street,city,country,post_id,day,month,year,level"
+                                                 : "expected CLIENT,id,name,surname,street,city,country,post_id,day,month,year");
+                return;
+            }
+            Address address{ std::string(fields[4]), std::string(fields[5]), std::string(fields[6]), post_id };
+            Date date(day, month, year);
+            if (premium) {
+                bank.createPremiumClient(id, std::string(fields[2]), std::string(fields[3]), address, date, std::string(fields[11]));
+            }
+            else {
+                bank.createClient(id, std::string(fields[2]), std::string(fields[3]), address, date);
+            }
+        }
+        else if (command == "CHECKING") {
+            int client_id = 0;
+            double balance = 0;
+            if ((count != 4 && count != 5) || !parseInt(fields[2], client_id) || !parseDouble(fields[3], balance)) {
+                reportError(line_number, "expected CHECKING,account_number,client_id,initial_balance[,currency]");
+                return;
+            }
+            bank.createCheckAccount(std::string(fields[1]), client_id, balance, 0, count == 5 ? std::string(fields[4]) : Banking::DEFAULT_CURRENCY);
+        }
+        else if (command == "SAVINGS") {
+            int client_id = 0, months = 0;
+            double balance = 0;
+            if ((count != 5 && count != 6) || !parseInt(fields[2], client_id) || !parseDouble(fields[3], balance) || !parseInt(fields[4], months)) {
+                reportError(line_number, "expected SAVINGS,account_number,client_id,initial_balance,months[,currency]");
+                return;
+            }
+            bank.createSavAccount(std::string(fields[1]), client_id, balance, months, count == 6 ? std::string(fields[5]) : Banking::DEFAULT_CURRENCY);
+        }
+        else if (command == "FXRATE") {
+            double rate = 0;
+            if (count != 3 || !parseDouble(fields[2], rate)) {
+                reportError(line_number, "expected FXRATE,currency,rate");
+                return;
+            }
+            bank.getFxRates().setRate(std::string(fields[1]), rate);
+        }
+        else if (command == "DEPOSIT" || command == "WITHDRAW") {
+            double amount = 0;
+            if (count != 3 || !parseDouble(fields[2], amount)) {
+                reportError(line_number, "expected DEPOSIT|WITHDRAW,account_number,amount");
+                return;
+            }
+            auto account = bank.find_acc_by_number(fields[1]);
+            if (!account) {
+                reportError(line_number, "account not found");
+                return;
+            }
+            if (command == "DEPOSIT") {
+                bank.registerDeposit(account, amount);
+            }
+            else {
+                if (!bank.registerWithdraw(account, amount)) {
+                    reportError(line_number, "withdrawal declined");
+                    return;
+                }
+            }
+        }
+        else {
+            reportError(line_number, "unknown command");
+            return;
+        }
+        ++processed;
+    }
+    catch (const std::exception& e) {
+        reportError(line_number, e.what());
+    }
+}
+
+size_t BatchProcessor::runBuffer(const std::string& buffer) {
+    QuietCout quiet;
+    std::string_view rest(buffer);
+    size_t line_number = 0;
+    while (!rest.empty()) {
+        size_t end = rest.find('\n');
+        processLine(rest.substr(0, end), ++line_number);
+        if (end == std::string_view::npos) {
+            break;
+        }
+        rest.remove_prefix(end + 1);
+    }
+    flushTransfers();
+    return processed;
+}
+
+size_t BatchProcessor::run(std::istream& in) {
+    // читаем весь поток в один буфер: поля команд ссылаются на него без копирования
+    std::ostringstream content;
+    content << in.rdbuf();
+    return runBuffer(content.str());
+}
+
+size_t BatchProcessor::runFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Cannot open batch file: " + path);
+    }
+    std::string buffer(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+    return runBuffer(buffer);
+}
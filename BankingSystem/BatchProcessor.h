@@ -0,0 +1,69 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <iostream>
+#include "Bank.h"
+
+// на время пакетной обработки глушим подробный вывод моделей в std::cout
+// (при badbit операторы << сразу выходят, не форматируя данные)
+class QuietCout {
+private:
+    std::ios_base::iostate old_state;
+
+public:
+    QuietCout() : old_state(std::cout.rdstate()) {
+        std::cout.flush();
+        std::cout.setstate(std::ios_base::badbit);
+    }
+    ~QuietCout() {
+        std::cout.clear(old_state);
+    }
+};
+
+// Неинтерактивный режим: команды читаются из файла или потока построчно (CSV)
+//
+// Формат строк (поля через запятую, '#' - комментарий):
+//   CLIENT,id,name,surname,street,city,country,post_id,day,month,year
+//   PREMIUM,id,name,surname,street,city,country,post_id,day,month,year,level
+//   CHECKING,account_number,client_id,initial_balance[,currency]
+//   SAVINGS,account_number,client_id,initial_balance,months[,currency]   (валюта по умолчанию - RUB)
+//   DEPOSIT,account_number,amount
+//   WITHDRAW,account_number,amount
+//   TRANSFER,from,to,amount
+//   FXRATE,currency,rate   (сколько единиц базовой валюты за 1 единицу currency)
+class BatchProcessor {
+private:
+    Banking::Bank& bank;
+    std::ostream& errors; // сюда пишутся ошибки с номером строки
+
+    size_t processed = 0;
+    size_t failed = 0;
+
+    // подряд идущие переводы копятся и отправляются в банк одним пакетом
+    std::vector<Banking::TransferOrder> pending_transfers;
+    std::vector<size_t> pending_lines;
+    std::vector<size_t> failed_orders;
+
+    size_t runBuffer(const std::string& buffer);
+    void processLine(std::string_view line, size_t line_number);
+    void flushTransfers();
+    void reportError(size_t line_number, const char* message);
+
+public:
+    static const size_t MAX_FIELDS = 12;
+
+    // разбор строки без выделения памяти (общий с BulkLoader); больше MAX_FIELDS полей - возвращает MAX_FIELDS + 1
+    static size_t splitFields(std::string_view line, std::string_view* fields);
+    static bool parseInt(std::string_view field, int& value);
+    static bool parseDouble(std::string_view field, double& value);
+
+    explicit BatchProcessor(Banking::Bank& bank_value, std::ostream& errors_value = std::cerr);
+
+    // обработать весь поток / файл, возвращает количество успешно выполненных команд
+    size_t run(std::istream& in);
+    size_t runFile(const std::string& path);
+
+    size_t getProcessedCount() const { return processed; }
+    size_t getFailedCount() const { return failed; }
+};
@@ -0,0 +1,1377 @@
+﻿#include "BenchBankSystem.h"
+#include "BatchProcessor.h"
+#include "ShardedBank.h"
+#include "ChangeFeedFile.h"
+#include "StandingOrders.h"
+#include "Client.h"
+#include "BulkLoader.h"
+#include "Metrics.h"
+#include "Account.h"
+#include "AsyncBank.h"
+#include "Workload.h"
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <algorithm>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <cstdint>
+
+using namespace Banking;
+
+// счетчики выделений памяти для бенчмарков (замена глобального operator new на всю программу):
+// перед блоком пишется его размер, чтобы считать занятые байты
+static std::atomic<size_t> allocation_count{ 0 };
+static std::atomic<size_t> live_bytes{ 0 };
+static const size_t SIZE_HEADER = 16; // сохраняет выравнивание malloc
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size + SIZE_HEADER)) {
+        *static_cast<std::size_t*>(memory) = size;
+        live_bytes.fetch_add(size, std::memory_order_relaxed);
+        return static_cast<char*>(memory) + SIZE_HEADER;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    if (memory) {
+        char* block = reinterpret_cast<char*>(reinterpret_cast<std::uintptr_t>(memory) - SIZE_HEADER);
+        live_bytes.fetch_sub(*reinterpret_cast<std::size_t*>(block), std::memory_order_relaxed);
+        std::free(block);
+    }
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    operator delete(memory);
+}
+
+void BenchBankSystem::runAllBenchmarks() {
+    std::cout << "=== STARTING BANK SYSTEM BENCHMARKS ===" << std::endl;
+
+    benchBatchMode();
+    benchShardedBank();
+    benchIdempotency();
+    benchChangeFeed();
+    benchDeclinedTransfers();
+    benchLedger();
+    benchStandingOrders();
+    benchVelocity();
+    benchClientIndex();
+    benchClientStorage();
+    benchEntityLinks();
+    benchBulkLoader();
+    benchStatements();
+    benchMetrics();
+    benchTransferAllocations();
+    benchFxTransfers();
+    benchAccountGroups();
+    benchAsyncBank();
+    benchWorkload();
+    benchHotAccount();
+    benchTransactionArchive();
+    benchLookupFilter();
+    benchAccountLayout();
+
+    std::cout << "=== BENCHMARKS FINISHED ===" << std::endl;
+}
+
+void BenchBankSystem::report(const std::string& name, size_t operations, double seconds) {
+    std::cout << name << ": " << operations << " ops in " << seconds << " s, "
+        << static_cast<size_t>(operations / seconds) << " ops/sec" << std::endl;
+}
+
+void BenchBankSystem::benchBatchMode() {
+    std::cout << "\n--- Batch mode throughput ---" << std::endl;
+
+    const int clients = 1000;
+    const int accounts = 10000;
+    const size_t commands = 1000000;
+
+    // готовим файл команд в памяти: клиенты, счета и смесь операций
+    std::ostringstream script;
+    for (int id = 1; id <= clients; ++id) {
+        script << "CLIENT," << id << ",Name,Surname" << id << ",Main St,City,Country,10001,1,1,2024\n";
+    }
+    for (int i = 0; i < accounts; ++i) {
+        script << "CHECKING,ACC" << i << ',' << (i % clients) + 1 << ",1000000\n";
+    }
+    unsigned seed = 12345;
+    for (size_t i = 0; i < commands; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        int from = static_cast<int>((seed >> 8) % accounts);
+        int to = static_cast<int>((seed >> 4) % accounts);
+        switch (i % 4) {
+        case 0: script << "DEPOSIT,ACC" << from << ",100\n"; break;
+        case 1: script << "WITHDRAW,ACC" << from << ",50\n"; break;
+        default:
+            if (from == to) {
+                to = (to + 1) % accounts;
+            }
+            script << "TRANSFER,ACC" << from << ",ACC" << to << ",10\n";
+        }
+    }
+    std::istringstream input(script.str());
+
+    std::chrono::duration<double> elapsed{};
+    size_t processed = 0;
+    size_t failed = 0;
+    {
+        QuietCout quiet;
+        Bank bank;
+        std::ostream no_errors(nullptr);
+        BatchProcessor batch(bank, no_errors);
+
+        auto start = std::chrono::steady_clock::now();
+        batch.run(input);
+        elapsed = std::chrono::steady_clock::now() - start;
+        processed = batch.getProcessedCount();
+        failed = batch.getFailedCount();
+    }
+
+    report("batch commands", clients + accounts + commands, elapsed.count());
+    std::cout << "processed: " << processed << ", failed: " << failed << std::endl;
+}
+
+void BenchBankSystem::benchShardedBank() {
+    std::cout << "\n--- Sharded bank scaling (random transfers) ---" << std::endl;
+
+    const int accounts = 10000;
+    const size_t transfers = 400000;
+
+    std::vector<std::string> numbers;
+    for (int i = 0; i < accounts; ++i) {
+        numbers.push_back("ACC" + std::to_string(i));
+    }
+
+    for (size_t shard_count = 1; shard_count <= 32; shard_count *= 2) {
+        std::chrono::duration<double> elapsed{};
+        size_t failed = 0;
+        {
+            QuietCout quiet;
+            ShardedBank sharded(shard_count);
+            sharded.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+            for (int i = 0; i < accounts; ++i) {
+                sharded.createSavAccount(numbers[i], 1, 1000000.0, 12);
+            }
+            sharded.drain();
+
+            unsigned seed = 12345;
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < transfers; ++i) {
+                seed = seed * 1103515245u + 12345u;
+                int from = static_cast<int>((seed >> 8) % accounts);
+                int to = (from + 1 + static_cast<int>((seed >> 4) % (accounts - 1))) % accounts;
+                sharded.transfer(numbers[from], numbers[to], 10.0);
+            }
+            sharded.drain();
+            elapsed = std::chrono::steady_clock::now() - start;
+            failed = sharded.getFailedCount();
+        }
+        report("shards=" + std::to_string(shard_count), transfers, elapsed.count());
+        if (failed != 0) {
+            std::cout << "failed transfers: " << failed << std::endl;
+        }
+    }
+}
+
+void BenchBankSystem::benchIdempotency() {
+    std::cout << "\n--- Idempotency key overhead (non-duplicate transfers) ---" << std::endl;
+
+    const int accounts = 1000;
+    const size_t transfers = 300000;
+
+    std::vector<std::string> numbers;
+    std::vector<std::string> keys;
+    for (int i = 0; i < accounts; ++i) {
+        numbers.push_back("ACC" + std::to_string(i));
+    }
+    for (size_t i = 0; i < transfers; ++i) {
+        keys.push_back("request-" + std::to_string(i));
+    }
+
+    for (int with_keys = 0; with_keys < 2; ++with_keys) {
+        std::chrono::duration<double> elapsed{};
+        {
+            QuietCout quiet;
+            Bank bank;
+            bank.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+            for (int i = 0; i < accounts; ++i) {
+                bank.createSavAccount(numbers[i], 1, 1000000.0, 12);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < transfers; ++i) {
+                const std::string& from = numbers[i % accounts];
+                const std::string& to = numbers[(i * 7 + 1) % accounts];
+                if (with_keys) {
+                    bank.transfer(from, to, 1.0, keys[i]);
+                }
+                else {
+                    bank.transfer(from, to, 1.0);
+                }
+            }
+            elapsed = std::chrono::steady_clock::now() - start;
+        }
+        report(with_keys ? "transfer with idempotency key" : "transfer without key", transfers, elapsed.count());
+    }
+}
+void BenchBankSystem::benchChangeFeed() {
+    std::cout << "\n--- Change feed overhead ---" << std::endl;
+
+    // чистая публикация события в кольцевой буфер
+    const size_t events = 5000000;
+    {
+        ChangeFeed feed;
+        auto subscription = feed.subscribe(ChangeFeed::Policy::Drop);
+        ChangeEvent event = ChangeEvent::make(ChangeEvent::DEPOSIT, "ACC1", "", 1.0, 1.0, 1);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < events; ++i) {
+            feed.publish(event);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        report("publish (drop subscriber)", events, elapsed.count());
+    }
+
+    // переводы без ленты, с отстающим drop-подписчиком и с файловым backpressure-подписчиком
+    const int accounts = 1000;
+    const size_t transfers = 300000;
+    const std::string path = "bench_change_feed.bin";
+    std::vector<std::string> numbers;
+    for (int i = 0; i < accounts; ++i) {
+        numbers.push_back("ACC" + std::to_string(i));
+    }
+
+    const char* names[] = { "transfer without feed", "transfer with drop subscriber", "transfer with file subscriber" };
+    for (int mode = 0; mode < 3; ++mode) {
+        std::chrono::duration<double> elapsed{};
+        {
+            QuietCout quiet;
+            Bank bank;
+            auto feed = std::make_shared<ChangeFeed>();
+            std::shared_ptr<ChangeFeed::Subscription> lagging;
+            std::unique_ptr<ChangeFeedFileWriter> writer;
+            if (mode == 1) {
+                lagging = feed->subscribe(ChangeFeed::Policy::Drop);
+            }
+            if (mode == 2) {
+                std::remove(path.c_str());
+                writer = std::make_unique<ChangeFeedFileWriter>(*feed, path);
+            }
+            if (mode > 0) {
+                bank.setChangeFeed(feed);
+            }
+            bank.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+            for (int i = 0; i < accounts; ++i) {
+                bank.createSavAccount(numbers[i], 1, 1000000.0, 12);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < transfers; ++i) {
+                bank.transfer(numbers[i % accounts], numbers[(i * 7 + 1) % accounts], 1.0);
+            }
+            if (writer) {
+                writer->stop(); // время включает дозапись хвоста ленты в файл
+            }
+            elapsed = std::chrono::steady_clock::now() - start;
+        }
+        report(names[mode], transfers, elapsed.count());
+    }
+    std::remove(path.c_str());
+}
+void BenchBankSystem::benchDeclinedTransfers() {
+    std::cout << "\n--- Declined transfers: exceptions vs status codes ---" << std::endl;
+
+    const size_t transfers = 300000;
+    const std::string rich = "ACC0";
+    const std::string poor = "ACC1";
+    const std::string missing = "NO-SUCH-ACCOUNT";
+
+    // два типичных отказа (нет денег, нет счета получателя), каждый через оба API
+    const char* names[] = { "insufficient funds, transfer (throws)", "insufficient funds, tryTransfer",
+        "missing destination, transfer (throws)", "missing destination, tryTransfer" };
+    double seconds[4] = {};
+    size_t allocations[4] = {};
+    {
+        QuietCout quiet;
+        Bank bank;
+        bank.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+        bank.createSavAccount(rich, 1, 1000000.0, 12);
+        bank.createSavAccount(poor, 1, 5000.0, 12);
+
+        for (int run = 0; run < 4; ++run) {
+            const std::string& from = run < 2 ? poor : rich;
+            const std::string& to = run < 2 ? rich : missing;
+            bool with_status = run % 2 == 1;
+            size_t allocations_before = allocation_count.load();
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < transfers; ++i) {
+                if (with_status) {
+                    bank.tryTransfer(from, to, 100.0);
+                }
+                else {
+                    try {
+                        bank.transfer(from, to, 100.0);
+                    }
+                    catch (const std::exception&) {
+                    }
+                }
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            seconds[run] = elapsed.count();
+            allocations[run] = allocation_count.load() - allocations_before;
+        }
+    }
+    for (int run = 0; run < 4; ++run) {
+        report(names[run], transfers, seconds[run]);
+        std::cout << "  allocations per declined transfer: " << static_cast<double>(allocations[run]) / transfers << std::endl;
+    }
+}
+void BenchBankSystem::benchLedger() {
+    std::cout << "\n--- Double-entry ledger: posting and trial balance ---" << std::endl;
+
+    const int accounts = 100000;
+    const size_t postings = 3000000;
+
+    Ledger ledger;
+    std::vector<uint32_t> index;
+    for (int i = 0; i < accounts; ++i) {
+        index.push_back(ledger.accountIndex("ACC" + std::to_string(i)));
+    }
+
+    // перевод с комиссией: 4 ноги на проводку
+    unsigned seed = 12345;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < postings; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        uint32_t from = index[seed % accounts];
+        uint32_t to = index[(seed >> 8) % accounts];
+        int64_t amount = 100 + seed % 10000;
+        ledger.post(Ledger::TRANSFER, { { from, -amount, Ledger::PRINCIPAL }, { to, amount, Ledger::PRINCIPAL },
+            { from, -25, Ledger::COMMISSION }, { Ledger::COMMISSION_INCOME, 25, Ledger::COMMISSION } });
+    }
+    std::chrono::duration<double> posting_time = std::chrono::steady_clock::now() - start;
+    report("ledger post (4 legs)", postings, posting_time.count());
+
+    start = std::chrono::steady_clock::now();
+    std::vector<int64_t> totals = ledger.trialBalance();
+    int64_t total = ledger.totalOfAllEntries();
+    std::chrono::duration<double> trial_time = std::chrono::steady_clock::now() - start;
+    report("trial balance + zero check (legs)", ledger.getEntryCount(), trial_time.count());
+
+    std::cout << "book total: " << total << ", commission income: " << Ledger::fromCents(totals[Ledger::COMMISSION_INCOME])
+        << ", storage: " << (sizeof(uint32_t) + sizeof(int64_t) + sizeof(uint8_t)) << " bytes per leg" << std::endl;
+}
+void BenchBankSystem::benchStandingOrders() {
+    std::cout << "\n--- Standing orders: 10M active schedules on a timer wheel ---" << std::endl;
+
+    const size_t schedules = 10000000;
+    const size_t cancels = 1000000;
+    const int accounts = 1000;
+    const uint32_t horizon = 3650; // сроки первых исполнений разбросаны на 10 лет
+    const uint32_t fire_days = 31;
+
+    std::vector<std::string> numbers;
+    for (int i = 0; i < accounts; ++i) {
+        numbers.push_back("ACC" + std::to_string(i));
+    }
+
+    double schedule_seconds = 0;
+    double cancel_seconds = 0;
+    double fire_seconds = 0;
+    size_t fired = 0;
+    size_t active = 0;
+    {
+        QuietCout quiet;
+        Bank bank;
+        bank.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+        for (int i = 0; i < accounts; ++i) {
+            bank.createSavAccount(numbers[i], 1, 100000000.0, 12);
+        }
+
+        StandingOrders orders;
+        const uint32_t today = StandingOrders::dayNumber(Date(1, 1, 2025));
+        orders.advanceTo(today - 1, bank);
+
+        std::vector<StandingOrders::OrderId> ids;
+        ids.reserve(schedules);
+        unsigned seed = 12345;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < schedules; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            int from = seed % accounts;
+            int to = (from + 1 + (seed >> 12) % (accounts - 1)) % accounts;
+            ids.push_back(orders.schedule(numbers[from], numbers[to], 1.0, today + (seed >> 8) % horizon, StandingOrders::DAYS_IN_MONTH, 12));
+        }
+        schedule_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < cancels; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            orders.cancel(ids[seed % schedules]);
+        }
+        cancel_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // месяц исполнения: переводы каждого дня уходят в банк одним пакетом
+        start = std::chrono::steady_clock::now();
+        orders.advanceTo(today + fire_days - 1, bank);
+        fire_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        fired = orders.getFiredCount();
+        active = orders.getActiveCount();
+    }
+    report("schedule", schedules, schedule_seconds);
+    report("cancel (random ids)", cancels, cancel_seconds);
+    report("fire due orders (31 days, via transfer_batch)", fired, fire_seconds);
+    std::cout << "active schedules after a month: " << active << std::endl;
+}
+void BenchBankSystem::benchVelocity() {
+    std::cout << "\n--- Velocity checks: sliding-window counters per account ---" << std::endl;
+
+    const uint32_t accounts = 100000;
+    const size_t checks = 20000000;
+    const size_t withdrawals = 300000;
+
+    // сам трекер: проверка + учет списания, время идет вперед (окна постоянно сдвигаются)
+    VelocityTracker tracker;
+    VelocityLimits limits;
+    limits.max_count = 1000000;
+    limits.max_amount = 1e12;
+    tracker.setLimits(limits);
+    auto now = VelocityTracker::Clock::now();
+    unsigned seed = 1;
+    size_t allowed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < checks; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        uint32_t account = (seed >> 8) % accounts;
+        auto at = now + std::chrono::milliseconds(i / 16);
+        if (tracker.allow(account, 10000, at)) {
+            tracker.record(account, 10000, at);
+            ++allowed;
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    report("allow + record", checks, elapsed.count());
+    std::cout << "  ns per check: " << elapsed.count() * 1e9 / checks << ", allowed: " << allowed
+        << ", side table: " << tracker.getMemoryUsage() / accounts << " bytes/account" << std::endl;
+
+    // снятие через банк без ограничений и с ними: разница - цена проверки на операцию
+    double seconds[2] = {};
+    {
+        QuietCout quiet;
+        Bank bank;
+        bank.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+        std::vector<std::shared_ptr<Account>> list;
+        for (int i = 0; i < 1000; ++i) {
+            bank.createSavAccount("ACC" + std::to_string(i), 1, 100000000.0, 12);
+            list.push_back(bank.find_acc_by_number("ACC" + std::to_string(i)));
+        }
+        for (int run = 0; run < 2; ++run) {
+            if (run == 1) {
+                bank.setVelocityLimits(limits);
+            }
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < withdrawals; ++i) {
+                bank.tryWithdraw(list[i % list.size()], 1.0);
+            }
+            seconds[run] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+    report("tryWithdraw, no limits", withdrawals, seconds[0]);
+    report("tryWithdraw, velocity limits on", withdrawals, seconds[1]);
+    std::cout << "  overhead per withdrawal: " << (seconds[1] - seconds[0]) * 1e9 / withdrawals << " ns" << std::endl;
+}
+void BenchBankSystem::benchClientIndex() {
+    std::cout << "\n--- Client secondary indexes: 10M clients ---" << std::endl;
+
+    const int clients = 10000000;
+    const int removals = 1000000;
+    const size_t queries = 100000;
+
+    // ~40K различных фамилий из слогов, 1000 городов, 50 стран, даты за 20 лет
+    const char* syllables[] = { "iv", "an", "ov", "pet", "ro", "sid", "kuz", "ne", "tsov", "smi", "rn", "vol", "kov", "mor", "oz", "le", "be", "de", "va", "ko" };
+    auto surname_of = [&](unsigned value) {
+        std::string name;
+        for (int part = 0; part < 3; ++part) {
+            name += syllables[value % 20];
+            value /= 20;
+        }
+        name += syllables[value % 5];
+        name[0] = static_cast<char>(name[0] - 'a' + 'A');
+        return name;
+    };
+    std::vector<std::string> cities;
+    for (int i = 0; i < 1000; ++i) {
+        cities.push_back("City" + std::to_string(i));
+    }
+    std::vector<std::string> countries;
+    for (int i = 0; i < 50; ++i) {
+        countries.push_back("Country" + std::to_string(i));
+    }
+
+    ClientIndex index;
+    index.reserve(clients);
+    unsigned seed = 42;
+    auto start = std::chrono::steady_clock::now();
+    for (int id = 1; id <= clients; ++id) {
+        seed = seed * 1103515245u + 12345u;
+        Date date(1 + seed % 28, 1 + (seed >> 5) % 12, 2005 + (seed >> 9) % 20);
+        index.add(id, surname_of(seed >> 12), Address("Street", cities[(seed >> 3) % 1000], countries[(seed >> 14) % 50], 1), date);
+    }
+    report("add", clients, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        found += index.findBySurnamePrefix(surname_of(seed >> 12).substr(0, 4), 100).size();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("surname prefix (4 chars, limit 100)", queries, seconds);
+    std::cout << "  us per query: " << seconds * 1e6 / queries << ", avg found: " << found / queries << std::endl;
+
+    found = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        found += index.findByCity(cities[seed % 1000], 100).size();
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("city (limit 100)", queries, seconds);
+    std::cout << "  us per query: " << seconds * 1e6 / queries << ", avg found: " << found / queries << std::endl;
+
+    found = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        Date day(1 + seed % 28, 1 + (seed >> 5) % 12, 2005 + (seed >> 9) % 20);
+        found += index.findRegisteredBetween(day, Date(day.day, day.month, day.year + 1), 1000).size();
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report("registration date range (1 year, limit 1000)", queries, seconds);
+    std::cout << "  us per query: " << seconds * 1e6 / queries << ", avg found: " << found / queries << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < removals; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        index.remove(1 + static_cast<int>(seed % clients));
+    }
+    report("remove (random ids)", removals, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    std::cout << "indexed clients after removals: " << index.size() << std::endl;
+}
+namespace {
+    // раскладка Client до пула атрибутов: три std::string адреса и три int даты в каждом объекте
+    class LegacyClient {
+    public:
+        int id;
+        std::string name;
+        std::string surname;
+        Address address;
+        Date registration_date;
+        std::vector<std::shared_ptr<Account>> all_client_accounts;
+
+        LegacyClient(int id_value, const std::string& name_value, const std::string& surname_value, const Address& address_value, const Date& date_value)
+            : id(id_value), name(name_value), surname(surname_value), address(address_value), registration_date(date_value) {
+        }
+        virtual ~LegacyClient() = default;
+    };
+}
+
+void BenchBankSystem::benchClientStorage() {
+    std::cout << "\n--- Client storage: 10M clients, inline strings vs pooled attributes ---" << std::endl;
+
+    const int clients = 10000000;
+    std::vector<std::string> cities;
+    for (int i = 0; i < 1000; ++i) {
+        cities.push_back(i % 4 == 0 ? "Nizhny Novgorod " + std::to_string(i) : "City" + std::to_string(i));
+    }
+    std::vector<std::string> countries;
+    for (int i = 0; i < 50; ++i) {
+        countries.push_back("Country" + std::to_string(i));
+    }
+    auto address_of = [&](int id) {
+        return Address("Krasnoselskaya " + std::to_string(id % 100000), cities[id % 1000], countries[id % 50], 100000 + id % 900000);
+    };
+
+    const char* names[] = { "inline Address/Date (before)", "pooled Address/Date (after)" };
+    double bytes_per_client[2] = {};
+    double seconds[2] = {};
+    for (int run = 0; run < 2; ++run) {
+        std::vector<std::shared_ptr<void>> holder;
+        holder.reserve(clients);
+        size_t bytes_before = live_bytes.load();
+        auto start = std::chrono::steady_clock::now();
+        {
+            QuietCout quiet;
+            for (int id = 1; id <= clients; ++id) {
+                if (run == 0) {
+                    holder.push_back(std::make_shared<LegacyClient>(id, "Ivan", "Ivanov", address_of(id), Date(1 + id % 28, 1 + id % 12, 2000 + id % 25)));
+                }
+                else {
+                    holder.push_back(std::make_shared<Client>(id, "Ivan", "Ivanov", address_of(id), Date(1 + id % 28, 1 + id % 12, 2000 + id % 25)));
+                }
+            }
+        }
+        seconds[run] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        bytes_per_client[run] = static_cast<double>(live_bytes.load() - bytes_before) / clients;
+    }
+    for (int run = 0; run < 2; ++run) {
+        report(names[run], clients, seconds[run]);
+        std::cout << "  heap bytes per client: " << bytes_per_client[run] << ", total: "
+            << bytes_per_client[run] * clients / (1024 * 1024) << " MB" << std::endl;
+    }
+    std::cout << "pool: " << ClientStorage::instance().getInternedCount() << " interned strings, "
+        << ClientStorage::instance().getMemoryUsage() / (1024 * 1024) << " MB with the street arena" << std::endl;
+}
+void BenchBankSystem::benchEntityLinks() {
+    std::cout << "\n--- Entity storage: dense tables and index links ---" << std::endl;
+
+    const int clients = 20000;
+    const int accounts_per_client = 10;
+    const int accounts = clients * accounts_per_client;
+    const size_t deposits = 500000;
+
+    double open_seconds = 0;
+    double deposit_seconds = 0;
+    double lookup_seconds = 0;
+    double delete_seconds = 0;
+    double allocations_per_deposit = 0;
+    double bytes_per_deposit = 0;
+    size_t linked = 0;
+    {
+        QuietCout quiet;
+        Bank bank;
+        std::vector<std::string> numbers;
+        for (int i = 0; i < accounts; ++i) {
+            numbers.push_back("ACC" + std::to_string(i));
+        }
+        for (int id = 1; id <= clients; ++id) {
+            bank.createClient(id, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < accounts; ++i) {
+            bank.createCheckAccount(numbers[i], 1 + i % clients, 0.0);
+        }
+        open_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<std::shared_ptr<Account>> targets;
+        for (int i = 0; i < 1000; ++i) {
+            targets.push_back(bank.find_acc_by_number(numbers[i]));
+        }
+        size_t allocations_before = allocation_count.load();
+        size_t bytes_before = live_bytes.load();
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < deposits; ++i) {
+            bank.registerDeposit(targets[i % targets.size()], 1.0);
+        }
+        deposit_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        allocations_per_deposit = static_cast<double>(allocation_count.load() - allocations_before) / deposits;
+        bytes_per_deposit = static_cast<double>(live_bytes.load() - bytes_before) / deposits;
+
+        start = std::chrono::steady_clock::now();
+        for (int id = 1; id <= clients; ++id) {
+            linked += bank.get_client_accounts(id).size();
+        }
+        lookup_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // закрываем счета без истории (первая 1000 получала депозиты)
+        start = std::chrono::steady_clock::now();
+        for (int i = 1000; i < accounts; ++i) {
+            bank.deleteAccount(numbers[i]);
+        }
+        delete_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    report("open account (linked to client)", accounts, open_seconds);
+    report("registerDeposit (history record + account link)", deposits, deposit_seconds);
+    std::cout << "  allocations per deposit: " << allocations_per_deposit << ", heap bytes per deposit: " << bytes_per_deposit << std::endl;
+    report("get_client_accounts", clients, lookup_seconds);
+    std::cout << "  accounts found: " << linked << std::endl;
+    report("deleteAccount (O(1) unlink)", accounts - 1000, delete_seconds);
+}
+void BenchBankSystem::benchBulkLoader() {
+    std::cout << "\n--- Bulk import: mapped file, parallel parse, one-pass index build ---" << std::endl;
+
+    const int clients = 100000;
+    const int accounts = 1000000;
+    const std::string path = "bench_bulk_import.csv";
+    {
+        std::ofstream file(path, std::ios::binary);
+        for (int id = 1; id <= clients; ++id) {
+            file << "CLIENT," << id << ",Name" << id << ",Surname" << id % 5000 << ",Main St " << id << ",City" << id % 300 << ",Country,10001,"
+                << 1 + id % 28 << ',' << 1 + id % 12 << ",2020\n";
+        }
+        for (int i = 0; i < accounts; ++i) {
+            file << "CHECKING,ACC" << i << ',' << 1 + i % clients << ',' << i % 10000 << ".50\n";
+        }
+    }
+
+    // тот же файл построчно через BatchProcessor (поиск дубликата и вывод на каждую запись)
+    double batch_seconds = 0;
+    size_t batch_rows = 0;
+    {
+        QuietCout quiet;
+        Bank bank;
+        std::ostringstream errors;
+        BatchProcessor batch(bank, errors);
+        auto start = std::chrono::steady_clock::now();
+        batch_rows = batch.runFile(path);
+        batch_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    double bulk_seconds = 0;
+    size_t bulk_rows = 0;
+    {
+        QuietCout quiet;
+        Bank bank;
+        std::ostringstream errors;
+        BulkLoader loader(bank, errors, threads);
+        auto start = std::chrono::steady_clock::now();
+        bulk_rows = loader.loadFile(path);
+        bulk_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::remove(path.c_str());
+
+    report("BatchProcessor (row by row)", batch_rows, batch_seconds);
+    report("BulkLoader (" + std::to_string(threads) + " parse threads)", bulk_rows, bulk_seconds);
+    std::cout << "  speedup: " << batch_seconds / bulk_seconds << "x, estimated time for 10M accounts: "
+        << bulk_seconds * 10000000.0 / accounts << " s" << std::endl;
+}
+void BenchBankSystem::benchStatements() {
+    std::cout << "\n--- Month-end statements from the ledger ---" << std::endl;
+
+    const uint32_t accounts = 200000;
+    const size_t transfers = 3000000;
+    const std::time_t month_start = StatementEngine::monthStart(2024, 3);
+    const std::time_t month_end = StatementEngine::monthStart(2024, 4);
+
+    // два месяца истории: февраль (входит во входящий остаток) и март (строки выписки)
+    const std::time_t history_start = StatementEngine::monthStart(2024, 2);
+    Ledger ledger;
+    ledger.reserveAccounts(accounts);
+    std::vector<uint32_t> index(accounts);
+    for (uint32_t i = 0; i < accounts; ++i) {
+        index[i] = ledger.accountIndex("ACC" + std::to_string(i));
+        Ledger::Leg open[] = { { Ledger::CASH, -100000, Ledger::PRINCIPAL }, { index[i], 100000, Ledger::PRINCIPAL } };
+        ledger.post(Ledger::OPEN, open, 2, history_start);
+    }
+    unsigned seed = 7;
+    for (size_t i = 0; i < transfers; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        uint32_t from = index[seed % accounts];
+        uint32_t to = index[(seed >> 8) % accounts];
+        std::time_t time = history_start + static_cast<std::time_t>((month_end - history_start) * static_cast<double>(i) / transfers);
+        Ledger::Leg legs[] = { { from, -500, Ledger::PRINCIPAL }, { from, -10, Ledger::COMMISSION },
+            { Ledger::COMMISSION_INCOME, 10, Ledger::COMMISSION }, { to, 500, Ledger::PRINCIPAL } };
+        ledger.post(Ledger::TRANSFER, legs, 4, time);
+    }
+
+    StatementEngine engine(ledger);
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t before = live_bytes.load();
+    auto start = std::chrono::steady_clock::now();
+    size_t statements = engine.writeAll(month_start, month_end, "bench_statements", threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t bytes = 0;
+    for (unsigned i = 0; i < threads; ++i) {
+        std::string path = "bench_statements_" + std::to_string(i) + ".txt";
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        bytes += static_cast<size_t>(file.tellg());
+        file.close();
+        std::remove(path.c_str());
+    }
+    report("month-end statements (" + std::to_string(threads) + " workers)", statements, seconds);
+    std::cout << "  legs in ledger: " << ledger.getEntryCount() << ", output: " << bytes / (1024 * 1024) << " MB, "
+        << bytes / seconds / (1024 * 1024) << " MB/s, heap growth after run: " << (live_bytes.load() > before ? live_bytes.load() - before : 0) << " bytes" << std::endl;
+}
+void BenchBankSystem::benchMetrics() {
+    std::cout << "\n--- Operation metrics: recording cost and transfer breakdown ---" << std::endl;
+
+    const size_t records = 10000000;
+    const size_t transfers = 300000;
+
+    Metrics::reset();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < records; ++i) {
+        Metrics::record(Metric::TRANSFER_BATCH, Metrics::Clock::now());
+    }
+    double record_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Metrics::reset();
+    double transfer_seconds = 0;
+    {
+        QuietCout quiet;
+        Bank bank;
+        bank.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+        for (int i = 0; i < 1000; ++i) {
+            bank.createSavAccount("ACC" + std::to_string(i), 1, 1000000.0, 12);
+        }
+        std::vector<std::string> numbers;
+        for (int i = 0; i < 1000; ++i) {
+            numbers.push_back("ACC" + std::to_string(i));
+        }
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < transfers; ++i) {
+            bank.tryTransfer(numbers[i % 1000], numbers[(i * 7 + 1) % 1000], 1.0);
+        }
+        transfer_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    report("Metrics::record (clock read + thread-local histogram)", records, record_seconds);
+    report("tryTransfer with metrics " + std::string(Metrics::enabled() ? "on" : "compiled out"), transfers, transfer_seconds);
+    Metrics::writeReport(std::cout);
+    Metrics::reset();
+}
+void BenchBankSystem::benchTransferAllocations() {
+    std::cout << "\n--- Transfer path: heap allocations per transfer ---" << std::endl;
+
+    const size_t transfers = 200000;
+    const int account_count = 1000;
+
+    // короткие номера помещаются в строку без выделения памяти (SSO), длинные (как IBAN) - нет:
+    // разница между прогонами - копии номеров счетов на пути перевода
+    const char* names[] = { "tryTransfer, short numbers (ACC123)", "tryTransfer, IBAN-length numbers (22 chars)" };
+    double seconds[2] = {};
+    double allocations[2] = {};
+    for (int run = 0; run < 2; ++run) {
+        QuietCout quiet;
+        Bank bank;
+        bank.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+        std::vector<std::string> numbers;
+        for (int i = 0; i < account_count; ++i) {
+            std::string number = std::to_string(i);
+            numbers.push_back(run == 0 ? "ACC" + number : "DE8937040044" + std::string(10 - number.size(), '0') + number);
+            bank.createCheckAccount(numbers.back(), 1, 1000000.0);
+        }
+        // прогрев: рабочие буферы банка и книги набирают емкость
+        for (int i = 0; i < account_count; ++i) {
+            bank.tryTransfer(numbers[i], numbers[(i + 1) % account_count], 1.0);
+        }
+        size_t allocations_before = allocation_count.load();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < transfers; ++i) {
+            bank.tryTransfer(numbers[i % account_count], numbers[(i * 7 + 1) % account_count], 1.0);
+        }
+        seconds[run] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        allocations[run] = static_cast<double>(allocation_count.load() - allocations_before) / transfers;
+    }
+    for (int run = 0; run < 2; ++run) {
+        report(names[run], transfers, seconds[run]);
+        std::cout << "  allocations per transfer: " << allocations[run] << std::endl;
+    }
+    // запись журнала - две Transaction (TRANSFER_OUT и TRANSFER_IN) по два номера счета в каждой
+    std::cout << "  account-number allocations per transfer: " << allocations[1] - allocations[0]
+        << " (journal entry: 2 records x 2 numbers = 4)" << std::endl;
+}
+void BenchBankSystem::benchFxTransfers() {
+    std::cout << "\n--- Cross-currency transfers with concurrent rate updates ---" << std::endl;
+
+    const size_t transfers = 300000;
+    const int account_count = 1000;
+    const char* currencies[] = { "RUB", "USD", "EUR", "CNY" };
+
+    // 0 - одна валюта, 1 - разные валюты без обновлений, 2 - разные валюты, курсы обновляются из другого потока
+    const char* names[] = { "tryTransfer, same currency", "tryTransfer, cross-currency", "tryTransfer, cross-currency, rates updated concurrently" };
+    double seconds[3] = {};
+    size_t updates = 0;
+    uint64_t first_version = 0;
+    uint64_t last_version = 0;
+    for (int run = 0; run < 3; ++run) {
+        QuietCout quiet;
+        Bank bank;
+        bank.getFxRates().setRates({ { "USD", 90.0 }, { "EUR", 98.0 }, { "CNY", 12.5 } });
+        bank.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+        std::vector<std::string> numbers;
+        for (int i = 0; i < account_count; ++i) {
+            numbers.push_back("ACC" + std::to_string(i));
+            bank.createSavAccount(numbers.back(), 1, 1000000.0, 12, run == 0 ? "RUB" : currencies[i % 4]);
+        }
+
+        std::atomic<bool> stop{ false };
+        std::thread updater;
+        if (run == 2) {
+            // поток котировок: новая версия таблицы примерно каждые 50 мкс
+            updater = std::thread([&]() {
+                double shift = 0;
+                while (!stop.load()) {
+                    shift = shift > 1.0 ? 0 : shift + 0.01;
+                    bank.getFxRates().setRates({ { "USD", 90.0 + shift }, { "EUR", 98.0 + shift }, { "CNY", 12.5 + shift / 10 } });
+                    ++updates;
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            });
+        }
+        first_version = bank.getFxRates().getVersion();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < transfers; ++i) {
+            // соседние счета всегда в разных валютах (кроме прогона 0)
+            bank.tryTransfer(numbers[i % account_count], numbers[(i + 1 + (i / account_count) % 3 * 4) % account_count], 10.0);
+        }
+        seconds[run] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stop = true;
+        if (updater.joinable()) {
+            updater.join();
+        }
+        last_version = bank.get_account_transactions(numbers[0]).back()->getFxVersion();
+    }
+    for (int run = 0; run < 3; ++run) {
+        report(names[run], transfers, seconds[run]);
+    }
+    std::cout << "  rate updates during run: " << updates << ", rate versions " << first_version << " -> " << last_version
+        << " recorded on transactions" << std::endl;
+}
+void BenchBankSystem::benchAccountGroups() {
+    std::cout << "\n--- Corporate client: group totals over 100K sub-accounts ---" << std::endl;
+
+    const int divisions = 10;
+    const int departments = 10;
+    const int per_department = 1000;
+    const int account_count = divisions * departments * per_department;
+    const size_t transfers = 200000;
+    const size_t queries = 20000;
+
+    // 0 - счета без групп, 1 - те же счета в дереве холдинг -> 10 дивизионов -> 100 отделов
+    double transfer_seconds[2] = {};
+    double fenwick_seconds = 0;
+    double walk_seconds = 0;
+    size_t walk_queries = 0;
+    double fenwick_total = 0;
+    double walk_total = 0;
+    for (int run = 0; run < 2; ++run) {
+        QuietCout quiet;
+        Bank bank;
+        bank.createClient(1, "Holding", "Corp", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+        std::vector<std::string> numbers;
+        numbers.reserve(account_count);
+        for (int i = 0; i < account_count; ++i) {
+            numbers.push_back("CORP" + std::to_string(i));
+            bank.createSavAccount(numbers.back(), 1, 100000.0, 12);
+        }
+        uint32_t holding = 0;
+        std::vector<uint32_t> division_groups;
+        if (run == 1) {
+            holding = bank.createAccountGroup(1, "Holding");
+            for (int d = 0; d < divisions; ++d) {
+                division_groups.push_back(bank.createAccountGroup(1, "Division " + std::to_string(d), holding));
+                for (int k = 0; k < departments; ++k) {
+                    uint32_t department = bank.createAccountGroup(1, "Department " + std::to_string(k), division_groups.back());
+                    for (int i = 0; i < per_department; ++i) {
+                        bank.assignAccountToGroup(numbers[(d * departments + k) * per_department + i], department);
+                    }
+                }
+            }
+            bank.getGroupTotal(holding); // первая раскладка
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < transfers; ++i) {
+            bank.tryTransfer(numbers[(i * 7919) % account_count], numbers[(i * 104729 + 1) % account_count], 10.0);
+        }
+        transfer_seconds[run] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (run == 1) {
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < queries; ++i) {
+                fenwick_total += bank.getGroupTotal(i % 2 ? holding : division_groups[i % divisions]);
+            }
+            fenwick_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            // прежний способ: получить счета группы и сложить остатки
+            start = std::chrono::steady_clock::now();
+            for (; walk_queries < queries && std::chrono::steady_clock::now() - start < std::chrono::seconds(2); ++walk_queries) {
+                double sum = 0;
+                for (const auto& account : bank.get_group_accounts(walk_queries % 2 ? holding : division_groups[walk_queries % divisions])) {
+                    sum += account->getBalance();
+                }
+                walk_total += sum;
+            }
+            walk_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+    report("tryTransfer, accounts without groups", transfers, transfer_seconds[0]);
+    report("tryTransfer, accounts in 111 groups", transfers, transfer_seconds[1]);
+    report("getGroupTotal (Fenwick, O(log n))", queries, fenwick_seconds);
+    report("walk get_group_accounts and sum", walk_queries, walk_seconds);
+    std::cout << "  average total per query: " << fenwick_total / queries << " (Fenwick) / "
+        << walk_total / std::max<size_t>(walk_queries, 1) << " (walk)" << std::endl;
+}
+void BenchBankSystem::benchAsyncBank() {
+    std::cout << "\n--- Coroutine API: 100K in-flight requests on 2 executor threads ---" << std::endl;
+
+    const int accounts = 10000;
+    const int requests = 100000;
+
+    std::vector<std::string> numbers;
+    for (int i = 0; i < accounts; ++i) {
+        numbers.push_back("ACC" + std::to_string(i));
+    }
+
+    // 0 - AsyncBank (Bank + AsyncMutex), 1 - AsyncShardedBank (4 шарда, переводы между шардами)
+    const char* names[] = { "AsyncBank transfer, 100K spawned", "AsyncShardedBank transfer, 100K spawned" };
+    for (int run = 0; run < 2; ++run) {
+        std::atomic<int> finished{ 0 };
+        std::atomic<int> succeeded{ 0 };
+        int peak_in_flight = 0;
+        size_t spawned_bytes = 0;
+        double seconds = 0;
+        {
+            QuietCout quiet;
+            Executor executor(2);
+            Bank bank;
+            ShardedBank sharded(4);
+            AsyncBank service(bank, executor);
+            AsyncShardedBank sharded_service(sharded, executor);
+            if (run == 0) {
+                bank.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+                for (int i = 0; i < accounts; ++i) {
+                    bank.createSavAccount(numbers[i], 1, 1000000.0, 12);
+                }
+            }
+            else {
+                sharded.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+                for (int i = 0; i < accounts; ++i) {
+                    sharded.createSavAccount(numbers[i], 1, 1000000.0, 12);
+                }
+                sharded.drain();
+            }
+
+            // запрос сервиса: ждет перевода, не занимая поток
+            auto request = [&](int i) -> Task<void> {
+                const std::string& from = numbers[(i * 7919) % accounts];
+                const std::string& to = numbers[(i * 7919 + 1 + i % 97) % accounts];
+                bool ok = run == 0 ? co_await service.transfer(from, to, 10.0) == BankStatus::Ok
+                    : co_await sharded_service.transfer(from, to, 10.0);
+                if (ok) {
+                    succeeded.fetch_add(1, std::memory_order_relaxed);
+                }
+                finished.fetch_add(1, std::memory_order_release);
+            };
+
+            size_t bytes_before = live_bytes.load();
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < requests; ++i) {
+                spawn(executor, request(i));
+            }
+            peak_in_flight = requests - finished.load();
+            spawned_bytes = live_bytes.load() - bytes_before;
+            while (finished.load(std::memory_order_acquire) != requests) {
+                std::this_thread::yield();
+            }
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        report(names[run], requests, seconds);
+        std::cout << "  in flight after spawning: " << peak_in_flight << ", memory per in-flight request: "
+            << spawned_bytes / std::max(peak_in_flight, 1) << " bytes (a thread per request would reserve a whole stack)"
+            << ", succeeded: " << succeeded.load() << std::endl;
+    }
+}
+void BenchBankSystem::benchWorkload() {
+    std::cout << "\n--- Synthetic workload: uniform vs Zipfian account popularity ---" << std::endl;
+
+    const double skews[] = { 0.0, 0.99, 1.2 };
+    for (double skew : skews) {
+        WorkloadConfig config;
+        config.operations = 300000;
+        config.zipf = skew;
+        WorkloadReport report;
+        {
+            QuietCout quiet;
+            Bank bank;
+            WorkloadRunner runner(bank);
+            runner.setup(config);
+            WorkloadGenerator generator(config);
+            report = runner.run(generator);
+        }
+        std::cout << "zipf=" << skew << ": ";
+        report.write(std::cout);
+    }
+}
+void BenchBankSystem::benchHotAccount() {
+    std::cout << "\n--- Skewed transfers: 90% to one merchant account, sharded bank ---" << std::endl;
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+    const int accounts = 2000;
+    const size_t transfers = 400000;
+
+    const std::string merchant = "MERCHANT";
+    std::vector<std::string> numbers;
+    for (int i = 0; i < accounts; ++i) {
+        numbers.push_back("ACC" + std::to_string(i));
+    }
+
+    for (size_t shard_count = 1; shard_count <= 8; shard_count *= 2) {
+        double seconds[2] = {};
+        for (int hot = 0; hot < 2; ++hot) {
+            QuietCout quiet;
+            ShardedBank sharded(shard_count);
+            sharded.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+            for (int i = 0; i < accounts; ++i) {
+                sharded.createSavAccount(numbers[i], 1, 1000000.0, 12);
+            }
+            sharded.createSavAccount(merchant, 1, 5000.0, 12);
+            sharded.drain();
+            if (hot) {
+                sharded.setHotAccount(merchant);
+            }
+
+            unsigned seed = 12345;
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < transfers; ++i) {
+                seed = seed * 1103515245u + 12345u;
+                int from = static_cast<int>((seed >> 8) % accounts);
+                const std::string& to = (seed >> 4) % 10 != 0 ? merchant : numbers[(from + 1) % accounts];
+                sharded.transfer(numbers[from], to, 10.0);
+            }
+            sharded.drain();
+            seconds[hot] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        report("shards=" + std::to_string(shard_count) + ", merchant on one shard", transfers, seconds[0]);
+        report("shards=" + std::to_string(shard_count) + ", merchant hot (striped credits)", transfers, seconds[1]);
+    }
+}
+
+void BenchBankSystem::benchTransactionArchive() {
+    std::cout << "\n--- Transaction archive: size, memory and audit scans ---" << std::endl;
+
+    const int accounts = 1000;
+    const size_t transfers = 200000;
+    const std::string path = "bench_archive_segment.bkar";
+    std::remove(path.c_str()); // файл прерванного запуска: существующий сегмент не перезаписывается
+
+    Bank bank;
+    size_t records = 0;
+    size_t freed = 0;
+    double archive_seconds = 0;
+    {
+        QuietCout quiet;
+        bank.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+        for (int i = 0; i < accounts; ++i) {
+            bank.createSavAccount("ACC" + std::to_string(i), 1, 1000000.0, 12);
+        }
+        unsigned seed = 12345;
+        for (size_t i = 0; i < transfers; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            int from = static_cast<int>((seed >> 8) % accounts);
+            int to = (from + 1 + static_cast<int>((seed >> 4) % (accounts - 1))) % accounts;
+            bank.tryTransfer("ACC" + std::to_string(from), "ACC" + std::to_string(to), 1.0 + (seed >> 16) % 100000 / 100.0);
+        }
+
+        records = bank.getTransactionCount();
+        size_t bytes_before = live_bytes.load();
+        auto start = std::chrono::steady_clock::now();
+        bank.archive_transactions(std::time(nullptr) + 1, path);
+        archive_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        freed = bytes_before - live_bytes.load();
+    }
+    ArchiveSegment segment = ArchiveSegment::open(path);
+
+    auto start = std::chrono::steady_clock::now();
+    size_t scanned = bank.audit_transactions(0, std::time(nullptr) + 3600, [](const TransactionView&) {});
+    double scan_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const int audits = 200;
+    start = std::chrono::steady_clock::now();
+    size_t account_records = 0;
+    for (int i = 0; i < audits; ++i) {
+        account_records += bank.audit_account_history("ACC" + std::to_string(i), 0, std::time(nullptr) + 3600, [](const TransactionView&) {});
+    }
+    double audit_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < audits; ++i) {
+        bank.audit_account_history("NO-SUCH-" + std::to_string(i), 0, std::time(nullptr) + 3600, [](const TransactionView&) {});
+    }
+    double pruned_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::remove(path.c_str());
+
+    std::cout << "records archived: " << records << ", memory freed: " << static_cast<double>(freed) / records << " bytes/record" << std::endl;
+    std::cout << "segment: " << static_cast<double>(segment.getFileBytes()) / records << " bytes/record on disk, "
+        << static_cast<double>(segment.getLogicalBytes()) / segment.getFileBytes() << "x smaller than the plain fields" << std::endl;
+    report("archive (encode + write)", records, archive_seconds);
+    report("full audit scan", scanned, scan_seconds);
+    std::cout << "  scan rate: " << segment.getLogicalBytes() / scan_seconds / 1e9 << " GB/s of plain fields" << std::endl;
+    report("account audit (" + std::to_string(account_records / audits) + " records each)", audits, audit_seconds);
+    report("account audit, segment pruned by footer", audits, pruned_seconds);
+}
+
+void BenchBankSystem::benchLookupFilter() {
+    std::cout << "\n--- Lookups of nonexistent account numbers ---" << std::endl;
+
+    const int accounts = 200000;
+    const size_t lookups = 1000000;
+
+    Bank bank;
+    std::unordered_map<std::string, uint32_t> plain_index; // индекс без фильтра - как было до него
+    {
+        QuietCout quiet;
+        bank.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+        for (int i = 0; i < accounts; ++i) {
+            std::string number = "ACC" + std::to_string(i);
+            bank.createCheckAccount(number, 1, 0.0);
+            plain_index.emplace(number, i);
+        }
+    }
+    std::vector<std::string> missing;
+    for (size_t i = 0; i < 4096; ++i) {
+        missing.push_back("ACX" + std::to_string(i * 7919 % 1000003));
+    }
+    LookupFilter filter(accounts);
+    for (int i = 0; i < accounts; ++i) {
+        filter.add(LookupFilter::hashOf("ACC" + std::to_string(i)));
+    }
+
+    size_t hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i) {
+        hits += plain_index.find(missing[i & 4095]) != plain_index.end();
+    }
+    report("unordered_map miss", lookups, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    size_t filter_hits = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i) {
+        filter_hits += filter.mayContain(LookupFilter::hashOf(missing[i & 4095]));
+    }
+    report("Bloom filter miss", lookups, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    Metrics::reset();
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i) {
+        hits += bank.find_acc_by_number(missing[i & 4095]) != nullptr;
+    }
+    report("Bank::find_acc_by_number miss", lookups, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    const std::string existing = "ACC1";
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; ++i) {
+        hits += bank.tryTransfer(existing, missing[i & 4095], 1.0) == BankStatus::Ok;
+    }
+    report("Bank::tryTransfer to a missing account", lookups, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    MetricsSnapshot data = Metrics::snapshot();
+    std::cout << "filter: " << filter.getMemoryBytes() / 1024 << " KB for " << accounts << " keys, false positives "
+        << filter_hits * 100.0 / lookups << "%; bank filters (after growth): " << Metrics::lookupFilterFalsePositiveRate(data) * 100.0
+        << "%, found: " << hits << std::endl;
+    Metrics::reset();
+}
+
+// раскладка расчетного счета до разделения: горячие поля в одном объекте с холодными
+struct InterleavedAccount {
+    virtual ~InterleavedAccount() = default;
+    std::string accountNumber;
+    int client_id = 0;
+    std::string type;
+    std::string currency;
+    std::atomic<void*> balance_versions{ nullptr };
+    void* spare_version = nullptr;
+    double balance = 0;
+    double commission = 0;
+    double available_overdraft = 0;
+    double overdraft_limit = 0;
+};
+
+// списание с комиссией и овердрафтом и зачисление - те же поля, что трогает CheckingAccount
+template <typename Record>
+static bool applyTransfer(Record& from, Record& to, double amount) {
+    double commission = amount / 100 * std::min(2 * (amount / 500), 20.0);
+    double total = amount + commission;
+    if (total > from.balance + from.available_overdraft) {
+        return false;
+    }
+    if (total <= from.balance) {
+        from.balance -= total;
+    }
+    else {
+        from.available_overdraft -= total - from.balance;
+        from.balance = 0;
+    }
+    from.commission = commission;
+    to.balance += amount;
+    return true;
+}
+
+template <typename Lookup>
+static double runRandomTransfers(size_t accounts, size_t transfers, Lookup lookup, size_t& applied) {
+    uint64_t seed = 12345;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < transfers; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t from = static_cast<size_t>(seed >> 33) % accounts;
+        size_t to = static_cast<size_t>(seed >> 11) % accounts;
+        applied += applyTransfer(lookup(from), lookup(to), 1.0 + static_cast<double>(seed & 0xffff) / 100.0);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BenchBankSystem::benchAccountLayout() {
+    std::cout << "\n--- Random transfers over 10M accounts: interleaved vs hot/cold split account fields, then a smaller bank through Bank::tryTransfer ---" << std::endl;
+
+    const size_t accounts = 10000000;
+    const size_t transfers = 10000000;
+    size_t applied = 0;
+
+    double interleaved_seconds = 0;
+    {
+        // как таблица счетов банка: shared_ptr на объекты, созданные по одному
+        std::vector<std::shared_ptr<InterleavedAccount>> table;
+        table.reserve(accounts);
+        for (size_t i = 0; i < accounts; ++i) {
+            auto account = std::make_shared<InterleavedAccount>();
+            account->accountNumber = "ACC" + std::to_string(i);
+            account->type = "Checking";
+            account->currency = "RUB";
+            account->balance = 100000.0;
+            table.push_back(std::move(account));
+        }
+        interleaved_seconds = runRandomTransfers(accounts, transfers, [&](size_t i) -> InterleavedAccount& { return *table[i]; }, applied);
+    }
+
+    double split_seconds = 0;
+    {
+        BalanceStore::shared()->reserve(accounts);
+        std::vector<BalanceSlot> table;
+        table.reserve(accounts);
+        for (size_t i = 0; i < accounts; ++i) {
+            table.emplace_back();
+            table.back()->balance = 100000.0;
+        }
+        split_seconds = runRandomTransfers(accounts, transfers, [&](size_t i) -> BalanceRecord& { return *table[i]; }, applied);
+    }
+
+    InterleavedAccount sample;
+    std::cout << "account object before the split: " << sizeof(InterleavedAccount) << " bytes (hot fields at offset "
+        << reinterpret_cast<char*>(&sample.balance) - reinterpret_cast<char*>(&sample) << "), hot record: " << sizeof(BalanceRecord) << " bytes, transfers applied: " << applied << std::endl;
+    report("interleaved fields (object per account)", transfers, interleaved_seconds);
+    report("hot/cold split (BalanceRecord array)", transfers, split_seconds);
+
+    // то же через настоящий путь перевода (поиск, проверки, проводка, журнал, версии MVCC) - на меньшем банке
+    const size_t bank_accounts = 200000;
+    const size_t bank_transfers = 1000000;
+    size_t bank_applied = 0;
+    double bank_seconds = 0;
+    {
+        QuietCout quiet; // и на разрушение банка
+        Bank bank;
+        std::vector<std::string> numbers;
+        numbers.reserve(bank_accounts);
+        bank.createClient(1, "Name", "Surname", Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+        for (size_t i = 0; i < bank_accounts; ++i) {
+            numbers.push_back("ACC" + std::to_string(i));
+            bank.createCheckAccount(numbers.back(), 1, 100000.0);
+        }
+        uint64_t seed = 12345;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < bank_transfers; ++i) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            size_t from = static_cast<size_t>(seed >> 33) % bank_accounts;
+            size_t to = static_cast<size_t>(seed >> 11) % bank_accounts;
+            bank_applied += bank.tryTransfer(numbers[from], numbers[to], 1.0 + static_cast<double>(seed & 0xffff) / 100.0) == BankStatus::Ok;
+        }
+        bank_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::cout << "bank: " << bank_accounts << " accounts in its own balance store, transfers applied: " << bank_applied << std::endl;
+    report("Bank::tryTransfer (200K accounts)", bank_transfers, bank_seconds);
+}
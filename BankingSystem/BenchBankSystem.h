@@ -0,0 +1,38 @@
+﻿#pragma once
+
+#include "Bank.h"
+#include <iostream>
+#include <string>
+
+// Замеры производительности (запуск: BankingSystem --bench)
+class BenchBankSystem {
+private:
+    void report(const std::string& name, size_t operations, double seconds);
+
+    void benchBatchMode();
+    void benchShardedBank();
+    void benchIdempotency();
+    void benchChangeFeed();
+    void benchDeclinedTransfers();
+    void benchLedger();
+    void benchStandingOrders();
+    void benchVelocity();
+    void benchClientIndex();
+    void benchClientStorage();
+    void benchEntityLinks();
+    void benchBulkLoader();
+    void benchStatements();
+    void benchMetrics();
+    void benchTransferAllocations();
+    void benchFxTransfers();
+    void benchAccountGroups();
+    void benchAsyncBank();
+    void benchWorkload();
+    void benchHotAccount();
+    void benchTransactionArchive();
+    void benchLookupFilter();
+    void benchAccountLayout();
+
+public:
+    void runAllBenchmarks();
+};
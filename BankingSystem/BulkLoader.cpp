@@ -0,0 +1,351 @@
+﻿#include "BulkLoader.h"
+#include "BatchProcessor.h"
+#include "Client.h"
+#include "PremiumClient.h"
+#include "CheckingAccount.h"
+#include "SavingsAccount.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Banking;
+
+namespace {
+
+    // файл, отображенный в память только для чтения
+    class MappedFile {
+    private:
+        const char* data = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#endif
+
+    public:
+        explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            LARGE_INTEGER file_size;
+            if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &file_size)) {
+                close();
+                throw std::runtime_error("Cannot open import file: " + path);
+            }
+            size = static_cast<size_t>(file_size.QuadPart);
+            if (size > 0) {
+                mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                data = mapping ? static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+                if (!data) {
+                    close();
+                    throw std::runtime_error("Cannot map import file: " + path);
+                }
+            }
+#else
+            int fd = ::open(path.c_str(), O_RDONLY);
+            struct stat info;
+            if (fd < 0 || ::fstat(fd, &info) != 0) {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+                throw std::runtime_error("Cannot open import file: " + path);
+            }
+            size = static_cast<size_t>(info.st_size);
+            if (size > 0) {
+                void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapped == MAP_FAILED) {
+                    ::close(fd);
+                    throw std::runtime_error("Cannot map import file: " + path);
+                }
+                ::madvise(mapped, size, MADV_SEQUENTIAL);
+                data = static_cast<const char*>(mapped);
+            }
+            ::close(fd); // отображение остается действительным и после закрытия дескриптора
+#endif
+        }
+
+        ~MappedFile() {
+            close();
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        std::string_view view() const { return std::string_view(data, size); }
+
+    private:
+        void close() {
+#ifdef _WIN32
+            if (data) {
+                UnmapViewOfFile(data);
+            }
+            if (mapping) {
+                CloseHandle(mapping);
+            }
+            if (file != INVALID_HANDLE_VALUE) {
+                CloseHandle(file);
+            }
+            mapping = nullptr;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (data) {
+                ::munmap(const_cast<char*>(data), size);
+            }
+#endif
+            data = nullptr;
+        }
+    };
+
+    bool isSkipped(std::string_view line) {
+        size_t first = line.find_first_not_of(" \t\r");
+        return first == std::string_view::npos || line[first] == '#';
+    }
+
+    bool isPremiumLevel(std::string_view level) {
+        return level == "Silver" || level == "Gold" || level == "Platinum";
+    }
+}
+
+BulkLoader::BulkLoader(Bank& bank_value, std::ostream& errors_value, unsigned threads_value)
+    : bank(bank_value), errors(errors_value), threads(threads_value) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+// разбор и проверка одной строки: те же проверки, что в конструкторах моделей,
+// чтобы почти все ошибки находились параллельно, а не при создании объектов
+void BulkLoader::parseLine(std::string_view line, size_t line_number, Chunk& chunk) {
+    std::string_view fields[BatchProcessor::MAX_FIELDS];
+    size_t count = BatchProcessor::splitFields(line, fields);
+    if (count > BatchProcessor::MAX_FIELDS) {
+        chunk.errors.push_back({ line_number, "too many fields" });
+        return;
+    }
+    std::string_view command = fields[0];
+
+    if (command == "CLIENT" || command == "PREMIUM") {
+        ClientRow row{};
+        row.line = line_number;
+        row.premium = command == "PREMIUM";
+        if (count != (row.premium ? 12u : 11u) || !BatchProcessor::parseInt(fields[1], row.id) || !BatchProcessor::parseInt(fields[7], row.post_id)
+            || !BatchProcessor::parseInt(fields[8], row.day) || !BatchProcessor::parseInt(fields[9], row.month) || !BatchProcessor::parseInt(fields[10], row.year)) {
+            chunk.errors.push_back({ line_number, row.premium ? "expected PREMIUM,id,name,surname,street,city,country,post_id,day,month,year,level"
+                                                              : "expected CLIENT,id,name,surname,street,city,country,post_id,day,month,year" });
+            return;
+        }
+        row.name = fields[2];
+        row.surname = fields[3];
+        row.street = fields[4];
+        row.city = fields[5];
+        row.country = fields[6];
+        if (row.premium) {
+            row.level = fields[11];
+        }
+        if (row.name.empty() || row.surname.empty()) {
+            chunk.errors.push_back({ line_number, "Name and surname cannot be empty" });
+        }
+        else if (row.id <= 0) {
+            chunk.errors.push_back({ line_number, "ID must be positive" });
+        }
+        else if (!Date(row.day, row.month, row.year).isValid()) {
+            chunk.errors.push_back({ line_number, "Invalid registration date" });
+        }
+        else if (row.premium && !isPremiumLevel(row.level)) {
+            chunk.errors.push_back({ line_number, "Invalid premium level. Must be Silver, Gold, or Platinum" });
+        }
+        else {
+            chunk.clients.push_back(row);
+        }
+    }
+    else if (command == "CHECKING" || command == "SAVINGS") {
+        AccountRow row{};
+        row.line = line_number;
+        row.savings = command == "SAVINGS";
+        size_t required = row.savings ? 5 : 4; // последнее необязательное поле - валюта
+        if (row.savings) {
+            if ((count != required && count != required + 1) || !BatchProcessor::parseInt(fields[2], row.client_id)
+                || !BatchProcessor::parseDouble(fields[3], row.balance) || !BatchProcessor::parseInt(fields[4], row.months)) {
+                chunk.errors.push_back({ line_number, "expected SAVINGS,account_number,client_id,initial_balance,months[,currency]" });
+                return;
+            }
+        }
+        else if ((count != required && count != required + 1) || !BatchProcessor::parseInt(fields[2], row.client_id)
+            || !BatchProcessor::parseDouble(fields[3], row.balance)) {
+            chunk.errors.push_back({ line_number, "expected CHECKING,account_number,client_id,initial_balance[,currency]" });
+            return;
+        }
+        row.number = fields[1];
+        row.currency = count > required ? fields[required] : std::string_view(Banking::DEFAULT_CURRENCY);
+        if (row.number.empty()) {
+            chunk.errors.push_back({ line_number, "Account number cannot be empty" });
+        }
+        else if (row.balance < 0) {
+            chunk.errors.push_back({ line_number, "Initial balance cannot be negative" });
+        }
+        else if (row.savings && row.balance < 5000) {
+            chunk.errors.push_back({ line_number, "Balance in SavingsAccount cannot be <5000" });
+        }
+        else if (row.savings && row.months < 1) {
+            chunk.errors.push_back({ line_number, "Months value cannot be <1" });
+        }
+        else {
+            chunk.accounts.push_back(row);
+        }
+    }
+    else {
+        chunk.errors.push_back({ line_number, "unknown command (bulk import accepts CLIENT, PREMIUM, CHECKING, SAVINGS)" });
+    }
+}
+
+void BulkLoader::parseChunk(Chunk& chunk) {
+    std::string_view rest = chunk.text;
+    while (!rest.empty()) {
+        size_t end = rest.find('\n');
+        std::string_view line = rest.substr(0, end);
+        ++chunk.line_count;
+        if (!isSkipped(line)) {
+            parseLine(line, chunk.line_count, chunk);
+        }
+        if (end == std::string_view::npos) {
+            break;
+        }
+        rest.remove_prefix(end + 1);
+    }
+}
+
+size_t BulkLoader::load(std::string_view buffer) {
+    // куски режутся по границам строк, не меньше ~64 КБ на поток
+    size_t chunk_count = std::max<size_t>(1, std::min<size_t>(threads, buffer.size() / (64 * 1024)));
+    std::vector<Chunk> chunks(chunk_count);
+    size_t begin = 0;
+    for (size_t i = 0; i < chunk_count; ++i) {
+        size_t end = buffer.size();
+        if (i + 1 < chunk_count) {
+            end = std::max(begin, buffer.size() * (i + 1) / chunk_count);
+            size_t newline = buffer.find('\n', end);
+            end = newline == std::string_view::npos ? buffer.size() : newline + 1;
+        }
+        chunks[i].text = buffer.substr(begin, end - begin);
+        begin = end;
+    }
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < chunk_count; ++i) {
+        workers.emplace_back(parseChunk, std::ref(chunks[i]));
+    }
+    parseChunk(chunks[0]);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // локальные номера строк -> номера строк файла
+    std::vector<LineError> line_errors;
+    size_t clients_total = 0;
+    size_t accounts_total = 0;
+    size_t line_offset = 0;
+    for (auto& chunk : chunks) {
+        for (auto& row : chunk.clients) {
+            row.line += line_offset;
+        }
+        for (auto& row : chunk.accounts) {
+            row.line += line_offset;
+        }
+        for (auto& error : chunk.errors) {
+            error.line += line_offset;
+            line_errors.push_back(std::move(error));
+        }
+        clients_total += chunk.clients.size();
+        accounts_total += chunk.accounts.size();
+        line_offset += chunk.line_count;
+    }
+
+    // создание объектов: конструкторы моделей пишут в cout, поэтому - в одном потоке
+    std::vector<std::shared_ptr<Client>> clients;
+    std::vector<size_t> client_lines;
+    std::vector<std::shared_ptr<Account>> accounts;
+    std::vector<size_t> account_lines;
+    std::vector<int> account_clients;
+    clients.reserve(clients_total);
+    client_lines.reserve(clients_total);
+    accounts.reserve(accounts_total);
+    account_lines.reserve(accounts_total);
+    account_clients.reserve(accounts_total);
+    const std::shared_ptr<BalanceStore>& store = bank.getBalanceStore(); // записи счетов - подряд в хранилище банка
+    store->reserve(accounts_total);
+    std::vector<size_t> rejected_clients;
+    std::vector<size_t> rejected_accounts;
+    {
+        QuietCout quiet;
+        for (const auto& chunk : chunks) {
+            for (const auto& row : chunk.clients) {
+                try {
+                    Address address{ std::string(row.street), std::string(row.city), std::string(row.country), row.post_id };
+                    Date date(row.day, row.month, row.year);
+                    if (row.premium) {
+                        clients.push_back(std::make_shared<PremiumClient>(row.id, std::string(row.name), std::string(row.surname), address, date, std::string(row.level)));
+                    }
+                    else {
+                        clients.push_back(std::make_shared<Client>(row.id, std::string(row.name), std::string(row.surname), address, date));
+                    }
+                    client_lines.push_back(row.line);
+                }
+                catch (const std::exception& e) {
+                    line_errors.push_back({ row.line, e.what() });
+                }
+            }
+        }
+        for (const auto& chunk : chunks) {
+            for (const auto& row : chunk.accounts) {
+                try {
+                    if (row.savings) {
+                        accounts.push_back(std::make_shared<SavingsAccount>(std::string(row.number), row.client_id, row.balance, row.months, std::string(row.currency), store));
+                    }
+                    else {
+                        accounts.push_back(std::make_shared<CheckingAccount>(std::string(row.number), row.client_id, row.balance, std::string(row.currency), store));
+                    }
+                    account_lines.push_back(row.line);
+                    account_clients.push_back(row.client_id);
+                }
+                catch (const std::exception& e) {
+                    line_errors.push_back({ row.line, e.what() });
+                }
+            }
+        }
+        bank.importEntities(clients, accounts, rejected_clients, rejected_accounts);
+    }
+
+    for (size_t index : rejected_clients) {
+        line_errors.push_back({ client_lines[index], "You already have this client in bank" });
+    }
+    for (size_t index : rejected_accounts) {
+        // те же сообщения, что у createClient / createCheckAccount
+        int client_id = account_clients[index];
+        line_errors.push_back({ account_lines[index], bank.find_client_by_id(client_id) ? std::string("You already have an account with this number")
+                                                                                        : "Client with id " + std::to_string(client_id) + " not found" });
+    }
+    std::sort(line_errors.begin(), line_errors.end(), [](const LineError& a, const LineError& b) { return a.line < b.line; });
+    for (const auto& error : line_errors) {
+        errors << "line " << error.line << ": " << error.message << '\n';
+    }
+
+    loaded_clients += clients.size() - rejected_clients.size();
+    loaded_accounts += accounts.size() - rejected_accounts.size();
+    failed += line_errors.size();
+    return clients.size() - rejected_clients.size() + accounts.size() - rejected_accounts.size();
+}
+
+size_t BulkLoader::loadFile(const std::string& path) {
+    MappedFile file(path);
+    return load(file.view());
+}
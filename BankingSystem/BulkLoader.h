@@ -0,0 +1,76 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <iostream>
+#include "Bank.h"
+
+// Массовая загрузка клиентов и счетов (миграция из другой системы).
+// Файл отображается в память и делится на куски по границам строк; куски разбираются
+// и проверяются параллельно, затем объекты создаются и банк заполняется одним вызовом
+// Bank::importEntities - без поиска дубликатов на каждую запись и без вывода на каждую запись.
+//
+// Формат строк - как у BatchProcessor, допускаются только команды создания:
+//   CLIENT,id,name,surname,street,city,country,post_id,day,month,year
+//   PREMIUM,id,name,surname,street,city,country,post_id,day,month,year,level
+//   CHECKING,account_number,client_id,initial_balance[,currency]
+//   SAVINGS,account_number,client_id,initial_balance,months[,currency]
+// Клиенты загружаются раньше счетов, поэтому счет может стоять в файле до своего клиента.
+class BulkLoader {
+private:
+    struct ClientRow {
+        size_t line;
+        bool premium;
+        int id;
+        int post_id;
+        int day, month, year;
+        std::string_view name, surname, street, city, country, level;
+    };
+
+    struct AccountRow {
+        size_t line;
+        bool savings;
+        std::string_view number;
+        int client_id;
+        double balance;
+        int months;
+        std::string_view currency;
+    };
+
+    struct LineError {
+        size_t line;
+        std::string message;
+    };
+
+    // кусок файла, который разбирает один поток; номера строк внутри куска локальные
+    struct Chunk {
+        std::string_view text;
+        size_t line_count = 0;
+        std::vector<ClientRow> clients;
+        std::vector<AccountRow> accounts;
+        std::vector<LineError> errors;
+    };
+
+    Banking::Bank& bank;
+    std::ostream& errors; // сюда пишутся ошибки с номером строки
+    unsigned threads;
+
+    size_t loaded_clients = 0;
+    size_t loaded_accounts = 0;
+    size_t failed = 0;
+
+    static void parseChunk(Chunk& chunk);
+    static void parseLine(std::string_view line, size_t line_number, Chunk& chunk);
+
+public:
+    // threads = 0 - по числу ядер
+    explicit BulkLoader(Banking::Bank& bank_value, std::ostream& errors_value = std::cerr, unsigned threads_value = 0);
+
+    // загрузить буфер / файл, возвращает количество загруженных клиентов и счетов
+    size_t load(std::string_view buffer);
+    size_t loadFile(const std::string& path);
+
+    size_t getClientCount() const { return loaded_clients; }
+    size_t getAccountCount() const { return loaded_accounts; }
+    size_t getFailedCount() const { return failed; }
+};
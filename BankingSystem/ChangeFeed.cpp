@@ -0,0 +1,144 @@
+﻿#include "ChangeFeed.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace Banking {
+
+    static_assert(sizeof(ChangeEvent) % sizeof(uint64_t) == 0, "ChangeEvent must be a whole number of words");
+
+    ChangeEvent ChangeEvent::make(Kind kind_value, const std::string& account_value, const std::string& counterpart_value,
+        double amount_value, double balance_value, int client_id_value) {
+        ChangeEvent event;
+        std::memset(&event, 0, sizeof(event));
+        event.timestamp = static_cast<int64_t>(std::time(nullptr));
+        event.amount = amount_value;
+        event.balance_after = balance_value;
+        std::strncpy(event.account, account_value.c_str(), sizeof(event.account) - 1);
+        std::strncpy(event.counterpart, counterpart_value.c_str(), sizeof(event.counterpart) - 1);
+        event.kind = kind_value;
+        event.client_id = client_id_value;
+        return event;
+    }
+
+    ChangeFeed::Subscription::Subscription(ChangeFeed& feed_value, Policy policy_value, uint64_t start)
+        : feed(feed_value), policy(policy_value), cursor(start) {
+    }
+
+    bool ChangeFeed::Subscription::poll(ChangeEvent& event) {
+        uint64_t next = cursor.load(std::memory_order_relaxed);
+        uint64_t newest = 0;
+        while (true) {
+            if (feed.read(next, event, newest)) {
+                cursor.store(next + 1, std::memory_order_release);
+                if (policy == Policy::Backpressure) {
+                    // пара к барьеру писателя: либо он увидит новый курсор, либо мы - его флаг ожидания
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (feed.writer_waiting.load(std::memory_order_relaxed)) {
+                        feed.cursor_moves.notify();
+                    }
+                }
+                return true;
+            }
+            if (newest <= next) {
+                return false; // событие еще не опубликовано
+            }
+            // слот уже перезаписан: перескакиваем на самое старое событие, которое еще лежит в буфере
+            uint64_t oldest = newest - std::min<uint64_t>(newest, feed.getCapacity());
+            dropped.fetch_add(oldest > next ? oldest - next : 1);
+            next = std::max(oldest, next + 1);
+        }
+    }
+
+    ChangeFeed::ChangeFeed(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots.reset(new Slot[size]);
+        mask = size - 1;
+    }
+
+    std::shared_ptr<ChangeFeed::Subscription> ChangeFeed::subscribe(Policy policy) {
+        std::lock_guard<std::mutex> lock(subscribers_mutex);
+        auto subscription = std::make_shared<Subscription>(*this, policy, head.load());
+        subscribers.push_back(subscription);
+        return subscription;
+    }
+
+    void ChangeFeed::unsubscribe(const std::shared_ptr<Subscription>& subscription) {
+        std::lock_guard<std::mutex> lock(subscribers_mutex);
+        subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), subscription), subscribers.end());
+        cursor_moves.notify(); // писатель мог ждать именно этого подписчика
+    }
+
+    // медленный путь писателя: буфер заполнен до самого медленного backpressure-подписчика -
+    // писатель спит, а не крутится, и не отнимает subscribers_mutex у читателей
+    void ChangeFeed::waitForBackpressure(uint64_t sequence) {
+        writer_waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cursor_moves.waitUntil([&]() { return backpressureAllows(sequence); });
+        writer_waiting.store(false, std::memory_order_relaxed);
+    }
+
+    bool ChangeFeed::backpressureAllows(uint64_t sequence) {
+        uint64_t slowest = UINT64_MAX;
+        {
+            std::lock_guard<std::mutex> lock(subscribers_mutex);
+            for (const auto& subscription : subscribers) {
+                if (subscription->policy == Policy::Backpressure) {
+                    slowest = std::min(slowest, subscription->cursor.load(std::memory_order_acquire));
+                }
+            }
+        }
+        if (slowest == UINT64_MAX || sequence < slowest + getCapacity()) {
+            backpressure_limit = slowest == UINT64_MAX ? UINT64_MAX : slowest + getCapacity();
+            return true;
+        }
+        return false;
+    }
+
+    void ChangeFeed::publish(ChangeEvent event) {
+        uint64_t sequence = head.load(std::memory_order_relaxed);
+        if (sequence >= backpressure_limit || sequence % getCapacity() == 0) {
+            // раз за круг буфера (или когда уперлись в лимит) пересчитываем самого медленного подписчика
+            waitForBackpressure(sequence);
+        }
+        event.sequence = sequence;
+
+        uint64_t words[WORDS];
+        std::memcpy(words, &event, sizeof(event));
+
+        Slot& slot = slots[sequence & mask];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.sequence.store(sequence + 1, std::memory_order_release);
+        head.store(sequence + 1, std::memory_order_release);
+    }
+
+    // чтение слота по схеме seqlock: если номер изменился во время копирования - событие потеряно
+    bool ChangeFeed::read(uint64_t sequence, ChangeEvent& event, uint64_t& newest) const {
+        newest = head.load(std::memory_order_acquire);
+        if (sequence >= newest) {
+            return false;
+        }
+        const Slot& slot = slots[sequence & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != sequence + 1) {
+            return false;
+        }
+        uint64_t words[WORDS];
+        for (size_t i = 0; i < WORDS; ++i) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence + 1) {
+            return false;
+        }
+        std::memcpy(&event, words, sizeof(event));
+        return true;
+    }
+
+}
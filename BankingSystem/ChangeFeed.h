@@ -0,0 +1,102 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include "Wakeup.h"
+
+namespace Banking {
+
+    // Компактное двоичное событие изменения баланса (фиксированный размер, без указателей)
+    struct ChangeEvent {
+        enum Kind : uint32_t {
+            ACCOUNT_OPENED = 1,
+            ACCOUNT_CLOSED = 2,
+            DEPOSIT = 3,
+            WITHDRAW = 4,
+            TRANSFER_OUT = 5,
+            TRANSFER_IN = 6
+        };
+
+        uint64_t sequence;     // номер события в ленте (заполняет ChangeFeed)
+        int64_t timestamp;
+        double amount;
+        double balance_after;
+        char account[24];      // номер счета (обрезается до 23 символов)
+        char counterpart[24];  // второй счет перевода
+        uint32_t kind;
+        int32_t client_id;
+
+        static ChangeEvent make(Kind kind_value, const std::string& account_value, const std::string& counterpart_value,
+            double amount_value, double balance_value, int client_id_value);
+    };
+
+    // Лента изменений: кольцевой буфер "один писатель - много читателей".
+    // Писатель - банк (публикует один поток за раз, уже без блокировки записи банка), читатели опрашивают ленту со своей скоростью.
+    // Политики подписчика:
+    //   Drop         - отставший читатель теряет старые события (писатель никогда не ждет)
+    //   Backpressure - писатель ждет, пока такой читатель не освободит место в буфере. Такой читатель может
+    //                  читать банк, но не должен менять его из своего потока: публикация его же события
+    //                  при заполненном буфере ждала бы его самого
+    class ChangeFeed {
+    public:
+        enum class Policy { Drop, Backpressure };
+
+        class Subscription {
+        private:
+            friend class ChangeFeed;
+            ChangeFeed& feed;
+            Policy policy;
+            std::atomic<uint64_t> cursor; // номер следующего события для чтения
+            std::atomic<uint64_t> dropped{ 0 };
+
+        public:
+            Subscription(ChangeFeed& feed_value, Policy policy_value, uint64_t start);
+
+            // забрать следующее событие; false - новых событий пока нет
+            bool poll(ChangeEvent& event);
+            uint64_t getDroppedCount() const { return dropped.load(); }
+            Policy getPolicy() const { return policy; }
+        };
+
+    private:
+        static const size_t WORDS = sizeof(ChangeEvent) / sizeof(uint64_t);
+
+        // слот хранит событие словами, чтобы чтение во время перезаписи не было гонкой данных
+        struct Slot {
+            std::atomic<uint64_t> sequence{ 0 }; // номер события + 1; 0 - слот пуст или пишется
+            std::atomic<uint64_t> words[WORDS];
+        };
+
+        std::unique_ptr<Slot[]> slots;
+        size_t mask;
+        std::atomic<uint64_t> head{ 0 }; // номер следующего публикуемого события
+
+        std::mutex subscribers_mutex;
+        std::vector<std::shared_ptr<Subscription>> subscribers;
+        uint64_t backpressure_limit = UINT64_MAX; // до этого номера можно писать без проверки подписчиков
+        // писатель уперся в backpressure-подписчика и спит; такие подписчики будят его, сдвинув курсор
+        std::atomic<bool> writer_waiting{ false };
+        WakeupCounter cursor_moves;
+
+        void waitForBackpressure(uint64_t sequence);
+        bool backpressureAllows(uint64_t sequence);
+        bool read(uint64_t sequence, ChangeEvent& event, uint64_t& newest) const;
+
+    public:
+        explicit ChangeFeed(size_t capacity = 65536); // округляется вверх до степени двойки
+
+        std::shared_ptr<Subscription> subscribe(Policy policy);
+        void unsubscribe(const std::shared_ptr<Subscription>& subscription);
+
+        // только один поток-писатель
+        void publish(ChangeEvent event);
+
+        uint64_t getPublishedCount() const { return head.load(); }
+        size_t getCapacity() const { return mask + 1; }
+    };
+
+}
@@ -0,0 +1,95 @@
+﻿#include "ChangeFeedFile.h"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace Banking {
+
+    ChangeFeedFileWriter::ChangeFeedFileWriter(ChangeFeed& feed_value, const std::string& path, ChangeFeed::Policy policy)
+        : feed(feed_value), file(path, std::ios::binary | std::ios::app) {
+        if (!file) {
+            throw std::runtime_error("Cannot open change feed file: " + path);
+        }
+        subscription = feed.subscribe(policy);
+        worker = std::thread(&ChangeFeedFileWriter::run, this);
+    }
+
+    ChangeFeedFileWriter::~ChangeFeedFileWriter() {
+        stop();
+    }
+
+    void ChangeFeedFileWriter::run() {
+        ChangeEvent event;
+        while (true) {
+            // флаг читаем до опроса: после остановки все события уже опубликованы и будут дочитаны
+            bool stopping = !running.load();
+            bool any = false;
+            while (subscription->poll(event)) {
+                file.write(reinterpret_cast<const char*>(&event), sizeof(event));
+                written.fetch_add(1, std::memory_order_relaxed);
+                any = true;
+            }
+            if (stopping) {
+                break;
+            }
+            if (!any) {
+                file.flush(); // пока ленте нечего отдать - делаем записи видимыми читателям файла
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        file.flush();
+    }
+
+    void ChangeFeedFileWriter::stop() {
+        if (!worker.joinable()) {
+            return;
+        }
+        running.store(false);
+        worker.join();
+        feed.unsubscribe(subscription);
+        file.close();
+    }
+
+    const char* changeKindName(uint32_t kind) {
+        switch (kind) {
+        case ChangeEvent::ACCOUNT_OPENED: return "ACCOUNT_OPENED";
+        case ChangeEvent::ACCOUNT_CLOSED: return "ACCOUNT_CLOSED";
+        case ChangeEvent::DEPOSIT: return "DEPOSIT";
+        case ChangeEvent::WITHDRAW: return "WITHDRAW";
+        case ChangeEvent::TRANSFER_OUT: return "TRANSFER_OUT";
+        case ChangeEvent::TRANSFER_IN: return "TRANSFER_IN";
+        default: return "UNKNOWN";
+        }
+    }
+
+    size_t tailChangeFile(const std::string& path, std::ostream& out, bool follow) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot open change feed file: " + path);
+        }
+        size_t count = 0;
+        ChangeEvent event;
+        while (true) {
+            std::streampos position = file.tellg();
+            if (file.read(reinterpret_cast<char*>(&event), sizeof(event))) {
+                out << event.sequence << ' ' << changeKindName(event.kind) << ' ' << event.account;
+                if (event.counterpart[0] != '\0') {
+                    out << " <-> " << event.counterpart;
+                }
+                out << " amount=" << event.amount << " balance=" << event.balance_after << " client=" << event.client_id << '\n';
+                ++count;
+                continue;
+            }
+            if (!follow) {
+                break;
+            }
+            // запись еще не дописана целиком - возвращаемся к ее началу и ждем
+            out.flush();
+            file.clear();
+            file.seekg(position);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        return count;
+    }
+
+}
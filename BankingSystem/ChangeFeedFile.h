@@ -0,0 +1,41 @@
+﻿#pragma once
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include "ChangeFeed.h"
+
+namespace Banking {
+
+    // Пример подписчика: в отдельном потоке дописывает события ленты в двоичный файл
+    // (записи фиксированного размера sizeof(ChangeEvent), файл можно читать "хвостом", пока он растет)
+    class ChangeFeedFileWriter {
+    private:
+        ChangeFeed& feed;
+        std::shared_ptr<ChangeFeed::Subscription> subscription;
+        std::ofstream file;
+        std::atomic<bool> running{ true };
+        std::atomic<uint64_t> written{ 0 };
+        std::thread worker;
+
+        void run();
+
+    public:
+        ChangeFeedFileWriter(ChangeFeed& feed_value, const std::string& path, ChangeFeed::Policy policy = ChangeFeed::Policy::Backpressure);
+        ~ChangeFeedFileWriter();
+
+        // дописать все уже опубликованные события и закрыть файл
+        void stop();
+
+        uint64_t getWrittenCount() const { return written.load(); }
+        uint64_t getDroppedCount() const { return subscription->getDroppedCount(); }
+    };
+
+    const char* changeKindName(uint32_t kind);
+
+    // вывести события из файла ленты в текстовом виде; follow - ждать новых записей (как tail -f)
+    size_t tailChangeFile(const std::string& path, std::ostream& out, bool follow = false);
+
+}
@@ -1,20 +1,22 @@
 #include "CheckingAccount.h"
 #include "Client.h"  //   
+#include "Ledger.h"
 #include <stdexcept>
 #include <iostream>
+#include <utility>
 
 namespace Banking {
 
-    CheckingAccount::CheckingAccount(const std::string& accountNumber, const int& client_id, double initialBalance)
-        : Account(accountNumber, client_id, "Checking", initialBalance) {
+    CheckingAccount::CheckingAccount(std::string accountNumber, const int& client_id, double initialBalance, std::string currency, std::shared_ptr<BalanceStore> store)
+        : Account(std::move(accountNumber), client_id, "Checking", initialBalance, std::move(currency), std::move(store)) {
         std::cout << "\n-----CheckingAccount constructor called. ";
-        commission = 0.0;
-        overdraft_limit = 0.0;
-        available_overdraft = 0.0;
+        hot->commission = 0.0;
+        hot->overdraft_limit = 0.0;
+        hot->available_overdraft = 0.0;
         set_overdraft_limit(); //   
-        available_overdraft = overdraft_limit; //    
+        hot->available_overdraft = hot->overdraft_limit; //    
         std::cout << "You created a new checking account." << std::endl;
-        std::cout << "Overdraft limit: " << overdraft_limit << ", Available overdraft: " << available_overdraft << std::endl;
+        std::cout << "Overdraft limit: " << hot->overdraft_limit << ", Available overdraft: " << hot->available_overdraft << std::endl;
     };
     
     CheckingAccount::~CheckingAccount() {
@@ -28,48 +30,48 @@ namespace Banking {
         Account::deposit(amount); //     
 
         //     
-        double old_limit = overdraft_limit;
+        double old_limit = hot->overdraft_limit;
 
         //   
         set_overdraft_limit();
 
         //     
         //   ,    
-        if (overdraft_limit > old_limit) {
-            double limit_increase = overdraft_limit - old_limit;
-            available_overdraft += limit_increase;
+        if (hot->overdraft_limit > old_limit) {
+            double limit_increase = hot->overdraft_limit - old_limit;
+            hot->available_overdraft += limit_increase;
 
             //    
-            if (available_overdraft > overdraft_limit) {
-                available_overdraft = overdraft_limit;
+            if (hot->available_overdraft > hot->overdraft_limit) {
+                hot->available_overdraft = hot->overdraft_limit;
             }
 
-            std::cout << "Overdraft limit increased from " << old_limit << " to " << overdraft_limit << std::endl;
-            std::cout << "Available overdraft updated to: " << available_overdraft << std::endl;
+            std::cout << "Overdraft limit increased from " << old_limit << " to " << hot->overdraft_limit << std::endl;
+            std::cout << "Available overdraft updated to: " << hot->available_overdraft << std::endl;
         }
-        else if (overdraft_limit < old_limit) {
+        else if (hot->overdraft_limit < old_limit) {
             //   ,    
-            if (available_overdraft > overdraft_limit) {
-                available_overdraft = overdraft_limit;
+            if (hot->available_overdraft > hot->overdraft_limit) {
+                hot->available_overdraft = hot->overdraft_limit;
             }
-            std::cout << "Overdraft limit decreased from " << old_limit << " to " << overdraft_limit << std::endl;
-            std::cout << "Available overdraft updated to: " << available_overdraft << std::endl;
+            std::cout << "Overdraft limit decreased from " << old_limit << " to " << hot->overdraft_limit << std::endl;
+            std::cout << "Available overdraft updated to: " << hot->available_overdraft << std::endl;
         }
 
-        std::cout << "Your new overdraft_limit: " << overdraft_limit << std::endl;
-        std::cout << "Your available overdraft: " << available_overdraft << std::endl;
+        std::cout << "Your new overdraft_limit: " << hot->overdraft_limit << std::endl;
+        std::cout << "Your available overdraft: " << hot->available_overdraft << std::endl;
     }
 
     //        -  2%   500  ,    20%
     bool CheckingAccount::withdraw(double amount) {
         setCommission(amount);
-        std::cout << "\nYou want to withdraw: " << amount << ", commission: " << commission << std::endl;
-        double total_amount = amount + commission;
+        std::cout << "\nYou want to withdraw: " << amount << ", commission: " << hot->commission << std::endl;
+        double total_amount = amount + hot->commission;
         std::cout << "Total amount to withdraw: " << total_amount << std::endl;
-        std::cout << "Balance: " << balance << std::endl;
-        std::cout << "Maximum withdrawal amount (balance + available_overdraft): " << (balance + available_overdraft) << std::endl;
+        std::cout << "Balance: " << hot->balance << std::endl;
+        std::cout << "Maximum withdrawal amount (balance + available_overdraft): " << (hot->balance + hot->available_overdraft) << std::endl;
 
-        double available_funds = balance + available_overdraft;
+        double available_funds = hot->balance + hot->available_overdraft;
         std::cout << "Available funds (balance + overdraft): " << available_funds << std::endl;
 
         if (total_amount > available_funds) {
@@ -78,39 +80,39 @@ namespace Banking {
         }
 
         //  
-        if (total_amount <= balance) {
+        if (total_amount <= hot->balance) {
             //    
-            balance -= total_amount;
+            hot->balance -= total_amount;
         }
         else {
             //  
-            double overdraft_needed = total_amount - balance;
-            balance = 0;
-            available_overdraft -= overdraft_needed; //   
+            double overdraft_needed = total_amount - hot->balance;
+            hot->balance = 0;
+            hot->available_overdraft -= overdraft_needed; //   
 
             //   
-            if (available_overdraft < 0) {
-                available_overdraft = 0;
+            if (hot->available_overdraft < 0) {
+                hot->available_overdraft = 0;
             }
         
-        std::cout << "Overdraft used: " << overdraft_needed << ", Remaining overdraft: " << available_overdraft << std::endl;
+        std::cout << "Overdraft used: " << overdraft_needed << ", Remaining overdraft: " << hot->available_overdraft << std::endl;
         }
 
         //    
         set_overdraft_limit();
-        std::cout << "Withdrawal successful! New balance: " << balance << std::endl;
-        std::cout << "Your new overdraft limit: " << overdraft_limit << std::endl;
+        std::cout << "Withdrawal successful! New balance: " << hot->balance << std::endl;
+        std::cout << "Your new overdraft limit: " << hot->overdraft_limit << std::endl;
         return true;
     }
 
     void CheckingAccount::displayinfo() const {
         Account::displayinfo();
-        std::cout << "Available overdraft: " << available_overdraft << std::endl;
-        std::cout << "Overdraft limit: " << overdraft_limit << std::endl;
+        std::cout << "Available overdraft: " << hot->available_overdraft << std::endl;
+        std::cout << "Overdraft limit: " << hot->overdraft_limit << std::endl;
     }
 
     bool CheckingAccount::canClose() const {
-        return balance >= 0; //     
+        return hot->balance >= 0; //     
     }
 
     //   
@@ -118,22 +120,22 @@ namespace Banking {
         double base_limit = 50000.0;
 
         //   : +10%    10 000  50 000
-        if (balance > 50000) {
-            double bonus_multiplier = ((balance - 50000) / 10000.0) * 0.1;
-            overdraft_limit = base_limit * (1.0 + bonus_multiplier);
+        if (hot->balance > 50000) {
+            double bonus_multiplier = ((hot->balance - 50000) / 10000.0) * 0.1;
+            hot->overdraft_limit = base_limit * (1.0 + bonus_multiplier);
         }
         else {
-            overdraft_limit = base_limit;
+            hot->overdraft_limit = base_limit;
         }
 
         //  
-        if (overdraft_limit > 100000) {
-            overdraft_limit = 100000;
+        if (hot->overdraft_limit > 100000) {
+            hot->overdraft_limit = 100000;
         }
 
         //      
-        if (available_overdraft > overdraft_limit) {
-            available_overdraft = overdraft_limit;
+        if (hot->available_overdraft > hot->overdraft_limit) {
+            hot->available_overdraft = hot->overdraft_limit;
         }
     }
 
@@ -142,15 +144,31 @@ namespace Banking {
         if (perc_of_commission > 20) {
             perc_of_commission = 20;
         }
-        commission = (amount / 100) * perc_of_commission;
+        //   ,   :      
+        hot->commission = Ledger::fromCents(Ledger::toCents((amount / 100) * perc_of_commission));
     }
 
     double CheckingAccount::get_overdraft_limit() const {
-        return overdraft_limit;
+        return hot->overdraft_limit;
     }
 
     double CheckingAccount::get_available_overdraft() const {
-        return available_overdraft;
+        return hot->available_overdraft;
+    }
+
+    //      :  deposit    
+    void CheckingAccount::saveState(AccountState& state) const {
+        Account::saveState(state);
+        state.fields[0] = hot->commission;
+        state.fields[1] = hot->available_overdraft;
+        state.fields[2] = hot->overdraft_limit;
+    }
+
+    void CheckingAccount::restoreState(const AccountState& state) {
+        Account::restoreState(state);
+        hot->commission = state.fields[0];
+        hot->available_overdraft = state.fields[1];
+        hot->overdraft_limit = state.fields[2];
     }
 
 }
\ No newline at end of file
@@ -10,15 +10,12 @@ namespace Banking {
 
 namespace Banking {
 
+    //       ,       (BalanceRecord)
     class CheckingAccount : public Account {
-    private:
-        double commission;
-        double available_overdraft;
-        double overdraft_limit;
-
     public:
 
-        CheckingAccount(const std::string& accountNumber, const int& client_id, double initialBalance = 0);
+        CheckingAccount(std::string accountNumber, const int& client_id, double initialBalance = 0, std::string currency = DEFAULT_CURRENCY,
+            std::shared_ptr<BalanceStore> store = nullptr);
         virtual ~CheckingAccount();
 
         //  
@@ -26,6 +23,9 @@ namespace Banking {
         bool withdraw(double amount) override;
         void displayinfo() const override;
         bool canClose() const override;
+        double getCommission() const override { return hot->commission; }
+        void saveState(AccountState& state) const override;
+        void restoreState(const AccountState& state) override;
 
         //   
         void set_overdraft_limit();
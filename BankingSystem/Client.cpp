@@ -1,46 +1,42 @@
 #include "Client.h"
+#include "Account.h"
 #include <stdexcept>
 #include <iostream>
-#include "Account.h"  //   
 
 
 namespace Banking {
     
-    Client::Client(int id_value, const std::string& name_value, const std::string& surname_value, const Address& address_value, const Date& date_value)
-        : id(id_value), name(name_value), surname(surname_value), address(address_value), registration_date(date_value)
+    Client::Client(int id_value, std::string name_value, std::string surname_value, const Address& address_value, const Date& date_value)
+        : id(id_value), name(std::move(name_value)), surname(std::move(surname_value))
     {
-        //  
+        //   (  :       )
         if (name.empty() || surname.empty()) {
             throw std::invalid_argument("Name and surname cannot be empty");
         }
         if (id <= 0) {
             throw std::invalid_argument("ID must be positive");
         }
-        if (!registration_date.isValid()) {
+        if (!date_value.isValid()) {
             throw std::invalid_argument("Invalid registration date");
         }
+        registration_date = PackedDate::pack(date_value);
+        address = PackedAddress::pack(address_value);
 
         std::cout << "Client constructor called for: " << getSurname() << std::endl;
     }
 
-    //   
+    //  :        
     void Client::addAccount_to_client(std::shared_ptr<Account> account) {
-        for (const auto& existing_account : all_client_accounts) {
-            if (existing_account->getAccountNumber() == account->getAccountNumber()) {
-                throw std::invalid_argument("Account with number " + account->getAccountNumber() + " already exists for this client");
-            }
+        if (!account) {
+            throw std::invalid_argument("Account cannot be null");
         }
+        if (account->getClientId() != id) {
+            throw std::invalid_argument("Account " + account->getAccountNumber() + " belongs to another client");
+        }
+        std::cout << "Account " << account->getAccountNumber() << " is linked to client " << getSurname() << " by the bank (Bank::addAccount)" << std::endl;
+    }
 
-        all_client_accounts.push_back(account);
-        std::cout << "Account " << account->getAccountNumber() << " added to client " << getSurname() << " Total accounts in client: " << all_client_accounts.size() << std::endl;
-    };
-    
-    //   
     void Client::displayinfo_about_client_accounts() {
-        std::cout << "\nInformation about accounts for client: " << getSurname() << std::endl;
-        std::cout << "Amount of accounts: " << all_client_accounts.size() << std::endl;
-        for (auto& account : all_client_accounts) {
-            account->displayinfo();
-        }
-    };
+        std::cout << "\nAccounts of client " << getSurname() << " are kept by the bank: use Bank::display_client_accounts(" << id << ")" << std::endl;
+    }
 }
\ No newline at end of file
@@ -3,58 +3,58 @@
 #include <vector>
 #include <memory>
 #include <iostream>
+#include <utility>
 #include "Structs.h"
+#include "ClientStorage.h"
 
-//    
 namespace Banking {
     class Account;
-}
 
-namespace Banking {
     class Client {
 
     private:
         int id;
         std::string name;
         std::string surname;
-        Address address; // 
-        Date registration_date; // 
-        std::vector<std::shared_ptr<Account>> all_client_accounts; //      
+        PackedAddress address; //    ClientStorage
+        PackedDate registration_date;
 
     public:
-        Client(int id_value, const std::string& name_value, const std::string& surname_value, const Address& address_value, const Date& date_value);
+        Client(int id_value, std::string name_value, std::string surname_value, const Address& address_value, const Date& date_value); //    
         virtual ~Client() = default;
 
-        ////  
-        void addAccount_to_client(std::shared_ptr<Account> account); //           =   
+        //    : Bank::get_client_accounts, Bank::display_client_accounts
+        //  API   :   ->   Bank::addAccount
+        [[deprecated("accounts are linked by Bank::addAccount, use Bank::get_client_accounts")]]
+        void addAccount_to_client(std::shared_ptr<Account> account);
+        [[deprecated("use Bank::display_client_accounts")]]
         void displayinfo_about_client_accounts();
 
         //    
         int getId() const { return id; }
-        std::string getName() const { return name; }
-        std::string getSurname() const { return surname; }
-        const Address& getAddress() const { return address; }
-        const Date& getRegistrationDate() const { return registration_date; }
+        const std::string& getName() const { return name; }
+        const std::string& getSurname() const { return surname; }
+        Address getAddress() const { return address.unpack(); }
+        Date getRegistrationDate() const { return registration_date.unpack(); }
 
         //    
-        void setName(const std::string& name_value) { name = name_value; }
-        void setSurname(const std::string& surname_value) { surname = surname_value; }
-        void setAddress(const Address& address_value) { address = address_value; }
-        void setRegistrationDate(const Date& date_value) { registration_date = date_value; }
+        void setName(std::string name_value) { name = std::move(name_value); }
+        void setSurname(std::string surname_value) { surname = std::move(surname_value); }
+        void setAddress(const Address& address_value) { address = PackedAddress::pack(address_value); }
+        void setRegistrationDate(const Date& date_value) { registration_date = PackedDate::pack(date_value); } //   - 
 
         //    
         virtual void displayinfo() const {
             std::cout << "\nClient Information:" << std::endl;
             std::cout << "ID: " << id << std::endl;
             std::cout << "Name: " << name << " " << surname << std::endl;
-            std::cout << "Address: " << address.getFullAddress() << std::endl;
-            std::cout << "Registration Date: " << registration_date.getFormattedDate() << std::endl;
-            std::cout << "Amount of accounts: " << all_client_accounts.size() << std::endl;
+            std::cout << "Address: " << getAddress().getFullAddress() << std::endl;
+            std::cout << "Registration Date: " << getRegistrationDate().getFormattedDate() << std::endl;
         }
 
         //   
         bool isAddressValid() const {
-            return !address.street.empty() && !address.city.empty() && !address.country.empty();
+            return address.isComplete();
         }
     
     };
@@ -0,0 +1,134 @@
+﻿#include "ClientIndex.h"
+
+#include <stdexcept>
+
+namespace Banking {
+
+    std::string ClientIndex::normalize(const std::string& value) {
+        std::string result = value;
+        for (char& c : result) {
+            if (c >= 'A' && c <= 'Z') {
+                c = static_cast<char>(c - 'A' + 'a');
+            }
+        }
+        return result;
+    }
+
+    void ClientIndex::reserve(size_t clients) {
+        records.reserve(clients);
+        record_by_id.reserve(clients);
+    }
+
+    // список для ключа (заводится при первой встрече ключа)
+    template <typename Map, typename Key>
+    uint32_t ClientIndex::listFor(Map& index, const Key& key) {
+        auto it = index.find(key);
+        if (it != index.end()) {
+            return it->second;
+        }
+        uint32_t list = static_cast<uint32_t>(lists.size());
+        lists.emplace_back();
+        index.emplace(key, list);
+        return list;
+    }
+
+    void ClientIndex::link(uint32_t record, Field field, uint32_t list) {
+        records[record].list[field] = list;
+        records[record].position[field] = static_cast<uint32_t>(lists[list].size());
+        lists[list].push_back(record);
+    }
+
+    // удаление из списка перестановкой последнего элемента на место удаляемого
+    void ClientIndex::unlink(uint32_t record, Field field) {
+        std::vector<uint32_t>& list = lists[records[record].list[field]];
+        uint32_t position = records[record].position[field];
+        uint32_t moved = list.back();
+        list[position] = moved;
+        records[moved].position[field] = position;
+        list.pop_back();
+    }
+
+    void ClientIndex::add(int id, const std::string& surname, const Address& address, const Date& registration_date) {
+        if (record_by_id.count(id) != 0) {
+            throw std::invalid_argument("Client is already indexed: " + std::to_string(id));
+        }
+        uint32_t record;
+        if (!free_records.empty()) {
+            record = free_records.back();
+            free_records.pop_back();
+        }
+        else {
+            record = static_cast<uint32_t>(records.size());
+            records.emplace_back();
+        }
+        records[record].id = id;
+        link(record, SURNAME, listFor(by_surname, normalize(surname)));
+        link(record, CITY, listFor(by_city, normalize(address.city)));
+        link(record, COUNTRY, listFor(by_country, normalize(address.country)));
+        link(record, REGISTRATION, listFor(by_registration, dateKey(registration_date)));
+        record_by_id.emplace(id, record);
+    }
+
+    bool ClientIndex::remove(int id) {
+        auto it = record_by_id.find(id);
+        if (it == record_by_id.end()) {
+            return false;
+        }
+        uint32_t record = it->second;
+        for (int field = 0; field < FIELDS; ++field) {
+            unlink(record, static_cast<Field>(field));
+        }
+        free_records.push_back(record);
+        record_by_id.erase(it);
+        return true;
+    }
+
+    void ClientIndex::collect(uint32_t list, size_t limit, std::vector<int>& ids) const {
+        for (uint32_t record : lists[list]) {
+            if (ids.size() >= limit) {
+                return;
+            }
+            ids.push_back(records[record].id);
+        }
+    }
+
+    std::vector<int> ClientIndex::findBySurnamePrefix(const std::string& prefix, size_t limit) const {
+        std::vector<int> ids;
+        std::string key = normalize(prefix);
+        for (auto it = by_surname.lower_bound(key); it != by_surname.end() && ids.size() < limit; ++it) {
+            if (it->first.compare(0, key.size(), key) != 0) {
+                break;
+            }
+            collect(it->second, limit, ids);
+        }
+        return ids;
+    }
+
+    std::vector<int> ClientIndex::findByCity(const std::string& city, size_t limit) const {
+        std::vector<int> ids;
+        auto it = by_city.find(normalize(city));
+        if (it != by_city.end()) {
+            collect(it->second, limit, ids);
+        }
+        return ids;
+    }
+
+    std::vector<int> ClientIndex::findByCountry(const std::string& country, size_t limit) const {
+        std::vector<int> ids;
+        auto it = by_country.find(normalize(country));
+        if (it != by_country.end()) {
+            collect(it->second, limit, ids);
+        }
+        return ids;
+    }
+
+    std::vector<int> ClientIndex::findRegisteredBetween(const Date& from, const Date& to, size_t limit) const {
+        std::vector<int> ids;
+        auto last = by_registration.upper_bound(dateKey(to));
+        for (auto it = by_registration.lower_bound(dateKey(from)); it != last && ids.size() < limit; ++it) {
+            collect(it->second, limit, ids);
+        }
+        return ids;
+    }
+
+}
@@ -0,0 +1,62 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+#include "Structs.h"
+
+namespace Banking {
+
+    // Вторичные индексы клиентов для поиска без перебора всех клиентов:
+    //  - фамилия: упорядоченный словарь различных фамилий (поиск по префиксу через lower_bound);
+    //  - город и страна: хэш-индексы;
+    //  - дата регистрации: упорядоченный индекс по ключу ггггммдд (поиск по диапазону).
+    // Каждый различный ключ ведет к списку клиентов; клиент помнит свою позицию в каждом списке,
+    // поэтому добавление и удаление - O(1) (плюс O(log k) для упорядоченных словарей).
+    // Фамилия, город и страна сравниваются без учета регистра латиницы.
+    // Значения берутся в момент добавления: после изменения клиента его нужно удалить и добавить заново.
+    class ClientIndex {
+    private:
+        enum Field { SURNAME = 0, CITY, COUNTRY, REGISTRATION, FIELDS };
+
+        struct Record {
+            int id;
+            uint32_t list[FIELDS];      // номер списка по каждому полю
+            uint32_t position[FIELDS];  // позиция записи в этом списке
+        };
+
+        std::vector<Record> records;
+        std::vector<uint32_t> free_records;
+        std::unordered_map<int, uint32_t> record_by_id;
+
+        // списки записей по ключам всех полей (пустые списки остаются за своим ключом)
+        std::vector<std::vector<uint32_t>> lists;
+        std::map<std::string, uint32_t> by_surname;
+        std::unordered_map<std::string, uint32_t> by_city;
+        std::unordered_map<std::string, uint32_t> by_country;
+        std::map<int, uint32_t> by_registration;
+
+        template <typename Map, typename Key>
+        uint32_t listFor(Map& index, const Key& key);
+        void link(uint32_t record, Field field, uint32_t list);
+        void unlink(uint32_t record, Field field);
+        void collect(uint32_t list, size_t limit, std::vector<int>& ids) const;
+
+    public:
+        static std::string normalize(const std::string& value);
+        static int dateKey(const Date& date) { return date.year * 10000 + date.month * 100 + date.day; }
+
+        void reserve(size_t clients);
+        void add(int id, const std::string& surname, const Address& address, const Date& registration_date);
+        bool remove(int id);
+        size_t size() const { return record_by_id.size(); }
+
+        // не больше limit идентификаторов клиентов
+        std::vector<int> findBySurnamePrefix(const std::string& prefix, size_t limit) const;
+        std::vector<int> findByCity(const std::string& city, size_t limit) const;
+        std::vector<int> findByCountry(const std::string& country, size_t limit) const;
+        std::vector<int> findRegisteredBetween(const Date& from, const Date& to, size_t limit) const; // включительно, по возрастанию даты
+    };
+
+}
@@ -0,0 +1,106 @@
+﻿#include "ClientStorage.h"
+
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace Banking {
+
+    ClientStorage::ClientStorage() {
+        intern(std::string());
+    }
+
+    ClientStorage& ClientStorage::instance() {
+        static ClientStorage storage;
+        return storage;
+    }
+
+    uint32_t ClientStorage::intern(const std::string& value) {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = interned_ids.find(value);
+            if (it != interned_ids.end()) {
+                return it->second;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        auto inserted = interned_ids.emplace(value, static_cast<uint32_t>(interned.size()));
+        if (inserted.second) {
+            interned.push_back(&inserted.first->first);
+        }
+        return inserted.first->second;
+    }
+
+    std::string ClientStorage::interned_string(uint32_t id) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return *interned.at(id);
+    }
+
+    uint64_t ClientStorage::storeStreet(const std::string& street) {
+        if (street.size() > MAX_STREET) {
+            throw std::invalid_argument("Street is too long");
+        }
+        if (street.empty()) {
+            return 0;
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (chunk_used + street.size() > CHUNK_SIZE) {
+            chunks.push_back(std::make_unique<char[]>(CHUNK_SIZE));
+            chunk_used = 0;
+        }
+        uint64_t offset = (chunks.size() - 1) * CHUNK_SIZE + chunk_used;
+        std::memcpy(chunks.back().get() + chunk_used, street.data(), street.size());
+        chunk_used += street.size();
+        street_bytes += street.size();
+        return (offset << 16) | street.size();
+    }
+
+    std::string ClientStorage::street(uint64_t ref) const {
+        size_t length = streetLength(ref);
+        if (length == 0) {
+            return std::string();
+        }
+        uint64_t offset = ref >> 16;
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return std::string(chunks[offset / CHUNK_SIZE].get() + offset % CHUNK_SIZE, length);
+    }
+
+    size_t ClientStorage::getInternedCount() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return interned.size();
+    }
+
+    size_t ClientStorage::getMemoryUsage() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        size_t bytes = chunks.size() * CHUNK_SIZE + interned.capacity() * sizeof(const std::string*);
+        for (const std::string* value : interned) {
+            bytes += sizeof(std::string) + sizeof(uint32_t) + value->capacity();
+        }
+        return bytes;
+    }
+
+    PackedDate PackedDate::pack(const Date& date) {
+        if (!date.isValid() || date.year >= (1 << 23)) {
+            throw std::invalid_argument("Invalid date");
+        }
+        PackedDate packed;
+        packed.value = (static_cast<uint32_t>(date.year) << 9) | (static_cast<uint32_t>(date.month) << 5) | static_cast<uint32_t>(date.day);
+        return packed;
+    }
+
+    PackedAddress PackedAddress::pack(const Address& address) {
+        ClientStorage& storage = ClientStorage::instance();
+        PackedAddress packed;
+        packed.street = storage.storeStreet(address.street);
+        packed.city = storage.intern(address.city);
+        packed.country = storage.intern(address.country);
+        packed.post_id = address.post_id;
+        return packed;
+    }
+
+    Address PackedAddress::unpack() const {
+        const ClientStorage& storage = ClientStorage::instance();
+        return Address(storage.street(street), storage.interned_string(city), storage.interned_string(country), post_id);
+    }
+
+}
@@ -0,0 +1,66 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <shared_mutex>
+#include <cstdint>
+#include "Structs.h"
+
+namespace Banking {
+
+    // Общее хранилище атрибутов клиентов: города и страны интернируются (одна строка на значение),
+    // улицы лежат подряд в арене из блоков по 1 МБ. Клиент хранит только номера и ссылки.
+    // Одно на процесс; запись под уникальной блокировкой, чтение - под разделяемой.
+    // Память арены не освобождается при удалении клиентов (как и журнал операций).
+    class ClientStorage {
+    private:
+        static const size_t CHUNK_SIZE = 1 << 20;
+        static const size_t MAX_STREET = UINT16_MAX;
+
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, uint32_t> interned_ids;
+        std::vector<const std::string*> interned; // ключи interned_ids (узлы не перемещаются)
+        std::vector<std::unique_ptr<char[]>> chunks;
+        size_t chunk_used = CHUNK_SIZE;
+        size_t street_bytes = 0;
+
+        ClientStorage();
+
+    public:
+        static ClientStorage& instance();
+
+        // номер строки (0 - пустая строка)
+        uint32_t intern(const std::string& value);
+        std::string interned_string(uint32_t id) const;
+
+        // ссылка на улицу: смещение в арене (старшие биты) и длина (младшие 16 бит)
+        uint64_t storeStreet(const std::string& street);
+        std::string street(uint64_t ref) const;
+        static size_t streetLength(uint64_t ref) { return static_cast<size_t>(ref & 0xFFFF); }
+
+        size_t getInternedCount() const;
+        size_t getMemoryUsage() const; // строки пула и блоки арены, байт
+    };
+
+    // дата в 32 битах: год (старшие биты), месяц (4 бита), день (5 бит)
+    struct PackedDate {
+        uint32_t value = 0;
+
+        static PackedDate pack(const Date& date); // только корректные даты (Date::isValid)
+        Date unpack() const { return Date(value & 0x1F, (value >> 5) & 0xF, value >> 9); }
+    };
+
+    // адрес из номеров в ClientStorage: 24 байта вместо трех std::string
+    struct PackedAddress {
+        uint64_t street = 0;
+        uint32_t city = 0;
+        uint32_t country = 0;
+        int post_id = 0;
+
+        static PackedAddress pack(const Address& address);
+        Address unpack() const;
+        bool isComplete() const { return ClientStorage::streetLength(street) != 0 && city != 0 && country != 0; }
+    };
+
+}
@@ -0,0 +1,48 @@
+﻿#pragma once
+#include <vector>
+#include <cstdint>
+
+namespace Banking {
+
+    // Дерево Фенвика (binary indexed tree) по суммам в копейках:
+    // изменение одного элемента и сумма на любом отрезке - O(log n), построение по готовым значениям - O(n)
+    class FenwickTree {
+    private:
+        std::vector<int64_t> tree; // tree[i] - сумма элементов (i - lowbit(i), i], нумерация с 1
+
+    public:
+        void assign(const std::vector<int64_t>& values) {
+            tree.assign(values.size() + 1, 0);
+            for (size_t i = 1; i < tree.size(); ++i) {
+                tree[i] += values[i - 1];
+                size_t parent = i + (i & (0 - i));
+                if (parent < tree.size()) {
+                    tree[parent] += tree[i];
+                }
+            }
+        }
+
+        void add(size_t index, int64_t delta) {
+            for (size_t i = index + 1; i < tree.size(); i += i & (0 - i)) {
+                tree[i] += delta;
+            }
+        }
+
+        // сумма элементов [0, end)
+        int64_t prefix(size_t end) const {
+            int64_t sum = 0;
+            for (size_t i = end; i > 0; i -= i & (0 - i)) {
+                sum += tree[i];
+            }
+            return sum;
+        }
+
+        // сумма элементов [begin, end)
+        int64_t range(size_t begin, size_t end) const {
+            return begin >= end ? 0 : prefix(end) - prefix(begin);
+        }
+
+        size_t size() const { return tree.empty() ? 0 : tree.size() - 1; }
+    };
+
+}
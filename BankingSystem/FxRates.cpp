@@ -0,0 +1,117 @@
+﻿#include "FxRates.h"
+
+#include <stdexcept>
+#include <thread>
+#include <algorithm>
+
+namespace Banking {
+
+    bool isCurrencyCode(const std::string& code) {
+        return code.size() == 3 && std::all_of(code.begin(), code.end(), [](char c) { return c >= 'A' && c <= 'Z'; });
+    }
+
+    FxRates::FxRates(uint64_t version_value, std::string base_value, std::unordered_map<std::string, double> rates_value)
+        : version(version_value), base(std::move(base_value)), to_base(std::move(rates_value)) {
+    }
+
+    bool FxRates::rateOf(const std::string& code, double& rate) const {
+        auto it = to_base.find(code);
+        if (it == to_base.end()) {
+            return false;
+        }
+        rate = it->second;
+        return true;
+    }
+
+    bool FxRates::crossRate(const std::string& from, const std::string& to, double& rate) const {
+        double from_rate = 0;
+        double to_rate = 0;
+        if (!rateOf(from, from_rate) || !rateOf(to, to_rate)) {
+            return false;
+        }
+        rate = from_rate / to_rate;
+        return true;
+    }
+
+    FxRateTable::FxRateTable(std::string base) {
+        if (!isCurrencyCode(base)) {
+            throw std::invalid_argument("Invalid currency code: " + base);
+        }
+        for (auto& slot : reader_versions) {
+            slot.store(NO_READER);
+        }
+        std::unordered_map<std::string, double> rates;
+        rates.emplace(base, 1.0);
+        current.store(new FxRates(0, std::move(base), std::move(rates)));
+    }
+
+    FxRateTable::~FxRateTable() {
+        delete current.load();
+    }
+
+    // читатель сначала объявляет версию, потом читает указатель: указатель не старше объявленной версии,
+    // а писатель удаляет только версии младше всех объявленных
+    size_t FxRateTable::enterReader() const {
+        uint64_t version = published_version.load();
+        for (;;) {
+            for (size_t i = 0; i < MAX_READERS; ++i) {
+                uint64_t expected = NO_READER;
+                if (reader_versions[i].load(std::memory_order_relaxed) == NO_READER
+                    && reader_versions[i].compare_exchange_strong(expected, version)) {
+                    return i;
+                }
+            }
+            std::this_thread::yield(); // все слоты заняты: читатели держат их недолго
+        }
+    }
+
+    FxRateTable::Reader::Reader(const FxRateTable& table_value)
+        : table(table_value), slot(table_value.enterReader()), rates(table_value.current.load()) {
+    }
+
+    uint64_t FxRateTable::publish(std::unordered_map<std::string, double> rates) {
+        const FxRates* old = current.load();
+        uint64_t version = old->getVersion() + 1;
+        current.store(new FxRates(version, old->getBase(), std::move(rates)));
+        published_version.store(version);
+        retired.emplace_back(old);
+
+        uint64_t oldest_needed = NO_READER;
+        for (const auto& slot : reader_versions) {
+            oldest_needed = std::min(oldest_needed, slot.load());
+        }
+        retired.erase(std::remove_if(retired.begin(), retired.end(),
+            [oldest_needed](const std::unique_ptr<const FxRates>& rates) { return rates->getVersion() < oldest_needed; }),
+            retired.end());
+        return version;
+    }
+
+    uint64_t FxRateTable::setRate(const std::string& code, double rate) {
+        return setRates({ { code, rate } });
+    }
+
+    uint64_t FxRateTable::setRates(const std::vector<std::pair<std::string, double>>& rates) {
+        std::lock_guard<std::mutex> lock(update_mutex);
+        const FxRates* old = current.load();
+        std::unordered_map<std::string, double> next = old->getRates();
+        for (const auto& item : rates) {
+            if (!isCurrencyCode(item.first)) {
+                throw std::invalid_argument("Invalid currency code: " + item.first);
+            }
+            if (!(item.second > 0)) {
+                throw std::invalid_argument("Exchange rate must be positive");
+            }
+            if (item.first == old->getBase()) {
+                throw std::invalid_argument("Cannot change the rate of the base currency");
+            }
+            next[item.first] = item.second;
+        }
+        return publish(std::move(next));
+    }
+
+    size_t FxRateTable::getRetiredCount() {
+        std::lock_guard<std::mutex> lock(update_mutex);
+        return retired.size();
+    }
+
+}
@@ -0,0 +1,92 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <array>
+#include <mutex>
+#include <utility>
+#include <cstdint>
+
+namespace Banking {
+
+    // валюта счетов по умолчанию и базовая валюта таблицы курсов
+    constexpr const char* DEFAULT_CURRENCY = "RUB";
+
+    // код валюты ISO 4217: три заглавные латинские буквы
+    bool isCurrencyCode(const std::string& code);
+
+    // Неизменяемая версия таблицы курсов: курс - сколько единиц базовой валюты стоит 1 единица валюты
+    class FxRates {
+    private:
+        uint64_t version;
+        std::string base;
+        std::unordered_map<std::string, double> to_base;
+
+    public:
+        FxRates(uint64_t version_value, std::string base_value, std::unordered_map<std::string, double> rates_value);
+
+        uint64_t getVersion() const { return version; }
+        const std::string& getBase() const { return base; }
+        const std::unordered_map<std::string, double>& getRates() const { return to_base; }
+
+        bool rateOf(const std::string& code, double& rate) const;
+        // курс пересчета from -> to (сколько единиц to за 1 единицу from); false - нет курса одной из валют
+        bool crossRate(const std::string& from, const std::string& to, double& rate) const;
+    };
+
+    // Таблица курсов в стиле RCU: читатели берут текущую версию без блокировок (один атомарный указатель),
+    // обновление строит новую версию целиком и подменяет указатель. Старая версия удаляется,
+    // когда ее не может читать ни один читатель (номера версий открытых читателей - в слотах, как снимки банка).
+    class FxRateTable {
+    private:
+        static const size_t MAX_READERS = 64;
+        static const uint64_t NO_READER = UINT64_MAX;
+
+        std::atomic<const FxRates*> current;
+        std::atomic<uint64_t> published_version{ 0 };
+        mutable std::array<std::atomic<uint64_t>, MAX_READERS> reader_versions;
+
+        std::mutex update_mutex; // обновления курсов выполняются по одному, чтение их не ждет
+        std::vector<std::unique_ptr<const FxRates>> retired;
+
+        size_t enterReader() const;
+        void leaveReader(size_t slot) const { reader_versions[slot].store(NO_READER); }
+        uint64_t publish(std::unordered_map<std::string, double> rates); // только под update_mutex
+
+    public:
+        explicit FxRateTable(std::string base = DEFAULT_CURRENCY);
+        ~FxRateTable();
+
+        FxRateTable(const FxRateTable&) = delete;
+        FxRateTable& operator=(const FxRateTable&) = delete;
+
+        // доступ к версии таблицы на время жизни объекта (версия не меняется и не удаляется)
+        class Reader {
+        private:
+            const FxRateTable& table;
+            size_t slot;
+            const FxRates* rates;
+
+        public:
+            explicit Reader(const FxRateTable& table_value);
+            ~Reader() { table.leaveReader(slot); }
+            Reader(const Reader&) = delete;
+            Reader& operator=(const Reader&) = delete;
+
+            const FxRates& operator*() const { return *rates; }
+            const FxRates* operator->() const { return rates; }
+        };
+
+        Reader read() const { return Reader(*this); }
+
+        // новая версия таблицы с измененными курсами (курс > 0, базовая валюта всегда 1); возвращает номер версии
+        uint64_t setRate(const std::string& code, double rate);
+        uint64_t setRates(const std::vector<std::pair<std::string, double>>& rates);
+        uint64_t getVersion() const { return published_version.load(); }
+        const std::string& getBase() const { return current.load()->getBase(); } // базовая валюта не меняется
+        size_t getRetiredCount(); // версии, которые еще могут читать
+    };
+
+}
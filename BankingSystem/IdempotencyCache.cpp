@@ -0,0 +1,81 @@
+﻿#include "IdempotencyCache.h"
+
+namespace Banking {
+
+    IdempotencyCache::IdempotencyCache(size_t capacity, Clock::duration ttl_value)
+        : capacity_per_stripe(capacity / STRIPES + 1), ttl(ttl_value) {
+    }
+
+    IdempotencyCache::Stripe& IdempotencyCache::stripe_for(const std::string& key) {
+        return stripes[std::hash<std::string>{}(key) % STRIPES];
+    }
+
+    // удаляем просроченные записи и лишние сверх лимита (самые старые)
+    void IdempotencyCache::evict(Stripe& stripe, Clock::time_point now) {
+        size_t skipped = 0;
+        while (!stripe.order.empty() && skipped < stripe.order.size()
+            && (stripe.order.front().second <= now || stripe.entries.size() > capacity_per_stripe)) {
+            auto it = stripe.entries.find(stripe.order.front().first);
+            // запись могла быть перезаписана после истечения срока - удаляем только свою версию
+            bool own = it != stripe.entries.end() && it->second.expires_at == stripe.order.front().second;
+            if (own && !it->second.completed && stripe.order.front().second > now) {
+                // операция еще выполняется - резерв переносим в конец очереди
+                stripe.order.push_back(std::move(stripe.order.front()));
+                stripe.order.pop_front();
+                ++skipped;
+                continue;
+            }
+            if (own) {
+                stripe.entries.erase(it);
+            }
+            stripe.order.pop_front();
+        }
+    }
+
+    IdempotencyCache::Lookup IdempotencyCache::lookupOrReserve(const std::string& key, const Request& request, Result& result) {
+        Stripe& stripe = stripe_for(key);
+        Clock::time_point now = Clock::now();
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+
+        auto it = stripe.entries.find(key);
+        if (it != stripe.entries.end() && it->second.expires_at > now) {
+            if (!(it->second.request == request)) {
+                return Lookup::Mismatch;
+            }
+            if (!it->second.completed) {
+                return Lookup::InProgress;
+            }
+            result = it->second.result;
+            return Lookup::Completed;
+        }
+
+        Entry& entry = stripe.entries[key];
+        entry.completed = false;
+        entry.request = request;
+        entry.result = Result();
+        entry.expires_at = now + ttl.load(std::memory_order_relaxed);
+        stripe.order.emplace_back(key, entry.expires_at);
+        evict(stripe, now);
+        return Lookup::Reserved;
+    }
+
+    void IdempotencyCache::complete(const std::string& key, const Result& result) {
+        Stripe& stripe = stripe_for(key);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        auto it = stripe.entries.find(key);
+        if (it != stripe.entries.end()) {
+            it->second.completed = true;
+            it->second.result = result;
+        }
+    }
+
+    size_t IdempotencyCache::size() {
+        size_t total = 0;
+        for (auto& stripe : stripes) {
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            total += stripe.entries.size();
+        }
+        return total;
+    }
+
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+#include <string>
+#include <deque>
+#include <mutex>
+#include <array>
+#include <chrono>
+#include <unordered_map>
+#include <exception>
+#include <atomic>
+#include <cstdint>
+
+namespace Banking {
+
+    // Кэш идемпотентных запросов: повтор запроса с тем же ключом возвращает
+    // сохраненный результат и не выполняет операцию повторно.
+    // Ограничен по размеру и времени жизни записей, разбит на независимые полосы (свой мьютекс на полосу).
+    // Резерв выполняющейся операции по размеру не вытесняется (иначе повтор выполнил бы ее второй раз),
+    // поэтому при множестве незавершенных операций полоса может временно превысить лимит.
+    class IdempotencyCache {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        enum class Lookup {
+            Reserved,   // ключ новый - вызывающий выполняет операцию и вызывает complete()
+            Completed,  // результат уже есть - вернуть его
+            InProgress, // такой же запрос выполняется прямо сейчас
+            Mismatch    // ключ уже занят другим запросом - повтор не выполняется и не получает чужой результат
+        };
+
+        // отпечаток запроса: ключ повторяют только с той же операцией, счетами и суммой
+        struct Request {
+            enum class Operation : uint8_t { Transfer, Deposit, Withdraw };
+            Operation operation = Operation::Transfer;
+            std::string account_from;
+            std::string account_to;
+            int64_t cents = 0;
+
+            bool operator==(const Request& other) const = default;
+        };
+
+        // результат операции, сохраняемый для повторов
+        struct Result {
+            bool success = true;
+            std::exception_ptr error; // исключение исходного запроса - при повторе бросается оно же
+        };
+
+    private:
+        static const size_t STRIPES = 16;
+
+        struct Entry {
+            bool completed = false;
+            Request request;
+            Result result;
+            Clock::time_point expires_at;
+        };
+
+        struct Stripe {
+            std::mutex mutex;
+            std::unordered_map<std::string, Entry> entries;
+            std::deque<std::pair<std::string, Clock::time_point>> order; // порядок вставки для вытеснения
+        };
+
+        std::array<Stripe, STRIPES> stripes;
+        size_t capacity_per_stripe;
+        std::atomic<Clock::duration> ttl; // меняется без блокировки полос
+
+        Stripe& stripe_for(const std::string& key);
+        void evict(Stripe& stripe, Clock::time_point now);
+
+    public:
+        explicit IdempotencyCache(size_t capacity = 1000000, Clock::duration ttl_value = std::chrono::hours(24));
+
+        Lookup lookupOrReserve(const std::string& key, const Request& request, Result& result);
+        void complete(const std::string& key, const Result& result);
+
+        void setTtl(Clock::duration ttl_value) { ttl.store(ttl_value, std::memory_order_relaxed); }
+        size_t size();
+    };
+
+}
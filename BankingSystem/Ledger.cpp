@@ -0,0 +1,139 @@
+﻿#include "Ledger.h"
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+namespace Banking {
+
+    Ledger::Ledger() {
+        accountIndex("@CASH");
+        accountIndex("@COMMISSION");
+        accountIndex("@DISCOUNT");
+        accountIndex("@TRANSIT");
+    }
+
+    int64_t Ledger::toCents(double amount) {
+        return static_cast<int64_t>(std::llround(amount * 100.0));
+    }
+
+    uint32_t Ledger::accountIndex(const std::string& accountNumber) {
+        auto it = account_index.find(accountNumber);
+        if (it != account_index.end()) {
+            return it->second;
+        }
+        uint32_t index = static_cast<uint32_t>(account_names.size());
+        account_names.reserve(index + 1);
+        account_first_entry.reserve(index + 1);
+        account_last_entry.reserve(index + 1);
+        account_names.push_back(accountNumber);
+        account_index.emplace(accountNumber, index);
+        account_first_entry.append().store(NO_ENTRY, std::memory_order_relaxed);
+        account_last_entry.push_back(NO_ENTRY);
+        return index;
+    }
+
+    bool Ledger::findAccount(const std::string& accountNumber, uint32_t& index) const {
+        auto it = account_index.find(accountNumber);
+        if (it == account_index.end()) {
+            return false;
+        }
+        index = it->second;
+        return true;
+    }
+
+    void Ledger::reserveAccounts(size_t extra) {
+        account_names.reserve(account_names.size() + extra);
+        account_index.reserve(account_index.size() + extra);
+        account_first_entry.reserve(account_first_entry.size() + extra);
+        account_last_entry.reserve(account_last_entry.size() + extra);
+    }
+
+    size_t Ledger::post(PostingType type, const Leg* legs, size_t count) {
+        return post(type, legs, count, std::time(nullptr));
+    }
+
+    size_t Ledger::post(PostingType type, const Leg* legs, size_t count, std::time_t time) {
+        int64_t sum = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (legs[i].account >= account_names.size()) {
+                throw std::logic_error("Ledger posting refers to unknown account");
+            }
+            sum += legs[i].amount;
+        }
+        if (count < 2 || sum != 0) {
+            throw std::logic_error("Unbalanced ledger posting");
+        }
+
+        // сначала резервируем место: дальше добавление не бросает и проводка не запишется наполовину
+        const size_t entries = entry_amount.size() + count;
+        entry_account.reserve(entries);
+        entry_amount.reserve(entries);
+        entry_kind.reserve(entries);
+        entry_next.reserve(entries);
+        entry_posting.reserve(entries);
+        posting_first.reserve(posting_type.size() + 1);
+        posting_type.reserve(posting_type.size() + 1);
+        posting_time.reserve(posting_type.size() + 1);
+
+        posting_first.push_back(static_cast<uint32_t>(entry_amount.size()));
+        posting_type.push_back(type);
+        posting_time.push_back(static_cast<int64_t>(time));
+        uint32_t posting = static_cast<uint32_t>(posting_type.size() - 1);
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t entry = static_cast<uint32_t>(entry_amount.size());
+            uint32_t account = legs[i].account;
+            entry_account.push_back(account);
+            entry_amount.push_back(legs[i].amount);
+            entry_kind.push_back(legs[i].kind);
+            entry_next.append().store(NO_ENTRY, std::memory_order_relaxed);
+            entry_posting.push_back(posting);
+            if (account_last_entry[account] == NO_ENTRY) {
+                account_first_entry[account].store(entry, std::memory_order_relaxed);
+            }
+            else {
+                entry_next[account_last_entry[account]].store(entry, std::memory_order_relaxed);
+            }
+            account_last_entry[account] = entry;
+        }
+        return posting;
+    }
+
+    Ledger::Leg Ledger::getLeg(size_t entry) const {
+        return Leg{ entry_account[entry], entry_amount[entry], static_cast<LegKind>(entry_kind[entry]) };
+    }
+
+    size_t Ledger::getLegCount(size_t posting) const {
+        size_t end = posting + 1 < posting_first.size() ? posting_first[posting + 1] : entry_amount.size();
+        return end - posting_first[posting];
+    }
+
+    size_t Ledger::getLegCount(size_t posting, const Snapshot& bound) const {
+        size_t end = posting + 1 < bound.postings ? posting_first[posting + 1] : bound.entries;
+        return end - posting_first[posting];
+    }
+
+    std::vector<int64_t> Ledger::trialBalance() const {
+        std::vector<int64_t> totals(account_names.size(), 0);
+        // ноги и суммы лежат в одинаковых блоках: кусок счетов и кусок сумм с одного индекса совпадают по длине
+        entry_account.forEachBlock(entry_amount.size(), [&](size_t first, const uint32_t* accounts, size_t length) {
+            const int64_t* amounts = &entry_amount[first];
+            for (size_t i = 0; i < length; ++i) {
+                totals[accounts[i]] += amounts[i];
+            }
+        });
+        return totals;
+    }
+
+    int64_t Ledger::totalOfAllEntries() const {
+        // простой проход по непрерывным блокам - компилятор векторизует сложение
+        int64_t sum = 0;
+        entry_amount.forEachBlock(entry_amount.size(), [&](size_t, const int64_t* amounts, size_t length) {
+            for (size_t i = 0; i < length; ++i) {
+                sum += amounts[i];
+            }
+        });
+        return sum;
+    }
+
+}
@@ -0,0 +1,182 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <initializer_list>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <ctime>
+
+namespace Banking {
+
+    // Двойная запись: каждая операция банка - проводка из N ног, сумма которых равна нулю.
+    // Суммы хранятся в копейках (int64), поэтому проверка баланса точная.
+    // Хранение по столбцам (счет / сумма / вид ноги), проводка - диапазон ног по смещению.
+    class Ledger {
+    public:
+        enum LegKind : uint8_t {
+            PRINCIPAL = 0,   // основная сумма операции
+            COMMISSION = 1,  // комиссия банка
+            DISCOUNT = 2     // скидка премиум-клиента (расход банка)
+        };
+
+        enum PostingType : uint8_t {
+            OPEN = 0,        // начальный баланс нового счета
+            DEPOSIT = 1,
+            WITHDRAW = 2,
+            TRANSFER = 3,
+            TRANSFER_OUT = 4, // половина межбанковского (межшардового) перевода
+            TRANSFER_IN = 5
+        };
+
+        // служебные счета банка (создаются первыми)
+        static const uint32_t CASH = 0;               // касса: деньги, пришедшие извне и ушедшие наружу
+        static const uint32_t COMMISSION_INCOME = 1;  // доход от комиссий
+        static const uint32_t DISCOUNT_EXPENSE = 2;   // расходы на скидки
+        static const uint32_t TRANSIT = 3;            // переводы между банками (шардами) в пути
+
+        static constexpr uint32_t NO_ENTRY = UINT32_MAX;
+
+        struct Leg {
+            uint32_t account;
+            int64_t amount;  // копейки: + зачисление на счет, - списание
+            LegKind kind;
+        };
+
+        // границы книги на момент снимка: берутся под блокировкой банка, после чего проводки, ноги и счета
+        // внутри границ можно читать без блокировки - книга только дописывается, записанное не перемещается
+        struct Snapshot {
+            size_t postings = 0;
+            size_t entries = 0;
+            size_t accounts = 0;
+        };
+
+    private:
+        // столбец книги: блоки по 64, 128, 256, ... элементов; в отличие от std::vector при росте
+        // ничего не копируется, поэтому читатель снимка не видит перевыделения памяти.
+        // size() меняет только пишущий поток - читатель берет границы из Snapshot
+        template <typename T>
+        class Column {
+        private:
+            static constexpr unsigned FIRST_BITS = 6;
+            static constexpr size_t FIRST = size_t(1) << FIRST_BITS;
+            static constexpr unsigned BLOCKS = 27; // 64 * (2^27 - 1) > UINT32_MAX элементов
+
+            std::unique_ptr<T[]> blocks[BLOCKS];
+            size_t count = 0;
+            size_t capacity = 0;
+            T* tail = nullptr;      // следующий свободный элемент текущего блока
+            T* tail_end = nullptr;
+
+            static unsigned blockOf(size_t position) { return static_cast<unsigned>(std::bit_width(position)) - 1 - FIRST_BITS; }
+
+        public:
+            T& operator[](size_t index) {
+                size_t position = index + FIRST;
+                unsigned block = blockOf(position);
+                return blocks[block][position - (FIRST << block)];
+            }
+            const T& operator[](size_t index) const {
+                size_t position = index + FIRST;
+                unsigned block = blockOf(position);
+                return blocks[block][position - (FIRST << block)];
+            }
+            size_t size() const { return count; }
+
+            void reserve(size_t total) {
+                while (capacity < total) {
+                    unsigned block = blockOf(capacity + FIRST);
+                    blocks[block] = std::make_unique<T[]>(FIRST << block);
+                    capacity += FIRST << block;
+                }
+            }
+            // следующий элемент (создан вместе с блоком)
+            T& append() {
+                if (tail == tail_end) {
+                    reserve(count + 1);
+                    unsigned block = blockOf(count + FIRST);
+                    tail = blocks[block].get();
+                    tail_end = tail + (FIRST << block);
+                }
+                ++count;
+                return *tail++;
+            }
+            void push_back(T value) { append() = std::move(value); }
+
+            // первые n элементов непрерывными кусками: f(индекс первого, указатель, длина)
+            template <typename F>
+            void forEachBlock(size_t n, F&& f) const {
+                for (size_t first = 0; first < n; ) {
+                    size_t length = std::min(n - first, FIRST << blockOf(first + FIRST));
+                    f(first, &(*this)[first], length);
+                    first += length;
+                }
+            }
+        };
+
+        Column<std::string> account_names;
+        std::unordered_map<std::string, uint32_t> account_index;
+
+        // ноги всех проводок подряд
+        Column<uint32_t> entry_account;
+        Column<int64_t> entry_amount;
+        Column<uint8_t> entry_kind;
+
+        // проводки: ноги проводки i - [posting_first[i], posting_first[i + 1])
+        Column<uint32_t> posting_first;
+        Column<uint8_t> posting_type;
+        Column<int64_t> posting_time; // std::time_t проводки
+
+        // ноги каждого счета в порядке проводок (односвязный список по номерам ног) - для выписок;
+        // начало и ссылки списка дописываются в уже прочитанные читателем элементы, поэтому атомарные
+        Column<std::atomic<uint32_t>> account_first_entry;
+        Column<uint32_t> account_last_entry;
+        Column<std::atomic<uint32_t>> entry_next;
+        Column<uint32_t> entry_posting; // проводка ноги (без двоичного поиска по posting_first)
+
+    public:
+        Ledger();
+
+        static int64_t toCents(double amount);
+        static double fromCents(int64_t cents) { return static_cast<double>(cents) / 100.0; }
+
+        // индекс счета в книге (счет регистрируется при первом обращении)
+        uint32_t accountIndex(const std::string& accountNumber);
+        void reserveAccounts(size_t extra); // перед массовой загрузкой счетов
+        bool findAccount(const std::string& accountNumber, uint32_t& index) const; // без регистрации
+        const std::string& getAccountName(uint32_t index) const { return account_names[index]; }
+        size_t getAccountCount() const { return account_names.size(); }
+
+        // записать проводку; если сумма ног не ноль - std::logic_error и книга не меняется
+        size_t post(PostingType type, const Leg* legs, size_t count);
+        size_t post(PostingType type, const Leg* legs, size_t count, std::time_t time);
+        size_t post(PostingType type, std::initializer_list<Leg> legs) { return post(type, legs.begin(), legs.size()); }
+
+        size_t getPostingCount() const { return posting_type.size(); }
+        size_t getEntryCount() const { return entry_amount.size(); }
+        PostingType getPostingType(size_t posting) const { return static_cast<PostingType>(posting_type[posting]); }
+        Leg getLeg(size_t entry) const;
+        size_t getFirstLeg(size_t posting) const { return posting_first[posting]; }
+        size_t getLegCount(size_t posting) const;
+        size_t getLegCount(size_t posting, const Snapshot& bound) const; // без обращения к текущему размеру книги
+        std::time_t getPostingTime(size_t posting) const { return static_cast<std::time_t>(posting_time[posting]); }
+
+        // границы для чтения без блокировки (вызывать под блокировкой банка)
+        Snapshot snapshot() const { return Snapshot{ posting_type.size(), entry_amount.size(), account_names.size() }; }
+
+        // обход ног одного счета: firstEntryOf(account), затем nextEntryOf(entry) до NO_ENTRY;
+        // читатель снимка останавливается и на ноге за границей snapshot().entries
+        uint32_t firstEntryOf(uint32_t account) const { return account_first_entry[account].load(std::memory_order_relaxed); }
+        uint32_t nextEntryOf(uint32_t entry) const { return entry_next[entry].load(std::memory_order_relaxed); }
+        size_t getPostingOfEntry(size_t entry) const { return entry_posting[entry]; }
+
+        // оборотно-сальдовая ведомость: итог по каждому счету книги за один проход по ногам
+        std::vector<int64_t> trialBalance() const;
+        // сумма всех ног книги (должна быть ноль)
+        int64_t totalOfAllEntries() const;
+    };
+
+}
@@ -0,0 +1,168 @@
+﻿#include "LookupFilter.h"
+
+#include <cstring>
+
+namespace Banking {
+
+    namespace {
+
+        const size_t BLOCK_BITS = 512;
+
+        // финализатор MurmurHash3
+        uint64_t mix(uint64_t value) {
+            value ^= value >> 33;
+            value *= 0xff51afd7ed558ccdULL;
+            value ^= value >> 33;
+            value *= 0xc4ceb9fe1a85ec53ULL;
+            value ^= value >> 33;
+            return value;
+        }
+
+        uint64_t rotate(uint64_t value) {
+            return (value << 31) | (value >> 33);
+        }
+
+        size_t blocksFor(size_t keys) {
+            size_t needed = (keys * LookupFilter::BITS_PER_KEY + BLOCK_BITS - 1) / BLOCK_BITS;
+            size_t blocks = 1;
+            while (blocks < needed) {
+                blocks <<= 1;
+            }
+            return blocks;
+        }
+
+    }
+
+    LookupFilter::Storage::Storage(size_t block_count)
+        : block_mask(block_count - 1), capacity(block_count * BLOCK_BITS / BITS_PER_KEY), blocks(new Block[block_count]) {
+        clear();
+    }
+
+    // блок - по младшим битам хэша, позиции битов в блоке - по 9 старших бит произведения хэша на нечетную константу
+    // (старшие биты произведения зависят от всех битов хэша, поэтому с номером блока почти не связаны)
+    void LookupFilter::Storage::set(uint64_t hash) {
+        Block& block = blocks[hash & block_mask];
+        uint64_t positions = hash * 0x9e3779b97f4a7c15ULL;
+        for (unsigned i = 0; i < BITS_PER_BLOCK_KEY; ++i, positions <<= 9) {
+            unsigned bit = static_cast<unsigned>(positions >> (64 - 9));
+            block.words[bit >> 6].fetch_or(uint64_t(1) << (bit & 63), std::memory_order_relaxed);
+        }
+    }
+
+    bool LookupFilter::Storage::test(uint64_t hash) const {
+        const Block& block = blocks[hash & block_mask];
+        uint64_t positions = hash * 0x9e3779b97f4a7c15ULL;
+        for (unsigned i = 0; i < BITS_PER_BLOCK_KEY; ++i, positions <<= 9) {
+            unsigned bit = static_cast<unsigned>(positions >> (64 - 9));
+            if ((block.words[bit >> 6].load(std::memory_order_relaxed) & (uint64_t(1) << (bit & 63))) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void LookupFilter::Storage::clear() {
+        for (size_t b = 0; b <= block_mask; ++b) {
+            for (auto& word : blocks[b].words) {
+                word.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    LookupFilter::LookupFilter(size_t expected_keys) {
+        storages.push_back(std::make_unique<Storage>(blocksFor(expected_keys)));
+        current.store(storages.back().get(), std::memory_order_release);
+    }
+
+    // по 8 байт за шаг, одно умножение на слово; номер счета обычно укладывается в одно-два слова
+    uint64_t LookupFilter::hashOf(std::string_view key) {
+        uint64_t hash = key.size() * 0x9e3779b97f4a7c15ULL;
+        size_t i = 0;
+        for (; i + 8 <= key.size(); i += 8) {
+            uint64_t word;
+            std::memcpy(&word, key.data() + i, 8);
+            hash = rotate((hash ^ word) * 0xc2b2ae3d27d4eb4fULL);
+        }
+        if (i < key.size()) {
+            // хвост: последние 8 байт строки (с перекрытием) или побайтно, если строка короче слова
+            uint64_t word = 0;
+            if (key.size() >= 8) {
+                std::memcpy(&word, key.data() + key.size() - 8, 8);
+            }
+            else {
+                for (size_t j = 0; j < key.size(); ++j) {
+                    word |= static_cast<uint64_t>(static_cast<unsigned char>(key[j])) << (8 * j);
+                }
+            }
+            hash = rotate((hash ^ word) * 0xc2b2ae3d27d4eb4fULL);
+        }
+        return mix(hash);
+    }
+
+    uint64_t LookupFilter::hashOf(uint64_t key) {
+        return mix(key ^ 0x2545f4914f6cdd1dULL);
+    }
+
+    bool LookupFilter::mayContain(uint64_t hash) const {
+        uint64_t before = version.load(std::memory_order_acquire);
+        if (before & 1) {
+            return true;
+        }
+        bool found = current.load(std::memory_order_acquire)->test(hash);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (found || version.load(std::memory_order_relaxed) != before) {
+            return true;
+        }
+        counts.rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    LookupFilter::Counts LookupFilter::getCounts() const {
+        Counts result;
+        result.rejected = counts.rejected.load(std::memory_order_relaxed);
+        result.false_positives = counts.false_positives.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    void LookupFilter::add(uint64_t hash) {
+        writable().set(hash);
+        ++keys;
+    }
+
+    bool LookupFilter::needsRebuild() const {
+        return keys + stale > getCapacity() || (stale > 64 && stale > keys / 4);
+    }
+
+    // ключей больше половины емкости - новый массив вдвое больше нужного, иначе перестроение на месте
+    void LookupFilter::rebuild(const std::vector<uint64_t>& hashes) {
+        if (hashes.size() * 2 > getCapacity()) {
+            auto storage = std::make_unique<Storage>(blocksFor(hashes.size() * 2));
+            for (uint64_t hash : hashes) {
+                storage->set(hash);
+            }
+            current.store(storage.get(), std::memory_order_release);
+            storages.push_back(std::move(storage));
+        }
+        else {
+            uint64_t before = version.load(std::memory_order_relaxed);
+            version.store(before + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            writable().clear();
+            for (uint64_t hash : hashes) {
+                writable().set(hash);
+            }
+            version.store(before + 2, std::memory_order_release);
+        }
+        keys = hashes.size();
+        stale = 0;
+    }
+
+    size_t LookupFilter::getMemoryBytes() const {
+        size_t bytes = 0;
+        for (const auto& storage : storages) {
+            bytes += (storage->block_mask + 1) * sizeof(Block);
+        }
+        return bytes;
+    }
+
+}
@@ -0,0 +1,96 @@
+﻿#pragma once
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+namespace Banking {
+
+    // Блочный фильтр Блума перед индексами банка: "нет" - ключа точно нет, "возможно" - нужен точный поиск.
+    // Все биты ключа лежат в одном блоке размером в кэш-линию, проверка - одно хэширование и одна линия.
+    // Около 10 бит на ключ, 7 бит на ключ в блоке: ложноположительных ответов порядка 1%.
+    //
+    // Проверка идет без блокировки банка, изменения - под его write_mutex:
+    //  - добавление только устанавливает биты (ключ, добавляемый одновременно с проверкой, может быть еще не виден);
+    //  - удалить ключ из фильтра Блума нельзя, удаленные ключи копятся до перестроения;
+    //  - перестроение на том же месте защищено счетчиком версий (seqlock): проверка, попавшая на перестроение,
+    //    отвечает "возможно"; при росте строится новый массив, старые не освобождаются до разрушения фильтра
+    //    (размеры растут вдвое, поэтому старые массивы занимают меньше текущего).
+    class LookupFilter {
+    public:
+        static constexpr size_t BITS_PER_KEY = 10;
+        static constexpr unsigned BITS_PER_BLOCK_KEY = 7;
+
+        // ответы "нет" и ложноположительные "возможно" - считаются всегда, не только при включенных метриках
+        struct Counts {
+            uint64_t rejected = 0;
+            uint64_t false_positives = 0;
+
+            // доля ложноположительных среди запросов несуществующих ключей
+            double falsePositiveRate() const {
+                return rejected + false_positives == 0 ? 0.0 : static_cast<double>(false_positives) / static_cast<double>(rejected + false_positives);
+            }
+        };
+
+    private:
+        struct alignas(64) Block {
+            std::atomic<uint64_t> words[8];
+        };
+
+        struct Storage {
+            size_t block_mask;
+            size_t capacity; // ключей до роста
+            std::unique_ptr<Block[]> blocks;
+
+            explicit Storage(size_t block_count);
+            void set(uint64_t hash);
+            bool test(uint64_t hash) const;
+            void clear();
+        };
+
+        std::atomic<const Storage*> current;
+        std::vector<std::unique_ptr<Storage>> storages; // последний - текущий
+        std::atomic<uint64_t> version{ 0 };             // нечетный - идет перестроение
+
+        // счетчики в своей кэш-линии: current и version читает каждая проверка
+        struct alignas(64) SharedCounts {
+            std::atomic<uint64_t> rejected{ 0 };
+            std::atomic<uint64_t> false_positives{ 0 };
+        };
+        mutable SharedCounts counts;
+
+        size_t keys = 0;   // ключей в индексе
+        size_t stale = 0;  // удаленных ключей, чьи биты еще в фильтре
+
+        Storage& writable() { return *storages.back(); }
+
+    public:
+        explicit LookupFilter(size_t expected_keys = 1024);
+
+        LookupFilter(const LookupFilter&) = delete;
+        LookupFilter& operator=(const LookupFilter&) = delete;
+
+        static uint64_t hashOf(std::string_view key);
+        static uint64_t hashOf(uint64_t key);
+
+        // false - ключа точно нет
+        bool mayContain(uint64_t hash) const;
+        // владелец индекса сообщает, что "возможно" оказалось промахом
+        void recordFalsePositive() const { counts.false_positives.fetch_add(1, std::memory_order_relaxed); }
+        Counts getCounts() const;
+
+        // изменения - только под блокировкой владельца индекса
+        void add(uint64_t hash);
+        void remove() { --keys; ++stale; }
+        // пора перестроить: фильтр переполнен или удаленные ключи заметно повышают долю ложных ответов
+        bool needsRebuild() const;
+        void rebuild(const std::vector<uint64_t>& hashes);
+
+        size_t getKeyCount() const { return keys; }
+        size_t getStaleCount() const { return stale; }
+        size_t getCapacity() const { return storages.back()->capacity; }
+        size_t getMemoryBytes() const;
+    };
+
+}
@@ -1,5 +1,8 @@
 #include "Menu.h"
+#include "Client.h"
+#include "Metrics.h"
 #include <iostream>
+#include <fstream>
 #include <limits>
 
 using namespace Banking;
@@ -78,7 +81,8 @@ void Menu::clientMenu() {
         std::cout << "2. Create Premium Client" << std::endl;
         std::cout << "3. Delete Client" << std::endl;
         std::cout << "4. Show All Clients" << std::endl;
-        std::cout << "5. Back to Main Menu" << std::endl;
+        std::cout << "5. Find Clients" << std::endl;
+        std::cout << "6. Back to Main Menu" << std::endl;
 
         int choice = getNumber("Select option: ");
 
@@ -87,7 +91,8 @@ void Menu::clientMenu() {
         case 2: createPremiumClient(); break;
         case 3: deleteClient(); break;
         case 4: showAllClients(); break;
-        case 5: return;
+        case 5: findClients(); break;
+        case 6: return;
         default: std::cout << "Invalid choice." << std::endl;
         }
     }
@@ -113,7 +118,7 @@ void Menu::createClient() {
         Address address(street, city, country, postId);
         Date date(day, month, year);
 
-        auto client = bank.createClient(id, name, surname, address, date);
+        auto client = bank.createClient(id, std::move(name), std::move(surname), address, date);
         std::cout << "Client created successfully!" << std::endl;
 
     }
@@ -159,7 +164,7 @@ void Menu::createPremiumClient() {
         Address address(street, city, country, postId);
         Date date(day, month, year);
 
-        auto client = bank.createPremiumClient(id, name, surname, address, date, level);
+        auto client = bank.createPremiumClient(id, std::move(name), std::move(surname), address, date, std::move(level));
         std::cout << "Premium client created successfully!" << std::endl;
 
     }
@@ -184,6 +189,45 @@ void Menu::showAllClients() {
     bank.display_all_clients_in_bank();
 }
 
+void Menu::findClients() {
+    std::cout << "\nFIND CLIENTS" << std::endl;
+    std::cout << "1. By surname prefix" << std::endl;
+    std::cout << "2. By city" << std::endl;
+    std::cout << "3. By country" << std::endl;
+    std::cout << "4. By registration date range" << std::endl;
+
+    int choice = getNumber("Select option: ");
+    std::vector<std::shared_ptr<Client>> found;
+    switch (choice) {
+    case 1: found = bank.find_clients_by_surname_prefix(getString("Surname prefix: ")); break;
+    case 2: found = bank.find_clients_by_city(getString("City: ")); break;
+    case 3: found = bank.find_clients_by_country(getString("Country: ")); break;
+    case 4: {
+        int day = getNumber("From day: ");
+        int month = getNumber("From month: ");
+        int year = getNumber("From year: ");
+        Date from(day, month, year);
+        day = getNumber("To day: ");
+        month = getNumber("To month: ");
+        year = getNumber("To year: ");
+        found = bank.find_clients_registered_between(from, Date(day, month, year));
+        break;
+    }
+    default:
+        std::cout << "Invalid choice." << std::endl;
+        return;
+    }
+
+    if (found.empty()) {
+        std::cout << "No clients found." << std::endl;
+        return;
+    }
+    for (const auto& client : found) {
+        client->displayinfo();
+    }
+    std::cout << "Found: " << found.size() << std::endl;
+}
+
 void Menu::accountMenu() {
     while (true) {
         std::cout << "\nACCOUNT MANAGEMENT" << std::endl;
@@ -339,7 +383,11 @@ void Menu::reportMenu() {
         std::cout << "1. Show All Clients" << std::endl;
         std::cout << "2. Show All Accounts" << std::endl;
         std::cout << "3. Show All Transactions" << std::endl;
-        std::cout << "4. Back to Main Menu" << std::endl;
+        std::cout << "4. Balance Report" << std::endl;
+        std::cout << "5. Trial Balance" << std::endl;
+        std::cout << "6. Account Statement" << std::endl;
+        std::cout << "7. Metrics" << std::endl;
+        std::cout << "8. Back to Main Menu" << std::endl;
 
         int choice = getNumber("Select option: ");
 
@@ -347,7 +395,11 @@ void Menu::reportMenu() {
         case 1: showAllClients(); break;
         case 2: showAllAccounts(); break;
         case 3: showAllTransactions(); break;
-        case 4: return;
+        case 4: showBalanceReport(); break;
+        case 5: showTrialBalance(); break;
+        case 6: showAccountStatement(); break;
+        case 7: showMetrics(); break;
+        case 8: return;
         default: std::cout << "Invalid choice." << std::endl;
         }
     }
@@ -355,4 +407,45 @@ void Menu::reportMenu() {
 
 void Menu::showAllTransactions() {
     bank.displayinfo_about_transactions_in_bank();
+}
+
+void Menu::showBalanceReport() {
+    bank.display_balance_report();
+}
+
+void Menu::showTrialBalance() {
+    bank.display_trial_balance();
+}
+
+//     
+void Menu::showAccountStatement() {
+    std::string accountNumber = getString("Account number: ");
+    int month = getNumber("Month (1-12): ");
+    int year = getNumber("Year: ");
+    if (month < 1 || month > 12) {
+        std::cout << "Invalid month." << std::endl;
+        return;
+    }
+    try {
+        bank.display_statement(accountNumber, year, month);
+    }
+    catch (const std::exception& e) {
+        std::cout << "Error: " << e.what() << std::endl;
+    }
+}
+
+//       ( )    JSON
+void Menu::showMetrics() {
+    std::cout << "\nMETRICS" << std::endl;
+    Metrics::writeReport(std::cout);
+    std::string path = getString("JSON file for dump (empty to skip): ");
+    if (!path.empty()) {
+        std::ofstream file(path);
+        if (!file) {
+            std::cout << "Cannot open file: " << path << std::endl;
+            return;
+        }
+        Metrics::writeJson(file);
+        std::cout << "Metrics saved to " << path << std::endl;
+    }
 }
\ No newline at end of file
@@ -22,6 +22,7 @@ private:
     void createPremiumClient();
     void deleteClient();
     void showAllClients();
+    void findClients();
 
     //   
     void createCheckingAccount();
@@ -36,6 +37,10 @@ private:
 
     // 
     void showAllTransactions();
+    void showBalanceReport();
+    void showTrialBalance();
+    void showAccountStatement();
+    void showMetrics();
 
 public:
     void showMainMenu();
@@ -0,0 +1,316 @@
+﻿#include "Metrics.h"
+
+#include <algorithm>
+#include <array>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Banking {
+
+    namespace {
+        unsigned highestBit(uint64_t value) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanReverse64(&index, value);
+            return static_cast<unsigned>(index);
+#else
+            return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#endif
+        }
+
+        const size_t METRIC_COUNT = static_cast<size_t>(Metric::COUNT);
+        const size_t COUNTER_COUNT = static_cast<size_t>(Counter::COUNT);
+        const size_t BUCKET_COUNT = LatencyHistogram::BUCKETS;
+
+        // счетчики одного потока; пишет только владелец, читают snapshot/reset
+        struct ThreadMetrics {
+            std::array<std::array<std::atomic<uint64_t>, BUCKET_COUNT>, METRIC_COUNT> buckets{};
+            std::array<std::atomic<uint64_t>, METRIC_COUNT> sums{};
+            std::array<std::atomic<uint64_t>, METRIC_COUNT> maxima{};
+            std::array<std::atomic<uint64_t>, COUNTER_COUNT> counters{};
+        };
+
+        void bump(std::atomic<uint64_t>& value, uint64_t delta) {
+            value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
+
+        // все потоки, когда-либо писавшие метрики; данные завершившихся потоков сливаются в retired
+        struct Registry {
+            std::mutex mutex;
+            std::vector<ThreadMetrics*> live;
+            ThreadMetrics retired;
+        };
+
+        Registry& registry() {
+            static Registry* instance = new Registry(); // не разрушается: thread_local могут умирать после main
+            return *instance;
+        }
+
+        void addInto(ThreadMetrics& target, const ThreadMetrics& source) {
+            for (size_t m = 0; m < METRIC_COUNT; ++m) {
+                for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+                    uint64_t value = source.buckets[m][b].load(std::memory_order_relaxed);
+                    if (value != 0) {
+                        bump(target.buckets[m][b], value);
+                    }
+                }
+                bump(target.sums[m], source.sums[m].load(std::memory_order_relaxed));
+                uint64_t maximum = source.maxima[m].load(std::memory_order_relaxed);
+                if (maximum > target.maxima[m].load(std::memory_order_relaxed)) {
+                    target.maxima[m].store(maximum, std::memory_order_relaxed);
+                }
+            }
+            for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+                bump(target.counters[c], source.counters[c].load(std::memory_order_relaxed));
+            }
+        }
+
+        void clear(ThreadMetrics& target) {
+            for (size_t m = 0; m < METRIC_COUNT; ++m) {
+                for (auto& bucket : target.buckets[m]) {
+                    bucket.store(0, std::memory_order_relaxed);
+                }
+                target.sums[m].store(0, std::memory_order_relaxed);
+                target.maxima[m].store(0, std::memory_order_relaxed);
+            }
+            for (auto& counter : target.counters) {
+                counter.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        class ThreadSlot {
+        public:
+            std::unique_ptr<ThreadMetrics> metrics;
+
+            ThreadSlot() : metrics(new ThreadMetrics()) {
+                Registry& all = registry();
+                std::lock_guard<std::mutex> lock(all.mutex);
+                all.live.push_back(metrics.get());
+            }
+
+            ~ThreadSlot() {
+                Registry& all = registry();
+                std::lock_guard<std::mutex> lock(all.mutex);
+                addInto(all.retired, *metrics);
+                all.live.erase(std::find(all.live.begin(), all.live.end(), metrics.get()));
+            }
+        };
+
+        ThreadMetrics& local() {
+            thread_local ThreadSlot slot;
+            return *slot.metrics;
+        }
+    }
+
+    size_t LatencyHistogram::bucketOf(uint64_t nanoseconds) {
+        const uint64_t linear = uint64_t(1) << (SUB_BITS + 1);
+        if (nanoseconds < linear) {
+            return static_cast<size_t>(nanoseconds);
+        }
+        if (nanoseconds > MAX_VALUE) {
+            nanoseconds = MAX_VALUE;
+        }
+        unsigned shift = highestBit(nanoseconds) - SUB_BITS;
+        return static_cast<size_t>(shift) * (size_t(1) << SUB_BITS) + static_cast<size_t>(nanoseconds >> shift);
+    }
+
+    uint64_t LatencyHistogram::lowerBound(size_t bucket) {
+        const size_t linear = size_t(1) << (SUB_BITS + 1);
+        if (bucket < linear) {
+            return bucket;
+        }
+        size_t sub = size_t(1) << SUB_BITS;
+        size_t shift = bucket / sub - 1;
+        return static_cast<uint64_t>(bucket % sub + sub) << shift;
+    }
+
+    void LatencyHistogram::add(uint64_t nanoseconds) {
+        if (buckets.empty()) {
+            buckets.assign(BUCKETS, 0);
+        }
+        ++buckets[bucketOf(nanoseconds)];
+        ++count;
+        sum += nanoseconds;
+        max = std::max(max, nanoseconds);
+    }
+
+    uint64_t LatencyHistogram::percentile(double p) const {
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t target = static_cast<uint64_t>(p * static_cast<double>(count));
+        if (target >= count) {
+            target = count - 1;
+        }
+        uint64_t seen = 0;
+        for (size_t b = 0; b < buckets.size(); ++b) {
+            seen += buckets[b];
+            if (seen > target) {
+                return std::min(lowerBound(b), max);
+            }
+        }
+        return max;
+    }
+
+    namespace {
+        void add(Metric metric, Metrics::Clock::duration duration) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+            uint64_t nanoseconds = elapsed > 0 ? static_cast<uint64_t>(elapsed) : 0;
+            ThreadMetrics& mine = local();
+            size_t m = static_cast<size_t>(metric);
+            bump(mine.buckets[m][LatencyHistogram::bucketOf(nanoseconds)], 1);
+            bump(mine.sums[m], nanoseconds);
+            if (nanoseconds > mine.maxima[m].load(std::memory_order_relaxed)) {
+                mine.maxima[m].store(nanoseconds, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void Metrics::record(Metric metric, Clock::time_point start) {
+        add(metric, Clock::now() - start);
+    }
+
+    void Metrics::lap(Metric metric, Clock::time_point& start) {
+        Clock::time_point now = Clock::now();
+        add(metric, now - start);
+        start = now;
+    }
+
+    void Metrics::count(Counter counter) {
+        bump(local().counters[static_cast<size_t>(counter)], 1);
+    }
+
+    MetricsSnapshot Metrics::snapshot() {
+        std::unique_ptr<ThreadMetrics> sum(new ThreadMetrics()); // ~50 КБ - не на стек
+        ThreadMetrics& total = *sum;
+        {
+            Registry& all = registry();
+            std::lock_guard<std::mutex> lock(all.mutex);
+            addInto(total, all.retired);
+            for (const ThreadMetrics* metrics : all.live) {
+                addInto(total, *metrics);
+            }
+        }
+        MetricsSnapshot result;
+        result.histograms.resize(METRIC_COUNT);
+        for (size_t m = 0; m < METRIC_COUNT; ++m) {
+            LatencyHistogram& histogram = result.histograms[m];
+            histogram.buckets.resize(BUCKET_COUNT);
+            for (size_t b = 0; b < BUCKET_COUNT; ++b) {
+                histogram.buckets[b] = total.buckets[m][b].load(std::memory_order_relaxed);
+                histogram.count += histogram.buckets[b];
+            }
+            histogram.sum = total.sums[m].load(std::memory_order_relaxed);
+            histogram.max = total.maxima[m].load(std::memory_order_relaxed);
+        }
+        for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+            result.counters.push_back(total.counters[c].load(std::memory_order_relaxed));
+        }
+        return result;
+    }
+
+    // записи, идущие в момент сброса, могут частично попасть в новый отсчет
+    void Metrics::reset() {
+        Registry& all = registry();
+        std::lock_guard<std::mutex> lock(all.mutex);
+        clear(all.retired);
+        for (ThreadMetrics* metrics : all.live) {
+            clear(*metrics);
+        }
+    }
+
+    const char* Metrics::name(Metric metric) {
+        switch (metric) {
+        case Metric::TRANSFER: return "transfer";
+        case Metric::LOCK_WAIT: return "transfer.lock_wait";
+        case Metric::TRANSFER_LOOKUP: return "transfer.lookup";
+        case Metric::VELOCITY_CHECK: return "transfer.velocity_check";
+        case Metric::POSTING_APPLY: return "posting.apply";
+        case Metric::POSTING_HISTORY: return "posting.history";
+        case Metric::POSTING_LEDGER: return "posting.ledger";
+        case Metric::POSTING_PUBLISH: return "posting.publish";
+        case Metric::DEPOSIT: return "deposit";
+        case Metric::WITHDRAW: return "withdraw";
+        case Metric::TRANSFER_BATCH: return "transfer_batch";
+        default: return "unknown";
+        }
+    }
+
+    const char* Metrics::name(Counter counter) {
+        switch (counter) {
+        case Counter::TRANSFER_DECLINED: return "transfer.declined";
+        case Counter::POSTING_ROLLBACK: return "posting.rollback";
+        case Counter::WITHDRAW_DECLINED: return "withdraw.declined";
+        case Counter::VELOCITY_BLOCKED: return "velocity.blocked";
+        case Counter::LOOKUP_FILTER_REJECTED: return "lookup.filter_rejected";
+        case Counter::LOOKUP_FILTER_FALSE_POSITIVE: return "lookup.filter_false_pos";
+        default: return "unknown";
+        }
+    }
+
+    // отказ фильтра - верный ответ "нет"; пропуск несуществующего ключа - ложноположительный
+    double Metrics::lookupFilterFalsePositiveRate(const MetricsSnapshot& data) {
+        uint64_t rejected = data.counters[static_cast<size_t>(Counter::LOOKUP_FILTER_REJECTED)];
+        uint64_t passed = data.counters[static_cast<size_t>(Counter::LOOKUP_FILTER_FALSE_POSITIVE)];
+        return rejected + passed == 0 ? 0.0 : static_cast<double>(passed) / static_cast<double>(rejected + passed);
+    }
+
+    void Metrics::writeReport(std::ostream& out) {
+        if (!enabled()) {
+            out << "Metrics are disabled in this build (BANKING_NO_METRICS)" << std::endl;
+            return;
+        }
+        MetricsSnapshot data = snapshot();
+        out << std::left << std::setw(26) << "operation" << std::right << std::setw(12) << "count" << std::setw(12) << "mean,us"
+            << std::setw(12) << "p50,us" << std::setw(12) << "p99,us" << std::setw(12) << "p99.9,us" << std::setw(12) << "max,us" << std::endl;
+        auto micros = [](double nanoseconds) { return nanoseconds / 1000.0; };
+        out << std::fixed << std::setprecision(3);
+        for (size_t m = 0; m < METRIC_COUNT; ++m) {
+            const LatencyHistogram& histogram = data.histograms[m];
+            out << std::left << std::setw(26) << name(static_cast<Metric>(m)) << std::right << std::setw(12) << histogram.count
+                << std::setw(12) << micros(histogram.mean()) << std::setw(12) << micros(static_cast<double>(histogram.percentile(0.5)))
+                << std::setw(12) << micros(static_cast<double>(histogram.percentile(0.99))) << std::setw(12) << micros(static_cast<double>(histogram.percentile(0.999)))
+                << std::setw(12) << micros(static_cast<double>(histogram.max)) << std::endl;
+        }
+        out.unsetf(std::ios::floatfield);
+        out << std::setprecision(6);
+        for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+            out << std::left << std::setw(26) << name(static_cast<Counter>(c)) << std::right << std::setw(12) << data.counters[c] << std::endl;
+        }
+        out << std::left << std::setw(26) << "lookup.filter_fp_rate" << std::right << std::setw(12) << lookupFilterFalsePositiveRate(data) << std::endl;
+    }
+
+    // {"histograms":{"transfer":{"count":..,"sum_ns":..,"max_ns":..,"p50_ns":..,"p99_ns":..,"p999_ns":..,
+    //   "buckets":[[lower_bound_ns,count],...]},...},"counters":{"transfer.declined":..,...},
+    //  "lookup.filter_fp_rate":..}
+    void Metrics::writeJson(std::ostream& out) {
+        MetricsSnapshot data = snapshot();
+        out << "{\"enabled\":" << (enabled() ? "true" : "false") << ",\"histograms\":{";
+        for (size_t m = 0; m < METRIC_COUNT; ++m) {
+            const LatencyHistogram& histogram = data.histograms[m];
+            out << (m == 0 ? "" : ",") << '"' << name(static_cast<Metric>(m)) << "\":{\"count\":" << histogram.count
+                << ",\"sum_ns\":" << histogram.sum << ",\"max_ns\":" << histogram.max
+                << ",\"p50_ns\":" << histogram.percentile(0.5) << ",\"p99_ns\":" << histogram.percentile(0.99)
+                << ",\"p999_ns\":" << histogram.percentile(0.999) << ",\"buckets\":[";
+            bool first = true;
+            for (size_t b = 0; b < histogram.buckets.size(); ++b) {
+                if (histogram.buckets[b] != 0) {
+                    out << (first ? "" : ",") << '[' << LatencyHistogram::lowerBound(b) << ',' << histogram.buckets[b] << ']';
+                    first = false;
+                }
+            }
+            out << "]}";
+        }
+        out << "},\"counters\":{";
+        for (size_t c = 0; c < COUNTER_COUNT; ++c) {
+            out << (c == 0 ? "" : ",") << '"' << name(static_cast<Counter>(c)) << "\":" << data.counters[c];
+        }
+        out << "},\"lookup.filter_fp_rate\":" << lookupFilterFalsePositiveRate(data) << "}" << std::endl;
+    }
+
+}
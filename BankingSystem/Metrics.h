@@ -0,0 +1,124 @@
+﻿#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Встроенные метрики задержек операций банка.
+// Сборка с BANKING_NO_METRICS убирает все точки замера из кода (макросы BANK_METRIC_* пустые).
+
+namespace Banking {
+
+    // замеряемые участки (порядок = порядок строк в отчете)
+    enum class Metric : uint8_t {
+        TRANSFER,          // tryTransfer целиком, включая ожидание блокировки
+        LOCK_WAIT,         // ожидание write_mutex в tryTransfer
+        TRANSFER_LOOKUP,   // поиск обоих счетов по номеру
+        VELOCITY_CHECK,    // проверка лимитов скорости
+        POSTING_APPLY,     // undo records + списания и зачисления
+        POSTING_HISTORY,   // создание записей Transaction
+        POSTING_LEDGER,    // запись проводки в книгу
+        POSTING_PUBLISH,   // связи истории, версии балансов, лента изменений
+        DEPOSIT,
+        WITHDRAW,
+        TRANSFER_BATCH,    // пакет переводов целиком
+        COUNT
+    };
+
+    enum class Counter : uint8_t {
+        TRANSFER_DECLINED,
+        POSTING_ROLLBACK,
+        WITHDRAW_DECLINED,
+        VELOCITY_BLOCKED,
+        LOOKUP_FILTER_REJECTED,       // поиск несуществующего номера отклонен фильтром Блума
+        LOOKUP_FILTER_FALSE_POSITIVE, // фильтр пропустил номер, которого нет в индексе
+        COUNT
+    };
+
+    // Гистограмма в стиле HDR: точные значения до 32 нс, дальше 16 корзин на каждую степень двойки
+    // (относительная ошибка не больше 1/16), значения в наносекундах до 2^40 (~18 минут)
+    struct LatencyHistogram {
+        static constexpr unsigned SUB_BITS = 4;
+        static constexpr unsigned MAX_BITS = 40;
+        static constexpr uint64_t MAX_VALUE = (uint64_t(1) << MAX_BITS) - 1;
+        static constexpr size_t BUCKETS = (MAX_BITS - 1 - SUB_BITS) * (size_t(1) << SUB_BITS) + (size_t(1) << (SUB_BITS + 1));
+        static size_t bucketOf(uint64_t nanoseconds);
+        static uint64_t lowerBound(size_t bucket);
+
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+        std::vector<uint64_t> buckets;
+
+        double mean() const { return count == 0 ? 0.0 : static_cast<double>(sum) / count; }
+        void add(uint64_t nanoseconds); // для гистограмм вне Metrics (один поток)
+        uint64_t percentile(double p) const; // нижняя граница корзины, где набирается доля p
+    };
+
+    // сумма по всем потокам на момент вызова
+    struct MetricsSnapshot {
+        std::vector<LatencyHistogram> histograms; // по Metric
+        std::vector<uint64_t> counters;           // по Counter
+    };
+
+    class Metrics {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr bool enabled() {
+#ifdef BANKING_NO_METRICS
+            return false;
+#else
+            return true;
+#endif
+        }
+
+        // запись в счетчики своего потока: без блокировок, только relaxed атомики (один писатель)
+        static void record(Metric metric, Clock::time_point start);
+        // участок закончился, следующий начинается с этого же момента (одно чтение часов на границу)
+        static void lap(Metric metric, Clock::time_point& start);
+        static void count(Counter counter);
+
+        // сложить данные всех потоков (живых и завершившихся) / обнулить
+        static MetricsSnapshot snapshot();
+        static void reset();
+
+        static const char* name(Metric metric);
+        static const char* name(Counter counter);
+        // доля ложноположительных ответов фильтров поиска среди запросов несуществующих ключей
+        static double lookupFilterFalsePositiveRate(const MetricsSnapshot& data);
+
+        // человекочитаемая таблица (мкс) и JSON для внешних систем мониторинга
+        static void writeReport(std::ostream& out);
+        static void writeJson(std::ostream& out);
+    };
+
+#ifdef BANKING_NO_METRICS
+#define BANK_METRIC_START(name)
+#define BANK_METRIC_LAP(name, metric)
+#define BANK_METRIC_SCOPE(metric)
+#define BANK_METRIC_COUNT(counter)
+#else
+    // замер участка до конца области видимости
+    class MetricScope {
+    private:
+        Metric metric;
+        Metrics::Clock::time_point start;
+
+    public:
+        explicit MetricScope(Metric metric_value) : metric(metric_value), start(Metrics::Clock::now()) {}
+        ~MetricScope() { Metrics::record(metric, start); }
+        MetricScope(const MetricScope&) = delete;
+        MetricScope& operator=(const MetricScope&) = delete;
+    };
+
+#define BANK_METRIC_CONCAT_(a, b) a##b
+#define BANK_METRIC_CONCAT(a, b) BANK_METRIC_CONCAT_(a, b)
+#define BANK_METRIC_START(name) auto name = ::Banking::Metrics::Clock::now()
+#define BANK_METRIC_LAP(name, metric) ::Banking::Metrics::lap(::Banking::Metric::metric, name)
+#define BANK_METRIC_SCOPE(metric) ::Banking::MetricScope BANK_METRIC_CONCAT(metric_scope_, __LINE__)(::Banking::Metric::metric)
+#define BANK_METRIC_COUNT(counter) ::Banking::Metrics::count(::Banking::Counter::counter)
+#endif
+
+}
@@ -0,0 +1,57 @@
+﻿#pragma once
+#include <atomic>
+#include <utility>
+
+namespace Banking {
+
+    // Неблокирующая очередь "много писателей - один читатель" (схема Вьюкова)
+    // push можно вызывать из любых потоков, pop - только из потока-владельца
+    template <typename T>
+    class MpscQueue {
+    private:
+        struct Node {
+            std::atomic<Node*> next{ nullptr };
+            T value{};
+        };
+
+        std::atomic<Node*> head; // сюда добавляют писатели
+        Node* tail;              // отсюда забирает читатель
+
+    public:
+        MpscQueue() {
+            Node* stub = new Node();
+            head.store(stub, std::memory_order_relaxed);
+            tail = stub;
+        }
+
+        ~MpscQueue() {
+            while (tail != nullptr) {
+                Node* next = tail->next.load(std::memory_order_relaxed);
+                delete tail;
+                tail = next;
+            }
+        }
+
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        void push(T value) {
+            Node* node = new Node();
+            node->value = std::move(value);
+            Node* prev = head.exchange(node, std::memory_order_acq_rel);
+            prev->next.store(node, std::memory_order_release);
+        }
+
+        bool pop(T& value) {
+            Node* next = tail->next.load(std::memory_order_acquire);
+            if (next == nullptr) {
+                return false;
+            }
+            value = std::move(next->value);
+            delete tail;
+            tail = next;
+            return true;
+        }
+    };
+
+}
@@ -0,0 +1,93 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace Banking {
+    class Account;
+}
+
+namespace Banking {
+
+    class Bank;
+
+    // Проводка: набор списаний и зачислений, которые банк применяет целиком или не применяет вовсе
+    // (например, перевод плюс комиссия). Выполняется через Bank::post.
+    class Posting {
+        friend class Bank; // пересчет валют назначает только банк при переводе (Bank::post такие проводки не принимает)
+
+    public:
+        struct Leg {
+            std::shared_ptr<Account> account;
+            double amount;
+            bool debit;               // true - списание (withdraw), false - зачисление (deposit)
+            const char* type;         // тип транзакции (литерал): TRANSFER_OUT, TRANSFER_IN, FEE, ...
+            std::string counterpart;  // второй счет для истории (" " - нет)
+        };
+
+        // ноги проводки: первые used элементов буфера
+        class Legs {
+        private:
+            const Leg* first;
+            size_t count;
+
+        public:
+            Legs(const Leg* first_value, size_t count_value) : first(first_value), count(count_value) {}
+            const Leg* begin() const { return first; }
+            const Leg* end() const { return first + count; }
+            size_t size() const { return count; }
+            bool empty() const { return count == 0; }
+            const Leg& operator[](size_t index) const { return first[index]; }
+        };
+
+    private:
+        // clear() не удаляет ноги, а только сбрасывает used: повторно используемая проводка
+        // (Bank::transfer_posting) не выделяет память ни под ноги, ни под номера второго счета
+        std::vector<Leg> legs;
+        size_t used = 0;
+        double discount = 0; // скидка клиенту за счет банка (в книге - нога расходов на скидки)
+        uint64_t fx_version = 0; // версия курсов, если ноги в разных валютах (0 - без пересчета)
+
+        // суммы ног уже пересчитаны в валюты своих счетов по версии курсов version
+        void setConversion(uint64_t version) { fx_version = version; }
+
+        void add(const std::shared_ptr<Account>& account, double amount, bool debit, const char* type, const std::string& counterpart) {
+            if (used == legs.size()) {
+                legs.emplace_back();
+            }
+            Leg& leg = legs[used++];
+            leg.account = account;
+            leg.amount = amount;
+            leg.debit = debit;
+            leg.type = type;
+            leg.counterpart.assign(counterpart); // строка переиспользует свою емкость
+        }
+
+    public:
+        Posting() = default;
+
+        void debit(const std::shared_ptr<Account>& account, double amount, const char* type, const std::string& counterpart = " ") {
+            add(account, amount, true, type, counterpart);
+        }
+        void credit(const std::shared_ptr<Account>& account, double amount, const char* type, const std::string& counterpart = " ") {
+            add(account, amount, false, type, counterpart);
+        }
+
+        void addDiscount(double amount) { discount += amount; }
+
+        Legs getLegs() const { return Legs(legs.data(), used); }
+        double getDiscount() const { return discount; }
+        bool isConversion() const { return fx_version != 0; }
+        uint64_t getFxVersion() const { return fx_version; }
+        void clear() {
+            for (size_t i = 0; i < used; ++i) {
+                legs[i].account.reset(); // проводка не держит счета после выполнения
+            }
+            used = 0;
+            discount = 0;
+            fx_version = 0;
+        }
+    };
+
+}
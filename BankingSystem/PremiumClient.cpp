@@ -1,17 +1,18 @@
 #include "PremiumClient.h"
 #include <stdexcept>
 #include <iostream>
+#include <utility>
 #include "Account.h"
 
 namespace Banking {
 
     // 
-    PremiumClient::PremiumClient(int id_value, const std::string& name_value, const std::string& surname_value,
+    PremiumClient::PremiumClient(int id_value, std::string name_value, std::string surname_value,
         const Address& address_value, const Date& date_value,
-        const std::string& level, double discount)
-        : Client(id_value, name_value, surname_value, address_value, date_value) {
+        std::string level, double discount)
+        : Client(id_value, std::move(name_value), std::move(surname_value), checkLevel(level, address_value), date_value) {
 
-        setPremiumLevel(level); //    
+        setPremiumLevel(std::move(level)); //    
         std::cout << "PremiumClient constructor called for: " << getSurname() << " with level: " << premium_level << std::endl;
     }
 
@@ -19,12 +20,19 @@ namespace Banking {
         std::cout << "PremiumClient destructor called for: " << getSurname() << std::endl;
     }
 
+    const Address& PremiumClient::checkLevel(const std::string& level, const Address& address_value) {
+        if (level != "Silver" && level != "Gold" && level != "Platinum") {
+            throw std::invalid_argument("Invalid premium level. Must be Silver, Gold, or Platinum");
+        }
+        return address_value;
+    }
+
     //      
-    void PremiumClient::setPremiumLevel(const std::string& level) {
+    void PremiumClient::setPremiumLevel(std::string level) {
         if (level != "Silver" && level != "Gold" && level != "Platinum") {
             throw std::invalid_argument("Invalid premium level. Must be Silver, Gold, or Platinum");
         }
-        premium_level = level;
+        premium_level = std::move(level);
         
         if (premium_level == "Silver") {
             discount_percentage = 5.0;}
@@ -9,16 +9,19 @@ namespace Banking {
         std::string premium_level; // "Silver", "Gold", "Platinum"
         double discount_percentage; //  
 
+        //     Client:      
+        static const Address& checkLevel(const std::string& level, const Address& address_value);
+
     public:
-        PremiumClient(int id_value, const std::string& name_value, const std::string& surname_value, const Address& address_value, const Date& date_value, const std::string& level = "Silver", double discount = 5.0);
+        PremiumClient(int id_value, std::string name_value, std::string surname_value, const Address& address_value, const Date& date_value, std::string level = "Silver", double discount = 5.0);
         virtual ~PremiumClient();
 
         //    
-        std::string getPremiumLevel() const { return premium_level; }
+        const std::string& getPremiumLevel() const { return premium_level; }
         double getDiscountPercentage() const { return discount_percentage; }
 
         //    
-        void setPremiumLevel(const std::string& level);
+        void setPremiumLevel(std::string level);
         void setDiscountPercentage(double discount);
 
         //   
@@ -2,11 +2,12 @@
 #include "Client.h"  //   
 #include <stdexcept>
 #include <iostream>
+#include <utility>
 
 namespace Banking {
 
-    SavingsAccount::SavingsAccount(const std::string& accountNumber, const int& client_id, double initialBalance, int months_value)
-        : Account(accountNumber, client_id, "Savings", initialBalance), months(months_value) {
+    SavingsAccount::SavingsAccount(std::string accountNumber, const int& client_id, double initialBalance, int months_value, std::string currency, std::shared_ptr<BalanceStore> store)
+        : Account(std::move(accountNumber), client_id, "Savings", initialBalance, std::move(currency), std::move(store)), months(months_value) {
         std::cout << "\n-----SavingsAccount constructor called. " << std::endl;
         if (initialBalance < 5000) {
             throw std::invalid_argument("Balance in SavingsAccount cannot be <5000");
@@ -32,9 +33,9 @@ namespace Banking {
 
     //        -    30     1000     1%
     bool SavingsAccount::withdraw(double amount) {
-        if (balance - amount < 5000) {
+        if (hot->balance - amount < 5000) {
             std::cout << "You can't leave less than 5000 in your account" << std::endl;
-            std::cout << "Maximum withdrawal amount: " << balance - 5000 << std::endl;
+            std::cout << "Maximum withdrawal amount: " << hot->balance - 5000 << std::endl;
             return false;
         }
         //     
@@ -55,7 +56,7 @@ namespace Banking {
     }
 
     bool SavingsAccount::canClose() const {
-        return balance >= 0; //     
+        return hot->balance >= 0; //     
     }
     
     //   
@@ -63,7 +64,7 @@ namespace Banking {
         double base_percentage = 5.0; // 5%  
 
         //   : +0.1%   10,000    5,000
-        double amount_bonus = ((balance - 5000) / 10000.0) * 0.1;
+        double amount_bonus = ((hot->balance - 5000) / 10000.0) * 0.1;
         if (amount_bonus > 5.0) amount_bonus = 5.0; //  +5%  
 
         //   
@@ -81,4 +82,14 @@ namespace Banking {
         return percentage;
     }
 
+    void SavingsAccount::saveState(AccountState& state) const {
+        Account::saveState(state);
+        state.fields[0] = percentage;
+    }
+
+    void SavingsAccount::restoreState(const AccountState& state) {
+        Account::restoreState(state);
+        percentage = state.fields[0];
+    }
+
 }
\ No newline at end of file
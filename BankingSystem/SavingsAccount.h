@@ -17,7 +17,8 @@ namespace Banking {
     
     public:
         
-        SavingsAccount(const std::string& accountNumber, const int& client_id, double initialBalance=5000, int months=1);
+        SavingsAccount(std::string accountNumber, const int& client_id, double initialBalance=5000, int months=1, std::string currency = DEFAULT_CURRENCY,
+            std::shared_ptr<BalanceStore> store = nullptr);
         virtual ~SavingsAccount() = default;
 
         //  
@@ -25,10 +26,13 @@ namespace Banking {
         bool withdraw(double amount) override;
         void displayinfo() const override;
         bool canClose() const override;
+        void saveState(AccountState& state) const override;
+        void restoreState(const AccountState& state) override;
 
         //   
         void setPercentage();
         double getPercentage() const;
+        int getMonths() const { return months; }
 
     };
 }
\ No newline at end of file
@@ -0,0 +1,362 @@
+﻿#include "ShardedBank.h"
+#include "Account.h"
+
+#include <stdexcept>
+
+namespace Banking {
+
+    ShardedBank::ShardedBank(size_t shard_count) {
+        if (shard_count == 0) {
+            throw std::invalid_argument("Shard count must be positive");
+        }
+        for (size_t i = 0; i < shard_count; ++i) {
+            shards.push_back(std::make_unique<Shard>());
+        }
+        for (size_t i = 0; i < shard_count; ++i) {
+            shards[i]->worker = std::thread(&ShardedBank::workerLoop, this, i);
+        }
+    }
+
+    ShardedBank::~ShardedBank() {
+        drain();
+        stopping.store(true, std::memory_order_release);
+        for (auto& shard : shards) {
+            shard->wakeups.notify();
+        }
+        for (auto& shard : shards) {
+            shard->worker.join();
+        }
+    }
+
+    size_t ShardedBank::shard_of(const std::string& accountNumber) const {
+        return std::hash<std::string>{}(accountNumber) % shards.size();
+    }
+
+    void ShardedBank::send(size_t shard_index, Message message) {
+        in_flight.fetch_add(1, std::memory_order_relaxed);
+        Shard& shard = *shards[shard_index];
+        shard.queue.push(std::move(message));
+        shard.wakeups.notify();
+    }
+
+    void ShardedBank::workerLoop(size_t shard_index) {
+        Shard& shard = *shards[shard_index];
+        Message message;
+        while (shard.queue.pop(message) || shard.wakeups.waitFor([&]() { return shard.queue.pop(message); }, stopping)) {
+            process(shard_index, message);
+            // счетчик уменьшаем после отправки ответных сообщений, чтобы drain не завершился раньше времени
+            if (in_flight.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                in_flight.notify_all();
+            }
+        }
+    }
+
+    void ShardedBank::process(size_t shard_index, Message& message) {
+        Shard& shard = *shards[shard_index];
+        try {
+            switch (message.kind) {
+            case Message::Kind::Admin:
+                message.admin(shard.bank);
+                return;
+            case Message::Kind::Deposit: {
+                auto account = shard.bank.find_acc_by_number(message.acc_to);
+                if (!account) {
+                    break;
+                }
+                shard.bank.registerDeposit(account, message.amount);
+                finish(shard, message, true);
+                return;
+            }
+            case Message::Kind::Withdraw: {
+                if (HotAccount* hot = findHot(message.acc_from)) {
+                    mergeStripes(shard, *hot);
+                }
+                auto account = shard.bank.find_acc_by_number(message.acc_from);
+                if (!account || !shard.bank.registerWithdraw(account, message.amount)) {
+                    break;
+                }
+                finish(shard, message, true);
+                return;
+            }
+            case Message::Kind::Transfer: {
+                if (HotAccount* hot = findHot(message.acc_from)) {
+                    mergeStripes(shard, *hot);
+                }
+                size_t target = shard_of(message.acc_to);
+                if (target == shard_index) {
+                    shard.bank.transfer(message.acc_from, message.acc_to, message.amount);
+                    finish(shard, message, true);
+                    return;
+                }
+                if (message.amount <= 0 || message.acc_from == message.acc_to) {
+                    break;
+                }
+                // фаза 1: списываем у себя и передаем зачисление шарду получателя
+                auto account = shard.bank.find_acc_by_number(message.acc_from);
+                if (!account || !shard.bank.registerTransferOut(account, message.acc_to, message.amount)) {
+                    break;
+                }
+                // горячий получатель: зачисление в полосу этого шарда, без сообщения его шарду
+                if (HotAccount* hot = findHot(message.acc_to)) {
+                    hot->stripes[shard_index].cents.fetch_add(Ledger::toCents(message.amount), std::memory_order_relaxed);
+                    finish(shard, message, true);
+                    return;
+                }
+                message.kind = Message::Kind::Credit;
+                send(target, std::move(message));
+                return;
+            }
+            case Message::Kind::Credit: {
+                // фаза 2: зачисляем или возвращаем деньги отправителю
+                auto account = shard.bank.find_acc_by_number(message.acc_to);
+                if (!account) {
+                    size_t source = shard_of(message.acc_from);
+                    message.kind = Message::Kind::Refund;
+                    send(source, std::move(message));
+                    return;
+                }
+                try {
+                    shard.bank.registerTransferIn(account, message.acc_from, message.amount);
+                }
+                catch (const std::exception&) {
+                    // деньги уже списаны у отправителя - возвращаем их
+                    size_t source = shard_of(message.acc_from);
+                    message.kind = Message::Kind::Refund;
+                    send(source, std::move(message));
+                    return;
+                }
+                finish(shard, message, true);
+                return;
+            }
+            case Message::Kind::Refund: {
+                auto account = shard.bank.find_acc_by_number(message.acc_from);
+                try {
+                    if (account) {
+                        shard.bank.registerTransferIn(account, message.acc_to, message.amount);
+                        break;
+                    }
+                }
+                catch (const std::exception&) {
+                }
+                park(shard, message.acc_from, message.acc_to, message.amount);
+                break;
+            }
+            }
+        }
+        catch (const std::exception&) {
+            // ошибка операции считается отказом, поток шарда продолжает работу
+        }
+        finish(shard, message, false);
+    }
+
+    ShardedBank::HotAccount* ShardedBank::findHot(const std::string& accountNumber) const {
+        if (hot_accounts.empty()) {
+            return nullptr;
+        }
+        auto it = hot_accounts.find(accountNumber);
+        return it == hot_accounts.end() ? nullptr : it->second.get();
+    }
+
+    // getBalance не должен увидеть сумму полос ни дважды, ни ни разу: счет пополняется раньше, чем полосы
+    // уменьшаются на снятые суммы (зачисления, пришедшие во время слияния, остаются в полосах),
+    // а читатель повторяет чтение, если за это время счетчик слияний изменился
+    void ShardedBank::mergeStripes(Shard& shard, HotAccount& hot) {
+        int64_t cents = 0;
+        for (size_t i = 0; i < hot.stripes.size(); ++i) {
+            hot.merging[i] = hot.stripes[i].cents.load(std::memory_order_acquire);
+            cents += hot.merging[i];
+        }
+        if (cents == 0) {
+            return;
+        }
+        auto account = shard.bank.find_acc_by_number(hot.accountNumber);
+        bool credited = false;
+        hot.merge_sequence.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        if (account) {
+            try {
+                shard.bank.registerTransferIn(account, HOT_STRIPES, Ledger::fromCents(cents));
+                credited = true;
+            }
+            catch (const std::exception&) {
+            }
+        }
+        for (size_t i = 0; i < hot.stripes.size(); ++i) {
+            hot.stripes[i].cents.fetch_sub(hot.merging[i], std::memory_order_relaxed);
+        }
+        hot.merge_sequence.fetch_add(1, std::memory_order_release);
+        hot.merge_sequence.notify_all();
+        if (!credited) {
+            // счет удален (или зачисление отказало), а отправители полос неизвестны - вернуть некому
+            park(shard, HOT_STRIPES, hot.accountNumber, Ledger::fromCents(cents));
+        }
+    }
+
+    void ShardedBank::setHotAccount(const std::string& accountNumber) {
+        drain();
+        size_t home = shard_of(accountNumber);
+        if (!shards[home]->bank.find_acc_by_number(accountNumber)) {
+            throw std::invalid_argument("Account not found: " + accountNumber);
+        }
+        if (findHot(accountNumber)) {
+            return;
+        }
+        auto hot = std::make_unique<HotAccount>();
+        hot->accountNumber = accountNumber;
+        hot->home_shard = home;
+        hot->stripes = std::vector<Stripe>(shards.size());
+        hot->merging.resize(shards.size());
+        hot_accounts.emplace(accountNumber, std::move(hot));
+    }
+
+    void ShardedBank::mergeHotAccounts() {
+        for (auto& item : hot_accounts) {
+            HotAccount* hot = item.second.get();
+            Shard* home = shards[hot->home_shard].get();
+            Message message;
+            message.admin = [this, hot, home](Bank&) {
+                mergeStripes(*home, *hot);
+            };
+            send(hot->home_shard, std::move(message));
+        }
+        drain();
+    }
+
+    void ShardedBank::finish(Shard& shard, const Message& message, bool ok) {
+        (ok ? shard.completed : shard.failed).fetch_add(1, std::memory_order_relaxed);
+        if (message.done.callback) {
+            message.done.callback(message.done.context, ok);
+        }
+    }
+
+    // сумма остается на @TRANSIT книги шарда (туда ее положило списание) до ручной сверки
+    void ShardedBank::park(Shard& shard, const std::string& acc_from, const std::string& acc_to, double amount) {
+        shard.suspense.push_back(SuspenseEntry{ acc_from, acc_to, amount });
+    }
+
+    void ShardedBank::createClient(int id_value, const std::string& name_value, const std::string& surname_value, const Address& address_value, const Date& date_value) {
+        for (size_t i = 0; i < shards.size(); ++i) {
+            Message message;
+            message.admin = [=](Bank& bank) {
+                bank.createClient(id_value, name_value, surname_value, address_value, date_value);
+            };
+            send(i, std::move(message));
+        }
+    }
+
+    void ShardedBank::createCheckAccount(const std::string& accountNumber, int client_id, double initialBalance) {
+        Message message;
+        message.admin = [=](Bank& bank) {
+            bank.createCheckAccount(accountNumber, client_id, initialBalance);
+        };
+        send(shard_of(accountNumber), std::move(message));
+    }
+
+    void ShardedBank::createSavAccount(const std::string& accountNumber, int client_id, double initialBalance, int months) {
+        Message message;
+        message.admin = [=](Bank& bank) {
+            bank.createSavAccount(accountNumber, client_id, initialBalance, months);
+        };
+        send(shard_of(accountNumber), std::move(message));
+    }
+
+    void ShardedBank::deleteAccount(const std::string& accountNumber) {
+        Message message;
+        HotAccount* hot = findHot(accountNumber);
+        Shard* home = shards[shard_of(accountNumber)].get();
+        message.admin = [=, this](Bank& bank) {
+            if (hot) {
+                mergeStripes(*home, *hot); // остаток счета вместе с полосами: непустой счет не удаляется
+            }
+            bank.deleteAccount(accountNumber);
+        };
+        send(shard_of(accountNumber), std::move(message));
+    }
+
+    void ShardedBank::deposit(const std::string& accountNumber, double amount, Completion done) {
+        Message message;
+        message.done = done;
+        message.kind = Message::Kind::Deposit;
+        message.acc_to = accountNumber;
+        message.amount = amount;
+        send(shard_of(accountNumber), std::move(message));
+    }
+
+    void ShardedBank::withdraw(const std::string& accountNumber, double amount, Completion done) {
+        Message message;
+        message.done = done;
+        message.kind = Message::Kind::Withdraw;
+        message.acc_from = accountNumber;
+        message.amount = amount;
+        send(shard_of(accountNumber), std::move(message));
+    }
+
+    void ShardedBank::transfer(const std::string& accountNumber_from, const std::string& accountNumber_to, double amount, Completion done) {
+        Message message;
+        message.done = done;
+        message.kind = Message::Kind::Transfer;
+        message.acc_from = accountNumber_from;
+        message.acc_to = accountNumber_to;
+        message.amount = amount;
+        send(shard_of(accountNumber_from), std::move(message));
+    }
+
+    void ShardedBank::drain() {
+        for (size_t left = in_flight.load(std::memory_order_acquire); left != 0; left = in_flight.load(std::memory_order_acquire)) {
+            in_flight.wait(left, std::memory_order_acquire);
+        }
+    }
+
+    double ShardedBank::getBalance(const std::string& accountNumber) {
+        auto account = shards[shard_of(accountNumber)]->bank.find_acc_by_number(accountNumber);
+        if (!account) {
+            throw std::invalid_argument("Account not found: " + accountNumber);
+        }
+        HotAccount* hot = findHot(accountNumber);
+        if (!hot) {
+            return account->getBalance();
+        }
+        // счет и полосы - между одинаковыми четными значениями счетчика слияний
+        while (true) {
+            uint64_t sequence = hot->merge_sequence.load(std::memory_order_acquire);
+            if (sequence % 2 != 0) {
+                hot->merge_sequence.wait(sequence, std::memory_order_acquire);
+                continue;
+            }
+            double balance = account->getBalance();
+            int64_t cents = 0;
+            for (const auto& stripe : hot->stripes) {
+                cents += stripe.cents.load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (hot->merge_sequence.load(std::memory_order_relaxed) == sequence) {
+                return balance + Ledger::fromCents(cents);
+            }
+        }
+    }
+
+    size_t ShardedBank::getCompletedCount() const {
+        size_t total = 0;
+        for (const auto& shard : shards) {
+            total += shard->completed.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    size_t ShardedBank::getFailedCount() const {
+        size_t total = 0;
+        for (const auto& shard : shards) {
+            total += shard->failed.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    std::vector<ShardedBank::SuspenseEntry> ShardedBank::getSuspense() const {
+        std::vector<SuspenseEntry> entries;
+        for (const auto& shard : shards) {
+            entries.insert(entries.end(), shard->suspense.begin(), shard->suspense.end());
+        }
+        return entries;
+    }
+
+}
@@ -0,0 +1,140 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+#include "Bank.h"
+#include "MpscQueue.h"
+#include "Wakeup.h"
+
+namespace Banking {
+
+    // Банк, разбитый на независимые шарды: счета распределяются по хешу номера,
+    // каждый шард (свой Bank) обслуживается ровно одним потоком. Операции Bank по-прежнему берут его write_mutex,
+    // но конкуренции за него почти нет: кроме потока шарда его берут только чтения (getBalance) из вызывающего потока,
+    // а потоки разных шардов общих блокировок не делят.
+    // Перевод между шардами идет в две фазы сообщениями через неблокирующие очереди:
+    //   1) шард отправителя списывает деньги и шлет CREDIT шарду получателя
+    //   2) шард получателя зачисляет (перевод завершен) или, если счета нет или зачисление не удалось, шлет REFUND обратно
+    //   3) если и вернуть нельзя (счет отправителя удален), сумма остается на @TRANSIT шарда отправителя
+    //      и записывается в список на ручную сверку (getSuspense) - деньги не пропадают молча
+    // Все методы асинхронные - результат виден после drain() или в уведомлении о завершении операции.
+    //
+    // Горячие счета (setHotAccount): на счет, куда идет большая доля переводов, межшардовые зачисления
+    // не пересылаются его шарду, а копятся в полосах (по одной на шард отправителя) - поток шарда счета
+    // перестает быть узким местом. Полосы сливаются в счет лениво: перед каждым списанием с него
+    // (списание проверяет полный остаток), перед удалением счета и в mergeHotAccounts(). getBalance складывает
+    // счет и полосы. До слияния зачисления из полос не видны в истории счета - при слиянии записывается одно
+    // зачисление от HOT_STRIPES на сумму полос; если счета уже нет, сумма уходит на сверку (getSuspense).
+    class ShardedBank {
+    public:
+        // уведомление о завершении операции (ok = false - отказ); вызывается в потоке шарда,
+        // где операция закончилась: для межшардового перевода - у получателя или после возврата денег
+        struct Completion {
+            void (*callback)(void* context, bool ok);
+            void* context;
+        };
+
+    private:
+        struct Message {
+            enum class Kind { Admin, Deposit, Withdraw, Transfer, Credit, Refund };
+            Kind kind = Kind::Admin;
+            std::string acc_from;
+            std::string acc_to;
+            double amount = 0;
+            std::function<void(Bank&)> admin; // редкие операции (создание клиентов и счетов)
+            Completion done{}; // без уведомления
+        };
+
+    public:
+        // перевод, который не удалось ни зачислить, ни вернуть (acc_from = HOT_STRIPES - полосы удаленного
+        // горячего счета: сумма лежит на @TRANSIT шардов отправителей)
+        struct SuspenseEntry {
+            std::string acc_from;
+            std::string acc_to;
+            double amount;
+        };
+
+    private:
+
+        // полоса в отдельной кэш-линии: пишет поток одного шарда, обнуляет при слиянии поток шарда счета
+        struct alignas(64) Stripe {
+            std::atomic<int64_t> cents{ 0 };
+        };
+
+        struct HotAccount {
+            std::string accountNumber;
+            size_t home_shard;
+            std::vector<Stripe> stripes; // по шарду отправителя
+            std::vector<int64_t> merging; // суммы полос, снятые текущим слиянием (только поток шарда счета)
+            // нечетное - идет слияние: счет уже пополнен, а полосы еще не уменьшены
+            std::atomic<uint64_t> merge_sequence{ 0 };
+        };
+
+        struct Shard {
+            Bank bank;
+            MpscQueue<Message> queue;
+            WakeupCounter wakeups;
+            std::thread worker;
+            std::atomic<size_t> completed{ 0 };
+            std::atomic<size_t> failed{ 0 };
+            std::vector<SuspenseEntry> suspense; // пишет только поток шарда
+        };
+
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::atomic<size_t> in_flight{ 0 }; // сообщения в очередях + в обработке (drain ждет нуля)
+        std::atomic<bool> stopping{ false };
+        // меняется только без операций в полете (после drain), потоки шардов только читают
+        std::unordered_map<std::string, std::unique_ptr<HotAccount>> hot_accounts;
+
+        void send(size_t shard_index, Message message);
+        void workerLoop(size_t shard_index);
+        void process(size_t shard_index, Message& message);
+        void finish(Shard& shard, const Message& message, bool ok);
+        void park(Shard& shard, const std::string& acc_from, const std::string& acc_to, double amount);
+        HotAccount* findHot(const std::string& accountNumber) const;
+        void mergeStripes(Shard& shard, HotAccount& hot); // только в потоке шарда счета
+
+    public:
+        explicit ShardedBank(size_t shard_count);
+        ~ShardedBank();
+
+        ShardedBank(const ShardedBank&) = delete;
+        ShardedBank& operator=(const ShardedBank&) = delete;
+
+        size_t getShardCount() const { return shards.size(); }
+        size_t shard_of(const std::string& accountNumber) const;
+
+        // клиенты копируются во все шарды, т.к. счета клиента могут попасть в любой из них
+        void createClient(int id_value, const std::string& name_value, const std::string& surname_value, const Address& address_value, const Date& date_value);
+        void createCheckAccount(const std::string& accountNumber, int client_id, double initialBalance = 0);
+        void createSavAccount(const std::string& accountNumber, int client_id, double initialBalance = 5000, int months = 1);
+        void deleteAccount(const std::string& accountNumber);
+
+        void deposit(const std::string& accountNumber, double amount, Completion done = {});
+        void withdraw(const std::string& accountNumber, double amount, Completion done = {});
+        void transfer(const std::string& accountNumber_from, const std::string& accountNumber_to, double amount, Completion done = {});
+
+        // дождаться обработки всех отправленных операций
+        void drain();
+
+        // горячие счета: назначение ждет drain(); std::invalid_argument, если счета нет
+        static constexpr const char* HOT_STRIPES = "HOT_STRIPES";
+        void setHotAccount(const std::string& accountNumber);
+        bool isHotAccount(const std::string& accountNumber) const { return findHot(accountNumber) != nullptr; }
+        void mergeHotAccounts(); // слить полосы всех горячих счетов и дождаться завершения
+
+        // читать можно только после drain(), пока новые операции не отправляются; горячий счет читается
+        // вместе с полосами согласованно со слиянием (сумма не видна ни дважды, ни ни разу)
+        double getBalance(const std::string& accountNumber);
+        size_t getCompletedCount() const;
+        size_t getFailedCount() const;
+        // суммы на сверке по всем шардам (читать после drain())
+        std::vector<SuspenseEntry> getSuspense() const;
+    };
+
+}
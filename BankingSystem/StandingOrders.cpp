@@ -0,0 +1,218 @@
+﻿#include "StandingOrders.h"
+#include "Bank.h"
+#include "SavingsAccount.h"
+
+#include <stdexcept>
+
+namespace Banking {
+
+    StandingOrders::StandingOrders() {
+        for (auto& head : heads) {
+            head = NIL;
+        }
+    }
+
+    uint32_t StandingOrders::dayNumber(const Date& date) {
+        // перевод гражданской даты в номер дня (алгоритм days_from_civil)
+        int year = date.getYear() - (date.getMonth() <= 2 ? 1 : 0);
+        int era = year / 400;
+        int year_of_era = year - era * 400;
+        int month = date.getMonth();
+        int day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + date.getDay() - 1;
+        int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+        return static_cast<uint32_t>(era * 146097 + day_of_era - 719468);
+    }
+
+    uint32_t StandingOrders::accountId(const std::string& accountNumber) {
+        auto it = account_index.find(accountNumber);
+        if (it != account_index.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(account_names.size());
+        account_names.push_back(accountNumber);
+        account_index.emplace(accountNumber, id);
+        return id;
+    }
+
+    // уровень выбирается по старшему байту, в котором день исполнения отличается от текущего дня
+    void StandingOrders::link(uint32_t index) {
+        Order& order = orders[index];
+        uint32_t level = 0;
+        while (level + 1 < LEVELS && (order.due >> (8 * (level + 1))) != (current_day >> (8 * (level + 1)))) {
+            ++level;
+        }
+        uint32_t slot = level * SLOTS + ((order.due >> (8 * level)) & (SLOTS - 1));
+        order.slot = static_cast<uint16_t>(slot);
+        order.prev = NIL;
+        order.next = heads[slot];
+        if (order.next != NIL) {
+            orders[order.next].prev = index;
+        }
+        heads[slot] = index;
+    }
+
+    void StandingOrders::unlink(uint32_t index) {
+        Order& order = orders[index];
+        if (order.prev != NIL) {
+            orders[order.prev].next = order.next;
+        }
+        else {
+            heads[order.slot] = order.next;
+        }
+        if (order.next != NIL) {
+            orders[order.next].prev = order.prev;
+        }
+        order.slot = FREE;
+    }
+
+    StandingOrders::OrderId StandingOrders::schedule(const std::string& accountNumber_from, const std::string& accountNumber_to, double amount,
+        uint32_t first_day, uint32_t interval_days, uint32_t count) {
+        if (amount <= 0) {
+            throw std::invalid_argument("Standing order amount must be positive");
+        }
+        if (count == 0 || count > UINT16_MAX || interval_days == 0 || interval_days > UINT16_MAX) {
+            throw std::invalid_argument("Invalid standing order period");
+        }
+        uint32_t from = accountId(accountNumber_from);
+        uint32_t to = accountId(accountNumber_to);
+
+        uint32_t index;
+        if (free_list != NIL) {
+            index = free_list;
+            free_list = orders[index].next;
+        }
+        else {
+            index = static_cast<uint32_t>(orders.size());
+            orders.push_back(Order());
+            orders[index].generation = 0;
+        }
+        Order& order = orders[index];
+        order.from = from;
+        order.to = to;
+        order.amount = amount;
+        order.due = first_day < current_day ? current_day : first_day;
+        order.interval = static_cast<uint16_t>(interval_days);
+        order.remaining = static_cast<uint16_t>(count);
+        link(index);
+        ++active;
+        return (static_cast<OrderId>(order.generation) << 32) | index;
+    }
+
+    StandingOrders::OrderId StandingOrders::scheduleSavingsTopUp(Bank& bank, const std::string& accountNumber_from, const std::string& savingsAccountNumber,
+        double amount, uint32_t first_day) {
+        auto savings = std::dynamic_pointer_cast<SavingsAccount>(bank.find_acc_by_number(savingsAccountNumber));
+        if (!savings) {
+            throw std::invalid_argument("Savings account not found: " + savingsAccountNumber);
+        }
+        return schedule(accountNumber_from, savingsAccountNumber, amount, first_day, DAYS_IN_MONTH, static_cast<uint32_t>(savings->getMonths()));
+    }
+
+    bool StandingOrders::cancel(OrderId id) {
+        uint32_t index = static_cast<uint32_t>(id);
+        if (index >= orders.size()) {
+            return false;
+        }
+        Order& order = orders[index];
+        if (order.slot == FREE || order.generation != static_cast<uint16_t>(id >> 32)) {
+            return false;
+        }
+        unlink(index);
+        ++order.generation;
+        order.next = free_list;
+        free_list = index;
+        --active;
+        return true;
+    }
+
+    // поручения ячейки верхнего уровня переносятся на уровень ниже, когда до них доходит очередь
+    void StandingOrders::cascade(uint32_t level) {
+        uint32_t slot = level * SLOTS + ((current_day >> (8 * level)) & (SLOTS - 1));
+        uint32_t index = heads[slot];
+        heads[slot] = NIL;
+        while (index != NIL) {
+            uint32_t next = orders[index].next;
+            link(index);
+            index = next;
+        }
+    }
+
+    void StandingOrders::fireDay(Bank& bank) {
+        uint32_t slot = current_day & (SLOTS - 1);
+        uint32_t index = heads[slot];
+        heads[slot] = NIL;
+        if (index == NIL) {
+            return;
+        }
+
+        due_orders.clear();
+        batch.clear();
+        while (index != NIL) {
+            const Order& order = orders[index];
+            due_orders.push_back(index);
+            batch.emplace_back(account_names[order.from], account_names[order.to], order.amount);
+            index = order.next;
+        }
+
+        batch_failed.clear();
+        fired += bank.transfer_batch(batch, batch_failed);
+        failed += batch_failed.size();
+
+        // повторяющиеся поручения встают на следующий срок, исполненные полностью освобождаются
+        for (uint32_t order_index : due_orders) {
+            Order& order = orders[order_index];
+            if (--order.remaining > 0) {
+                order.due += order.interval;
+                link(order_index);
+            }
+            else {
+                order.slot = FREE;
+                ++order.generation;
+                order.next = free_list;
+                free_list = order_index;
+                --active;
+            }
+        }
+    }
+
+    // ближайший день после current_day, с которого начинается непустая ячейка какого-либо уровня.
+    // Ячейки уровня L правее текущей относятся к следующим блокам по 256^L дней, ячейки нижних уровней - раньше них
+    uint64_t StandingOrders::nextBusyDay() const {
+        for (uint32_t level = 0; level < LEVELS; ++level) {
+            uint32_t shift = 8 * level;
+            uint32_t position = (current_day >> shift) & (SLOTS - 1);
+            for (uint32_t slot = position + 1; slot < SLOTS; ++slot) {
+                if (heads[level * SLOTS + slot] != NIL) {
+                    uint64_t block = (static_cast<uint64_t>(current_day) >> (shift + 8)) << (shift + 8);
+                    return block | (static_cast<uint64_t>(slot) << shift);
+                }
+            }
+        }
+        return UINT64_MAX;
+    }
+
+    void StandingOrders::advanceTo(uint32_t day, Bank& bank) {
+        while (current_day <= day) {
+            // на границе оборота сначала разбираем верхние уровни: они могут пополнить ячейки нижних
+            uint32_t top = 0;
+            while (top + 1 < LEVELS && (current_day & ((1u << (8 * (top + 1))) - 1)) == 0) {
+                ++top;
+            }
+            for (uint32_t level = top; level >= 1; --level) {
+                cascade(level);
+            }
+            fireDay(bank);
+            // пропускаем пустые дни: сразу к ближайшей непустой ячейке (границы с пустыми ячейками каскада не требуют)
+            uint64_t next = nextBusyDay();
+            if (next > day) {
+                if (day == UINT32_MAX) {
+                    break;
+                }
+                current_day = day + 1;
+            }
+            else {
+                current_day = static_cast<uint32_t>(next);
+            }
+        }
+    }
+
+}
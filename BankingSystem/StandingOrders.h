@@ -0,0 +1,93 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "Structs.h"
+
+namespace Banking {
+    class Bank;
+}
+
+namespace Banking {
+
+    // Постоянные поручения (регулярные переводы) на иерархическом таймерном колесе.
+    // Время - номер дня (dayNumber), одно деление колеса - один день.
+    // 4 уровня по 256 ячеек покрывают весь диапазон uint32; в ячейке - двусвязный список поручений
+    // на индексах, поэтому добавление и отмена - O(1). Класс не потокобезопасен: им управляет один поток.
+    class StandingOrders {
+    public:
+        typedef uint64_t OrderId; // индекс поручения + поколение (старый id после отмены не срабатывает)
+
+        static const uint32_t DAYS_IN_MONTH = 30; // "ежемесячно" = каждые 30 дней
+
+    private:
+        static const uint32_t LEVELS = 4;
+        static const uint32_t SLOTS = 256;
+        static const uint32_t NIL = UINT32_MAX;
+        static const uint16_t FREE = UINT16_MAX; // поручение не стоит ни в одной ячейке
+
+        // компактная запись: 40 байт на поручение (36 байт полей + выравнивание double)
+        struct Order {
+            uint32_t from;       // индексы в таблице номеров счетов
+            uint32_t to;
+            double amount;
+            uint32_t due;        // день следующего исполнения
+            uint32_t next;       // соседи по списку ячейки
+            uint32_t prev;
+            uint16_t slot;       // уровень * SLOTS + ячейка, FREE - свободная запись
+            uint16_t generation;
+            uint16_t interval;   // период в днях
+            uint16_t remaining;  // сколько исполнений осталось
+        };
+        static_assert(sizeof(Order) == 40, "Order layout changed: update the size comment");
+
+        std::vector<Order> orders;
+        uint32_t free_list = NIL;        // свободные записи связаны через next
+        uint32_t heads[LEVELS * SLOTS];
+        uint32_t current_day = 0;        // ближайший еще не обработанный день
+        size_t active = 0;
+
+        std::vector<std::string> account_names;
+        std::unordered_map<std::string, uint32_t> account_index;
+
+        size_t fired = 0;
+        size_t failed = 0;
+
+        // рабочие буферы исполнения одного дня
+        std::vector<uint32_t> due_orders;
+        std::vector<TransferOrder> batch;
+        std::vector<size_t> batch_failed;
+
+        uint32_t accountId(const std::string& accountNumber);
+        void link(uint32_t index);
+        void unlink(uint32_t index);
+        void cascade(uint32_t level);
+        void fireDay(Bank& bank);
+        uint64_t nextBusyDay() const;
+
+    public:
+        StandingOrders();
+
+        // номер дня для календарной даты (дни с 01.01.1970)
+        static uint32_t dayNumber(const Date& date);
+
+        // перевод amount каждые interval_days дней начиная с first_day, всего count раз
+        OrderId schedule(const std::string& accountNumber_from, const std::string& accountNumber_to, double amount,
+            uint32_t first_day, uint32_t interval_days, uint32_t count);
+        // ежемесячное пополнение сберегательного счета на весь его срок (SavingsAccount::getMonths)
+        OrderId scheduleSavingsTopUp(Bank& bank, const std::string& accountNumber_from, const std::string& savingsAccountNumber,
+            double amount, uint32_t first_day);
+        bool cancel(OrderId id);
+
+        // исполнить все поручения со сроком до day включительно (переводы одного дня - одним пакетом через transfer_batch);
+        // пустые дни пропускаются, поэтому первый вызов с реальной датой не перебирает дни с 1970 года
+        void advanceTo(uint32_t day, Bank& bank);
+
+        uint32_t getCurrentDay() const { return current_day; }
+        size_t getActiveCount() const { return active; }
+        size_t getFiredCount() const { return fired; }
+        size_t getFailedCount() const { return failed; }
+    };
+
+}
@@ -0,0 +1,254 @@
+﻿#include "Statement.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace Banking {
+
+    namespace {
+        const char* postingTypeName(Ledger::PostingType type) {
+            switch (type) {
+            case Ledger::OPEN: return "OPEN";
+            case Ledger::DEPOSIT: return "DEPOSIT";
+            case Ledger::WITHDRAW: return "WITHDRAW";
+            case Ledger::TRANSFER: return "TRANSFER";
+            case Ledger::TRANSFER_OUT: return "TRANSFER_OUT";
+            case Ledger::TRANSFER_IN: return "TRANSFER_IN";
+            }
+            return "UNKNOWN";
+        }
+
+        bool isSystemAccount(const std::string& name) {
+            return !name.empty() && name.front() == '@';
+        }
+    }
+
+    StatementSink::StatementSink(std::ostream& out_value, size_t capacity)
+        : out(out_value), buffer(std::max<size_t>(capacity, 256)) {
+    }
+
+    StatementSink::~StatementSink() {
+        flush();
+    }
+
+    void StatementSink::write(std::string_view text) {
+        while (!text.empty()) {
+            if (used == buffer.size()) {
+                flush();
+            }
+            size_t part = std::min(text.size(), buffer.size() - used);
+            std::memcpy(buffer.data() + used, text.data(), part);
+            used += part;
+            text.remove_prefix(part);
+        }
+    }
+
+    void StatementSink::writeMoney(int64_t cents) {
+        char text[32];
+        char* end = text;
+        uint64_t value = cents < 0 ? 0 - static_cast<uint64_t>(cents) : static_cast<uint64_t>(cents);
+        if (cents < 0) {
+            *end++ = '-';
+        }
+        end = std::to_chars(end, text + sizeof(text), value / 100).ptr;
+        *end++ = '.';
+        *end++ = static_cast<char>('0' + value % 100 / 10);
+        *end++ = static_cast<char>('0' + value % 10);
+        write(std::string_view(text, static_cast<size_t>(end - text)));
+    }
+
+    void StatementSink::writeTime(std::time_t time) {
+        std::tm local_time;
+        localtime_s(&local_time, &time);
+        char text[32];
+        write(std::string_view(text, std::strftime(text, sizeof(text), "%d.%m.%Y %H:%M:%S", &local_time)));
+    }
+
+    void StatementSink::flush() {
+        if (used > 0) {
+            out.write(buffer.data(), static_cast<std::streamsize>(used));
+            written += used;
+            used = 0;
+        }
+    }
+
+    // второй участник перевода: нога основной суммы другого счета с противоположным знаком
+    std::string StatementEngine::counterpartOf(size_t posting, uint32_t account, int64_t amount) const {
+        size_t first = ledger.getFirstLeg(posting);
+        size_t count = ledger.getLegCount(posting, bound);
+        for (size_t i = first; i < first + count; ++i) {
+            Ledger::Leg leg = ledger.getLeg(i);
+            if (leg.account != account && leg.kind == Ledger::PRINCIPAL && (leg.amount < 0) != (amount < 0)
+                && !isSystemAccount(ledger.getAccountName(leg.account))) {
+                return ledger.getAccountName(leg.account);
+            }
+        }
+        return std::string();
+    }
+
+    StatementSummary StatementEngine::write(uint32_t account, std::time_t from, std::time_t to, StatementSink& sink) const {
+        StatementSummary summary;
+        uint32_t entry = firstEntry(account);
+
+        // входящий остаток: все, что было до начала периода
+        size_t posting = 0;
+        while (entry != Ledger::NO_ENTRY) {
+            posting = ledger.getPostingOfEntry(entry);
+            if (ledger.getPostingTime(posting) >= from) {
+                break;
+            }
+            summary.opening += ledger.getLeg(entry).amount;
+            entry = nextEntry(entry);
+        }
+
+        sink.write("STATEMENT ");
+        sink.write(ledger.getAccountName(account));
+        sink.write("\nPeriod: ");
+        sink.writeTime(from);
+        sink.write(" - ");
+        sink.writeTime(to);
+        sink.write("\nOpening balance: ");
+        sink.writeMoney(summary.opening);
+        sink.write("\n");
+
+        int64_t balance = summary.opening;
+        while (entry != Ledger::NO_ENTRY) {
+            posting = ledger.getPostingOfEntry(entry);
+            std::time_t time = ledger.getPostingTime(posting);
+            if (time >= to) {
+                break;
+            }
+            Ledger::Leg leg = ledger.getLeg(entry);
+            balance += leg.amount;
+            if (leg.amount >= 0) {
+                summary.credits += leg.amount;
+            }
+            else {
+                summary.debits -= leg.amount;
+            }
+            ++summary.lines;
+
+            sink.writeTime(time);
+            sink.write("  ");
+            if (leg.kind == Ledger::COMMISSION) {
+                sink.write("COMMISSION");
+            }
+            else if (leg.kind == Ledger::DISCOUNT) {
+                sink.write("DISCOUNT");
+            }
+            else {
+                Ledger::PostingType type = ledger.getPostingType(posting);
+                sink.write(postingTypeName(type));
+                if (type == Ledger::TRANSFER) {
+                    std::string counterpart = counterpartOf(posting, account, leg.amount);
+                    if (!counterpart.empty()) {
+                        sink.write(leg.amount < 0 ? " to " : " from ");
+                        sink.write(counterpart);
+                    }
+                }
+            }
+            sink.write("  ");
+            if (leg.amount >= 0) {
+                sink.write("+");
+            }
+            sink.writeMoney(leg.amount);
+            sink.write("  ");
+            sink.writeMoney(balance);
+            sink.write("\n");
+            entry = nextEntry(entry);
+        }
+        summary.closing = balance;
+
+        sink.write("Closing balance: ");
+        sink.writeMoney(summary.closing);
+        sink.write("\nCredits: ");
+        sink.writeMoney(summary.credits);
+        sink.write(", debits: ");
+        sink.writeMoney(summary.debits);
+        sink.write(", operations: ");
+        sink.write(std::to_string(summary.lines));
+        sink.write("\n-----\n");
+        return summary;
+    }
+
+    size_t StatementEngine::writeAll(std::time_t from, std::time_t to, const std::string& path_prefix, unsigned threads) const {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        const uint32_t account_count = static_cast<uint32_t>(bound.accounts);
+        std::atomic<uint32_t> next_account{ 0 };
+        std::atomic<size_t> statements{ 0 };
+        std::mutex failures_mutex;
+        std::string failures; // ошибки файлов всех потоков - бросаются после завершения пула
+
+        // каждый поток берет счета блоками из общего счетчика (балансировка без очереди задач)
+        auto worker = [&](unsigned number) {
+            const std::string path = path_prefix + "_" + std::to_string(number) + ".txt";
+            try {
+                std::ofstream file(path, std::ios::binary);
+                if (!file) {
+                    throw std::runtime_error("cannot open " + path); // счета этого потока заберут остальные
+                }
+                StatementSink sink(file);
+                const uint32_t block = 256;
+                size_t written = 0;
+                for (uint32_t begin = next_account.fetch_add(block); begin < account_count; begin = next_account.fetch_add(block)) {
+                    uint32_t end = std::min(account_count, begin + block);
+                    for (uint32_t account = begin; account < end; ++account) {
+                        uint32_t entry = firstEntry(account);
+                        if (entry == Ledger::NO_ENTRY || isSystemAccount(ledger.getAccountName(account))
+                            || ledger.getPostingTime(ledger.getPostingOfEntry(entry)) >= to) {
+                            continue;
+                        }
+                        write(account, from, to, sink);
+                        ++written;
+                    }
+                }
+                sink.flush();
+                file.flush();
+                if (!file.good()) {
+                    throw std::runtime_error("cannot write " + path);
+                }
+                statements += written;
+            }
+            catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(failures_mutex);
+                failures += failures.empty() ? "" : "; ";
+                failures += e.what();
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (unsigned i = 1; i < threads; ++i) {
+            pool.emplace_back(worker, i);
+        }
+        worker(0);
+        for (auto& thread : pool) {
+            thread.join();
+        }
+        if (!failures.empty()) {
+            throw std::runtime_error("Statements were not written: " + failures);
+        }
+        return statements.load();
+    }
+
+    std::time_t StatementEngine::monthStart(int year, int month) {
+        std::tm start = {};
+        start.tm_year = year - 1900;
+        start.tm_mon = month - 1; // 13-й месяц mktime переносит на январь следующего года
+        start.tm_mday = 1;
+        start.tm_isdst = -1;
+        std::time_t result = std::mktime(&start);
+        if (result == static_cast<std::time_t>(-1)) {
+            throw std::invalid_argument("Invalid statement period");
+        }
+        return result;
+    }
+
+}
@@ -0,0 +1,75 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ostream>
+#include <ctime>
+#include <cstdint>
+#include "Ledger.h"
+
+namespace Banking {
+
+    // Буферизованный приемник текста выписки: строки копятся в буфере фиксированного размера
+    // и уходят в поток целыми блоками (память не растет с длиной выписки)
+    class StatementSink {
+    private:
+        std::ostream& out;
+        std::vector<char> buffer;
+        size_t used = 0;
+        size_t written = 0;
+
+    public:
+        explicit StatementSink(std::ostream& out_value, size_t capacity = 64 * 1024);
+        ~StatementSink();
+
+        StatementSink(const StatementSink&) = delete;
+        StatementSink& operator=(const StatementSink&) = delete;
+
+        void write(std::string_view text);
+        void writeMoney(int64_t cents); // 1234 -> "12.34"
+        void writeTime(std::time_t time);
+        void flush();
+
+        size_t getBytesWritten() const { return written + used; }
+    };
+
+    // итоги одной выписки (копейки)
+    struct StatementSummary {
+        int64_t opening = 0;
+        int64_t closing = 0;
+        int64_t credits = 0;
+        int64_t debits = 0;
+        size_t lines = 0;
+    };
+
+    // Выписка по счету за период [from, to): строится по ногам счета в книге (точные суммы,
+    // включая комиссии и скидки), входящий остаток и текущий остаток считаются по ходу обхода
+    class StatementEngine {
+    private:
+        const Ledger& ledger;
+        Ledger::Snapshot bound; // читаются только проводки и ноги внутри снимка
+
+        std::string counterpartOf(size_t posting, uint32_t account, int64_t amount) const;
+        uint32_t visible(uint32_t entry) const { return entry < bound.entries ? entry : Ledger::NO_ENTRY; }
+        uint32_t firstEntry(uint32_t account) const { return visible(ledger.firstEntryOf(account)); }
+        uint32_t nextEntry(uint32_t entry) const { return visible(ledger.nextEntryOf(entry)); }
+
+    public:
+        // книга на текущий момент (вызывать под блокировкой банка)
+        explicit StatementEngine(const Ledger& ledger_value) : ledger(ledger_value), bound(ledger_value.snapshot()) {}
+        // снимок, взятый раньше под блокировкой: дальше выписки строятся без нее, пока банк дописывает книгу
+        StatementEngine(const Ledger& ledger_value, const Ledger::Snapshot& bound_value) : ledger(ledger_value), bound(bound_value) {}
+
+        StatementSummary write(uint32_t account, std::time_t from, std::time_t to, StatementSink& sink) const;
+
+        // выписки всех счетов клиентов (кроме служебных @...) с операциями до конца периода:
+        // пул из threads потоков, каждый пишет в свой файл <path_prefix>_<номер потока>.txt через свой буфер,
+        // поэтому память ограничена threads * размер буфера независимо от числа счетов; возвращает число выписок.
+        // Файл, который не открылся или не записался целиком, - runtime_error со списком файлов после завершения всех потоков
+        size_t writeAll(std::time_t from, std::time_t to, const std::string& path_prefix, unsigned threads = 0) const;
+
+        // границы календарного месяца (местное время)
+        static std::time_t monthStart(int year, int month);
+    };
+
+}
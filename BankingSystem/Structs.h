@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 
 namespace Banking {
     struct Address {
@@ -59,4 +60,31 @@ namespace Banking {
             return day >= 1 && day <= 31 && month >= 1 && month <= 12 && year >= 1900;
         }
     };
+
+    //     ()
+    struct AccountBalance {
+        std::string accountNumber;
+        double balance;
+
+        AccountBalance(const std::string& accountNumber_value, double balance_value)
+            : accountNumber(accountNumber_value), balance(balance_value) {
+        }
+    };
+
+    //     (undo record   )
+    struct AccountState {
+        double balance;
+        double fields[3]; //   
+    };
+
+    //       (    ,  )
+    struct TransferOrder {
+        std::string_view from;
+        std::string_view to;
+        double amount;
+
+        TransferOrder(std::string_view from_value, std::string_view to_value, double amount_value)
+            : from(from_value), to(to_value), amount(amount_value) {
+        }
+    };
 }
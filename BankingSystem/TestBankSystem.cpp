@@ -3,6 +3,23 @@
 #include "PremiumClient.h"
 #include "CheckingAccount.h"
 #include "SavingsAccount.h"
+#include "BatchProcessor.h"
+#include "ShardedBank.h"
+#include "ChangeFeedFile.h"
+#include "StandingOrders.h"
+#include "BulkLoader.h"
+#include "Metrics.h"
+#include "AsyncBank.h"
+#include "Workload.h"
+
+#include <sstream>
+#include <fstream>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <functional>
 
 using namespace Banking;
 
@@ -14,6 +31,31 @@ void TestBankSystem::runAllTests() {
     testTransactions();
     testDeletion();
     testErrorHandling();
+    testBatchMode();
+    testShardedBank();
+    testSnapshotConsistency();
+    testIdempotency();
+    testChangeFeed();
+    testStatusResults();
+    testPostingRollback();
+    testLedger();
+    testStandingOrders();
+    testVelocityLimits();
+    testClientSearch();
+    testClientStorage();
+    testEntityLinks();
+    testBulkLoader();
+    testStatements();
+    testMetrics();
+    testMoveSemantics();
+    testMultiCurrency();
+    testAccountGroups();
+    testAsyncBank();
+    testWorkload();
+    testHotAccounts();
+    testTransactionArchive();
+    testLookupFilter();
+    testBalanceStore();
 
     std::cout << "=== ALL TESTS PASSED! ===" << std::endl;
 }
@@ -173,7 +215,7 @@ void TestBankSystem::testErrorHandling() {
     // Test 3: Transfer with insufficient funds (should throw exception)
     try {
         auto smallAccount = bank.createCheckAccount("SMALL001", 2, 50.0);
-        bank.transfer("SMALL001", "SAV001", 100.0); // Try to transfer more than balance
+        bank.transfer("SMALL001", "SAV001", 100000.0); // Try to transfer more than balance + overdraft
         assert(false); // Should not reach here
     }
     catch (const std::exception& e) {
@@ -188,4 +230,2281 @@ void TestBankSystem::testErrorHandling() {
     catch (const std::exception& e) {
         std::cout << "OK Non-existent client test passed: " << e.what() << std::endl;
     }
-}
\ No newline at end of file
+}
+
+void TestBankSystem::testBatchMode() {
+    std::cout << "\n--- Testing Batch Mode ---" << std::endl;
+
+    Bank batchBank;
+    std::istringstream script(
+        "# clients and accounts\n"
+        "CLIENT,10,Anna,Ivanova,Lenina 1,Moscow,Russia,101000,5,3,2024\n"
+        "PREMIUM,11,Petr,Petrov,Tverskaya 2,Moscow,Russia,101001,6,3,2024,Gold\n"
+        "SAVINGS,B-SAV,10,10000,6\n"
+        "CHECKING,B-CHK,11,1000\r\n"
+        "\n"
+        "DEPOSIT,B-CHK,500\n"
+        "TRANSFER,B-CHK,B-SAV,100\n"
+        "TRANSFER,B-CHK,MISSING,100\n"
+        "WITHDRAW,B-SAV,9000\n"
+        "UNKNOWN,1,2\n"
+        "DEPOSIT,B-CHK,abc\n"
+        "PREMIUM,12,Ivan,Sidorov,Arbat 3,Moscow,Russia,101002,7,3,2024,Gold,junk\n");
+
+    std::ostringstream errors;
+    BatchProcessor batch(batchBank, errors);
+    size_t processed = batch.run(script);
+
+    assert(processed == 6);
+    assert(batch.getFailedCount() == 5);
+    assert(batchBank.getClientsCount() == 2);
+    assert(batchBank.getAccountCount() == 2);
+    assert(batchBank.find_acc_by_number("B-SAV")->getBalance() == 10100.0);
+    assert(errors.str().find("line 9:") != std::string::npos); // MISSING account
+    assert(errors.str().find("line 13: too many fields") != std::string::npos); // лишнее поле не отбрасывается
+    std::cout << "OK Batch mode test passed" << std::endl;
+}
+
+void TestBankSystem::testShardedBank() {
+    std::cout << "\n--- Testing Sharded Bank ---" << std::endl;
+
+    const int accounts = 16;
+    double total = 0;
+    size_t completed = 0;
+    size_t failed = 0;
+    {
+        QuietCout quiet; // потоки шардов не должны писать в общий cout
+        ShardedBank sharded(4);
+        sharded.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        for (int i = 0; i < accounts; ++i) {
+            sharded.createSavAccount("SH" + std::to_string(i), 1, 100000.0, 12);
+        }
+
+        // переводы внутри шардов и между ними + перевод на несуществующий счет (должен вернуться)
+        for (int i = 0; i < 200; ++i) {
+            sharded.transfer("SH" + std::to_string(i % accounts), "SH" + std::to_string((i * 7 + 3) % accounts), 10.0);
+        }
+        sharded.transfer("SH0", "NO_SUCH_ACCOUNT", 500.0);
+        sharded.drain();
+
+        for (int i = 0; i < accounts; ++i) {
+            total += sharded.getBalance("SH" + std::to_string(i));
+        }
+        completed = sharded.getCompletedCount();
+        failed = sharded.getFailedCount();
+    }
+
+    assert(total == accounts * 100000.0); // деньги не появились и не пропали
+    assert(completed == 200);
+    assert(failed == 1);
+
+    // возврат, который не может дойти: счет отправителя удален, пока зачисление ждало в очереди
+    std::vector<ShardedBank::SuspenseEntry> suspense;
+    {
+        QuietCout quiet;
+        ShardedBank sharded(2);
+        sharded.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        std::string from, missing, blocker;
+        for (int i = 0; from.empty() || missing.empty() || blocker.empty(); ++i) {
+            std::string number = "SP" + std::to_string(i);
+            if (sharded.shard_of(number) == 0) {
+                if (from.empty()) {
+                    from = number;
+                }
+            }
+            else if (missing.empty()) {
+                missing = number;
+            }
+            else if (blocker.empty()) {
+                blocker = number;
+            }
+        }
+        sharded.createCheckAccount(from, 1, 510.0);
+        sharded.createCheckAccount(blocker, 1, 0.0);
+        sharded.drain();
+
+        // поток шарда получателя стоит в уведомлении о пополнении, пока не откроем шлюз
+        std::atomic<bool> gate{ false };
+        sharded.deposit(blocker, 1.0, ShardedBank::Completion{ [](void* context, bool) {
+            while (!static_cast<std::atomic<bool>*>(context)->load()) {
+                std::this_thread::yield();
+            }
+        }, &gate });
+        sharded.transfer(from, missing, 500.0); // 500 + комиссия 10 - весь остаток
+        sharded.deleteAccount(from);
+        gate.store(true);
+        sharded.drain();
+        suspense = sharded.getSuspense();
+    }
+    assert(suspense.size() == 1);
+    assert(suspense[0].amount == 500.0);
+    std::cout << "OK Sharded bank test passed" << std::endl;
+}
+
+void TestBankSystem::testSnapshotConsistency() {
+    std::cout << "\n--- Testing Snapshot Consistency ---" << std::endl;
+
+    const int accounts = 5000; // отчет должен занимать заметное время, чтобы переводы шли параллельно
+    const double expected_total = accounts * 100000.0;
+    size_t snapshots = 0;
+    bool consistent = true;
+    {
+        QuietCout quiet;
+        Bank liveBank;
+        liveBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        for (int i = 0; i < accounts; ++i) {
+            liveBank.createSavAccount("MV" + std::to_string(i), 1, 100000.0, 12);
+        }
+
+        // переводы из нескольких потоков, пока основной поток снимает отчеты
+        std::atomic<bool> stop{ false };
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; ++t) {
+            writers.emplace_back([&liveBank, &stop, t]() {
+                unsigned seed = 17u + t;
+                while (!stop.load()) {
+                    seed = seed * 1103515245u + 12345u;
+                    int from = static_cast<int>((seed >> 8) % accounts);
+                    int to = (from + 1 + static_cast<int>((seed >> 16) % (accounts - 1))) % accounts;
+                    try {
+                        liveBank.transfer("MV" + std::to_string(from), "MV" + std::to_string(to), 1.0 + (seed % 50));
+                    }
+                    catch (const std::exception&) {
+                        // отказ в переводе не влияет на сумму балансов
+                    }
+                }
+            });
+        }
+
+        for (int i = 0; i < 50; ++i) {
+            double total = 0;
+            auto balances = liveBank.snapshot_balances();
+            for (const auto& item : balances) {
+                total += item.balance;
+            }
+            consistent = consistent && balances.size() == accounts && total == expected_total;
+            ++snapshots;
+        }
+
+        stop.store(true);
+        for (auto& writer : writers) {
+            writer.join();
+        }
+    }
+
+    assert(consistent); // сумма балансов не меняется при переводах
+    std::cout << "OK Snapshot consistency test passed (" << snapshots << " snapshots)" << std::endl;
+}
+
+void TestBankSystem::testIdempotency() {
+    std::cout << "\n--- Testing Idempotency Keys ---" << std::endl;
+
+    Bank retryBank;
+    retryBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+    auto from = retryBank.createSavAccount("ID-1", 1, 10000.0, 12);
+    auto to = retryBank.createSavAccount("ID-2", 1, 10000.0, 12);
+
+    // Test 1: replayed deposit is applied once
+    retryBank.registerDeposit(from, 1000.0, "dep-1");
+    retryBank.registerDeposit(from, 1000.0, "dep-1");
+    assert(from->getBalance() == 11000.0);
+    std::cout << "OK Replayed deposit test passed" << std::endl;
+
+    // Test 2: replayed transfer is applied once
+    retryBank.transfer("ID-1", "ID-2", 500.0, "tr-1");
+    retryBank.transfer("ID-1", "ID-2", 500.0, "tr-1");
+    assert(from->getBalance() == 10500.0);
+    assert(to->getBalance() == 10500.0);
+    std::cout << "OK Replayed transfer test passed" << std::endl;
+
+    // Test 3: replayed failure returns the original error, even if it would succeed now
+    int errors = 0;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        try {
+            retryBank.transfer("ID-1", "ID-3", 100.0, "tr-2");
+        }
+        catch (const std::invalid_argument&) {
+            ++errors;
+        }
+        if (attempt == 0) {
+            retryBank.createSavAccount("ID-3", 1, 5000.0, 1);
+        }
+    }
+    assert(errors == 2);
+    assert(from->getBalance() == 10500.0);
+    std::cout << "OK Replayed failure test passed" << std::endl;
+
+    // Test 4: expired keys are executed again
+    retryBank.getIdempotencyCache().setTtl(std::chrono::seconds(0));
+    retryBank.registerDeposit(to, 100.0, "dep-2");
+    retryBank.registerDeposit(to, 100.0, "dep-2");
+    assert(to->getBalance() == 10700.0);
+    std::cout << "OK Expired key test passed" << std::endl;
+
+    // Test 5: capacity eviction keeps reservations of operations still in progress
+    IdempotencyCache small(16); // 2 записи на полосу
+    IdempotencyCache::Result result;
+    const IdempotencyCache::Request request{ IdempotencyCache::Request::Operation::Deposit, "", "ID-1", 100 };
+    const IdempotencyCache::Lookup pending_reserved = small.lookupOrReserve("pending", request, result);
+    assert(pending_reserved == IdempotencyCache::Lookup::Reserved);
+    for (int i = 0; i < 200; ++i) {
+        std::string key = "done-" + std::to_string(i);
+        const IdempotencyCache::Lookup reserved = small.lookupOrReserve(key, request, result);
+        assert(reserved == IdempotencyCache::Lookup::Reserved);
+        small.complete(key, result);
+    }
+    const IdempotencyCache::Lookup pending_again = small.lookupOrReserve("pending", request, result);
+    assert(pending_again == IdempotencyCache::Lookup::InProgress);
+    assert(small.size() <= 16 * 2 + 1);
+    std::cout << "OK Pending reservation eviction test passed" << std::endl;
+
+    // Test 6: a key reused for a different amount is rejected, not answered with the first result
+    retryBank.getIdempotencyCache().setTtl(std::chrono::hours(24));
+    retryBank.registerDeposit(from, 100.0, "dep-3");
+    bool reused = false;
+    try {
+        retryBank.registerDeposit(from, 200.0, "dep-3");
+    }
+    catch (const std::invalid_argument&) {
+        reused = true;
+    }
+    bool other_operation = false;
+    try {
+        retryBank.registerWithdraw(from, 100.0, "dep-3");
+    }
+    catch (const std::invalid_argument&) {
+        other_operation = true;
+    }
+    assert(reused && other_operation);
+    assert(from->getBalance() == 10600.0);
+    retryBank.registerDeposit(from, 100.0, "dep-3"); // тот же запрос - по-прежнему повтор
+    assert(from->getBalance() == 10600.0);
+    std::cout << "OK Reused key mismatch test passed" << std::endl;
+}
+void TestBankSystem::testChangeFeed() {
+    std::cout << "\n--- Testing Change Feed ---" << std::endl;
+
+    // Test 1: bank operations are published in order
+    std::vector<ChangeEvent> events;
+    {
+        QuietCout quiet;
+        Bank feedBank;
+        auto feed = std::make_shared<ChangeFeed>(1024);
+        auto subscription = feed->subscribe(ChangeFeed::Policy::Backpressure);
+        feedBank.setChangeFeed(feed);
+        feedBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        auto first = feedBank.createCheckAccount("CF-1", 1, 1000.0);
+        feedBank.createCheckAccount("CF-2", 1, 0.0);
+        feedBank.registerDeposit(first, 500.0);
+        feedBank.registerWithdraw(first, 200.0);
+        feedBank.transfer("CF-1", "CF-2", 300.0);
+        feedBank.transfer("CF-2", "CF-1", 300.0);
+        feedBank.deleteAccount("CF-2");
+        ChangeEvent event;
+        while (subscription->poll(event)) {
+            events.push_back(event);
+        }
+    }
+    const uint32_t expected[] = { ChangeEvent::ACCOUNT_OPENED, ChangeEvent::ACCOUNT_OPENED, ChangeEvent::DEPOSIT, ChangeEvent::WITHDRAW,
+        ChangeEvent::TRANSFER_OUT, ChangeEvent::TRANSFER_IN, ChangeEvent::TRANSFER_OUT, ChangeEvent::TRANSFER_IN, ChangeEvent::ACCOUNT_CLOSED };
+    assert(events.size() == 9);
+    for (size_t i = 0; i < events.size(); ++i) {
+        assert(events[i].sequence == i);
+        assert(events[i].kind == expected[i]);
+    }
+    assert(std::string(events[2].account) == "CF-1" && events[2].balance_after == 1500.0);
+    assert(std::string(events[5].account) == "CF-2" && std::string(events[5].counterpart) == "CF-1" && events[5].balance_after == 300.0);
+    std::cout << "OK Event order test passed" << std::endl;
+
+    // Test 2: a drop subscriber that never reads does not stall the writer
+    ChangeFeed smallFeed(8);
+    auto lagging = smallFeed.subscribe(ChangeFeed::Policy::Drop);
+    for (int i = 0; i < 100; ++i) {
+        smallFeed.publish(ChangeEvent::make(ChangeEvent::DEPOSIT, "CF-1", "", i, i, 1));
+    }
+    ChangeEvent event;
+    uint64_t received = 0;
+    uint64_t last = 0;
+    while (lagging->poll(event)) {
+        ++received;
+        last = event.sequence;
+    }
+    assert(last == 99);
+    assert(received + lagging->getDroppedCount() == 100);
+    assert(lagging->getDroppedCount() > 0);
+    std::cout << "OK Drop policy test passed (dropped " << lagging->getDroppedCount() << ")" << std::endl;
+
+    // Test 3: a backpressure subscriber receives every event even through a tiny buffer
+    ChangeFeed tinyFeed(4);
+    auto reader = tinyFeed.subscribe(ChangeFeed::Policy::Backpressure);
+    const uint64_t total = 20000;
+    std::atomic<bool> ordered{ true };
+    std::thread consumer([&]() {
+        ChangeEvent item;
+        uint64_t next = 0;
+        while (next < total) {
+            if (reader->poll(item)) {
+                if (item.sequence != next || item.amount != static_cast<double>(next)) {
+                    ordered = false;
+                }
+                ++next;
+            }
+        }
+    });
+    for (uint64_t i = 0; i < total; ++i) {
+        tinyFeed.publish(ChangeEvent::make(ChangeEvent::DEPOSIT, "CF-1", "", static_cast<double>(i), 0, 1));
+    }
+    consumer.join();
+    assert(ordered);
+    assert(reader->getDroppedCount() == 0);
+    std::cout << "OK Backpressure policy test passed" << std::endl;
+
+    // Test 4: file consumer writes a log that can be tailed
+    const std::string path = "test_change_feed.bin";
+    std::remove(path.c_str());
+    {
+        ChangeFeed fileFeed;
+        ChangeFeedFileWriter writer(fileFeed, path);
+        fileFeed.publish(ChangeEvent::make(ChangeEvent::DEPOSIT, "CF-1", "", 10.0, 110.0, 1));
+        fileFeed.publish(ChangeEvent::make(ChangeEvent::TRANSFER_OUT, "CF-1", "CF-2", 5.0, 105.0, 1));
+        writer.stop();
+        assert(writer.getWrittenCount() == 2);
+    }
+    std::ostringstream tail;
+    const size_t tailed = tailChangeFile(path, tail);
+    assert(tailed == 2);
+    assert(tail.str().find("TRANSFER_OUT CF-1 <-> CF-2") != std::string::npos);
+    std::remove(path.c_str());
+    std::cout << "OK File consumer test passed" << std::endl;
+
+    // Test 5: the writer waits for a backpressure subscriber without holding the bank lock,
+    // so the subscriber can read the bank (before the fix this deadlocked on write_mutex)
+    const int deposits = 500;
+    double seen_balance = 0;
+    {
+        QuietCout quiet;
+        Bank busyBank;
+        auto feed = std::make_shared<ChangeFeed>(4);
+        auto slow = feed->subscribe(ChangeFeed::Policy::Backpressure);
+        busyBank.setChangeFeed(feed);
+        busyBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        auto target = busyBank.createCheckAccount("CF-3", 1, 0.0); // событие открытия - тоже в ленте
+        std::thread auditor([&]() {
+            ChangeEvent item;
+            int received = 0;
+            while (received < deposits + 1) {
+                if (!slow->poll(item)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                ++received;
+                seen_balance = busyBank.find_acc_by_number("CF-3")->getBalance();
+            }
+        });
+        for (int i = 0; i < deposits; ++i) {
+            busyBank.registerDeposit(target, 1.0);
+        }
+        auditor.join();
+    }
+    assert(seen_balance == deposits);
+    std::cout << "OK Backpressure subscriber reading the bank test passed" << std::endl;
+}
+void TestBankSystem::testStatusResults() {
+    std::cout << "\n--- Testing Status Results ---" << std::endl;
+
+    Bank statusBank;
+
+    // Test 1: create operations report refusals instead of throwing
+    auto client = statusBank.tryCreateClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+    assert(client.isOk() && client.getValue()->getId() == 1);
+    const BankStatus duplicate_client = statusBank.tryCreateClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024)).getStatus();
+    assert(duplicate_client == BankStatus::DuplicateClient);
+    const BankStatus empty_name = statusBank.tryCreateClient(2, "", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024)).getStatus();
+    assert(empty_name == BankStatus::InvalidClientData);
+    const BankStatus bad_level = statusBank.tryCreatePremiumClient(3, "Oleg", "Petrov", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024), "Bronze").getStatus();
+    assert(bad_level == BankStatus::InvalidClientData);
+    const BankStatus missing_client = statusBank.tryCreateCheckAccount("ST-1", 99, 100.0).getStatus();
+    assert(missing_client == BankStatus::ClientNotFound);
+    auto checking = statusBank.tryCreateCheckAccount("ST-1", 1, 1000.0);
+    assert(checking);
+    const BankStatus duplicate_account = statusBank.tryCreateCheckAccount("ST-1", 1, 1000.0).getStatus();
+    assert(duplicate_account == BankStatus::DuplicateAccount);
+    const BankStatus small_savings = statusBank.tryCreateSavAccount("ST-2", 1, 100.0, 12).getStatus();
+    assert(small_savings == BankStatus::InvalidAccountData);
+    auto savings = statusBank.tryCreateSavAccount("ST-2", 1, 10000.0, 12);
+    assert(savings);
+    assert(statusBank.getAccountCount() == 2);
+    std::cout << "OK Create status test passed" << std::endl;
+
+    // Test 2: declined money operations leave balances unchanged
+    const BankStatus same_account = statusBank.tryTransfer("ST-1", "ST-1", 10.0);
+    assert(same_account == BankStatus::SameAccount);
+    const BankStatus negative_amount = statusBank.tryTransfer("ST-1", "ST-2", -10.0);
+    assert(negative_amount == BankStatus::InvalidAmount);
+    const BankStatus missing_source = statusBank.tryTransfer("NOPE", "ST-2", 10.0);
+    assert(missing_source == BankStatus::SourceNotFound);
+    const BankStatus missing_destination = statusBank.tryTransfer("ST-1", "NOPE", 10.0);
+    assert(missing_destination == BankStatus::DestinationNotFound);
+    const BankStatus over_balance = statusBank.tryTransfer("ST-2", "ST-1", 100000.0);
+    assert(over_balance == BankStatus::InsufficientFunds);
+    const BankStatus over_withdraw = statusBank.tryWithdraw(savings.getValue(), 100000.0);
+    assert(over_withdraw == BankStatus::InsufficientFunds);
+    const BankStatus zero_deposit = statusBank.tryDeposit(savings.getValue(), 0.0);
+    assert(zero_deposit == BankStatus::InvalidAmount);
+    const BankStatus null_deposit = statusBank.tryDeposit(nullptr, 10.0);
+    assert(null_deposit == BankStatus::AccountNotFound);
+    assert(savings.getValue()->getBalance() == 10000.0);
+    std::cout << "OK Declined status test passed" << std::endl;
+
+    // Test 3: successful operations and the throwing API on top of them
+    const BankStatus deposited = statusBank.tryDeposit(savings.getValue(), 500.0);
+    assert(deposited == BankStatus::Ok);
+    const BankStatus transferred = statusBank.tryTransfer("ST-2", "ST-1", 500.0);
+    assert(transferred == BankStatus::Ok);
+    assert(savings.getValue()->getBalance() == 10000.0);
+    bool thrown = false;
+    try {
+        statusBank.transfer("ST-1", "NOPE", 10.0);
+    }
+    catch (const std::invalid_argument& e) {
+        thrown = std::string(e.what()) == "Destination account not found: NOPE";
+    }
+    assert(thrown);
+    assert(std::string(statusMessage(BankStatus::InsufficientFunds)) == "Insufficient funds");
+    std::cout << "OK Successful status test passed" << std::endl;
+
+    // Test 4: accounts of another bank are not touched
+    {
+        QuietCout quiet;
+        Bank otherBank;
+        otherBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        auto foreign = otherBank.createSavAccount("ST-9", 1, 10000.0, 12);
+        const BankStatus foreign_deposit = statusBank.tryDeposit(foreign, 100.0);
+        assert(foreign_deposit == BankStatus::AccountNotFound);
+        const BankStatus foreign_withdraw = statusBank.tryWithdraw(foreign, 100.0);
+        assert(foreign_withdraw == BankStatus::AccountNotFound);
+        assert(foreign->getBalance() == 10000.0);
+        uint32_t index = 0;
+        assert(!statusBank.getLedger().findAccount("ST-9", index)); // номер не попал в книгу этого банка
+    }
+    std::cout << "OK Foreign account status test passed" << std::endl;
+}
+void TestBankSystem::testPostingRollback() {
+    std::cout << "\n--- Testing Posting Rollback ---" << std::endl;
+
+    Bank postingBank;
+    auto feed = std::make_shared<ChangeFeed>(1024);
+    auto events = feed->subscribe(ChangeFeed::Policy::Drop);
+    postingBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+    auto checking = postingBank.createCheckAccount("PS-1", 1, 100.0);
+    auto savings = postingBank.createSavAccount("PS-2", 1, 10000.0, 12);
+    auto fees = postingBank.createCheckAccount("PS-FEE", 1, 0.0);
+    postingBank.setChangeFeed(feed);
+
+    double balance = checking->getBalance();
+    double available = checking->get_available_overdraft();
+    double limit = checking->get_overdraft_limit();
+
+    // Test 1: a failing leg rolls back every earlier leg, including overdraft usage
+    Posting posting;
+    posting.debit(checking, 1000.0, "TRANSFER_OUT", "PS-2");  // уходит в овердрафт
+    posting.credit(savings, 1000.0, "TRANSFER_IN", "PS-1");
+    posting.debit(savings, 1000000.0, "FEE", "PS-FEE");       // не хватает средств
+    const BankStatus rolled_back = postingBank.post(posting);
+    assert(rolled_back == BankStatus::InsufficientFunds);
+    assert(checking->getBalance() == balance);
+    assert(checking->get_available_overdraft() == available);
+    assert(checking->get_overdraft_limit() == limit);
+    assert(savings->getBalance() == 10000.0);
+    ChangeEvent event;
+    const bool rolled_back_event = events->poll(event);
+    assert(!rolled_back_event); // отмененная проводка не попадает в ленту
+    std::cout << "OK Multi-leg rollback test passed" << std::endl;
+
+    // Test 2: transfer with fee commits all legs in one unit
+    const BankStatus fee_transfer = postingBank.tryTransferWithFee("PS-2", "PS-1", 1000.0, 50.0, "PS-FEE");
+    assert(fee_transfer == BankStatus::Ok);
+    assert(savings->getBalance() == 8950.0);
+    assert(fees->getBalance() == 50.0);
+    size_t published = 0;
+    while (events->poll(event)) {
+        ++published;
+    }
+    assert(published == 4);
+    double total = 0;
+    for (const auto& item : postingBank.snapshot_balances()) {
+        total += item.balance;
+    }
+    assert(total == checking->getBalance() + savings->getBalance() + fees->getBalance());
+    std::cout << "OK Transfer with fee test passed" << std::endl;
+
+    // Test 3: fee that does not fit rolls back the transfer leg too
+    double checking_before = checking->getBalance();
+    const BankStatus fee_too_large = postingBank.tryTransferWithFee("PS-2", "PS-1", 3900.0, 100.0, "PS-FEE");
+    assert(fee_too_large == BankStatus::InsufficientFunds);
+    assert(savings->getBalance() == 8950.0);
+    assert(checking->getBalance() == checking_before);
+    assert(fees->getBalance() == 50.0);
+    std::cout << "OK Fee rollback test passed" << std::endl;
+}
+void TestBankSystem::testLedger() {
+    std::cout << "\n--- Testing Double-Entry Ledger ---" << std::endl;
+
+    Bank ledgerBank;
+    ledgerBank.createPremiumClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024), "Gold");
+    ledgerBank.createClient(2, "Oleg", "Petrov", Address("Lenina 2", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+    auto checking = ledgerBank.createCheckAccount("LG-1", 1, 10000.0);
+    auto savings = ledgerBank.createSavAccount("LG-2", 2, 20000.0, 12);
+    auto fees = ledgerBank.createCheckAccount("LG-FEE", 2, 0.0);
+
+    ledgerBank.registerDeposit(checking, 1000.0);
+    ledgerBank.registerWithdraw(checking, 500.0);
+    ledgerBank.transfer("LG-2", "LG-1", 300.0);
+    ledgerBank.transfer("LG-1", "LG-2", 200.0);
+    const BankStatus fee_status = ledgerBank.tryTransferWithFee("LG-1", "LG-2", 100.0, 50.0, "LG-FEE");
+    assert(fee_status == BankStatus::Ok);
+    ledgerBank.registerTransferOut(savings, "OTHER-BANK", 100.0);
+    ledgerBank.registerTransferIn(savings, "OTHER-BANK", 100.0);
+
+    // Test 1: every posting and the whole book sum to zero
+    Ledger& ledger = ledgerBank.getLedger();
+    assert(ledger.totalOfAllEntries() == 0);
+    for (size_t posting = 0; posting < ledger.getPostingCount(); ++posting) {
+        int64_t sum = 0;
+        for (size_t i = 0; i < ledger.getLegCount(posting); ++i) {
+            sum += ledger.getLeg(ledger.getFirstLeg(posting) + i).amount;
+        }
+        assert(sum == 0);
+    }
+    assert(ledger.getPostingCount() == 9); // 2 открытия с балансом + 7 операций
+    std::cout << "OK Balanced postings test passed" << std::endl;
+
+    // Test 2: trial balance matches account balances, commissions and discounts are booked
+    std::vector<int64_t> totals = ledger.trialBalance();
+    assert(totals[ledger.accountIndex("LG-1")] == Ledger::toCents(checking->getBalance()));
+    assert(totals[ledger.accountIndex("LG-2")] == Ledger::toCents(savings->getBalance()));
+    assert(totals[ledger.accountIndex("LG-FEE")] == 5000);
+    assert(totals[Ledger::DISCOUNT_EXPENSE] == -500); // 10% скидки Gold с комиссии 50
+    assert(totals[Ledger::COMMISSION_INCOME] > 0);    // комиссии расчетного счета больше не теряются
+    assert(totals[Ledger::TRANSIT] == 0);
+    std::cout << "OK Trial balance test passed" << std::endl;
+
+    // Test 3: an unbalanced posting is rejected and leaves the book unchanged
+    size_t postings = ledger.getPostingCount();
+    bool rejected = false;
+    try {
+        ledger.post(Ledger::DEPOSIT, { { Ledger::CASH, -100, Ledger::PRINCIPAL }, { ledger.accountIndex("LG-1"), 99, Ledger::PRINCIPAL } });
+    }
+    catch (const std::logic_error&) {
+        rejected = true;
+    }
+    assert(rejected);
+    assert(ledger.getPostingCount() == postings);
+    std::cout << "OK Unbalanced posting test passed" << std::endl;
+
+    // Test 4: withdrawals with a commission move the account and the book by the same cents
+    auto small = ledgerBank.createCheckAccount("LG-3", 2, 1000.0);
+    for (int i = 0; i < 7; ++i) {
+        ledgerBank.registerWithdraw(small, 33.33); // комиссия 0.0444... -> 0.04
+    }
+    totals = ledger.trialBalance();
+    assert(totals[ledger.accountIndex("LG-3")] == 76641);
+    assert(Ledger::toCents(small->getBalance()) == 76641);
+    std::cout << "OK Commission rounding test passed" << std::endl;
+
+    // Test 5: a pointer to a deleted account does not post to the live account that reuses its number
+    auto stale = ledgerBank.createCheckAccount("LG-X", 2, 0.0);
+    const bool deleted = ledgerBank.deleteAccount("LG-X");
+    assert(deleted);
+    auto live = ledgerBank.createCheckAccount("LG-X", 2, 0.0);
+    postings = ledger.getPostingCount();
+    int refused = 0;
+    auto expectRefused = [&](const std::function<void()>& operation) {
+        try {
+            operation();
+        }
+        catch (const std::invalid_argument&) {
+            ++refused;
+        }
+    };
+    expectRefused([&]() { ledgerBank.registerDeposit(stale, 100.0); });
+    expectRefused([&]() { ledgerBank.registerWithdraw(stale, 1.0); });
+    expectRefused([&]() { ledgerBank.registerTransferOut(stale, "OTHER-BANK", 1.0); });
+    expectRefused([&]() { ledgerBank.registerTransferIn(stale, "OTHER-BANK", 100.0); });
+    assert(refused == 4);
+    assert(ledger.getPostingCount() == postings);
+    totals = ledger.trialBalance();
+    assert(totals[ledger.accountIndex("LG-X")] == 0 && live->getBalance() == 0);
+    std::cout << "OK Stale account pointer test passed" << std::endl;
+}
+void TestBankSystem::testStandingOrders() {
+    std::cout << "\n--- Testing Standing Orders ---" << std::endl;
+
+    assert(StandingOrders::dayNumber(Date(1, 1, 1970)) == 0);
+    assert(StandingOrders::dayNumber(Date(1, 1, 2000)) == 10957);
+    assert(StandingOrders::dayNumber(Date(1, 3, 2024)) - StandingOrders::dayNumber(Date(28, 2, 2024)) == 2);
+
+    const uint32_t start = StandingOrders::dayNumber(Date(1, 1, 2025));
+    bool monthly_ok = false;
+    bool cancel_ok = false;
+    bool wheel_ok = true;
+    {
+        QuietCout quiet;
+        Bank orderBank;
+        orderBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        orderBank.createSavAccount("SO-1", 1, 10000000.0, 12);
+        auto savings = orderBank.createSavAccount("SO-2", 1, 10000.0, 6);
+
+        StandingOrders orders;
+        orders.advanceTo(start - 1, orderBank);
+
+        // Test 1: monthly top-up runs SavingsAccount::months times, then disappears
+        orders.scheduleSavingsTopUp(orderBank, "SO-1", "SO-2", 1000.0, start);
+        orders.advanceTo(start + 29, orderBank);
+        bool first_month = savings->getBalance() == 11000.0;
+        orders.advanceTo(start + 365, orderBank);
+        monthly_ok = first_month && savings->getBalance() == 16000.0 && orders.getFiredCount() == 6 && orders.getActiveCount() == 0;
+
+        // Test 2: cancelled orders never fire, stale ids are rejected
+        StandingOrders::OrderId id = orders.schedule("SO-1", "SO-2", 5.0, start + 400, 1, 10);
+        cancel_ok = orders.cancel(id) && !orders.cancel(id) && orders.getActiveCount() == 0;
+        orders.schedule("SO-1", "NO-SUCH", 5.0, start + 400, 1, 1); // переиспользует запись отмененного
+        cancel_ok = cancel_ok && !orders.cancel(id);
+        orders.advanceTo(start + 400, orderBank);
+        cancel_ok = cancel_ok && orders.getFiredCount() == 6 && orders.getFailedCount() == 1;
+
+        // Test 3: orders spread over ~200 years fire exactly on their day across all wheel levels
+        const int count = 3000;
+        std::vector<uint32_t> due;
+        unsigned seed = 7;
+        uint32_t from = orders.getCurrentDay();
+        for (int i = 0; i < count; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            due.push_back(from + (seed >> 4) % 70000);
+            orders.schedule("SO-1", "SO-2", 1.0, due.back(), 1, 1);
+        }
+        size_t fired_before = orders.getFiredCount();
+        for (uint32_t day = from; day < from + 70000; day += 997) {
+            orders.advanceTo(day, orderBank);
+            size_t expected = 0;
+            for (uint32_t value : due) {
+                expected += value <= day;
+            }
+            if (orders.getFiredCount() - fired_before != expected) {
+                wheel_ok = false;
+            }
+        }
+        orders.advanceTo(from + 70000, orderBank);
+        wheel_ok = wheel_ok && orders.getFiredCount() - fired_before == static_cast<size_t>(count) && orders.getActiveCount() == 0;
+    }
+    assert(monthly_ok);
+    std::cout << "OK Monthly savings top-up test passed" << std::endl;
+    assert(cancel_ok);
+    std::cout << "OK Cancel test passed" << std::endl;
+    assert(wheel_ok);
+    std::cout << "OK Timer wheel levels test passed" << std::endl;
+
+    // Test 4: a fresh wheel jumps from day 0 straight to real dates without losing orders
+    bool jump_ok = false;
+    {
+        QuietCout quiet;
+        Bank orderBank;
+        orderBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        orderBank.createSavAccount("SO-1", 1, 10000000.0, 12);
+        orderBank.createSavAccount("SO-2", 1, 10000.0, 6);
+        StandingOrders orders;
+        orders.schedule("SO-1", "SO-2", 1.0, start + 70000, 1, 1);
+        orders.schedule("SO-1", "SO-2", 1.0, start, 7, 3);
+        orders.advanceTo(start + 13, orderBank);
+        bool weekly = orders.getFiredCount() == 2;
+        orders.advanceTo(start + 100000, orderBank);
+        jump_ok = weekly && orders.getFiredCount() == 4 && orders.getActiveCount() == 0 && orders.getCurrentDay() == start + 100001;
+    }
+    assert(jump_ok);
+    std::cout << "OK Empty day skipping test passed" << std::endl;
+}
+void TestBankSystem::testVelocityLimits() {
+    std::cout << "\n--- Testing Velocity Limits ---" << std::endl;
+
+    // Test 1: the window slides bucket by bucket
+    using Clock = VelocityTracker::Clock;
+    VelocityTracker tracker(std::chrono::minutes(10));
+    VelocityLimits limits;
+    limits.max_count = 3;
+    limits.max_amount = 1000.0;
+    tracker.setLimits(limits);
+    Clock::time_point t0 = Clock::time_point(std::chrono::hours(1000));
+    for (int i = 0; i < 3; ++i) {
+        const bool allowed = tracker.allow(7, 10000, t0 + std::chrono::minutes(i));
+        assert(allowed);
+        tracker.record(7, 10000, t0 + std::chrono::minutes(i));
+    }
+    const bool over_count = tracker.allow(7, 100, t0 + std::chrono::minutes(9));
+    assert(!over_count);
+    const bool other_window = tracker.allow(8, 100, t0 + std::chrono::minutes(9));
+    assert(other_window); // у другого счета свое окно
+    assert(tracker.getCount(7, t0 + std::chrono::minutes(10)) == 2); // первая минута вышла из окна
+    const bool after_slide = tracker.allow(7, 100, t0 + std::chrono::minutes(10));
+    assert(after_slide);
+    assert(tracker.getCount(7, t0 + std::chrono::minutes(30)) == 0 && tracker.getAmount(7, t0 + std::chrono::minutes(30)) == 0);
+    tracker.record(7, 90000, t0 + std::chrono::minutes(30));
+    const bool over_amount = tracker.allow(7, 20000, t0 + std::chrono::minutes(31));
+    assert(!over_amount);
+    const bool within_amount = tracker.allow(7, 10000, t0 + std::chrono::minutes(31));
+    assert(within_amount);
+    std::cout << "OK Sliding window test passed" << std::endl;
+
+    // Test 2: the bank blocks withdrawals and transfers over the limit, declined operations do not count
+    BankStatus blocked_withdraw = BankStatus::Ok;
+    BankStatus blocked_transfer = BankStatus::Ok;
+    BankStatus other_account = BankStatus::Ok;
+    double balance = 0;
+    bool thrown = false;
+    {
+        QuietCout quiet;
+        Bank velocityBank;
+        velocityBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        auto first = velocityBank.createSavAccount("VL-1", 1, 10000.0, 12);
+        velocityBank.createSavAccount("VL-2", 1, 10000.0, 12);
+        VelocityLimits bankLimits;
+        bankLimits.max_count = 3;
+        velocityBank.setVelocityLimits(bankLimits);
+
+        velocityBank.tryWithdraw(first, 100000.0); // отказ по балансу - не списание
+        velocityBank.tryWithdraw(first, 100.0);
+        velocityBank.registerWithdraw(first, 100.0);
+        velocityBank.tryTransfer("VL-1", "VL-2", 100.0);
+        blocked_withdraw = velocityBank.tryWithdraw(first, 100.0);
+        blocked_transfer = velocityBank.tryTransfer("VL-1", "VL-2", 100.0);
+        try {
+            velocityBank.transfer("VL-1", "VL-2", 100.0);
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        other_account = velocityBank.tryTransfer("VL-2", "VL-1", 100.0);
+        balance = first->getBalance();
+    }
+    assert(blocked_withdraw == BankStatus::VelocityLimitExceeded);
+    assert(blocked_transfer == BankStatus::VelocityLimitExceeded);
+    assert(thrown);
+    assert(other_account == BankStatus::Ok);
+    assert(balance == 9800.0);
+    std::cout << "OK Bank velocity limits test passed" << std::endl;
+
+    // Test 3: transfers with a fee and multi-leg postings are limited too, principal and fee count together
+    BankStatus fee_over = BankStatus::Ok;
+    BankStatus fee_within = BankStatus::Ok;
+    BankStatus post_over = BankStatus::Ok;
+    BankStatus post_within = BankStatus::Ok;
+    BankStatus after_limit = BankStatus::Ok;
+    double fee_balance = 0;
+    {
+        QuietCout quiet;
+        Bank velocityBank;
+        velocityBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        auto first = velocityBank.createSavAccount("VL-1", 1, 10000.0, 12);
+        auto second = velocityBank.createSavAccount("VL-2", 1, 10000.0, 12);
+        velocityBank.createCheckAccount("VL-FEE", 1, 0.0);
+        VelocityLimits bankLimits;
+        bankLimits.max_amount = 1000.0;
+        velocityBank.setVelocityLimits(bankLimits);
+
+        fee_over = velocityBank.tryTransferWithFee("VL-1", "VL-2", 900.0, 150.0, "VL-FEE"); // 1050 за одну операцию
+        fee_within = velocityBank.tryTransferWithFee("VL-1", "VL-2", 400.0, 100.0, "VL-FEE");
+        Posting split;
+        split.debit(first, 300.0, "TRANSFER_OUT", "VL-2");
+        split.credit(second, 300.0, "TRANSFER_IN", "VL-1");
+        split.debit(first, 300.0, "TRANSFER_OUT", "VL-2");
+        split.credit(second, 300.0, "TRANSFER_IN", "VL-1");
+        post_over = velocityBank.post(split); // 500 + 600
+        Posting rest;
+        rest.debit(first, 250.0, "TRANSFER_OUT", "VL-2");
+        rest.credit(second, 250.0, "TRANSFER_IN", "VL-1");
+        rest.debit(first, 250.0, "TRANSFER_OUT", "VL-2");
+        rest.credit(second, 250.0, "TRANSFER_IN", "VL-1");
+        post_within = velocityBank.post(rest); // ровно 1000
+        after_limit = velocityBank.tryTransferWithFee("VL-1", "VL-2", 1.0, 0.0, "VL-FEE");
+        fee_balance = first->getBalance();
+    }
+    assert(fee_over == BankStatus::VelocityLimitExceeded);
+    assert(fee_within == BankStatus::Ok);
+    assert(post_over == BankStatus::VelocityLimitExceeded);
+    assert(post_within == BankStatus::Ok);
+    assert(after_limit == BankStatus::VelocityLimitExceeded);
+    assert(fee_balance == 9000.0);
+    std::cout << "OK Fee and posting velocity limits test passed" << std::endl;
+}
+void TestBankSystem::testClientSearch() {
+    std::cout << "\n--- Testing Client Search ---" << std::endl;
+
+    size_t by_prefix = 0;
+    size_t by_prefix_lower = 0;
+    size_t by_city = 0;
+    size_t by_country = 0;
+    size_t by_date = 0;
+    size_t after_delete = 0;
+    size_t limited = 0;
+    bool first_is_older = false;
+    {
+        QuietCout quiet;
+        Bank searchBank;
+        searchBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(10, 3, 2023));
+        searchBank.createClient(2, "Ivan", "Ivanov", Address("Nevsky 2", "Saint Petersburg", "Russia", 190000), Date(1, 1, 2024));
+        searchBank.createPremiumClient(3, "Petr", "Ivashin", Address("Tverskaya 3", "Moscow", "Russia", 101000), Date(15, 6, 2024));
+        searchBank.createClient(4, "John", "Smith", Address("Main St 4", "London", "UK", 10001), Date(20, 12, 2022));
+
+        by_prefix = searchBank.find_clients_by_surname_prefix("Ivan").size();
+        by_prefix_lower = searchBank.find_clients_by_surname_prefix("iva").size();
+        by_city = searchBank.find_clients_by_city("MOSCOW").size();
+        by_country = searchBank.find_clients_by_country("Russia").size();
+        auto range = searchBank.find_clients_registered_between(Date(1, 1, 2023), Date(1, 1, 2024));
+        by_date = range.size();
+        first_is_older = by_date == 2 && range[0]->getId() == 1 && range[1]->getId() == 2;
+        limited = searchBank.find_clients_by_country("Russia", 2).size();
+        searchBank.deleteClient(1);
+        after_delete = searchBank.find_clients_by_city("Moscow").size() + searchBank.find_clients_by_surname_prefix("Ivanova").size();
+    }
+    assert(by_prefix == 2 && by_prefix_lower == 3);
+    assert(by_city == 2 && by_country == 3);
+    assert(by_date == 2 && first_is_older);
+    assert(limited == 2);
+    assert(after_delete == 1);
+    std::cout << "OK Client search test passed" << std::endl;
+
+    // Test 2: the index agrees with a full scan after random inserts and deletes
+    const char* surnames[] = { "Ivanov", "Ivanova", "Petrov", "Petrova", "Sidorov", "Smith", "Smirnov", "Kuznetsov" };
+    const char* cities[] = { "Moscow", "Kazan", "Omsk", "Tomsk", "Perm" };
+    struct Row {
+        std::string surname;
+        std::string city;
+        int date;
+        bool alive;
+    };
+    std::vector<Row> rows;
+    ClientIndex index;
+    unsigned seed = 3;
+    for (int id = 1; id <= 3000; ++id) {
+        seed = seed * 1103515245u + 12345u;
+        Date date(1 + seed % 28, 1 + (seed >> 8) % 12, 2000 + (seed >> 12) % 20);
+        rows.push_back({ surnames[(seed >> 16) % 8], cities[(seed >> 20) % 5], ClientIndex::dateKey(date), true });
+        index.add(id, rows.back().surname, Address("Street", rows.back().city, "Russia", 1), date);
+        if (id % 3 == 0) {
+            int victim = 1 + static_cast<int>((seed >> 4) % id);
+            bool removed = index.remove(victim);
+            assert(removed == rows[victim - 1].alive);
+            rows[victim - 1].alive = false;
+        }
+    }
+    bool scan_ok = true;
+    const char* prefixes[] = { "Iv", "Ivanov", "Petrova", "Sm", "S", "X" };
+    for (const char* prefix : prefixes) {
+        size_t expected = 0;
+        for (const Row& row : rows) {
+            expected += row.alive && row.surname.compare(0, std::string(prefix).size(), prefix) == 0;
+        }
+        scan_ok = scan_ok && index.findBySurnamePrefix(prefix, rows.size()).size() == expected;
+    }
+    for (const char* city : cities) {
+        size_t expected = 0;
+        for (const Row& row : rows) {
+            expected += row.alive && row.city == city;
+        }
+        scan_ok = scan_ok && index.findByCity(city, rows.size()).size() == expected;
+    }
+    size_t expected_dates = 0;
+    for (const Row& row : rows) {
+        expected_dates += row.alive && row.date >= 20050301 && row.date <= 20101231;
+    }
+    scan_ok = scan_ok && index.findRegisteredBetween(Date(1, 3, 2005), Date(31, 12, 2010), rows.size()).size() == expected_dates;
+    scan_ok = scan_ok && index.findByCountry("russia", rows.size()).size() == index.size();
+    assert(scan_ok);
+    std::cout << "OK Client index vs full scan test passed" << std::endl;
+}
+void TestBankSystem::testClientStorage() {
+    std::cout << "\n--- Testing Client Storage ---" << std::endl;
+
+    // Test 1: packed values come back unchanged through the getters
+    PackedDate packed = PackedDate::pack(Date(31, 12, 2024));
+    Date unpacked = packed.unpack();
+    assert(unpacked.day == 31 && unpacked.month == 12 && unpacked.year == 2024);
+    assert(sizeof(PackedAddress) <= 24 && sizeof(PackedDate) == 4);
+
+    bool roundtrip = false;
+    bool shared_city = false;
+    bool updated = false;
+    bool invalid_date_thrown = false;
+    bool incomplete = false;
+    bool rejected_not_stored = false;
+    {
+        QuietCout quiet;
+        ClientStorage& storage = ClientStorage::instance();
+        Client first(1, "Anna", "Ivanova", Address("Nizhnyaya Krasnoselskaya 40", "Nizhny Novgorod", "Russia", 603000), Date(10, 3, 2023));
+        Address address = first.getAddress();
+        Date date = first.getRegistrationDate();
+        roundtrip = address.street == "Nizhnyaya Krasnoselskaya 40" && address.city == "Nizhny Novgorod" && address.country == "Russia"
+            && address.post_id == 603000 && date.day == 10 && date.month == 3 && date.year == 2023 && first.isAddressValid();
+
+        // Test 2: a repeated city or country does not add strings to the pool
+        size_t interned_before = storage.getInternedCount();
+        for (int id = 2; id < 1000; ++id) {
+            Client other(id, "Ivan", "Ivanov", Address("Street " + std::to_string(id), "Nizhny Novgorod", "Russia", 603000), Date(1, 1, 2024));
+        }
+        shared_city = storage.getInternedCount() == interned_before;
+
+        // Test 3: setters repack the values
+        first.setAddress(Address("Lenina 1", "Moscow", "Russia", 101000));
+        first.setRegistrationDate(Date(1, 2, 2024));
+        updated = first.getAddress().getFullAddress() == "Lenina 1, Moscow, Russia, 101000" && first.getRegistrationDate().getFormattedDate() == "1.2.2024";
+        try {
+            first.setRegistrationDate(Date(40, 2, 2024));
+        }
+        catch (const std::invalid_argument&) {
+            invalid_date_thrown = true;
+        }
+        first.setAddress(Address("", "Moscow", "Russia", 101000));
+        incomplete = !first.isAddressValid();
+
+        // Test 4: clients rejected by validation leave nothing in the pool and the arena
+        size_t interned = storage.getInternedCount();
+        size_t memory = storage.getMemoryUsage();
+        int rejected = 0;
+        for (int id = 0; id < 100; ++id) {
+            std::string unique = "Rejected " + std::to_string(id);
+            try {
+                if (id % 2 == 0) {
+                    Client bad(-id, "Ivan", "Ivanov", Address(unique, unique, unique, 1), Date(1, 1, 2024));
+                }
+                else {
+                    PremiumClient bad(id, "Ivan", "Ivanov", Address(unique, unique, unique, 1), Date(1, 1, 2024), "Bronze");
+                }
+            }
+            catch (const std::invalid_argument&) {
+                ++rejected;
+            }
+        }
+        rejected_not_stored = rejected == 100 && storage.getInternedCount() == interned && storage.getMemoryUsage() == memory;
+    }
+    assert(roundtrip);
+    std::cout << "OK Packed address and date test passed" << std::endl;
+    assert(shared_city);
+    std::cout << "OK City and country interning test passed" << std::endl;
+    assert(updated && invalid_date_thrown && incomplete);
+    std::cout << "OK Client setters test passed" << std::endl;
+    assert(rejected_not_stored);
+    std::cout << "OK Rejected clients storage test passed" << std::endl;
+}
+void TestBankSystem::testEntityLinks() {
+    std::cout << "\n--- Testing Entity Links ---" << std::endl;
+
+    bool client_links = false;
+    bool history_links = false;
+    bool rollback_clean = false;
+    bool delete_links = false;
+    bool slot_reuse = false;
+    bool external_owner = false;
+    {
+        QuietCout quiet;
+        Bank linkBank;
+        linkBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        linkBank.createClient(2, "Ivan", "Ivanov", Address("Nevsky 2", "Saint Petersburg", "Russia", 190000), Date(1, 1, 2024));
+        linkBank.createSavAccount("LK-1", 1, 10000.0, 12);
+        auto empty = linkBank.createCheckAccount("LK-2", 1, 0.0);
+        linkBank.createSavAccount("LK-3", 2, 10000.0, 12);
+
+        // Test 1: client -> accounts in opening order
+        auto accounts = linkBank.get_client_accounts(1);
+        client_links = accounts.size() == 2 && accounts[0]->getAccountNumber() == "LK-1" && accounts[1]->getAccountNumber() == "LK-2"
+            && linkBank.get_client_accounts(2).size() == 1 && linkBank.get_client_accounts(99).empty();
+
+        // Test 2: account -> its own history records
+        linkBank.registerDeposit(linkBank.find_acc_by_number("LK-1"), 500.0);
+        linkBank.transfer("LK-1", "LK-3", 200.0);
+        auto history = linkBank.get_account_transactions("LK-1");
+        history_links = history.size() == 2 && history[0]->getType() == "DEPOSIT" && history[1]->getType() == "TRANSFER_OUT"
+            && linkBank.get_account_transactions("LK-3").size() == 1 && linkBank.getTransactionCount() == 3;
+
+        // Test 3: a rolled back posting leaves no history behind
+        Posting posting;
+        posting.credit(linkBank.find_acc_by_number("LK-3"), 100.0, "TRANSFER_IN", "LK-1");
+        posting.debit(linkBank.find_acc_by_number("LK-1"), 1000000.0, "TRANSFER_OUT", "LK-3");
+        rollback_clean = linkBank.post(posting) == BankStatus::InsufficientFunds && linkBank.getTransactionCount() == 3
+            && linkBank.get_account_transactions("LK-3").size() == 1;
+
+        // Test 4: deleting an account unlinks it from the client; the client goes once it has no accounts
+        bool blocked = !linkBank.deleteClient(2);
+        bool deleted = linkBank.deleteAccount("LK-2");
+        delete_links = blocked && deleted && linkBank.get_client_accounts(1).size() == 1 && linkBank.getTransactionCount() == 3;
+
+        // Test 5: a reused slot starts with empty links
+        linkBank.createCheckAccount("LK-4", 2, 0.0);
+        slot_reuse = linkBank.get_account_transactions("LK-4").empty() && linkBank.get_client_accounts(2).size() == 2
+            && linkBank.get_client_accounts(1).size() == 1;
+
+        // the caller's shared_ptr keeps a deleted account alive
+        external_owner = empty->getAccountNumber() == "LK-2" && !linkBank.find_acc_by_number("LK-2");
+    }
+    assert(client_links);
+    std::cout << "OK Client accounts links test passed" << std::endl;
+    assert(history_links && rollback_clean);
+    std::cout << "OK Account history links test passed" << std::endl;
+    assert(delete_links && slot_reuse && external_owner);
+    std::cout << "OK Delete and slot reuse test passed" << std::endl;
+}
+void TestBankSystem::testBulkLoader() {
+    std::cout << "\n--- Testing Bulk Loader ---" << std::endl;
+
+    // Test 1: invalid rows, duplicates and unknown clients are reported with their line numbers
+    size_t loaded = 0;
+    size_t failed = 0;
+    size_t clients = 0;
+    size_t accounts = 0;
+    double balance = 0;
+    double cash = 0;
+    std::string report;
+    {
+        QuietCout quiet;
+        Bank bulkBank;
+        std::ostringstream errors;
+        BulkLoader loader(bulkBank, errors, 4);
+        loaded = loader.load(
+            "# migration\n"
+            "CLIENT,1,Anna,Ivanova,Lenina 1,Moscow,Russia,101000,5,3,2024\n"
+            "PREMIUM,2,Petr,Petrov,Tverskaya 2,Moscow,Russia,101001,6,3,2024,Gold\n"
+            "CLIENT,1,Anna,Copy,Lenina 1,Moscow,Russia,101000,5,3,2024\n"
+            "CLIENT,3,Ivan,Sidorov,Nevsky 3,Saint Petersburg,Russia,190000,31,13,2024\n"
+            "PREMIUM,4,Olga,Orlova,Arbat 4,Moscow,Russia,101002,1,1,2024,Bronze\n"
+            "SAVINGS,BL-SAV,1,10000,6\n"
+            "CHECKING,BL-CHK,2,1500.50\r\n"
+            "\n"
+            "CHECKING,BL-CHK,1,10\n"
+            "CHECKING,BL-NOCLIENT,99,10\n"
+            "SAVINGS,BL-LOW,1,100,6\n"
+            "DEPOSIT,BL-CHK,100\n"
+            "CHECKING,BL-EARLY,5,20\n"
+            "CLIENT,5,Late,Client,Street 5,Kazan,Russia,420000,1,2,2024");
+        failed = loader.getFailedCount();
+        clients = bulkBank.getClientsCount();
+        accounts = bulkBank.getAccountCount();
+        balance = bulkBank.find_acc_by_number("BL-CHK")->getBalance();
+        for (const auto& row : bulkBank.trial_balance()) {
+            if (row.accountNumber == "@CASH") {
+                cash = row.balance;
+            }
+        }
+        report = errors.str();
+    }
+    assert(loaded == 6 && failed == 7);
+    assert(clients == 3 && accounts == 3);
+    assert(balance == 1500.5 && cash == -11520.5);
+    const char* expected_lines[] = { "line 4:", "line 5:", "line 6:", "line 10:", "line 11:", "line 12:", "line 13:" };
+    for (const char* line : expected_lines) {
+        assert(report.find(line) != std::string::npos);
+    }
+    assert(report.find("line 4: You already have this client in bank") != std::string::npos);
+    assert(report.find("line 10: You already have an account with this number") != std::string::npos);
+    assert(report.find("line 11: Client with id 99 not found") != std::string::npos);
+    assert(report.find("line 4:") < report.find("line 13:")); // ошибки по порядку строк
+    std::cout << "OK Bulk loader validation test passed" << std::endl;
+
+    // Test 2: a file split into several chunks gives the same bank as per-row creation
+    std::string csv;
+    const int rows = 6000;
+    for (int id = 1; id <= rows; ++id) {
+        csv += (id % 5 == 0 ? "PREMIUM," : "CLIENT,") + std::to_string(id) + ",Name" + std::to_string(id) + ",Surname" + std::to_string(id % 97)
+            + ",Street " + std::to_string(id) + ",City" + std::to_string(id % 13) + ",Country,100000," + std::to_string(1 + id % 28) + ",5,2020"
+            + (id % 5 == 0 ? ",Platinum\n" : "\n");
+        csv += "CHECKING,BULK-C" + std::to_string(id) + "," + std::to_string(id) + "," + std::to_string(id % 1000) + ".25\n";
+        if (id % 3 == 0) {
+            csv += "SAVINGS,BULK-S" + std::to_string(id) + "," + std::to_string(id) + "," + std::to_string(5000 + id) + ",12\n";
+        }
+    }
+    csv += "CHECKING,BULK-C7,8,1\n"; // дубликат в последнем куске
+
+    const std::string path = "test_bulk_import.csv";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << csv;
+    }
+    bool same_bank = true;
+    size_t bulk_failed = 0;
+    size_t bulk_clients = 0;
+    {
+        QuietCout quiet;
+        Bank bulkBank;
+        Bank referenceBank;
+        std::ostringstream errors;
+        BulkLoader loader(bulkBank, errors, 4);
+        loader.loadFile(path);
+        bulk_failed = loader.getFailedCount();
+        bulk_clients = loader.getClientCount();
+
+        std::istringstream script(csv);
+        std::ostringstream reference_errors;
+        BatchProcessor batch(referenceBank, reference_errors);
+        batch.run(script);
+
+        same_bank = bulkBank.getClientsCount() == referenceBank.getClientsCount()
+            && bulkBank.getAccountCount() == referenceBank.getAccountCount()
+            && errors.str() == reference_errors.str();
+        for (int id = 1; id <= rows && same_bank; id += 7) {
+            auto bulk = bulkBank.get_client_accounts(id);
+            auto reference = referenceBank.get_client_accounts(id);
+            same_bank = bulk.size() == reference.size();
+            for (size_t i = 0; i < bulk.size() && same_bank; ++i) {
+                same_bank = bulk[i]->getAccountNumber() == reference[i]->getAccountNumber()
+                    && bulk[i]->getBalance() == reference[i]->getBalance() && bulk[i]->getType() == reference[i]->getType();
+            }
+        }
+        auto bulk_trial = bulkBank.trial_balance();
+        auto reference_trial = referenceBank.trial_balance();
+        same_bank = same_bank && bulk_trial.size() == reference_trial.size();
+        for (size_t i = 0; i < bulk_trial.size() && same_bank; ++i) {
+            same_bank = bulk_trial[i].accountNumber == reference_trial[i].accountNumber
+                && std::abs(bulk_trial[i].balance - reference_trial[i].balance) < 0.005;
+        }
+        same_bank = same_bank && bulkBank.find_clients_by_city("City3").size() == referenceBank.find_clients_by_city("City3").size()
+            && bulkBank.find_clients_by_surname_prefix("Surname4", 1000).size() == referenceBank.find_clients_by_surname_prefix("Surname4", 1000).size();
+    }
+    std::remove(path.c_str());
+    assert(csv.size() > 4 * 64 * 1024); // файл действительно делится на 4 куска
+    assert(bulk_clients == rows && bulk_failed == 1);
+    assert(same_bank);
+    std::cout << "OK Bulk loader chunked import test passed" << std::endl;
+}
+void TestBankSystem::testStatements() {
+    std::cout << "\n--- Testing Account Statements ---" << std::endl;
+
+    // Test 1: opening, running and closing balances for a period, commission as its own line
+    Ledger ledger;
+    uint32_t a = ledger.accountIndex("ST-A");
+    uint32_t b = ledger.accountIndex("ST-B");
+    ledger.post(Ledger::OPEN, std::vector<Ledger::Leg>{ { Ledger::CASH, -10000, Ledger::PRINCIPAL }, { a, 10000, Ledger::PRINCIPAL } }.data(), 2, 100);
+    ledger.post(Ledger::DEPOSIT, std::vector<Ledger::Leg>{ { Ledger::CASH, -5000, Ledger::PRINCIPAL }, { a, 5000, Ledger::PRINCIPAL } }.data(), 2, 200);
+    ledger.post(Ledger::TRANSFER, std::vector<Ledger::Leg>{ { a, -3000, Ledger::PRINCIPAL }, { a, -100, Ledger::COMMISSION },
+        { Ledger::COMMISSION_INCOME, 100, Ledger::COMMISSION }, { b, 3000, Ledger::PRINCIPAL } }.data(), 4, 300);
+    ledger.post(Ledger::WITHDRAW, std::vector<Ledger::Leg>{ { a, -1000, Ledger::PRINCIPAL }, { Ledger::CASH, 1000, Ledger::PRINCIPAL } }.data(), 2, 400);
+
+    StatementEngine engine(ledger);
+    std::ostringstream text_a;
+    StatementSummary summary_a;
+    {
+        StatementSink sink(text_a, 256); // маленький буфер: выписка уходит в поток несколькими блоками
+        summary_a = engine.write(a, 150, 350, sink);
+    }
+    assert(summary_a.opening == 10000 && summary_a.closing == 11900);
+    assert(summary_a.credits == 5000 && summary_a.debits == 3100 && summary_a.lines == 3);
+    assert(text_a.str().find("Opening balance: 100.00\n") != std::string::npos);
+    assert(text_a.str().find("DEPOSIT  +50.00  150.00\n") != std::string::npos);
+    assert(text_a.str().find("TRANSFER to ST-B  -30.00  120.00\n") != std::string::npos);
+    assert(text_a.str().find("COMMISSION  -1.00  119.00\n") != std::string::npos);
+    assert(text_a.str().find("WITHDRAW") == std::string::npos); // после конца периода
+    assert(text_a.str().find("Closing balance: 119.00\n") != std::string::npos);
+
+    std::ostringstream text_b;
+    StatementSummary summary_b;
+    {
+        StatementSink sink(text_b);
+        summary_b = engine.write(b, 0, 1000, sink);
+    }
+    assert(summary_b.opening == 0 && summary_b.closing == 3000 && summary_b.lines == 1);
+    assert(text_b.str().find("TRANSFER from ST-A  +30.00  30.00\n") != std::string::npos);
+    std::cout << "OK Statement balances test passed" << std::endl;
+
+    // Test 2: bank statements agree with account balances; month-end run writes every account exactly once
+    std::time_t now = std::time(nullptr);
+    std::tm local_now;
+    localtime_s(&local_now, &now);
+    const int accounts = 40;
+    bool balances_match = true;
+    size_t statements = 0;
+    std::string all_text;
+    bool missing_rejected = false;
+    const std::string prefix = "test_statements";
+    {
+        QuietCout quiet;
+        Bank statementBank;
+        statementBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        for (int i = 0; i < accounts; ++i) {
+            statementBank.createCheckAccount("STM" + std::to_string(i), 1, 1000.0 + i);
+        }
+        for (int i = 0; i < 400; ++i) {
+            statementBank.transfer("STM" + std::to_string(i % accounts), "STM" + std::to_string((i * 7 + 3) % accounts), 5.0 + i % 10);
+            statementBank.registerDeposit(statementBank.find_acc_by_number("STM" + std::to_string(i % 13)), 2.5);
+        }
+        // книга хранит каждую ногу в копейках, комиссия счета в double может иметь доли копейки
+        auto trial = statementBank.trial_balance();
+        for (int i = 0; i < accounts && balances_match; ++i) {
+            std::ostringstream text;
+            std::string number = "STM" + std::to_string(i);
+            StatementSummary summary = statementBank.write_statement(number, 0, now + 3600, text);
+            uint32_t index = 0;
+            statementBank.getLedger().findAccount(number, index);
+            balances_match = summary.opening == 0 && summary.closing == Ledger::toCents(trial[index].balance)
+                && std::abs(Ledger::fromCents(summary.closing) - statementBank.find_acc_by_number(number)->getBalance()) < 1.0;
+        }
+        try {
+            std::ostringstream text;
+            statementBank.write_statement("NO_SUCH", 0, now, text);
+        }
+        catch (const std::invalid_argument&) {
+            missing_rejected = true;
+        }
+
+        statements = statementBank.write_month_end_statements(local_now.tm_year + 1900, local_now.tm_mon + 1, prefix, 3);
+        for (int worker = 0; worker < 3; ++worker) {
+            std::string path = prefix + "_" + std::to_string(worker) + ".txt";
+            std::ifstream file(path, std::ios::binary);
+            std::ostringstream content;
+            content << file.rdbuf();
+            all_text += content.str();
+            file.close();
+            std::remove(path.c_str());
+        }
+    }
+    assert(balances_match && missing_rejected);
+    assert(statements == accounts);
+    for (int i = 0; i < accounts; ++i) {
+        std::string header = "STATEMENT STM" + std::to_string(i) + "\n";
+        size_t first = all_text.find(header);
+        assert(first != std::string::npos && all_text.find(header, first + 1) == std::string::npos);
+    }
+    std::cout << "OK Month-end statements test passed" << std::endl;
+
+    // Test 3: a snapshot keeps its bounds while the ledger grows past several column blocks
+    Ledger growing;
+    uint32_t c = growing.accountIndex("ST-C");
+    growing.post(Ledger::OPEN, std::vector<Ledger::Leg>{ { Ledger::CASH, -10000, Ledger::PRINCIPAL }, { c, 10000, Ledger::PRINCIPAL } }.data(), 2, 100);
+    Ledger::Snapshot bound = growing.snapshot();
+    for (int i = 0; i < 5000; ++i) {
+        uint32_t other = growing.accountIndex("ST-N" + std::to_string(i));
+        growing.post(Ledger::TRANSFER, std::vector<Ledger::Leg>{ { c, -1, Ledger::PRINCIPAL }, { other, 1, Ledger::PRINCIPAL } }.data(), 2, 200);
+    }
+    StatementSummary old_summary;
+    StatementSummary new_summary;
+    {
+        std::ostringstream text;
+        StatementSink sink(text);
+        old_summary = StatementEngine(growing, bound).write(c, 0, 1000, sink);
+        new_summary = StatementEngine(growing).write(c, 0, 1000, sink);
+    }
+    assert(old_summary.closing == 10000 && old_summary.lines == 1);
+    assert(new_summary.closing == 5000 && new_summary.lines == 5001);
+    assert(growing.totalOfAllEntries() == 0 && growing.trialBalance()[c] == 5000);
+    std::cout << "OK Statement snapshot test passed" << std::endl;
+
+    // Test 4: transfers keep running while the month-end run writes statements
+    size_t busy_statements = 0;
+    int busy_transfers = 0;
+    {
+        QuietCout quiet;
+        Bank busyBank;
+        busyBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        for (int i = 0; i < accounts; ++i) {
+            busyBank.createCheckAccount("BSY" + std::to_string(i), 1, 1000.0);
+        }
+        std::atomic<bool> done{ false };
+        std::thread writer([&]() {
+            for (int i = 0; !done.load() || i < 100; ++i) {
+                busyBank.transfer("BSY" + std::to_string(i % accounts), "BSY" + std::to_string((i + 1) % accounts), 1.0);
+                ++busy_transfers;
+            }
+        });
+        busy_statements = busyBank.write_month_end_statements(local_now.tm_year + 1900, local_now.tm_mon + 1, prefix + "_busy", 2);
+        done = true;
+        writer.join();
+        for (int worker = 0; worker < 2; ++worker) {
+            std::remove((prefix + "_busy_" + std::to_string(worker) + ".txt").c_str());
+        }
+        assert(busyBank.getLedger().totalOfAllEntries() == 0);
+    }
+    assert(busy_statements == accounts && busy_transfers >= 100);
+    std::cout << "OK Statements without bank lock test passed" << std::endl;
+
+    // Test 5: a month-end run that cannot write its files fails instead of reporting success
+    bool write_failed = false;
+    {
+        QuietCout quiet;
+        Bank failBank;
+        failBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        failBank.createCheckAccount("FAIL0", 1, 1000.0);
+        try {
+            failBank.write_month_end_statements(local_now.tm_year + 1900, local_now.tm_mon + 1, "no_such_directory/statements", 2);
+        }
+        catch (const std::runtime_error&) {
+            write_failed = true;
+        }
+    }
+    assert(write_failed);
+    std::cout << "OK Statement write failure test passed" << std::endl;
+}
+void TestBankSystem::testMetrics() {
+    std::cout << "\n--- Testing Metrics ---" << std::endl;
+
+    // Test 1: histogram buckets cover every value with at most 1/16 relative error
+    for (uint64_t value = 0; value < 5000000; value = value * 3 / 2 + 1) {
+        size_t bucket = LatencyHistogram::bucketOf(value);
+        assert(bucket < LatencyHistogram::BUCKETS);
+        assert(LatencyHistogram::lowerBound(bucket) <= value && value < LatencyHistogram::lowerBound(bucket + 1));
+        assert(value - LatencyHistogram::lowerBound(bucket) <= value / 16);
+    }
+    assert(LatencyHistogram::bucketOf(LatencyHistogram::MAX_VALUE) == LatencyHistogram::BUCKETS - 1);
+    assert(LatencyHistogram::bucketOf(UINT64_MAX) == LatencyHistogram::BUCKETS - 1);
+    std::cout << "OK Histogram buckets test passed" << std::endl;
+
+    if (!Metrics::enabled()) {
+        std::cout << "OK Metrics disabled in this build, recording test skipped" << std::endl;
+        return;
+    }
+
+    // Test 2: bank operations are recorded, records of finished threads are kept
+    Metrics::reset();
+    {
+        QuietCout quiet;
+        Bank metricsBank;
+        metricsBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        metricsBank.createSavAccount("MT1", 1, 100000.0, 12);
+        metricsBank.createSavAccount("MT2", 1, 5000.0, 12);
+        for (int i = 0; i < 100; ++i) {
+            metricsBank.tryTransfer("MT1", "MT2", 10.0);
+        }
+        metricsBank.tryTransfer("MT2", "MT1", 1000000.0); // недостаточно средств
+        metricsBank.registerDeposit(metricsBank.find_acc_by_number("MT1"), 5.0);
+    }
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([]() {
+            for (int i = 0; i < 1000; ++i) {
+                Metrics::record(Metric::WITHDRAW, Metrics::Clock::now() - std::chrono::microseconds(50));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    MetricsSnapshot data = Metrics::snapshot();
+    const LatencyHistogram& transfers = data.histograms[static_cast<size_t>(Metric::TRANSFER)];
+    const LatencyHistogram& withdrawals = data.histograms[static_cast<size_t>(Metric::WITHDRAW)];
+    assert(transfers.count == 101 && data.histograms[static_cast<size_t>(Metric::TRANSFER_LOOKUP)].count == 101);
+    assert(data.histograms[static_cast<size_t>(Metric::POSTING_APPLY)].count == 101);
+    assert(data.histograms[static_cast<size_t>(Metric::POSTING_PUBLISH)].count == 100);
+    assert(data.histograms[static_cast<size_t>(Metric::DEPOSIT)].count == 1);
+    assert(data.counters[static_cast<size_t>(Counter::TRANSFER_DECLINED)] == 1);
+    assert(data.counters[static_cast<size_t>(Counter::POSTING_ROLLBACK)] == 1);
+    assert(transfers.percentile(0.5) <= transfers.percentile(0.99) && transfers.percentile(0.99) <= transfers.max);
+    assert(withdrawals.count == 4000 && withdrawals.percentile(0.5) >= 47000 && withdrawals.sum >= 4000u * 50000u);
+
+    std::ostringstream json;
+    Metrics::writeJson(json);
+    assert(json.str().find("\"transfer\":{\"count\":101,") != std::string::npos);
+    assert(json.str().find("\"transfer.declined\":1") != std::string::npos);
+
+    Metrics::reset();
+    assert(Metrics::snapshot().histograms[static_cast<size_t>(Metric::WITHDRAW)].count == 0);
+    std::cout << "OK Operation metrics test passed" << std::endl;
+}
+void TestBankSystem::testMoveSemantics() {
+    std::cout << "\n--- Testing Move Semantics ---" << std::endl;
+
+    // длинные строки (без SSO): перемещение передает тот же буфер, копия - новый
+    const std::string long_number = "DE89370400440532013000";
+
+    // Test 1: sink parameters move strings into the record, getters return references
+    std::string acc1 = long_number;
+    std::string acc2 = long_number + "-2";
+    const char* acc1_data = acc1.data();
+    const char* acc2_data = acc2.data();
+    Transaction record("TRANSFER_OUT", 10.0, std::move(acc1), std::move(acc2));
+    assert(record.getAcc1().data() == acc1_data && record.getAcc2().data() == acc2_data);
+    assert(&record.getAcc1() == &record.getAcc1());
+    std::string bad_type = "NOT_A_TYPE_FOR_TRANSACTIONS";
+    bool thrown = false;
+    try {
+        Transaction invalid(bad_type, 10.0, long_number);
+    }
+    catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown && bad_type == "NOT_A_TYPE_FOR_TRANSACTIONS"); // lvalue копируется, а не перемещается
+    std::cout << "OK Transaction sink parameters test passed" << std::endl;
+
+    // Test 2: client names are moved from temporaries through Bank::createClient
+    Bank moveBank;
+    std::string surname = "Konstantinopolskaya-Rimskaya";
+    const char* surname_data = surname.data();
+    auto client = moveBank.createClient(1, "Anna", std::move(surname), Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+    assert(client->getSurname().data() == surname_data);
+    auto account = moveBank.createCheckAccount(long_number, 1, 1000.0);
+    auto other = moveBank.createCheckAccount(long_number + "-2", 1, 0.0);
+    assert(&account->getAccountNumber() == &account->getAccountNumber() && account->getAccountNumber() == long_number);
+    std::cout << "OK Client sink parameters test passed" << std::endl;
+
+    // Test 3: a reused posting releases its accounts on clear and keeps leg capacity
+    long references = account.use_count();
+    Posting posting;
+    posting.debit(account, 1.0, "TRANSFER_OUT", long_number + "-2");
+    posting.credit(other, 1.0, "TRANSFER_IN", long_number);
+    assert(posting.getLegs().size() == 2 && account.use_count() == references + 1);
+    const char* counterpart_data = posting.getLegs()[0].counterpart.data();
+    posting.clear();
+    assert(posting.getLegs().empty() && account.use_count() == references);
+    posting.debit(account, 1.0, "TRANSFER_OUT", long_number + "-2");
+    assert(posting.getLegs()[0].counterpart.data() == counterpart_data);
+    posting.clear();
+    std::cout << "OK Posting reuse test passed" << std::endl;
+
+    // Test 4: recycled balance versions keep snapshots consistent
+    for (int i = 0; i < 200; ++i) {
+        const BankStatus moved_out = moveBank.tryTransfer(long_number, long_number + "-2", 1.0);
+        assert(moved_out == BankStatus::Ok);
+        const BankStatus moved_back = moveBank.tryTransfer(long_number + "-2", long_number, 0.5);
+        assert(moved_back == BankStatus::Ok);
+    }
+    double total = 0;
+    for (const auto& item : moveBank.snapshot_balances()) {
+        total += item.balance;
+    }
+    assert(total == account->getBalance() + other->getBalance() && std::abs(other->getBalance() - 100.0) < 0.01);
+    assert(moveBank.get_account_transactions(long_number).size() == 400);
+    std::cout << "OK Balance version reuse test passed" << std::endl;
+}
+void TestBankSystem::testMultiCurrency() {
+    std::cout << "\n--- Testing Multi-Currency Accounts ---" << std::endl;
+
+    Bank fxBank;
+    fxBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+    auto rub = fxBank.createCheckAccount("FX-RUB", 1, 100000.0);
+    auto usd = fxBank.createCheckAccount("FX-USD", 1, 1000.0, 0, "USD");
+    auto eur = fxBank.createSavAccount("FX-EUR", 1, 10000.0, 12, "EUR");
+    assert(rub->getCurrency() == "RUB" && usd->getCurrency() == "USD" && eur->getCurrency() == "EUR");
+
+    // Test 1: no rate yet - cross-currency transfer is declined without changes
+    const BankStatus unsupported = fxBank.tryTransfer("FX-RUB", "FX-USD", 900.0);
+    assert(unsupported == BankStatus::CurrencyNotSupported);
+    bool thrown = false;
+    try {
+        fxBank.transfer("FX-RUB", "FX-USD", 900.0);
+    }
+    catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown && rub->getBalance() == 100000.0 && usd->getBalance() == 1000.0);
+    std::cout << "OK Missing rate test passed" << std::endl;
+
+    // Test 2: conversion at the current version, recorded on both history records
+    uint64_t version = fxBank.getFxRates().setRates({ { "USD", 90.0 }, { "EUR", 99.0 } });
+    assert(version == 1 && fxBank.getFxRates().getVersion() == 1);
+    fxBank.transfer("FX-RUB", "FX-USD", 900.0);
+    assert(rub->getBalance() <= 99100.0 && usd->getBalance() == 1010.0); // комиссия расчетного счета - в рублях
+    auto history = fxBank.get_account_transactions("FX-USD");
+    assert(history.size() == 1 && history[0]->getSumma() == 10.0 && history[0]->getFxVersion() == 1);
+    assert(fxBank.get_account_transactions("FX-RUB")[0]->getFxVersion() == 1);
+
+    const auto rate_version = fxBank.getFxRates().setRate("USD", 100.0);
+    assert(rate_version == 2);
+    const BankStatus cross_rate = fxBank.tryTransfer("FX-EUR", "FX-USD", 100.0);
+    assert(cross_rate == BankStatus::Ok); // кросс-курс 0.99
+    assert(std::abs(usd->getBalance() - 1109.0) < 1e-9);
+    assert(fxBank.get_account_transactions("FX-EUR")[0]->getFxVersion() == 2);
+    fxBank.transfer("FX-USD", "FX-RUB", 9.0);
+    assert(fxBank.get_account_transactions("FX-RUB").back()->getFxVersion() == 2);
+    std::cout << "OK Conversion at rate version test passed" << std::endl;
+
+    // Test 3: same currency keeps version 0, fee transfers and postings do not mix currencies
+    auto rub2 = fxBank.createCheckAccount("FX-RUB-2", 1, 0.0);
+    fxBank.transfer("FX-RUB", "FX-RUB-2", 100.0);
+    assert(fxBank.get_account_transactions("FX-RUB-2")[0]->getFxVersion() == 0 && rub2->getBalance() == 100.0);
+    const BankStatus mixed_fee = fxBank.tryTransferWithFee("FX-RUB", "FX-USD", 100.0, 1.0, "FX-RUB-2");
+    assert(mixed_fee == BankStatus::CurrencyMismatch);
+    Posting posting;
+    posting.debit(rub, 100.0, "TRANSFER_OUT", "FX-USD");
+    posting.credit(usd, 100.0, "TRANSFER_IN", "FX-RUB");
+    const BankStatus mixed_posting = fxBank.post(posting);
+    assert(mixed_posting == BankStatus::CurrencyMismatch);
+    std::cout << "OK Currency mismatch test passed" << std::endl;
+
+    // Test 4: each currency balances in the ledger through the bank's position account @FX-<code>
+    int64_t usd_position = 0;
+    int64_t rub_position = 0;
+    for (const auto& row : fxBank.trial_balance()) {
+        if (row.accountNumber == "@FX-USD") {
+            usd_position = Ledger::toCents(row.balance);
+        }
+        if (row.accountNumber == "@FX-RUB") {
+            rub_position = Ledger::toCents(row.balance);
+        }
+    }
+    assert(usd_position == -(1000 + 9900) + 900 && rub_position == -90000 + 900 * 100);
+    assert(fxBank.getLedger().totalOfAllEntries() == 0);
+    std::cout << "OK Ledger currency positions test passed" << std::endl;
+
+    // Test 5: invalid codes and rates are rejected
+    thrown = false;
+    try {
+        fxBank.createCheckAccount("FX-BAD", 1, 0.0, 0, "usd");
+    }
+    catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown && !fxBank.find_acc_by_number("FX-BAD"));
+    const BankStatus bad_currency = fxBank.tryCreateCheckAccount("FX-BAD", 1, 0.0, 0, "US").getStatus();
+    assert(bad_currency == BankStatus::InvalidAccountData);
+    thrown = false;
+    try {
+        fxBank.getFxRates().setRate("GBP", -1.0);
+    }
+    catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown && fxBank.getFxRates().getVersion() == 2);
+    std::cout << "OK Invalid currency test passed" << std::endl;
+
+    // Test 6: readers see whole versions while rates are replaced concurrently
+    FxRateTable table;
+    std::atomic<bool> done{ false };
+    std::atomic<size_t> torn{ 0 };
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t) {
+        readers.emplace_back([&]() {
+            while (!done.load()) {
+                FxRateTable::Reader rates = table.read();
+                double usd_rate = 0;
+                double eur_rate = 0;
+                if (rates->rateOf("USD", usd_rate) && rates->rateOf("EUR", eur_rate)
+                    && (usd_rate != static_cast<double>(rates->getVersion()) || eur_rate != usd_rate + 0.5)) {
+                    ++torn;
+                }
+            }
+        });
+    }
+    for (int i = 1; i <= 20000; ++i) {
+        table.setRates({ { "USD", static_cast<double>(i) }, { "EUR", i + 0.5 } });
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    assert(torn.load() == 0 && table.getVersion() == 20000);
+    table.setRate("USD", 1.0); // читателей нет - все старые версии освобождаются
+    assert(table.getRetiredCount() == 0);
+    std::cout << "OK Concurrent rate updates test passed" << std::endl;
+
+    // Test 7: batch mode sets rates and opens accounts in a currency
+    Bank batchBank;
+    std::ostringstream errors;
+    BatchProcessor batch(batchBank, errors);
+    std::istringstream script(
+        "CLIENT,1,Anna,Ivanova,Lenina 1,Moscow,Russia,101000,1,1,2024\n"
+        "FXRATE,USD,80\n"
+        "CHECKING,B-RUB,1,8000\n"
+        "CHECKING,B-USD,1,0,USD\n"
+        "TRANSFER,B-RUB,B-USD,800\n");
+    size_t done_commands = batch.run(script);
+    assert(done_commands == 5 && errors.str().empty());
+    assert(batchBank.find_acc_by_number("B-USD")->getBalance() == 10.0);
+    std::cout << "OK Batch currency commands test passed" << std::endl;
+}
+
+void TestBankSystem::testAccountGroups() {
+    std::cout << "\n--- Testing Account Groups ---" << std::endl;
+
+    Bank groupBank;
+    groupBank.createClient(1, "Holding", "Corp", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+    groupBank.createClient(2, "Other", "Client", Address("Lenina 2", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+    auto sales1 = groupBank.createSavAccount("GR-SALES-1", 1, 10000.0, 12);
+    auto sales2 = groupBank.createSavAccount("GR-SALES-2", 1, 20000.0, 12);
+    auto ops = groupBank.createSavAccount("GR-OPS", 1, 6000.0, 12);
+    auto opsEu = groupBank.createSavAccount("GR-OPS-EU", 1, 5000.0, 12);
+    auto loose = groupBank.createSavAccount("GR-LOOSE", 1, 5000.0, 12);
+    groupBank.createCheckAccount("GR-OTHER", 2, 0.0);
+    groupBank.createSavAccount("GR-USD", 1, 5000.0, 12, "USD");
+
+    // Test 1: tree Holding -> Sales, Ops -> Ops-EU; totals include subgroups
+    uint32_t holding = groupBank.createAccountGroup(1, "Holding");
+    uint32_t sales = groupBank.createAccountGroup(1, "Sales", holding);
+    uint32_t opsGroup = groupBank.createAccountGroup(1, "Ops", holding);
+    uint32_t opsEuGroup = groupBank.createAccountGroup(1, "Ops-EU", opsGroup);
+    groupBank.assignAccountToGroup("GR-SALES-1", sales);
+    groupBank.assignAccountToGroup("GR-SALES-2", sales);
+    groupBank.assignAccountToGroup("GR-OPS", opsGroup);
+    groupBank.assignAccountToGroup("GR-OPS-EU", opsEuGroup);
+    assert(groupBank.getGroupTotal(holding) == 41000.0);
+    assert(groupBank.getGroupTotal(sales) == 30000.0);
+    assert(groupBank.getGroupTotal(opsGroup) == 11000.0);
+    assert(groupBank.getGroupTotal(opsEuGroup) == 5000.0);
+    assert(groupBank.get_group_accounts(holding).size() == 4 && groupBank.get_consolidated_accounts(1).size() == 4);
+    std::cout << "OK Group tree totals test passed" << std::endl;
+
+    // Test 2: totals follow transfers, including transfers to an ungrouped account
+    groupBank.transfer("GR-SALES-1", "GR-OPS-EU", 100.0);
+    groupBank.transfer("GR-SALES-2", "GR-LOOSE", 500.0);
+    const BankStatus ops_deposit = groupBank.tryDeposit(ops, 60.0);
+    assert(ops_deposit == BankStatus::Ok);
+    double manual = 0;
+    for (const auto& account : groupBank.get_group_accounts(holding)) {
+        manual += account->getBalance();
+    }
+    assert(groupBank.getGroupTotal(holding) == manual && manual == 40560.0);
+    assert(groupBank.getGroupTotal(sales) == sales1->getBalance() + sales2->getBalance());
+    assert(groupBank.getGroupTotal(opsGroup) == ops->getBalance() + opsEu->getBalance() && opsEu->getBalance() == 5100.0);
+    assert(loose->getBalance() == 5500.0);
+    std::cout << "OK Totals after postings test passed" << std::endl;
+
+    // Test 3: range sums in the order of get_group_accounts / get_consolidated_accounts
+    auto accounts = groupBank.get_consolidated_accounts(1);
+    assert(groupBank.getClientRangeTotal(1, 1, 3) == accounts[1]->getBalance() + accounts[2]->getBalance());
+    assert(groupBank.getGroupRangeTotal(opsGroup, 0, 1) == groupBank.get_group_accounts(opsGroup)[0]->getBalance());
+    assert(groupBank.getGroupRangeTotal(sales, 1, 100) == groupBank.get_group_accounts(sales)[1]->getBalance());
+    assert(groupBank.getClientRangeTotal(2, 0, 10) == 0.0);
+    std::cout << "OK Range totals test passed" << std::endl;
+
+    // Test 4: moving and deleting accounts updates totals
+    groupBank.assignAccountToGroup("GR-OPS-EU", sales);
+    assert(groupBank.getGroupTotal(sales) == 34500.0 && groupBank.getGroupTotal(opsGroup) == 6060.0);
+    assert(groupBank.getGroupTotal(holding) == 40560.0);
+    groupBank.removeAccountFromGroup("GR-OPS");
+    assert(groupBank.getGroupTotal(opsGroup) == 0.0 && groupBank.getGroupTotal(holding) == 34500.0);
+    const BankStatus sales_withdraw = groupBank.tryWithdraw(sales2, 500.0);
+    assert(sales_withdraw == BankStatus::Ok);
+    groupBank.createCheckAccount("GR-SALES-3", 1, 0.0);
+    groupBank.assignAccountToGroup("GR-SALES-3", sales);
+    assert(groupBank.get_group_accounts(sales).size() == 4);
+    const bool sales_deleted = groupBank.deleteAccount("GR-SALES-3");
+    assert(sales_deleted);
+    assert(groupBank.getGroupTotal(sales) == 34000.0 && groupBank.get_group_accounts(sales).size() == 3);
+    std::cout << "OK Move and delete test passed" << std::endl;
+
+    // Test 5: accounts of another client or currency and unknown groups are rejected
+    auto expectInvalid = [](const std::function<void()>& action) {
+        bool thrown = false;
+        try {
+            action();
+        }
+        catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown);
+    };
+    expectInvalid([&]() { groupBank.assignAccountToGroup("GR-OTHER", sales); });
+    expectInvalid([&]() { groupBank.assignAccountToGroup("GR-USD", sales); });
+    expectInvalid([&]() { groupBank.assignAccountToGroup("GR-LOOSE", 999); });
+    expectInvalid([&]() { groupBank.createAccountGroup(2, "Foreign", holding); });
+    expectInvalid([&]() { groupBank.createAccountGroup(42, "Nobody"); });
+    expectInvalid([&]() { groupBank.getGroupTotal(999); });
+    uint32_t usdGroup = groupBank.createAccountGroup(1, "Treasury", AccountGroups::NO_GROUP, "USD");
+    groupBank.assignAccountToGroup("GR-USD", usdGroup);
+    assert(groupBank.getGroupTotal(usdGroup) == 5000.0 && groupBank.getGroupTotal(holding) == 34000.0);
+    std::cout << "OK Invalid group data test passed" << std::endl;
+
+    // Test 6: deleting the client invalidates its groups
+    uint32_t otherGroup = groupBank.createAccountGroup(2, "Main");
+    groupBank.assignAccountToGroup("GR-OTHER", otherGroup);
+    assert(groupBank.getGroupTotal(otherGroup) == 0.0 && groupBank.get_group_accounts(otherGroup).size() == 1);
+    const bool other_deleted = groupBank.deleteAccount("GR-OTHER");
+    const bool client_deleted = groupBank.deleteClient(2);
+    assert(other_deleted && client_deleted);
+    expectInvalid([&]() { groupBank.getGroupTotal(otherGroup); });
+    assert(groupBank.get_consolidated_accounts(2).empty());
+    std::cout << "OK Client deletion test passed" << std::endl;
+}
+
+void TestBankSystem::testAsyncBank() {
+    std::cout << "\n--- Testing Coroutine Bank API ---" << std::endl;
+
+    Executor executor(2);
+    Bank asyncBank;
+    AsyncBank service(asyncBank, executor);
+    {
+        QuietCout quiet;
+        asyncBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        for (int i = 0; i < 4; ++i) {
+            asyncBank.createSavAccount("AS-" + std::to_string(i), 1, 10000.0, 12);
+        }
+    }
+
+    // Test 1: awaited operations return statuses and results, errors reach the awaiting coroutine
+    auto scenario = [&]() -> Task<double> {
+        BankStatus status = co_await service.transfer("AS-0", "AS-1", 1000.0);
+        assert(status == BankStatus::Ok);
+        const BankStatus missing_destination = co_await service.transfer("AS-0", "AS-404", 1.0);
+        assert(missing_destination == BankStatus::DestinationNotFound);
+        const BankStatus too_much = co_await service.withdraw("AS-0", 100000.0);
+        assert(too_much != BankStatus::Ok);
+        const BankStatus missing_account = co_await service.deposit("AS-404", 1.0);
+        assert(missing_account == BankStatus::AccountNotFound);
+        bool thrown = false;
+        try {
+            co_await service.getBalance("AS-404");
+        }
+        catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown);
+        co_return co_await service.getBalance("AS-1");
+    };
+    double balance = 0;
+    {
+        QuietCout quiet;
+        balance = syncWait(executor, scenario());
+    }
+    assert(balance == 11000.0);
+    std::cout << "OK Awaited operations test passed" << std::endl;
+
+    // Test 2: many in-flight requests queue on the async mutex and all complete
+    const int requests = 2000;
+    std::atomic<int> finished{ 0 };
+    std::atomic<int> succeeded{ 0 };
+    auto request = [&](int i) -> Task<void> {
+        if (co_await service.transfer("AS-" + std::to_string(i % 4), "AS-" + std::to_string((i + 1) % 4), 1.0) == BankStatus::Ok) {
+            ++succeeded;
+        }
+        ++finished;
+    };
+    {
+        QuietCout quiet;
+        for (int i = 0; i < requests; ++i) {
+            spawn(executor, request(i));
+        }
+        while (finished.load() != requests) {
+            std::this_thread::yield();
+        }
+    }
+    double total = 0;
+    for (int i = 0; i < 4; ++i) {
+        total += asyncBank.find_acc_by_number("AS-" + std::to_string(i))->getBalance();
+    }
+    assert(succeeded.load() == requests && total == 40000.0);
+    std::cout << "OK Concurrent in-flight requests test passed" << std::endl;
+
+    // Test 3: sharded bank - the coroutine resumes after the cross-shard credit or refund
+    ShardedBank sharded(4);
+    AsyncShardedBank shardedService(sharded, executor);
+    {
+        QuietCout quiet;
+        sharded.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        sharded.createCheckAccount("SH-A", 1, 1000.0);
+        sharded.createCheckAccount("SH-B", 1, 0.0);
+        sharded.drain();
+    }
+    std::string other = "SH-B";
+    for (int i = 0; sharded.shard_of(other) == sharded.shard_of("SH-A"); ++i) {
+        other = "SH-C" + std::to_string(i);
+    }
+    if (other != "SH-B") {
+        QuietCout quiet;
+        sharded.createCheckAccount(other, 1, 0.0);
+        sharded.drain();
+    }
+    auto shardedScenario = [&]() -> Task<int> {
+        int results = 0;
+        results += co_await shardedService.transfer("SH-A", other, 100.0) ? 1 : 0;
+        // получателя нет: списание в шарде отправителя и возврат после отказа другого шарда
+        results += co_await shardedService.transfer("SH-A", "SH-MISSING", 50.0) ? 10 : 0;
+        results += co_await shardedService.deposit(other, 5.0) ? 100 : 0;
+        co_return results;
+    };
+    int results = 0;
+    {
+        QuietCout quiet;
+        results = syncWait(executor, shardedScenario());
+    }
+    assert(results == 101);
+    assert(sharded.getBalance(other) == 105.0 && sharded.getBalance("SH-A") <= 900.0);
+    std::cout << "OK Cross-shard await test passed" << std::endl;
+}
+
+void TestBankSystem::testWorkload() {
+    std::cout << "\n--- Testing Workload Generator and Trace Replay ---" << std::endl;
+
+    WorkloadConfig config;
+    config.clients = 50;
+    config.accounts = 1000;
+    config.operations = 20000;
+    config.seed = 42;
+
+    // Test 1: the same seed gives the same operations, another seed - different ones
+    auto sameOps = [](const WorkloadConfig& a, const WorkloadConfig& b) {
+        WorkloadGenerator first(a);
+        WorkloadGenerator second(b);
+        WorkloadOp x;
+        WorkloadOp y;
+        while (first.next(x)) {
+            if (!second.next(y) || x.kind != y.kind || x.from != y.from || x.to != y.to || x.cents != y.cents) {
+                return false;
+            }
+        }
+        return !second.next(y);
+    };
+    WorkloadConfig other = config;
+    other.seed = 43;
+    assert(sameOps(config, config) && !sameOps(config, other));
+    std::cout << "OK Deterministic generator test passed" << std::endl;
+
+    // Test 2: Zipfian popularity and operation mix
+    auto hottestShare = [](const WorkloadConfig& c, size_t& transfers) {
+        WorkloadGenerator generator(c);
+        std::vector<size_t> hits(c.accounts, 0);
+        WorkloadOp op;
+        transfers = 0;
+        while (generator.next(op)) {
+            ++hits[op.from];
+            if (op.kind == WorkloadOpKind::Transfer) {
+                ++transfers;
+                assert(op.to != op.from && op.to < c.accounts);
+            }
+            assert(op.cents >= c.min_amount_cents && op.cents <= c.max_amount_cents);
+        }
+        return static_cast<double>(*std::max_element(hits.begin(), hits.end())) / c.operations;
+    };
+    size_t transfers = 0;
+    assert(hottestShare(config, transfers) > 0.08); // ранг 1 при zipf 0.99 и 1000 счетов - около 13%
+    assert(transfers > config.operations / 2 && transfers < config.operations * 7 / 10);
+    WorkloadConfig uniform = config;
+    uniform.zipf = 0;
+    const bool mix_set = setWorkloadOption(uniform, "mix", "0:0:1");
+    assert(mix_set);
+    assert(hottestShare(uniform, transfers) < 0.01 && transfers == uniform.operations);
+    std::cout << "OK Zipf distribution and mix test passed" << std::endl;
+
+    // Test 3: a recorded run replayed on an empty bank ends with the same balances
+    const std::string path = "test_workload_trace.bin";
+    std::remove(path.c_str());
+    config.initial_balance_cents = 50000; // малые остатки - часть операций отклоняется
+    Bank recorded;
+    Bank replayed;
+    WorkloadReport first;
+    WorkloadReport second;
+    {
+        QuietCout quiet;
+        WorkloadRunner runner(recorded);
+        runner.setup(config);
+        WorkloadGenerator generator(config);
+        TraceWriter writer(path, config);
+        first = runner.run(generator, &writer);
+        writer.close();
+        assert(writer.getWrittenCount() == config.operations);
+
+        TraceReader reader(path);
+        assert(reader.getConfig().accounts == config.accounts && reader.getConfig().operations == config.operations);
+        WorkloadRunner replayer(replayed);
+        replayer.setup(reader.getConfig());
+        second = replayer.replay(reader, false);
+    }
+    assert(first.operations == config.operations && second.operations == config.operations);
+    assert(first.declined > 0 && first.declined == second.declined);
+    assert(first.latency.count == config.operations && first.latency.percentile(0.99) <= first.latency.max);
+    for (uint32_t i = 0; i < config.accounts; ++i) {
+        std::string number = WorkloadRunner::accountNumber(i);
+        assert(recorded.find_acc_by_number(number)->getBalance() == replayed.find_acc_by_number(number)->getBalance());
+    }
+    std::cout << "OK Record and replay test passed" << std::endl;
+
+    // Test 4: invalid options and files are rejected
+    auto throwsInvalid = [&](const std::string& name, const std::string& value) {
+        try {
+            setWorkloadOption(config, name, value);
+        }
+        catch (const std::invalid_argument&) {
+            return true;
+        }
+        return false;
+    };
+    const bool bad_ops = throwsInvalid("ops", "-5");
+    const bool bad_accounts = throwsInvalid("accounts", "0");
+    const bool bad_mix = throwsInvalid("mix", "1:2");
+    const bool bad_zipf = throwsInvalid("zipf", "abc");
+    const bool unknown_set = setWorkloadOption(config, "unknown", "1");
+    assert(bad_ops && bad_accounts && bad_mix && bad_zipf && !unknown_set);
+    {
+        std::ofstream junk(path, std::ios::binary | std::ios::trunc);
+        junk << "not a trace";
+    }
+    bool thrown = false;
+    try {
+        TraceReader reader(path);
+    }
+    catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    std::remove(path.c_str());
+    std::cout << "OK Invalid workload input test passed" << std::endl;
+}
+
+void TestBankSystem::testHotAccounts() {
+    std::cout << "\n--- Testing Hot Accounts (striped credits) ---" << std::endl;
+
+    const int accounts = 16;
+    {
+        QuietCout quiet; // потоки шардов не должны писать в общий cout
+        ShardedBank sharded(4);
+        sharded.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        for (int i = 0; i < accounts; ++i) {
+            sharded.createSavAccount("HC" + std::to_string(i), 1, 100000.0, 12);
+        }
+        sharded.createSavAccount("MERCHANT", 1, 5000.0, 12);
+        sharded.drain();
+
+        // Test 1: only existing accounts can be hot
+        sharded.setHotAccount("MERCHANT");
+        bool thrown = false;
+        try {
+            sharded.setHotAccount("NO_SUCH_ACCOUNT");
+        }
+        catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown && sharded.isHotAccount("MERCHANT") && !sharded.isHotAccount("HC0"));
+
+        // Test 2: credits from all shards are visible in the balance, declined debits credit nothing
+        for (int i = 0; i < 300; ++i) {
+            sharded.transfer("HC" + std::to_string(i % accounts), "MERCHANT", 10.0);
+        }
+        sharded.transfer("HC0", "MERCHANT", 1000000000.0);
+        sharded.drain();
+        double total = sharded.getBalance("MERCHANT");
+        for (int i = 0; i < accounts; ++i) {
+            total += sharded.getBalance("HC" + std::to_string(i));
+        }
+        assert(sharded.getBalance("MERCHANT") == 8000.0 && total == accounts * 100000.0 + 5000.0);
+        assert(sharded.getCompletedCount() == 300 && sharded.getFailedCount() == 1);
+
+        // Test 3: a debit checks the aggregated balance (account + stripes)
+        sharded.withdraw("MERCHANT", 3000.0);
+        sharded.drain();
+        assert(sharded.getBalance("MERCHANT") == 5000.0 && sharded.getFailedCount() == 1);
+        sharded.withdraw("MERCHANT", 1.0); // меньше 5000 на сберегательном счете оставить нельзя
+        sharded.drain();
+        assert(sharded.getFailedCount() == 2 && sharded.getBalance("MERCHANT") == 5000.0);
+
+        // Test 4: explicit merge keeps the balance, transfers out of the hot account go through the normal path
+        for (int i = 0; i < 40; ++i) {
+            sharded.transfer("HC" + std::to_string(i % accounts), "MERCHANT", 25.0);
+        }
+        sharded.drain();
+        double before = sharded.getBalance("MERCHANT");
+        sharded.mergeHotAccounts();
+        assert(before == 6000.0 && sharded.getBalance("MERCHANT") == before);
+        sharded.transfer("MERCHANT", "HC3", 1000.0);
+        sharded.drain();
+        assert(sharded.getBalance("MERCHANT") == 5000.0);
+
+        // Test 5: a reader never sees the stripe sum twice or not at all while stripes are merged
+        std::atomic<bool> merging{ true };
+        bool monotonic = true;
+        std::thread reader([&]() {
+            double last = 0;
+            while (merging.load()) {
+                double balance = sharded.getBalance("MERCHANT");
+                monotonic = monotonic && balance >= last && balance <= 5100.0;
+                last = balance;
+            }
+        });
+        for (int i = 0; i < 100; ++i) {
+            sharded.transfer("HC" + std::to_string(i % accounts), "MERCHANT", 1.0);
+            sharded.mergeHotAccounts();
+        }
+        merging = false;
+        reader.join();
+        assert(monotonic && sharded.getBalance("MERCHANT") == 5100.0);
+
+        // Test 6: a hot account with unmerged credits is not deleted; stripes of a deleted one go to suspense
+        sharded.createCheckAccount("HOT-KEEP", 1, 0.0);
+        sharded.createCheckAccount("HOT-GONE", 1, 0.0);
+        sharded.drain();
+        sharded.setHotAccount("HOT-KEEP");
+        sharded.setHotAccount("HOT-GONE");
+        std::string sender;
+        for (int i = 0; i < accounts && sender.empty(); ++i) {
+            std::string number = "HC" + std::to_string(i);
+            if (sharded.shard_of(number) != sharded.shard_of("HOT-KEEP") && sharded.shard_of(number) != sharded.shard_of("HOT-GONE")) {
+                sender = number;
+            }
+        }
+        assert(!sender.empty());
+        sharded.transfer(sender, "HOT-KEEP", 10.0);
+        sharded.drain();
+        sharded.deleteAccount("HOT-KEEP");
+        sharded.deleteAccount("HOT-GONE");
+        sharded.drain();
+        assert(sharded.getBalance("HOT-KEEP") == 10.0);
+        double sender_before = sharded.getBalance(sender);
+        sharded.transfer(sender, "HOT-GONE", 20.0); // списание прошло, зачисление - в полосу удаленного счета
+        sharded.drain();
+        sharded.mergeHotAccounts();
+        auto suspense = sharded.getSuspense();
+        assert(suspense.size() == 1 && suspense[0].acc_from == ShardedBank::HOT_STRIPES);
+        assert(suspense[0].acc_to == "HOT-GONE" && suspense[0].amount == 20.0);
+        assert(sharded.getBalance(sender) == sender_before - 20.0);
+    }
+    std::cout << "OK Hot account stripes test passed" << std::endl;
+}
+
+void TestBankSystem::testTransactionArchive() {
+    std::cout << "\n--- Testing Transaction Archive ---" << std::endl;
+
+    const std::string path = "test_archive_segment.bkar";
+    std::remove(path.c_str()); // файл прерванного запуска: существующий сегмент не перезаписывается
+    Bank archiveBank;
+    archiveBank.createClient(1, "Anna", "Ivanova", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+    auto first = archiveBank.createSavAccount("AR-1", 1, 10000.0, 12);
+    archiveBank.createSavAccount("AR-2", 1, 10000.0, 12);
+    for (int i = 0; i < 20; ++i) {
+        archiveBank.tryTransfer(i % 2 ? "AR-1" : "AR-2", i % 2 ? "AR-2" : "AR-1", 10.25 + i);
+    }
+    archiveBank.tryDeposit(first, 0.01);
+    std::vector<const Transaction*> originals = archiveBank.get_account_transactions("AR-1");
+    std::vector<int> original_ids;
+    std::vector<double> original_sums;
+    for (auto record : originals) {
+        original_ids.push_back(record->getId());
+        original_sums.push_back(record->getSumma());
+    }
+    size_t history = archiveBank.getTransactionCount();
+
+    // Test 1: nothing is older than the beginning of time
+    const size_t archived_none = archiveBank.archive_transactions(0, path);
+    assert(archived_none == 0 && archiveBank.getArchivedTransactionCount() == 0);
+
+    // Test 2: the whole history moves to the segment, the memory keeps only new records
+    std::time_t cutoff = std::time(nullptr) + 1;
+    const size_t archived = archiveBank.archive_transactions(cutoff, path);
+    assert(archived == history);
+    assert(archiveBank.getTransactionCount() == 0 && archiveBank.getArchivedTransactionCount() == history);
+    assert(archiveBank.get_account_transactions("AR-1").empty());
+    archiveBank.tryTransfer("AR-2", "AR-1", 7.5);
+    assert(archiveBank.get_account_transactions("AR-1").size() == 1 && archiveBank.getTransactionCount() == 2);
+
+    // Test 3: the audit returns archived records exactly as they were, then the live ones
+    std::vector<int> ids;
+    std::vector<double> sums;
+    bool owners_match = true;
+    size_t audited = archiveBank.audit_account_history("AR-1", 0, cutoff + 3600, [&](const TransactionView& view) {
+        ids.push_back(view.id);
+        sums.push_back(view.summa);
+        owners_match = owners_match && view.owner == "AR-1";
+    });
+    assert(audited == original_ids.size() + 1 && owners_match);
+    assert(std::equal(original_ids.begin(), original_ids.end(), ids.begin()));
+    assert(std::equal(original_sums.begin(), original_sums.end(), sums.begin()));
+    assert(sums.back() == 7.5);
+
+    // Test 4: the whole-bank audit sees every record once; other periods and accounts are skipped
+    size_t all = archiveBank.audit_transactions(0, cutoff + 3600, [](const TransactionView&) {});
+    assert(all == history + 2);
+    assert(archiveBank.audit_transactions(cutoff + 3600, cutoff + 7200, [](const TransactionView&) {}) == 0);
+    assert(archiveBank.audit_account_history("NO_SUCH_ACCOUNT", 0, cutoff + 3600, [](const TransactionView&) {}) == 0);
+
+    // Test 5: existing segments and files are never overwritten, the history stays in memory
+    bool reused_rejected = false;
+    try {
+        archiveBank.archive_transactions(cutoff + 3600, path);
+    }
+    catch (const std::invalid_argument&) {
+        reused_rejected = true;
+    }
+    const std::string other_path = "test_archive_other.bkar";
+    {
+        std::ofstream other(other_path, std::ios::binary);
+        other << "not a segment";
+    }
+    bool existing_rejected = false;
+    try {
+        archiveBank.archive_transactions(cutoff + 3600, other_path);
+    }
+    catch (const std::runtime_error&) {
+        existing_rejected = true;
+    }
+    std::string other_content;
+    {
+        std::ifstream other(other_path, std::ios::binary);
+        std::getline(other, other_content);
+    }
+    std::remove(other_path.c_str());
+    assert(reused_rejected && existing_rejected && other_content == "not a segment");
+    assert(archiveBank.getTransactionCount() == 2 && archiveBank.getArchivedTransactionCount() == history);
+    assert(archiveBank.audit_transactions(0, cutoff + 3600, [](const TransactionView&) {}) == history + 2);
+    assert(!std::ifstream(other_path + ".tmp") && ArchiveSegment::open(path).getCount() == history);
+
+    // Test 6: a damaged segment is rejected
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-1, std::ios::end);
+        file.put('X');
+    }
+    bool thrown = false;
+    try {
+        ArchiveSegment::open(path);
+    }
+    catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    std::remove(path.c_str());
+    std::cout << "OK Transaction archive test passed" << std::endl;
+}
+
+void TestBankSystem::testLookupFilter() {
+    std::cout << "\n--- Testing Lookup Filters ---" << std::endl;
+
+    // Test 1: no false negatives, about 1% false positives at the designed load
+    LookupFilter filter(10000);
+    std::vector<uint64_t> present;
+    for (int i = 0; i < 10000; ++i) {
+        present.push_back(LookupFilter::hashOf("ACC" + std::to_string(i)));
+        filter.add(present.back());
+    }
+    bool all_found = true;
+    for (uint64_t hash : present) {
+        all_found = all_found && filter.mayContain(hash);
+    }
+    size_t false_positives = 0;
+    for (int i = 0; i < 100000; ++i) {
+        false_positives += filter.mayContain(LookupFilter::hashOf("MISS" + std::to_string(i)));
+    }
+    assert(all_found && false_positives < 3000);
+    assert(!filter.needsRebuild() && filter.getKeyCount() == 10000);
+
+    // Test 2: removed keys pile up until a rebuild from the remaining keys
+    for (int i = 0; i < 5000; ++i) {
+        filter.remove();
+    }
+    assert(filter.needsRebuild());
+    present.resize(5000);
+    filter.rebuild(present);
+    all_found = true;
+    for (uint64_t hash : present) {
+        all_found = all_found && filter.mayContain(hash);
+    }
+    assert(all_found && !filter.needsRebuild() && filter.getStaleCount() == 0);
+
+    // Test 3: the bank grows its filters and still finds every account and client
+    Bank filterBank;
+    {
+        QuietCout quiet;
+        for (int c = 1; c <= 1500; ++c) {
+            filterBank.createClient(c, "Name", "Surname", Address("Lenina 1", "Moscow", "Russia", 101000), Date(1, 1, 2024));
+        }
+        for (int i = 0; i < 3000; ++i) {
+            filterBank.createCheckAccount("LF-" + std::to_string(i), 1 + i % 1500, 0.0);
+        }
+    }
+    bool bank_found = true;
+    for (int i = 0; i < 3000; ++i) {
+        bank_found = bank_found && filterBank.find_acc_by_number("LF-" + std::to_string(i)) != nullptr;
+    }
+    for (int c = 1; c <= 1500; ++c) {
+        bank_found = bank_found && filterBank.find_client_by_id(c) != nullptr;
+    }
+    assert(bank_found);
+
+    // Test 4: misses are rejected and counted, the false positive rate is reported
+    Metrics::reset(); // поиск перед добавлением тоже промах, его не считаем
+    LookupFilter::Counts before = filterBank.getLookupFilterCounts();
+    for (int i = 0; i < 10000; ++i) {
+        assert(filterBank.find_acc_by_number("LF-X" + std::to_string(i)) == nullptr);
+    }
+    const BankStatus to_missing = filterBank.tryTransfer("LF-1", "NO_SUCH_ACCOUNT", 10.0);
+    assert(to_missing == BankStatus::DestinationNotFound);
+    const BankStatus from_missing = filterBank.tryTransfer("NO_SUCH_ACCOUNT", "LF-1", 10.0);
+    assert(from_missing == BankStatus::SourceNotFound);
+    LookupFilter::Counts counts = filterBank.getLookupFilterCounts();
+    counts.rejected -= before.rejected;
+    counts.false_positives -= before.false_positives;
+    assert(counts.rejected + counts.false_positives == 10002 && counts.falsePositiveRate() < 0.03);
+    if (Metrics::enabled()) {
+        MetricsSnapshot data = Metrics::snapshot();
+        assert(data.counters[static_cast<size_t>(Counter::LOOKUP_FILTER_REJECTED)] == counts.rejected);
+        assert(data.counters[static_cast<size_t>(Counter::LOOKUP_FILTER_FALSE_POSITIVE)] == counts.false_positives);
+        std::ostringstream report;
+        Metrics::writeReport(report);
+        assert(report.str().find("lookup.filter_fp_rate") != std::string::npos);
+    }
+
+    // Test 5: deleted accounts are gone, the rest are found after automatic and explicit rebuilds
+    {
+        QuietCout quiet;
+        for (int i = 0; i < 3000; ++i) {
+            if (i % 3 != 0) {
+                filterBank.deleteAccount("LF-" + std::to_string(i));
+            }
+        }
+    }
+    for (int pass = 0; pass < 2; ++pass) {
+        bool consistent = filterBank.getAccountCount() == 1000;
+        for (int i = 0; i < 3000; ++i) {
+            consistent = consistent && (filterBank.find_acc_by_number("LF-" + std::to_string(i)) != nullptr) == (i % 3 == 0);
+        }
+        assert(consistent);
+        filterBank.rebuildLookupFilters();
+    }
+    Metrics::reset();
+    std::cout << "OK Lookup filter test passed" << std::endl;
+}
+
+void TestBankSystem::testBalanceStore() {
+    std::cout << "\n--- Testing Balance Store (hot account fields) ---" << std::endl;
+
+    // Test 1: one record per cache line
+    static_assert(sizeof(BalanceRecord) == 64 && alignof(BalanceRecord) == 64, "BalanceRecord must fill one cache line");
+    BalanceStore& store = *BalanceStore::shared();
+    std::vector<BalanceSlot> slots;
+    for (int i = 0; i < 8; ++i) {
+        slots.emplace_back();
+    }
+    bool aligned = true;
+    for (size_t i = 0; i < slots.size(); ++i) {
+        aligned = aligned && reinterpret_cast<uintptr_t>(&*slots[i]) % 64 == 0 && slots[i]->balance == 0;
+    }
+    assert(aligned && &*slots[0] != &*slots[1]);
+
+    // Test 2: accounts keep their hot fields in the store, released records are reused
+    size_t free_before = store.getFreeCount();
+    {
+        QuietCout quiet;
+        CheckingAccount checking("HS-1", 1, 60000.0);
+        assert(store.getFreeCount() == free_before - 1);
+        const bool withdrawn = checking.withdraw(1000.0);
+        assert(withdrawn && checking.getCommission() == 40.0 && checking.getBalance() == 58960.0);
+        AccountState state;
+        checking.saveState(state);
+        checking.withdraw(500.0);
+        checking.restoreState(state);
+        assert(checking.getBalance() == 58960.0 && checking.getCommission() == 40.0);
+    }
+    assert(store.getFreeCount() == free_before);
+    {
+        QuietCout quiet;
+        SavingsAccount savings("HS-2", 1, 7000.0, 12);
+        const bool below_minimum = savings.withdraw(2500.0);
+        assert(savings.getBalance() == 7000.0 && !below_minimum);
+    }
+    assert(store.getFreeCount() == free_before);
+
+    // Test 3: each bank has its own store; the MVCC version list lives in the record, an account may outlive its bank
+    std::shared_ptr<CheckingAccount> survivor;
+    {
+        QuietCout quiet;
+        Bank storeBank;
+        Bank otherBank;
+        assert(storeBank.getBalanceStore() != otherBank.getBalanceStore() && storeBank.getBalanceStore() != BalanceStore::shared());
+        storeBank.createClient(1, "Hot", "Store", Address("Main St", "New York", "USA", 10001), Date(1, 1, 2024));
+        BalanceStore& bank_store = *storeBank.getBalanceStore();
+        survivor = storeBank.createCheckAccount("HS-3", 1, 1000.0);
+        assert(bank_store.getCapacity() - bank_store.getFreeCount() == 1 && store.getFreeCount() == free_before);
+        survivor->publishBalance(1, 1);
+        survivor->deposit(500.0);
+        survivor->publishBalance(2, 1);
+        double at_first = 0;
+        double at_second = 0;
+        assert(survivor->getBalanceAt(1, at_first) && at_first == 1000.0);
+        assert(survivor->getBalanceAt(2, at_second) && at_second == 1500.0);
+    }
+    {
+        QuietCout quiet;
+        survivor->deposit(100.0);
+        assert(survivor->getBalance() == 1600.0);
+        survivor.reset();
+    }
+    std::cout << "OK Balance store test passed" << std::endl;
+}
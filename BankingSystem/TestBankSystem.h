@@ -13,6 +13,31 @@ private:
     void testTransactions();
     void testDeletion();
     void testErrorHandling();
+    void testBatchMode();
+    void testShardedBank();
+    void testSnapshotConsistency();
+    void testIdempotency();
+    void testChangeFeed();
+    void testStatusResults();
+    void testPostingRollback();
+    void testLedger();
+    void testStandingOrders();
+    void testVelocityLimits();
+    void testClientSearch();
+    void testClientStorage();
+    void testEntityLinks();
+    void testBulkLoader();
+    void testStatements();
+    void testMetrics();
+    void testMoveSemantics();
+    void testMultiCurrency();
+    void testAccountGroups();
+    void testAsyncBank();
+    void testWorkload();
+    void testHotAccounts();
+    void testTransactionArchive();
+    void testLookupFilter();
+    void testBalanceStore();
 
 public:
     void runAllTests();
@@ -5,28 +5,59 @@
 #include <iostream>
 #include <iomanip> //  
 #include <sstream> //  
+#include <atomic>
 
 namespace Banking {
 
-    Transaction::Transaction(const std::string& type, double summa, const std::string& acc1, const std::string& acc2)
-        : acc1(acc1), acc2(acc2), timestamp(std::time(nullptr))  //  
+    Transaction::Transaction(std::string type_value, double summa_value, std::string acc1_value, std::string acc2_value)
+        : timestamp(std::time(nullptr))  //  
     {
-        //   
-        setType(type);
-        setSumma(summa);
-        setAcc1(acc1);
-        setAcc2(acc2);
+        //   :      
+        validateType(type_value);
+        validateSumma(summa_value);
+        validateAcc1(acc1_value);
+        type = std::move(type_value);
+        summa = summa_value;
+        acc1 = std::move(acc1_value);
+        acc2 = std::move(acc2_value);
         
         //  ID   
-        static int counter = 1000; 
+        static std::atomic<int> counter{ 1000 }; //      
         id = ++counter;
 
         std::cout << "\n-----Transaction constructor called. ID: " << getFormattedId() << std::endl;
     }
 
-    std::shared_ptr<Transaction> Transaction::createTransaction(const std::string& type, double summa, const std::string& acc1, const std::string& acc2) {  //       
-        auto transaction = std::make_shared<Transaction>(type, summa, acc1, acc2);
-        return transaction;
+    std::shared_ptr<Transaction> Transaction::createTransaction(std::string type, double summa, std::string acc1, std::string acc2) {  //       
+        return std::make_shared<Transaction>(std::move(type), summa, std::move(acc1), std::move(acc2));
+    }
+
+    void Transaction::validateType(const std::string& value) {
+        if (value.empty()) {
+            throw std::invalid_argument("Transaction type cannot be empty");
+        }
+        //    (  ,   )
+        static const char* const validTypes[] = {
+            "DEPOSIT", "WITHDRAW", "TRANSFER_IN", "TRANSFER_OUT", "FEE"
+        };
+        for (const char* valid : validTypes) {
+            if (value == valid) {
+                return;
+            }
+        }
+        throw std::invalid_argument("Invalid transaction type");
+    }
+
+    void Transaction::validateSumma(double value) {
+        if (value <= 0) {
+            throw std::invalid_argument("Transaction amount must be positive");
+        }
+    }
+
+    void Transaction::validateAcc1(const std::string& value) {
+        if (value.empty()) {
+            throw std::invalid_argument("Account number cannot be empty");
+        }
     }
 
     Transaction::~Transaction() {
@@ -47,7 +78,14 @@ namespace Banking {
         std::cout << "time: " << getFormattedTime() << std::endl;
         std::cout << "type: " << getType() << std::endl;
         std::cout << "amount: " << getSumma() << std::endl;
-        std::cout << "account(-s): " << getAccounts() << std::endl;
+        if (fx_version != 0) {
+            std::cout << "fx rates version: " << fx_version << std::endl;
+        }
+        std::cout << "account(-s): " << acc1;
+        if (acc2 != " ") {
+            std::cout << " -> " << acc2;
+        }
+        std::cout << std::endl;
         std::cout << "-----" << std::endl;
     }
 }
\ No newline at end of file
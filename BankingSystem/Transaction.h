@@ -5,6 +5,8 @@
 #include <ctime>  //  std::time_t
 #include <stdexcept> 
 #include <algorithm>  //  std::find
+#include <utility>
+#include <cstdint>
 
 //     Bank.h
 namespace Banking {
@@ -21,10 +23,17 @@ namespace Banking {
         double summa;
         std::time_t timestamp;
         std::string type;
+        uint64_t fx_version = 0; //        (0 -  )
+
+        //      (    )
+        static void validateType(const std::string& value);
+        static void validateSumma(double value);
+        static void validateAcc1(const std::string& value);
 
     public:
-        Transaction(const std::string& type, double summa, const std::string& acc1, const std::string& acc2 = " ");
-        static std::shared_ptr<Transaction> createTransaction(const std::string& type, double summa, const std::string& acc1, const std::string& acc2 = " "); //       
+        //  - sink-:   ,     lvalue 
+        Transaction(std::string type, double summa, std::string acc1, std::string acc2 = " ");
+        static std::shared_ptr<Transaction> createTransaction(std::string type, double summa, std::string acc1, std::string acc2 = " "); //       
         virtual ~Transaction();
 
         void displayinfo();
@@ -32,16 +41,17 @@ namespace Banking {
         //
         int getId() const { return id; }
         double getSumma() const { return summa; }
-        std::string getType() const { return type; }
-        std::string getAcc1() const { return acc1; }
-        std::string getAcc2() const { return acc2; }
+        const std::string& getType() const { return type; }
+        const std::string& getAcc1() const { return acc1; }
+        const std::string& getAcc2() const { return acc2; }
         std::time_t getTimestamp() const { return timestamp; }
+        uint64_t getFxVersion() const { return fx_version; }
 
         std::string getFormattedTime() const; //   
         std::string getFormattedId() const { //   
             return "T-" + std::to_string(id); }
 
-        //     
+        //      (  ; displayinfo     )
         std::string getAccounts() const {
             if (acc2 == " ") {
                 return acc1;
@@ -53,36 +63,26 @@ namespace Banking {
 
         //   
         void setSumma(double newSumma) {
-            if (newSumma <= 0) {
-                throw std::invalid_argument("Transaction amount must be positive"); }
+            validateSumma(newSumma);
             summa = newSumma;
         }
 
-        void setType(const std::string& newType) {
-            if (newType.empty()) {
-                throw std::invalid_argument("Transaction type cannot be empty");
-            }
-            //   
-            static const std::vector<std::string> validTypes = {
-                "DEPOSIT", "WITHDRAW", "TRANSFER_IN", "TRANSFER_OUT"
-            };
-            if (std::find(validTypes.begin(), validTypes.end(), newType) == validTypes.end()) {
-                throw std::invalid_argument("Invalid transaction type");
-            }
-            type = newType;
+        void setType(std::string newType) {
+            validateType(newType);
+            type = std::move(newType);
         }
 
-        void setAcc1(const std::string& newAcc1) {
-            if (newAcc1.empty()) {
-                throw std::invalid_argument("Account number cannot be empty");
-            }
-            acc1 = newAcc1;
+        void setAcc1(std::string newAcc1) {
+            validateAcc1(newAcc1);
+            acc1 = std::move(newAcc1);
         }
 
-        void setAcc2(const std::string& newAcc2) {
-            acc2 = newAcc2; // acc2      
+        void setAcc2(std::string newAcc2) {
+            acc2 = std::move(newAcc2); // acc2      
         }
 
+        void setFxVersion(uint64_t version) { fx_version = version; }
+
     };
 
 }
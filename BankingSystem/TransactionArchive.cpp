@@ -0,0 +1,309 @@
+﻿#include "TransactionArchive.h"
+#include "Transaction.h"
+#include "Ledger.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+namespace Banking {
+
+    namespace {
+
+        const char SEGMENT_MAGIC[4] = { 'B', 'K', 'A', 'R' };
+        const uint64_t SEGMENT_VERSION = 1;
+        const size_t TRAILER_SIZE = 8; // длина оглавления (4 байта) + сигнатура
+
+        void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+            while (value >= 0x80) {
+                out.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        uint64_t zigzag(int64_t value) {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        int64_t unzigzag(uint64_t value) {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        void putString(std::vector<uint8_t>& out, const std::string& value) {
+            putVarint(out, value.size());
+            out.insert(out.end(), value.begin(), value.end());
+        }
+
+        // чтение varint из столбца или оглавления; выход за границу - поврежденный файл
+        struct Cursor {
+            const uint8_t* position;
+            const uint8_t* end;
+
+            uint64_t next() {
+                uint64_t value = 0;
+                for (unsigned shift = 0; shift < 64; shift += 7) {
+                    if (position == end) {
+                        throw std::runtime_error("Corrupted archive segment");
+                    }
+                    uint8_t byte = *position++;
+                    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                    if ((byte & 0x80) == 0) {
+                        return value;
+                    }
+                }
+                throw std::runtime_error("Corrupted archive segment");
+            }
+
+            std::string nextString() {
+                uint64_t size = next();
+                if (size > static_cast<uint64_t>(end - position)) {
+                    throw std::runtime_error("Corrupted archive segment");
+                }
+                std::string value(reinterpret_cast<const char*>(position), static_cast<size_t>(size));
+                position += size;
+                return value;
+            }
+        };
+
+        std::vector<uint8_t> readRange(std::ifstream& file, uint64_t offset, uint64_t size) {
+            std::vector<uint8_t> buffer(static_cast<size_t>(size));
+            file.seekg(static_cast<std::streamoff>(offset));
+            if (!file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(size))) {
+                throw std::runtime_error("Cannot read archive segment");
+            }
+            return buffer;
+        }
+
+    }
+
+    uint32_t ArchiveWriter::encode(const std::string& value, std::vector<std::string>& dictionary, std::unordered_map<std::string, uint32_t>& ids) {
+        auto it = ids.find(value);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(dictionary.size());
+        dictionary.push_back(value);
+        ids.emplace(value, id);
+        return id;
+    }
+
+    void ArchiveWriter::add(const Transaction& transaction, const std::string& owner) {
+        Row row;
+        row.id = transaction.getId();
+        row.timestamp = transaction.getTimestamp();
+        row.cents = Ledger::toCents(transaction.getSumma()); // точность архива - как у книги
+        row.fx_version = transaction.getFxVersion();
+        row.type = encode(transaction.getType(), types, type_ids);
+        row.acc1 = encode(transaction.getAcc1(), accounts, account_ids);
+        row.acc2 = encode(transaction.getAcc2(), accounts, account_ids);
+        row.owner = encode(owner, accounts, account_ids);
+        rows.push_back(row);
+        logical_bytes += sizeof(row.id) + sizeof(row.timestamp) + sizeof(double) + sizeof(row.fx_version)
+            + transaction.getType().size() + transaction.getAcc1().size() + transaction.getAcc2().size() + owner.size();
+    }
+
+    ArchiveSegment ArchiveWriter::finish(const std::string& path) {
+        std::vector<uint8_t> columns[ArchiveSegment::COLUMN_COUNT];
+        int previous_id = 0;
+        std::time_t previous_time = 0;
+        for (const Row& row : rows) {
+            putVarint(columns[ArchiveSegment::ID], zigzag(static_cast<int64_t>(row.id) - previous_id));
+            putVarint(columns[ArchiveSegment::TIME], zigzag(static_cast<int64_t>(row.timestamp - previous_time)));
+            putVarint(columns[ArchiveSegment::TYPE], row.type);
+            putVarint(columns[ArchiveSegment::ACC1], row.acc1);
+            putVarint(columns[ArchiveSegment::ACC2], row.acc2);
+            putVarint(columns[ArchiveSegment::OWNER], row.owner);
+            putVarint(columns[ArchiveSegment::AMOUNT], zigzag(row.cents));
+            putVarint(columns[ArchiveSegment::FX_VERSION], row.fx_version);
+            previous_id = row.id;
+            previous_time = row.timestamp;
+        }
+
+        std::vector<uint8_t> footer;
+        putVarint(footer, SEGMENT_VERSION);
+        putVarint(footer, rows.size());
+        std::time_t min_time = rows.empty() ? 0 : rows.front().timestamp;
+        std::time_t max_time = min_time;
+        int min_id = rows.empty() ? 0 : rows.front().id;
+        int max_id = min_id;
+        for (const Row& row : rows) {
+            min_time = std::min(min_time, row.timestamp);
+            max_time = std::max(max_time, row.timestamp);
+            min_id = std::min(min_id, row.id);
+            max_id = std::max(max_id, row.id);
+        }
+        putVarint(footer, zigzag(min_time));
+        putVarint(footer, zigzag(max_time));
+        putVarint(footer, zigzag(min_id));
+        putVarint(footer, zigzag(max_id));
+        putVarint(footer, logical_bytes);
+        uint64_t offset = 0;
+        for (const auto& column : columns) {
+            putVarint(footer, offset);
+            putVarint(footer, column.size());
+            offset += column.size();
+        }
+        putVarint(footer, types.size());
+        for (const auto& type : types) {
+            putString(footer, type);
+        }
+        putVarint(footer, accounts.size());
+        for (const auto& account : accounts) {
+            putString(footer, account);
+        }
+
+        // существующий сегмент не перезаписывается: в нем может быть единственная копия старых записей
+        if (std::ifstream(path, std::ios::binary)) {
+            throw std::runtime_error("Archive segment already exists: " + path);
+        }
+        // файл пишется под временным именем и получает имя сегмента только целиком
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                throw std::runtime_error("Cannot create archive segment: " + path);
+            }
+            for (const auto& column : columns) {
+                file.write(reinterpret_cast<const char*>(column.data()), static_cast<std::streamsize>(column.size()));
+            }
+            file.write(reinterpret_cast<const char*>(footer.data()), static_cast<std::streamsize>(footer.size()));
+            uint8_t trailer[TRAILER_SIZE];
+            for (size_t i = 0; i < 4; ++i) {
+                trailer[i] = static_cast<uint8_t>(footer.size() >> (8 * i));
+            }
+            std::memcpy(trailer + 4, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+            file.write(reinterpret_cast<const char*>(trailer), sizeof(trailer));
+            file.close();
+            if (file.fail()) {
+                std::remove(temporary.c_str());
+                throw std::runtime_error("Cannot write archive segment: " + path);
+            }
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Cannot write archive segment: " + path);
+        }
+        return ArchiveSegment::open(path);
+    }
+
+    ArchiveSegment ArchiveSegment::open(const std::string& path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            throw std::runtime_error("Cannot open archive segment: " + path);
+        }
+        ArchiveSegment segment;
+        segment.path = path;
+        segment.file_bytes = static_cast<uint64_t>(file.tellg());
+        if (segment.file_bytes < TRAILER_SIZE) {
+            throw std::runtime_error("Not an archive segment: " + path);
+        }
+        std::vector<uint8_t> trailer = readRange(file, segment.file_bytes - TRAILER_SIZE, TRAILER_SIZE);
+        if (std::memcmp(trailer.data() + 4, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0) {
+            throw std::runtime_error("Not an archive segment: " + path);
+        }
+        uint64_t footer_size = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            footer_size |= static_cast<uint64_t>(trailer[i]) << (8 * i);
+        }
+        if (footer_size > segment.file_bytes - TRAILER_SIZE) {
+            throw std::runtime_error("Corrupted archive segment: " + path);
+        }
+        uint64_t footer_offset = segment.file_bytes - TRAILER_SIZE - footer_size;
+        std::vector<uint8_t> footer = readRange(file, footer_offset, footer_size);
+
+        Cursor cursor{ footer.data(), footer.data() + footer.size() };
+        if (cursor.next() != SEGMENT_VERSION) {
+            throw std::runtime_error("Unsupported archive segment version: " + path);
+        }
+        segment.count = static_cast<uint32_t>(cursor.next());
+        segment.min_time = static_cast<std::time_t>(unzigzag(cursor.next()));
+        segment.max_time = static_cast<std::time_t>(unzigzag(cursor.next()));
+        segment.min_id = static_cast<int>(unzigzag(cursor.next()));
+        segment.max_id = static_cast<int>(unzigzag(cursor.next()));
+        segment.logical_bytes = cursor.next();
+        for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+            segment.column_offset[c] = cursor.next();
+            segment.column_size[c] = cursor.next();
+            if (segment.column_offset[c] + segment.column_size[c] > footer_offset) {
+                throw std::runtime_error("Corrupted archive segment: " + path);
+            }
+        }
+        uint64_t type_count = cursor.next();
+        for (uint64_t i = 0; i < type_count; ++i) {
+            segment.types.push_back(cursor.nextString());
+        }
+        uint64_t account_count = cursor.next();
+        for (uint64_t i = 0; i < account_count; ++i) {
+            segment.accounts.push_back(cursor.nextString());
+        }
+        for (uint32_t i = 0; i < segment.accounts.size(); ++i) {
+            segment.account_ids.emplace(segment.accounts[i], i);
+        }
+        return segment;
+    }
+
+    size_t ArchiveSegment::scan(std::string_view owner, std::time_t from, std::time_t to, const TransactionVisitor& visit) const {
+        // оглавление: сегмент вне периода или без этого счета не читается
+        if (count == 0 || to <= min_time || from > max_time) {
+            return 0;
+        }
+        uint32_t owner_id = UINT32_MAX;
+        if (!owner.empty()) {
+            auto it = account_ids.find(owner);
+            if (it == account_ids.end()) {
+                return 0;
+            }
+            owner_id = it->second;
+        }
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot open archive segment: " + path);
+        }
+        uint64_t data_size = column_offset[COLUMN_COUNT - 1] + column_size[COLUMN_COUNT - 1];
+        std::vector<uint8_t> data = readRange(file, 0, data_size);
+        Cursor cursors[COLUMN_COUNT];
+        for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+            cursors[c] = Cursor{ data.data() + column_offset[c], data.data() + column_offset[c] + column_size[c] };
+        }
+        auto word = [this](const std::vector<std::string>& dictionary, uint64_t id) -> std::string_view {
+            if (id >= dictionary.size()) {
+                throw std::runtime_error("Corrupted archive segment: " + path);
+            }
+            return dictionary[static_cast<size_t>(id)];
+        };
+
+        size_t visited = 0;
+        TransactionView view;
+        int64_t id = 0;
+        int64_t time = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            id += unzigzag(cursors[ID].next());
+            time += unzigzag(cursors[TIME].next());
+            uint64_t type = cursors[TYPE].next();
+            uint64_t acc1 = cursors[ACC1].next();
+            uint64_t acc2 = cursors[ACC2].next();
+            uint64_t record_owner = cursors[OWNER].next();
+            int64_t cents = unzigzag(cursors[AMOUNT].next());
+            uint64_t fx_version = cursors[FX_VERSION].next();
+            if ((owner_id != UINT32_MAX && record_owner != owner_id) || time < from || time >= to) {
+                continue;
+            }
+            view.id = static_cast<int>(id);
+            view.timestamp = static_cast<std::time_t>(time);
+            view.summa = Ledger::fromCents(cents);
+            view.fx_version = fx_version;
+            view.type = word(types, type);
+            view.acc1 = word(accounts, acc1);
+            view.acc2 = word(accounts, acc2);
+            view.owner = word(accounts, record_owner);
+            visit(view);
+            ++visited;
+        }
+        return visited;
+    }
+
+}
@@ -0,0 +1,108 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <ctime>
+#include <cstdint>
+
+namespace Banking {
+
+    class Transaction;
+
+    // Запись истории для аудита - из памяти или из архива; строки действительны только во время обратного вызова
+    struct TransactionView {
+        int id = 0;
+        std::time_t timestamp = 0;
+        double summa = 0;
+        uint64_t fx_version = 0;
+        std::string_view type;
+        std::string_view acc1;
+        std::string_view acc2;
+        std::string_view owner; // счет, в историю которого входит запись
+    };
+
+    using TransactionVisitor = std::function<void(const TransactionView&)>;
+
+    // Неизменяемый сегмент архива истории: записи хранятся по столбцам
+    //   id и время - разности с предыдущей записью (zigzag varint),
+    //   тип и номера счетов - номера в словарях сегмента (varint),
+    //   сумма - копейки (varint), версия курсов - varint.
+    // В конце файла - оглавление (footer): число записей, диапазоны времени и id, смещения столбцов, словари;
+    // за ним длина оглавления и сигнатура. Открытие читает только оглавление: по диапазону времени
+    // и словарю счетов сегмент отбрасывается без чтения столбцов.
+    class ArchiveSegment {
+    public:
+        enum Column { ID, TIME, TYPE, ACC1, ACC2, OWNER, AMOUNT, FX_VERSION, COLUMN_COUNT };
+
+    private:
+        std::string path;
+        uint32_t count = 0;
+        std::time_t min_time = 0;
+        std::time_t max_time = 0;
+        int min_id = 0;
+        int max_id = 0;
+        uint64_t logical_bytes = 0;  // размер тех же записей без сжатия (поля + строки)
+        uint64_t file_bytes = 0;
+        uint64_t column_offset[COLUMN_COUNT] = {};
+        uint64_t column_size[COLUMN_COUNT] = {};
+        std::vector<std::string> types;
+        std::vector<std::string> accounts;
+        std::unordered_map<std::string_view, uint32_t> account_ids; // ключи - строки accounts
+
+        ArchiveSegment() = default;
+
+    public:
+        // прочитать оглавление; std::runtime_error - файл не открылся или поврежден
+        static ArchiveSegment open(const std::string& path);
+
+        ArchiveSegment(ArchiveSegment&&) = default; // строки словаря не перемещаются, ключи account_ids остаются верными
+        ArchiveSegment& operator=(ArchiveSegment&&) = delete;
+        ArchiveSegment(const ArchiveSegment&) = delete;
+        ArchiveSegment& operator=(const ArchiveSegment&) = delete;
+
+        // записи за [from, to); owner пустой - все счета. Возвращает число выданных записей
+        size_t scan(std::string_view owner, std::time_t from, std::time_t to, const TransactionVisitor& visit) const;
+
+        const std::string& getPath() const { return path; }
+        uint32_t getCount() const { return count; }
+        std::time_t getMinTime() const { return min_time; }
+        std::time_t getMaxTime() const { return max_time; }
+        uint64_t getLogicalBytes() const { return logical_bytes; }
+        uint64_t getFileBytes() const { return file_bytes; }
+    };
+
+    // Запись сегмента: записи добавляются в порядке истории, finish пишет файл целиком
+    class ArchiveWriter {
+    private:
+        struct Row {
+            int id;
+            std::time_t timestamp;
+            int64_t cents;
+            uint64_t fx_version;
+            uint32_t type;
+            uint32_t acc1;
+            uint32_t acc2;
+            uint32_t owner;
+        };
+
+        std::vector<Row> rows;
+        std::vector<std::string> types;
+        std::vector<std::string> accounts;
+        std::unordered_map<std::string, uint32_t> type_ids;
+        std::unordered_map<std::string, uint32_t> account_ids;
+        uint64_t logical_bytes = 0;
+
+        static uint32_t encode(const std::string& value, std::vector<std::string>& dictionary, std::unordered_map<std::string, uint32_t>& ids);
+
+    public:
+        void add(const Transaction& transaction, const std::string& owner);
+        size_t size() const { return rows.size(); }
+
+        // записать сегмент в новый файл (через временный <path>.tmp); std::runtime_error, если файл
+        // уже существует или запись не удалась
+        ArchiveSegment finish(const std::string& path);
+    };
+
+}
@@ -0,0 +1,80 @@
+﻿#include "VelocityTracker.h"
+#include "Ledger.h"
+
+#include <stdexcept>
+
+namespace Banking {
+
+    VelocityTracker::VelocityTracker(Clock::duration window)
+        : bucket_width(window / BUCKETS) {
+        if (bucket_width <= Clock::duration::zero()) {
+            throw std::invalid_argument("Velocity window is too short");
+        }
+    }
+
+    void VelocityTracker::setLimits(const VelocityLimits& limits_value) {
+        if (limits_value.max_amount < 0) {
+            throw std::invalid_argument("Velocity amount limit cannot be negative");
+        }
+        limits = limits_value;
+        max_amount_cents = Ledger::toCents(limits.max_amount);
+    }
+
+    // окно счета, сдвинутое к текущему времени: корзины, вышедшие из окна, вычитаются из итогов
+    VelocityTracker::Window& VelocityTracker::windowFor(uint32_t account, Clock::time_point now) {
+        if (account >= windows.size()) {
+            windows.resize(account + 1);
+        }
+        Window& window = windows[account];
+        uint64_t bucket = static_cast<uint64_t>(now.time_since_epoch() / bucket_width);
+        if (bucket <= window.head) {
+            return window; // время не сдвинулось (или часы отстали) - пишем в текущую корзину
+        }
+        if (bucket - window.head >= BUCKETS) {
+            window = Window();
+        }
+        else {
+            for (uint64_t b = window.head + 1; b <= bucket; ++b) {
+                uint32_t slot = static_cast<uint32_t>(b % BUCKETS);
+                window.total_count -= window.counts[slot];
+                window.total_amount -= window.amounts[slot];
+                window.counts[slot] = 0;
+                window.amounts[slot] = 0;
+            }
+        }
+        window.head = bucket;
+        return window;
+    }
+
+    bool VelocityTracker::allow(uint32_t account, int64_t amount, Clock::time_point now) {
+        if (!isEnabled()) {
+            return true;
+        }
+        const Window& window = windowFor(account, now);
+        if (limits.max_count != 0 && window.total_count + 1 > limits.max_count) {
+            return false;
+        }
+        if (max_amount_cents != 0 && window.total_amount + amount > max_amount_cents) {
+            return false;
+        }
+        return true;
+    }
+
+    void VelocityTracker::record(uint32_t account, int64_t amount, Clock::time_point now) {
+        Window& window = windowFor(account, now);
+        uint32_t slot = static_cast<uint32_t>(window.head % BUCKETS);
+        window.counts[slot] += 1;
+        window.amounts[slot] += amount;
+        window.total_count += 1;
+        window.total_amount += amount;
+    }
+
+    uint32_t VelocityTracker::getCount(uint32_t account, Clock::time_point now) {
+        return windowFor(account, now).total_count;
+    }
+
+    int64_t VelocityTracker::getAmount(uint32_t account, Clock::time_point now) {
+        return windowFor(account, now).total_amount;
+    }
+
+}
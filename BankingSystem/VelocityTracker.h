@@ -0,0 +1,58 @@
+﻿#pragma once
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+namespace Banking {
+
+    // Ограничения скорости списаний со счета: не больше N операций и не больше X суммы
+    // за скользящее окно (по умолчанию 10 минут). 0 - ограничение выключено.
+    struct VelocityLimits {
+        uint32_t max_count = 0;
+        double max_amount = 0;
+    };
+
+    // Скользящее окно на каждый счет: кольцо из BUCKETS корзин (число операций и сумма в копейках)
+    // плюс итоги по окну, так что проверка - O(1) без просмотра истории транзакций.
+    // Окна лежат в плотной таблице по индексу счета в главной книге. Не потокобезопасен (вызывается под write_mutex банка).
+    class VelocityTracker {
+    public:
+        using Clock = std::chrono::steady_clock;
+        static constexpr uint32_t BUCKETS = 10;
+
+    private:
+        struct Window {
+            uint64_t head = 0;          // номер последней корзины (время / ширина корзины)
+            int64_t total_amount = 0;   // сумма по всем корзинам окна
+            uint32_t total_count = 0;
+            uint32_t counts[BUCKETS] = {};
+            int64_t amounts[BUCKETS] = {};
+        };
+
+        std::vector<Window> windows;
+        VelocityLimits limits;
+        int64_t max_amount_cents = 0;
+        Clock::duration bucket_width;
+
+        Window& windowFor(uint32_t account, Clock::time_point now);
+
+    public:
+        explicit VelocityTracker(Clock::duration window = std::chrono::minutes(10));
+
+        void setLimits(const VelocityLimits& limits_value);
+        const VelocityLimits& getLimits() const { return limits; }
+        bool isEnabled() const { return limits.max_count != 0 || max_amount_cents != 0; }
+        Clock::duration getWindow() const { return bucket_width * BUCKETS; }
+        size_t getMemoryUsage() const { return windows.capacity() * sizeof(Window); }
+
+        // true, если списание amount (копейки) со счета не превысит ограничений окна
+        bool allow(uint32_t account, int64_t amount, Clock::time_point now);
+        // учесть состоявшееся списание
+        void record(uint32_t account, int64_t amount, Clock::time_point now);
+
+        // операции и сумма за окно, заканчивающееся в now
+        uint32_t getCount(uint32_t account, Clock::time_point now);
+        int64_t getAmount(uint32_t account, Clock::time_point now);
+    };
+
+}
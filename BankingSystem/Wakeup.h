@@ -0,0 +1,49 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace Banking {
+
+    // Счетчик пробуждений потока, который разбирает очередь (MpscQueue): писатель увеличивает его после каждой записи,
+    // поток с пустой очередью спит до его изменения. Пока никто не спит, notify обходится без системного вызова.
+    class WakeupCounter {
+    private:
+        std::atomic<uint32_t> value{ 0 };
+
+    public:
+        void notify() {
+            value.fetch_add(1, std::memory_order_release);
+            value.notify_one();
+        }
+
+        // ждать, пока take() не заберет работу (true) или не выставлен stopping (false).
+        // Счетчик запоминаем до повторной проверки: запись, которую проверка не увидела,
+        // изменит его уже после этого чтения, и wait сразу вернется
+        template <typename Take>
+        bool waitFor(Take take, const std::atomic<bool>& stopping) {
+            while (true) {
+                uint32_t seen = value.load(std::memory_order_acquire);
+                if (take()) {
+                    return true;
+                }
+                if (stopping.load(std::memory_order_acquire)) {
+                    return false;
+                }
+                value.wait(seen, std::memory_order_acquire);
+            }
+        }
+
+        // то же без остановки: ждать, пока ready() не вернет true
+        template <typename Ready>
+        void waitUntil(Ready ready) {
+            while (true) {
+                uint32_t seen = value.load(std::memory_order_acquire);
+                if (ready()) {
+                    return;
+                }
+                value.wait(seen, std::memory_order_acquire);
+            }
+        }
+    };
+
+}
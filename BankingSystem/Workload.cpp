@@ -0,0 +1,352 @@
+﻿#include "Workload.h"
+#include "CheckingAccount.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+
+using namespace Banking;
+
+namespace {
+
+    const char TRACE_MAGIC[4] = { 'B', 'K', 'W', 'L' };
+    const uint32_t TRACE_VERSION = 1;
+
+    struct TraceHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t clients;
+        uint32_t accounts;
+        int64_t initial_balance_cents;
+        uint64_t seed;
+        uint64_t operations;
+    };
+
+    struct TraceRecord {
+        uint64_t offset_ns;
+        int64_t cents;
+        uint32_t from;
+        uint32_t to;
+        uint8_t kind;
+        uint8_t reserved[7];
+    };
+
+    uint64_t parseUnsigned(const std::string& name, const std::string& value) {
+        size_t used = 0;
+        unsigned long long result = 0;
+        try {
+            result = std::stoull(value, &used);
+        }
+        catch (const std::exception&) {
+            used = 0;
+        }
+        if (used == 0 || used != value.size() || value[0] == '-') {
+            throw std::invalid_argument("Invalid value for --" + name + ": " + value);
+        }
+        return result;
+    }
+
+    double parseDouble(const std::string& name, const std::string& value) {
+        size_t used = 0;
+        double result = 0;
+        try {
+            result = std::stod(value, &used);
+        }
+        catch (const std::exception&) {
+            used = 0;
+        }
+        if (used == 0 || used != value.size() || !(result >= 0)) {
+            throw std::invalid_argument("Invalid value for --" + name + ": " + value);
+        }
+        return result;
+    }
+
+}
+
+bool setWorkloadOption(WorkloadConfig& config, const std::string& name, const std::string& value) {
+    if (name == "clients" || name == "accounts") {
+        uint64_t count = parseUnsigned(name, value);
+        if (count == 0 || count > UINT32_MAX) {
+            throw std::invalid_argument("--" + name + " must be between 1 and " + std::to_string(UINT32_MAX));
+        }
+        (name == "clients" ? config.clients : config.accounts) = static_cast<uint32_t>(count);
+    }
+    else if (name == "ops") {
+        config.operations = parseUnsigned(name, value);
+    }
+    else if (name == "zipf") {
+        config.zipf = parseDouble(name, value);
+    }
+    else if (name == "rate") {
+        config.rate = parseDouble(name, value);
+    }
+    else if (name == "seed") {
+        config.seed = parseUnsigned(name, value);
+    }
+    else if (name == "mix") {
+        // D:W:T - веса пополнений, снятий и переводов
+        size_t first = value.find(':');
+        size_t second = first == std::string::npos ? std::string::npos : value.find(':', first + 1);
+        if (second == std::string::npos) {
+            throw std::invalid_argument("--mix must be deposits:withdrawals:transfers, got " + value);
+        }
+        uint64_t deposits = parseUnsigned(name, value.substr(0, first));
+        uint64_t withdrawals = parseUnsigned(name, value.substr(first + 1, second - first - 1));
+        uint64_t transfers = parseUnsigned(name, value.substr(second + 1));
+        if (deposits + withdrawals + transfers == 0 || std::max({ deposits, withdrawals, transfers }) > 1000000) {
+            throw std::invalid_argument("--mix weights must be up to 1000000 and not all zero");
+        }
+        config.deposit_weight = static_cast<uint32_t>(deposits);
+        config.withdraw_weight = static_cast<uint32_t>(withdrawals);
+        config.transfer_weight = static_cast<uint32_t>(transfers);
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadConfig& config_value)
+    : config(config_value), state(config_value.seed) {
+    if (config.accounts == 0 || config.clients == 0) {
+        throw std::invalid_argument("Workload needs at least one client and one account");
+    }
+    if (config.deposit_weight + config.withdraw_weight + config.transfer_weight == 0) {
+        throw std::invalid_argument("Workload operation weights are all zero");
+    }
+    if (config.min_amount_cents <= 0 || config.max_amount_cents < config.min_amount_cents) {
+        throw std::invalid_argument("Invalid workload amount range");
+    }
+
+    cdf.resize(config.accounts);
+    double total = 0;
+    for (uint32_t rank = 0; rank < config.accounts; ++rank) {
+        total += 1.0 / std::pow(static_cast<double>(rank) + 1.0, config.zipf);
+        cdf[rank] = total;
+    }
+    for (double& value : cdf) {
+        value /= total;
+    }
+
+    // перестановка Фишера-Йейтса своим генератором
+    account_of_rank.resize(config.accounts);
+    for (uint32_t i = 0; i < config.accounts; ++i) {
+        account_of_rank[i] = i;
+    }
+    for (uint32_t i = config.accounts - 1; i > 0; --i) {
+        std::swap(account_of_rank[i], account_of_rank[nextRandom() % (uint64_t(i) + 1)]);
+    }
+}
+
+uint64_t WorkloadGenerator::nextRandom() {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+double WorkloadGenerator::nextUnit() {
+    return static_cast<double>(nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+uint32_t WorkloadGenerator::nextAccount() {
+    size_t rank = std::upper_bound(cdf.begin(), cdf.end(), nextUnit()) - cdf.begin();
+    return account_of_rank[std::min(rank, cdf.size() - 1)];
+}
+
+bool WorkloadGenerator::next(WorkloadOp& op) {
+    if (generated == config.operations) {
+        return false;
+    }
+    ++generated;
+
+    uint64_t pick = nextRandom() % (uint64_t(config.deposit_weight) + config.withdraw_weight + config.transfer_weight);
+    op.kind = pick < config.deposit_weight ? WorkloadOpKind::Deposit
+        : pick < uint64_t(config.deposit_weight) + config.withdraw_weight ? WorkloadOpKind::Withdraw
+        : WorkloadOpKind::Transfer;
+    op.from = nextAccount();
+    op.to = op.from;
+    if (op.kind == WorkloadOpKind::Transfer && config.accounts > 1) {
+        op.to = nextAccount();
+        if (op.to == op.from) {
+            op.to = (op.from + 1) % config.accounts;
+        }
+    }
+    op.cents = config.min_amount_cents + static_cast<int64_t>(nextRandom() % uint64_t(config.max_amount_cents - config.min_amount_cents + 1));
+
+    // пуассоновский поток: экспоненциальные интервалы между операциями
+    if (config.rate > 0) {
+        next_offset += -std::log(1.0 - nextUnit()) / config.rate * 1e9;
+    }
+    op.offset_ns = static_cast<uint64_t>(next_offset);
+    return true;
+}
+
+TraceWriter::TraceWriter(const std::string& path, const WorkloadConfig& config)
+    : file(path, std::ios::binary | std::ios::trunc) {
+    if (!file) {
+        throw std::runtime_error("Cannot create trace file: " + path);
+    }
+    TraceHeader header{};
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version = TRACE_VERSION;
+    header.clients = config.clients;
+    header.accounts = config.accounts;
+    header.initial_balance_cents = config.initial_balance_cents;
+    header.seed = config.seed;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+TraceWriter::~TraceWriter() {
+    try {
+        close();
+    }
+    catch (const std::exception&) {
+        // деструктор не бросает; ошибку записи видно по явному close()
+    }
+}
+
+void TraceWriter::write(const WorkloadOp& op) {
+    TraceRecord record{};
+    record.offset_ns = op.offset_ns;
+    record.cents = op.cents;
+    record.from = op.from;
+    record.to = op.to;
+    record.kind = static_cast<uint8_t>(op.kind);
+    file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    ++written;
+}
+
+void TraceWriter::close() {
+    if (!file.is_open()) {
+        return;
+    }
+    file.seekp(offsetof(TraceHeader, operations));
+    file.write(reinterpret_cast<const char*>(&written), sizeof(written));
+    file.close();
+    if (file.fail()) {
+        throw std::runtime_error("Cannot write trace file");
+    }
+}
+
+TraceReader::TraceReader(const std::string& path)
+    : file(path, std::ios::binary) {
+    if (!file) {
+        throw std::runtime_error("Cannot open trace file: " + path);
+    }
+    TraceHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header.version != TRACE_VERSION) {
+        throw std::runtime_error("Not a workload trace file: " + path);
+    }
+    config.clients = header.clients;
+    config.accounts = header.accounts;
+    config.initial_balance_cents = header.initial_balance_cents;
+    config.seed = header.seed;
+    config.operations = header.operations;
+}
+
+bool TraceReader::next(WorkloadOp& op) {
+    TraceRecord record{};
+    if (read == config.operations || !file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        return false;
+    }
+    if (record.kind > static_cast<uint8_t>(WorkloadOpKind::Transfer) || record.from >= config.accounts || record.to >= config.accounts) {
+        throw std::runtime_error("Corrupted trace record " + std::to_string(read));
+    }
+    ++read;
+    op.offset_ns = record.offset_ns;
+    op.cents = record.cents;
+    op.from = record.from;
+    op.to = record.to;
+    op.kind = static_cast<WorkloadOpKind>(record.kind);
+    return true;
+}
+
+void WorkloadReport::write(std::ostream& out) const {
+    out << "Operations: " << operations << ", declined: " << declined << ", time: " << seconds << " s, throughput: "
+        << (seconds > 0 ? operations / seconds : 0) << " ops/sec" << std::endl;
+    out << "Latency, us: p50 " << latency.percentile(0.5) / 1000.0 << ", p90 " << latency.percentile(0.9) / 1000.0
+        << ", p99 " << latency.percentile(0.99) / 1000.0 << ", p99.9 " << latency.percentile(0.999) / 1000.0
+        << ", max " << latency.max / 1000.0 << std::endl;
+}
+
+WorkloadRunner::WorkloadRunner(Bank& bank_value) : bank(bank_value) {
+}
+
+void WorkloadRunner::setup(const WorkloadConfig& config) {
+    for (uint32_t id = 1; id <= config.clients; ++id) {
+        bank.createClient(static_cast<int>(id), "Client", "N" + std::to_string(id),
+            Address("Main St", "City", "Country", 10001), Date(1, 1, 2024));
+    }
+    accounts.clear();
+    numbers.clear();
+    accounts.reserve(config.accounts);
+    numbers.reserve(config.accounts);
+    for (uint32_t i = 0; i < config.accounts; ++i) {
+        numbers.push_back(accountNumber(i));
+        accounts.push_back(bank.createCheckAccount(numbers.back(), static_cast<int>(1 + i % config.clients),
+            Ledger::fromCents(config.initial_balance_cents)));
+    }
+}
+
+BankStatus WorkloadRunner::execute(const WorkloadOp& op) {
+    switch (op.kind) {
+    case WorkloadOpKind::Deposit:
+        return bank.tryDeposit(accounts.at(op.from), Ledger::fromCents(op.cents));
+    case WorkloadOpKind::Withdraw:
+        return bank.tryWithdraw(accounts.at(op.from), Ledger::fromCents(op.cents));
+    case WorkloadOpKind::Transfer:
+        return bank.tryTransfer(numbers.at(op.from), numbers.at(op.to), Ledger::fromCents(op.cents));
+    }
+    return BankStatus::OperationFailed;
+}
+
+template <typename Source>
+WorkloadReport WorkloadRunner::drive(Source& source, TraceWriter* recorder, bool paced) {
+    using Clock = std::chrono::steady_clock;
+    WorkloadReport report;
+    WorkloadOp op;
+    auto start = Clock::now();
+    while (source.next(op)) {
+        auto begin = Clock::now();
+        if (paced) {
+            // назначенный момент; до него - сон, последние сотни микросекунд - уступаем поток
+            auto scheduled = start + std::chrono::nanoseconds(op.offset_ns);
+            if (scheduled - begin > std::chrono::microseconds(200)) {
+                std::this_thread::sleep_until(scheduled - std::chrono::microseconds(100));
+            }
+            while (Clock::now() < scheduled) {
+                std::this_thread::yield();
+            }
+            begin = scheduled;
+        }
+        auto issued = Clock::now();
+        if (execute(op) != BankStatus::Ok) {
+            ++report.declined;
+        }
+        auto end = Clock::now();
+        if (recorder) {
+            WorkloadOp recorded = op;
+            recorded.offset_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(issued - start).count());
+            recorder->write(recorded);
+        }
+        uint64_t nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+        report.latency.add(nanoseconds);
+        ++report.operations;
+    }
+    report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return report;
+}
+
+WorkloadReport WorkloadRunner::run(WorkloadGenerator& generator, TraceWriter* recorder) {
+    return drive(generator, recorder, generator.getConfig().rate > 0);
+}
+
+WorkloadReport WorkloadRunner::replay(TraceReader& reader, bool paced) {
+    return drive(reader, nullptr, paced);
+}
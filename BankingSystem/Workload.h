@@ -0,0 +1,128 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include "Bank.h"
+#include "Metrics.h"
+
+// Воспроизводимая синтетическая нагрузка на Bank для сравнения производительности между версиями.
+// Генератор детерминирован (свой генератор случайных чисел, без std::*_distribution, которые
+// различаются между стандартными библиотеками): одинаковые параметры и seed дают одинаковые операции.
+// Популярность счетов - распределение Ципфа: счет ранга k выбирается с весом 1 / k^zipf,
+// ранги перемешаны по счетам, чтобы горячие счета не шли подряд.
+// Нагрузку можно записать в двоичный файл трассы и воспроизвести на пустом банке
+// с максимальной скоростью или в исходном темпе.
+
+struct WorkloadConfig {
+    uint32_t clients = 1000;
+    uint32_t accounts = 10000;
+    uint64_t operations = 1000000;
+    double zipf = 0.99;                 // 0 - все счета одинаково популярны
+    uint32_t deposit_weight = 20;       // доли видов операций
+    uint32_t withdraw_weight = 20;
+    uint32_t transfer_weight = 60;
+    int64_t min_amount_cents = 100;
+    int64_t max_amount_cents = 100000;
+    int64_t initial_balance_cents = 100000000;
+    double rate = 0;                    // операций в секунду (пуассоновский поток); 0 - без темпа
+    uint64_t seed = 1;
+};
+
+// задать параметр по имени из командной строки ("clients", "mix" как D:W:T, ...);
+// false - неизвестное имя, std::invalid_argument - неверное значение
+bool setWorkloadOption(WorkloadConfig& config, const std::string& name, const std::string& value);
+
+enum class WorkloadOpKind : uint8_t { Deposit, Withdraw, Transfer };
+
+struct WorkloadOp {
+    uint64_t offset_ns = 0;  // момент операции от начала нагрузки
+    int64_t cents = 0;
+    uint32_t from = 0;       // индекс счета (для пополнения - счет зачисления)
+    uint32_t to = 0;         // только для перевода
+    WorkloadOpKind kind = WorkloadOpKind::Deposit;
+};
+
+class WorkloadGenerator {
+private:
+    WorkloadConfig config;
+    uint64_t state;
+    std::vector<double> cdf;               // накопленные вероятности рангов
+    std::vector<uint32_t> account_of_rank;
+    uint64_t generated = 0;
+    double next_offset = 0;                // в наносекундах
+
+    uint64_t nextRandom();                 // splitmix64
+    double nextUnit();                     // [0, 1)
+    uint32_t nextAccount();
+
+public:
+    explicit WorkloadGenerator(const WorkloadConfig& config_value);
+
+    const WorkloadConfig& getConfig() const { return config; }
+    bool next(WorkloadOp& op); // false - все операции выданы
+};
+
+// Файл трассы: заголовок (параметры банка и число операций) и записи фиксированного размера
+class TraceWriter {
+private:
+    std::ofstream file;
+    uint64_t written = 0;
+
+public:
+    TraceWriter(const std::string& path, const WorkloadConfig& config);
+    ~TraceWriter();
+
+    void write(const WorkloadOp& op);
+    void close(); // число операций дописывается в заголовок
+    uint64_t getWrittenCount() const { return written; }
+};
+
+class TraceReader {
+private:
+    std::ifstream file;
+    WorkloadConfig config; // заполнены clients, accounts, initial_balance_cents, seed, operations
+    uint64_t read = 0;
+
+public:
+    explicit TraceReader(const std::string& path); // std::runtime_error, если файл не открылся или не трасса
+
+    const WorkloadConfig& getConfig() const { return config; }
+    bool next(WorkloadOp& op);
+};
+
+struct WorkloadReport {
+    uint64_t operations = 0;
+    uint64_t declined = 0;
+    double seconds = 0;
+    Banking::LatencyHistogram latency;
+
+    void write(std::ostream& out) const;
+};
+
+// Выполняет нагрузку на банке: счет с индексом i - "WL<i>" клиента 1 + i % clients.
+// В темпе задержка считается от назначенного момента операции, а не от фактического начала,
+// поэтому отставание от графика попадает в хвост распределения, а не теряется.
+class WorkloadRunner {
+private:
+    Banking::Bank& bank;
+    std::vector<std::shared_ptr<Banking::Account>> accounts;
+    std::vector<std::string> numbers;
+
+    template <typename Source>
+    WorkloadReport drive(Source& source, TraceWriter* recorder, bool paced);
+
+public:
+    explicit WorkloadRunner(Banking::Bank& bank_value);
+
+    static std::string accountNumber(uint32_t index) { return "WL" + std::to_string(index); }
+
+    void setup(const WorkloadConfig& config); // клиенты и расчетные счета с начальным остатком
+    Banking::BankStatus execute(const WorkloadOp& op);
+
+    // recorder - записать операции с фактическими моментами выполнения
+    WorkloadReport run(WorkloadGenerator& generator, TraceWriter* recorder = nullptr);
+    WorkloadReport replay(TraceReader& reader, bool paced);
+};
@@ -1,17 +1,182 @@
 ﻿#include <iostream>
 #include <windows.h>
 
+#include <string>
+#include <cstdlib>
+
 #include "Bank.h"
 #include "Menu.h"
+#include "BatchProcessor.h"
+#include "BulkLoader.h"
+#include "ChangeFeedFile.h"
 #include "TestBankSystem.h"
+#include "BenchBankSystem.h"
+#include "Workload.h"
 
 using namespace Banking;
 
-int main() {
+int main(int argc, char* argv[]) {
 // Настройка консоли для UTF-8
 SetConsoleOutputCP(CP_UTF8);
 SetConsoleCP(CP_UTF8);
 
+    std::string mode = argc > 1 ? argv[1] : "";
+
+    // пакетный режим: BankingSystem --batch <file> (или "-" для stdin) [--feed <events.bin>]
+    if (mode == "--batch") {
+        if (argc < 3 || (argc > 3 && (argc != 5 || std::string(argv[3]) != "--feed"))) {
+            std::cerr << "Usage: BankingSystem --batch <file|-> [--feed <events.bin>]" << std::endl;
+            return 1;
+        }
+        std::string path = argv[2];
+        size_t processed = 0;
+        size_t failed = 0;
+        {
+            QuietCout quiet; // деструкторы объектов банка тоже пишут в cout
+            Bank bank;
+            BatchProcessor batch(bank);
+            try {
+                // лента изменений пишется в файл параллельно с обработкой команд
+                std::unique_ptr<ChangeFeedFileWriter> feed_writer;
+                if (argc == 5) {
+                    auto feed = std::make_shared<ChangeFeed>();
+                    bank.setChangeFeed(feed);
+                    feed_writer = std::make_unique<ChangeFeedFileWriter>(*feed, argv[4]);
+                }
+                if (path == "-") {
+                    batch.run(std::cin);
+                }
+                else {
+                    batch.runFile(path);
+                }
+            }
+            catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            processed = batch.getProcessedCount();
+            failed = batch.getFailedCount();
+        }
+        std::cout << "Batch finished. Processed: " << processed << ", failed: " << failed << std::endl;
+        return failed == 0 ? 0 : 2;
+    }
+    // массовая загрузка клиентов и счетов: BankingSystem --import <file.csv> [--threads N]
+    if (mode == "--import") {
+        if (argc != 3 && (argc != 5 || std::string(argv[3]) != "--threads")) {
+            std::cerr << "Usage: BankingSystem --import <file.csv> [--threads N]" << std::endl;
+            return 1;
+        }
+        size_t clients = 0;
+        size_t accounts = 0;
+        size_t failed = 0;
+        {
+            QuietCout quiet;
+            Bank bank;
+            BulkLoader loader(bank, std::cerr, argc == 5 ? static_cast<unsigned>(std::atoi(argv[4])) : 0);
+            try {
+                loader.loadFile(argv[2]);
+            }
+            catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            clients = loader.getClientCount();
+            accounts = loader.getAccountCount();
+            failed = loader.getFailedCount();
+        }
+        std::cout << "Import finished. Clients: " << clients << ", accounts: " << accounts << ", failed: " << failed << std::endl;
+        return failed == 0 ? 0 : 2;
+    }
+    // чтение файла ленты изменений: BankingSystem --tail <events.bin> [--follow]
+    if (mode == "--tail") {
+        if (argc < 3) {
+            std::cerr << "Usage: BankingSystem --tail <events.bin> [--follow]" << std::endl;
+            return 1;
+        }
+        try {
+            tailChangeFile(argv[2], std::cout, argc > 3 && std::string(argv[3]) == "--follow");
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    // синтетическая нагрузка: BankingSystem --workload [--clients N] [--accounts N] [--ops N] [--zipf S]
+    //     [--mix D:W:T] [--rate OPS_PER_SEC] [--seed N] [--record <trace.bin>]
+    // воспроизведение записанной нагрузки на пустом банке: BankingSystem --replay <trace.bin> [--paced]
+    if (mode == "--workload" || mode == "--replay") {
+        const char* usage = mode == "--workload"
+            ? "Usage: BankingSystem --workload [--clients N] [--accounts N] [--ops N] [--zipf S] [--mix D:W:T] [--rate R] [--seed N] [--record <trace.bin>]"
+            : "Usage: BankingSystem --replay <trace.bin> [--paced]";
+        WorkloadReport report;
+        try {
+            std::unique_ptr<TraceReader> reader;
+            std::unique_ptr<TraceWriter> recorder;
+            WorkloadConfig config;
+            bool paced = false;
+            int next = 2;
+            if (mode == "--replay") {
+                if (argc < 3 || argc > 4 || (argc == 4 && std::string(argv[3]) != "--paced")) {
+                    std::cerr << usage << std::endl;
+                    return 1;
+                }
+                reader = std::make_unique<TraceReader>(argv[2]);
+                config = reader->getConfig();
+                paced = argc == 4;
+                next = argc;
+            }
+            std::string record_path;
+            for (; next < argc; next += 2) {
+                std::string option = argv[next];
+                if (next + 1 >= argc || option.rfind("--", 0) != 0) {
+                    std::cerr << usage << std::endl;
+                    return 1;
+                }
+                if (option == "--record") {
+                    record_path = argv[next + 1];
+                }
+                else if (!setWorkloadOption(config, option.substr(2), argv[next + 1])) {
+                    std::cerr << usage << std::endl;
+                    return 1;
+                }
+            }
+            QuietCout quiet; // деструкторы объектов банка тоже пишут в cout
+            Bank bank;
+            WorkloadRunner runner(bank);
+            runner.setup(config);
+            if (reader) {
+                report = runner.replay(*reader, paced);
+            }
+            else {
+                WorkloadGenerator generator(config);
+                if (!record_path.empty()) {
+                    recorder = std::make_unique<TraceWriter>(record_path, config);
+                }
+                report = runner.run(generator, recorder.get());
+                if (recorder) {
+                    recorder->close();
+                }
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        report.write(std::cout);
+        return 0;
+    }
+    if (mode == "--test") {
+        TestBankSystem tests;
+        tests.runAllTests();
+        return 0;
+    }
+    if (mode == "--bench") {
+        BenchBankSystem bench;
+        bench.runAllBenchmarks();
+        return 0;
+    }
+
     std::cout << "Banking System Started!" << std::endl;
 
     // Start menu system